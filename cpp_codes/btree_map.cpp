@@ -0,0 +1,383 @@
+/* This file shows BTreeMap from btree_map.h, an ordered map stored as a
+ * B+tree with linked leaves, running the ordered examples of
+ * container_map.cpp, and measures it against std::map.
+ *
+ * 1. Initialization, including from_sorted() bulk loading
+ * 2. Inserting and removing, including range erase
+ * 3. Searching algorithms: find(), lower_bound(), upper_bound(),
+ *    equal_range()
+ * 4. Benchmark: building, random finds, full and partial range scans, and
+ *    range erase
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native btree_map.cpp
+ */
+
+#include "btree_map.h"
+#include "fast_output.h"
+#include "node_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Initialization
+void initialization() {
+  // 1.1. Initializer list; sorted once, the first of equal keys is kept
+  std::cout << "1.1. Initializer list {{3, three}, {1, one}, {2, two}, "
+               "{1, I}}"
+            << std::endl;
+  BTreeMap<int, std::string> mp1{
+      {3, "three"}, {1, "one"}, {2, "two"}, {1, "I"}};
+  printMap("Map", mp1);
+
+  // 1.2. from_sorted() builds the tree bottom-up without comparing keys
+  std::cout << std::endl
+            << "1.2. from_sorted() with 1000 keys {0, 10, 20, ...}"
+            << std::endl;
+  std::vector<std::pair<int, int>> sorted;
+  for (int i = 0; i < 1000; ++i) sorted.emplace_back(10 * i, i);
+  auto mp2 = BTreeMap<int, int>::from_sorted(sorted.begin(), sorted.end());
+  std::cout << "Size: " << mp2.size() << ", height: " << mp2.height()
+            << ", keys per node: " << BTreeMap<int, int>::nodeCapacity
+            << ", last element: {" << std::prev(mp2.end())->first << ","
+            << std::prev(mp2.end())->second << "}" << std::endl;
+
+  // 1.3. Copying a std::map
+  std::cout << std::endl
+            << "1.3. Range initialization from a std::map" << std::endl;
+  std::map<int, std::string> source{{1, "one"}, {2, "two"}, {3, "three"}};
+  BTreeMap<int, std::string> mp3(source.begin(), source.end());
+  printMap("Map", mp3);
+}
+
+// 2. Inserting and removing
+void insertingAndRemoving() {
+  BTreeMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  // 2.1. insert(), insert_or_assign(), emplace() and operator []
+  std::cout << "2.1. insert() {1, I} and {4, four}, insert_or_assign() "
+               "{1, I}, emplace() {5, five}, operator [] {6, six}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert({{1, "I"}, {4, "four"}});
+  mp.insert_or_assign(1, "I");
+  mp.emplace(5, "five");
+  mp[6] = "six";
+  printMap("Modified map", mp);
+
+  // 2.2. erase() by key and with an iterator
+  std::cout << std::endl
+            << "2.2. erase() key 6, and key 5 through an iterator"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(6);
+  mp.erase(mp.find(5));
+  printMap("Modified map", mp);
+
+  // 2.3. erase() with a range of iterators
+  std::cout << std::endl
+            << "2.3. erase() with the range [find(2), find(4))" << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(mp.find(2), mp.find(4));
+  printMap("Modified map", mp);
+
+  // 2.4. Range erase in a large map: a range larger than 1/8 of the map
+  // rebuilds the tree from the rest in one pass
+  std::cout << std::endl
+            << "2.4. erase() keys [1000, 90000) from a map of keys "
+               "[0, 100000)"
+            << std::endl;
+  BTreeMap<int, int> large;
+  for (int i = 0; i < 100000; ++i) large[i] = i;
+  auto next = large.erase(large.lower_bound(1000), large.lower_bound(90000));
+  std::cout << "Size: " << large.size() << ", next key: " << next->first
+            << ", height: " << large.height() << std::endl;
+}
+
+// 3. Searching algorithms
+void searchingAlgorithms() {
+  BTreeMap<int, std::string> mp{
+      {1, "one"}, {2, "two"}, {3, "three"}, {5, "five"}, {6, "six"}};
+  printMap("Map", mp);
+
+  // 3.1. find() and count()
+  std::cout << std::endl << "3.1. find(2) and count(4)" << std::endl;
+  auto it = mp.find(2);
+  if (it != mp.end()) std::cout << "Found value: " << it->second << std::endl;
+  std::cout << "count(4): " << mp.count(4) << std::endl;
+
+  // 3.2. lower_bound() and upper_bound()
+  std::cout << std::endl
+            << "3.2. lower_bound(4) and upper_bound(5)" << std::endl;
+  std::cout << "Lower bound: " << mp.lower_bound(4)->second
+            << ", upper bound: " << mp.upper_bound(5)->second << std::endl;
+
+  // 3.3. equal_range() and a reverse walk
+  std::cout << std::endl
+            << "3.3. equal_range(3), then the elements before it in reverse"
+            << std::endl;
+  auto [first, last] = mp.equal_range(3);
+  std::cout << "Range: {" << first->first << "," << first->second
+            << "} up to key " << last->first << std::endl;
+  for (auto rit = std::make_reverse_iterator(first); rit != mp.rend(); ++rit)
+    std::cout << "{" << rit->first << "," << rit->second << "} ";
+  std::cout << std::endl;
+}
+
+// Applies random operations to a BTreeMap and a std::map and compares them,
+// for vector searched (int, int64_t) and std::lower_bound searched (double)
+// nodes.
+template <typename Key>
+bool checkAgainstStd(uint32_t seed) {
+  std::mt19937 gen(seed);
+  bool ok = true;
+  for (int keyRange : {50, 3000, 200000}) {
+    BTreeMap<Key, int> tree;
+    std::map<Key, int> reference;
+    for (int step = 0; step < 60000; ++step) {
+      Key key = static_cast<Key>(gen() % keyRange) - keyRange / 2;
+      int value = static_cast<int>(gen() % 1000);
+      switch (gen() % 10) {
+        case 0:
+        case 1:
+        case 2:
+          ok = ok && tree.insert({key, value}).second ==
+                         reference.insert({key, value}).second;
+          break;
+        case 3:
+          tree.insert_or_assign(key, value);
+          reference.insert_or_assign(key, value);
+          break;
+        case 4:
+        case 5:
+          ok = ok && tree.erase(key) == reference.erase(key);
+          break;
+        case 6: {
+          // Mostly short ranges, sometimes long ones.
+          Key to = key + static_cast<Key>(gen() % (step % 97 == 0 ? 2000 : 8));
+          auto t = tree.erase(tree.lower_bound(key), tree.lower_bound(to));
+          auto r = reference.erase(reference.lower_bound(key),
+                                   reference.lower_bound(to));
+          ok = ok && (t == tree.end()) == (r == reference.end()) &&
+               (t == tree.end() || t->first == r->first);
+          break;
+        }
+        case 7: {
+          auto t = tree.upper_bound(key);
+          auto r = reference.upper_bound(key);
+          ok = ok && (t == tree.end()) == (r == reference.end()) &&
+               (t == tree.end() || t->first == r->first);
+          break;
+        }
+        default: {
+          auto t = tree.find(key);
+          auto r = reference.find(key);
+          ok = ok && (t == tree.end()) == (r == reference.end()) &&
+               (t == tree.end() || t->second == r->second);
+          break;
+        }
+      }
+    }
+    auto same = [](const auto& a, const auto& b) {
+      return a.first == b.first && a.second == b.second;
+    };
+    BTreeMap<Key, int> copy = tree;
+    erase_if(copy, [](const auto& e) { return e.second % 3 == 0; });
+    std::erase_if(reference, [](const auto& e) { return e.second % 3 == 0; });
+    ok = ok && copy.size() == reference.size() &&
+         std::equal(copy.begin(), copy.end(), reference.begin(),
+                    reference.end(), same) &&
+         std::equal(copy.rbegin(), copy.rend(), reference.rbegin(),
+                    reference.rend(), same);
+  }
+  return ok;
+}
+
+// Move assignment between maps on different pools: polymorphic_allocator
+// does not propagate, so the elements are moved and each pool gets back
+// exactly the nodes it handed out.
+bool checkMoveAcrossPools() {
+  using Allocator = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+  using Map = BTreeMap<int, int, std::less<int>, Allocator>;
+  NodePool poolA;
+  NodePool poolB;
+  std::map<int, int> reference;
+  bool ok = true;
+  {
+    Map a(std::less<int>(), &poolA);
+    Map b(std::less<int>(), &poolB);
+    for (int i = 0; i < 10; ++i) a.emplace(-i, i);
+    for (int i = 0; i < 1000; ++i) {
+      b.emplace(i, -i);
+      reference.emplace(i, -i);
+    }
+    a = std::move(b);
+    auto same = [](const auto& x, const auto& y) {
+      return x.first == y.first && x.second == y.second;
+    };
+    ok = a.get_allocator().resource() == &poolA && b.empty() &&
+         std::equal(a.begin(), a.end(), reference.begin(), reference.end(),
+                    same) &&
+         poolB.stats().bytesInUse == 0;
+  }
+  return ok && poolA.stats().bytesInUse == 0 &&
+         poolB.stats().bytesInUse == 0;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 21;
+  constexpr size_t lookups = 1 << 20;
+  constexpr size_t scans = 1 << 12;
+  constexpr size_t scanLength = 1000;
+  std::mt19937 gen(42);
+  std::vector<std::pair<int, int>> elements(size);
+  for (auto& [key, value] : elements) {
+    key = static_cast<int>(gen());
+    value = static_cast<int>(gen() % 1000);
+  }
+  std::vector<int> queries(lookups);
+  for (int& query : queries) query = elements[gen() % size].first;
+  // volatile keeps the compiler from dropping the unused results.
+  volatile long long sink = 0;
+
+  std::map<int, int> tree;
+  BTreeMap<int, int> btree;
+  double treeInsert = measureMilliseconds([&] {
+    for (const auto& [key, value] : elements) tree.emplace(key, value);
+  });
+  double btreeInsert = measureMilliseconds([&] {
+    for (const auto& [key, value] : elements) btree.emplace(key, value);
+  });
+  std::vector<std::pair<int, int>> sorted(tree.begin(), tree.end());
+  double bulkLoad = measureMilliseconds([&] {
+    auto loaded = BTreeMap<int, int>::from_sorted(sorted.begin(),
+                                                  sorted.end());
+    sink = static_cast<long long>(loaded.size());
+  });
+
+  auto findAll = [&](const auto& map) {
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (int query : queries) sum += map.find(query)->second;
+      sink = sum;
+    });
+  };
+  double treeFind = findAll(tree);
+  double btreeFind = findAll(btree);
+
+  auto scanAll = [&](const auto& map) {
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (int pass = 0; pass < 10; ++pass)
+        for (const auto& element : map) sum += element.second;
+      sink = sum;
+    });
+  };
+  double treeScan = scanAll(tree);
+  double btreeScan = scanAll(btree);
+
+  // scanLength elements from a random lower_bound().
+  auto scanRanges = [&](const auto& map) {
+    std::mt19937 rangeGen(7);
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (size_t s = 0; s < scans; ++s) {
+        auto it = map.lower_bound(static_cast<int>(rangeGen()));
+        for (size_t i = 0; i < scanLength && it != map.end(); ++i, ++it)
+          sum += it->second;
+      }
+      sink = sum;
+    });
+  };
+  double treeRanges = scanRanges(tree);
+  double btreeRanges = scanRanges(btree);
+
+  // Erase the middle half of the keys.
+  int from = sorted[size / 4].first;
+  int to = sorted[3 * size / 4].first;
+  // BTreeMap goes first: the nodes std::map frees would otherwise sit in
+  // malloc's unsorted bin, and sorting them is charged to the next
+  // allocation, here the rebuilt leaves.
+  double btreeErase = measureMilliseconds(
+      [&] { btree.erase(btree.lower_bound(from), btree.lower_bound(to)); });
+  double treeErase = measureMilliseconds(
+      [&] { tree.erase(tree.lower_bound(from), tree.lower_bound(to)); });
+
+  auto report = [](const std::string& what, double treeTime,
+                   double btreeTime) {
+    std::cout << what << ": std::map " << treeTime << " ms, BTreeMap "
+              << btreeTime << " ms (" << treeTime / btreeTime << "x)"
+              << std::endl;
+  };
+  std::cout << sorted.size() << " int keys, "
+            << BTreeMap<int, int>::nodeCapacity << " keys per node, height "
+            << btree.height() << std::endl;
+  report("Random inserts", treeInsert, btreeInsert);
+  std::cout << "from_sorted(): " << bulkLoad << " ms" << std::endl;
+  report(std::to_string(lookups) + " random finds", treeFind, btreeFind);
+  report("10 full scans", treeScan, btreeScan);
+  report(std::to_string(scans) + " scans of " + std::to_string(scanLength) +
+             " elements",
+         treeRanges, btreeRanges);
+  report("Range erase of half the keys", treeErase, btreeErase);
+  std::cout << "Maps equal after the erase: " << std::boolalpha
+            << (tree.size() == btree.size() &&
+                std::equal(btree.begin(), btree.end(), tree.begin(),
+                           [](const auto& a, const auto& b) {
+                             return a.first == b.first;
+                           }))
+            << std::endl;
+}
+
+int main() {
+  // Initialization
+  std::cout << "*** Initialization ***" << std::endl;
+  initialization();
+
+  // Inserting and removing
+  std::cout << std::endl << "*** Inserting and removing ***" << std::endl;
+  insertingAndRemoving();
+
+  // Searching
+  std::cout << std::endl << "*** Searching algorithms ***" << std::endl;
+  searchingAlgorithms();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::map: " << std::boolalpha
+            << (checkAgainstStd<int>(1) && checkAgainstStd<int64_t>(2) &&
+                checkAgainstStd<double>(3) && checkMoveAcrossPools())
+            << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,954 @@
+/* This header implements BTreeMap<Key, T, Compare>, an ordered map stored
+ * as a B+tree, for the ordered work of container_map.cpp: printMap(),
+ * lower_bound(), upper_bound() and erase(itStart, itEnd). std::map keeps
+ * one element per red-black tree node, so walking it follows a pointer to
+ * a new cache line for every element.
+ *
+ * 1. Nodes: every node holds up to nodeCapacity keys in an array of about
+ *    256 bytes (four cache lines); 64 keys for int, 32 for int64_t. Inner
+ *    nodes hold keys and child pointers; leaves hold keys and values in
+ *    two arrays, and all elements live in the leaves.
+ * 2. Intra-node search: for signed 32- and 64-bit keys ordered by
+ *    std::less, a node is searched by comparing 16 (AVX-512), 8 (AVX2) or
+ *    4 (SSE2) keys per instruction and counting the smaller ones; other
+ *    keys use std::lower_bound.
+ * 3. Linked leaves: every leaf points to its neighbours, so iteration and
+ *    range scans walk arrays leaf by leaf without going back up the tree.
+ * 4. from_sorted() builds the tree bottom-up from sorted input in linear
+ *    time, with leaves filled evenly.
+ * 5. erase(first, last) removes a range inside one leaf by shifting that
+ *    leaf, a short range key by key, and a large range by rebuilding the
+ *    tree from the remaining elements in one linear pass.
+ *
+ * As in FlatMap (flat_map.h), keys and values are kept in separate arrays,
+ * so iterators dereference to std::pair<const Key&, T&>. Key and T must be
+ * default constructible. Insertions and erasures invalidate iterators.
+ */
+
+#ifndef BTREE_MAP_H
+#define BTREE_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class BTreeMap {
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using key_compare = Compare;
+  using allocator_type = Allocator;
+  using reference = std::pair<const Key&, T&>;
+  using const_reference = std::pair<const Key&, const T&>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // Keys per node: about 256 bytes of keys, a multiple of 16 so that the
+  // vector search never reads past the array.
+  static constexpr size_t nodeCapacity =
+      std::max<size_t>(16, 256 / sizeof(Key) / 16 * 16);
+
+  // 1. Construction
+  BTreeMap() = default;
+
+  explicit BTreeMap(const Compare& comp, const Allocator& alloc = Allocator())
+      : mComp(comp), mLeafAlloc(alloc), mInnerAlloc(alloc) {}
+
+  // Sorts the elements, keeps the first of equal keys and builds the tree
+  // bottom-up.
+  template <typename InputIt>
+  BTreeMap(InputIt first, InputIt last, const Compare& comp = Compare(),
+           const Allocator& alloc = Allocator())
+      : BTreeMap(comp, alloc) {
+    std::vector<value_type> elements(first, last);
+    std::stable_sort(elements.begin(), elements.end(),
+                     [&](const value_type& a, const value_type& b) {
+                       return mComp(a.first, b.first);
+                     });
+    auto end = std::unique(elements.begin(), elements.end(),
+                           [&](const value_type& a, const value_type& b) {
+                             return !mComp(a.first, b.first);
+                           });
+    bulkLoad(std::make_move_iterator(elements.begin()),
+             static_cast<size_t>(end - elements.begin()));
+  }
+
+  BTreeMap(std::initializer_list<value_type> init,
+           const Compare& comp = Compare(),
+           const Allocator& alloc = Allocator())
+      : BTreeMap(init.begin(), init.end(), comp, alloc) {}
+
+  // Builds the tree from key/value pairs that are already sorted by comp
+  // and free of duplicates, in linear time.
+  template <typename ForwardIt>
+  static BTreeMap from_sorted(ForwardIt first, ForwardIt last,
+                              const Compare& comp = Compare(),
+                              const Allocator& alloc = Allocator()) {
+    BTreeMap map(comp, alloc);
+    map.bulkLoad(first, static_cast<size_t>(std::distance(first, last)));
+    return map;
+  }
+
+  BTreeMap(const BTreeMap& other)
+      : mComp(other.mComp),
+        mLeafAlloc(LeafTraits::select_on_container_copy_construction(
+            other.mLeafAlloc)),
+        mInnerAlloc(mLeafAlloc) {
+    bulkLoad(other.begin(), other.size());
+  }
+
+  BTreeMap(BTreeMap&& other) noexcept
+      : mComp(other.mComp),
+        mLeafAlloc(std::move(other.mLeafAlloc)),
+        mInnerAlloc(std::move(other.mInnerAlloc)) {
+    steal(other);
+  }
+
+  BTreeMap& operator=(const BTreeMap& other) {
+    if (this == &other) return *this;
+    clear();
+    mComp = other.mComp;
+    bulkLoad(other.begin(), other.size());
+    return *this;
+  }
+
+  BTreeMap& operator=(BTreeMap&& other) noexcept(
+      LeafTraits::propagate_on_container_move_assignment::value ||
+      LeafTraits::is_always_equal::value) {
+    if (this == &other) return *this;
+    clear();
+    mComp = other.mComp;
+    if constexpr (LeafTraits::propagate_on_container_move_assignment::value) {
+      mLeafAlloc = std::move(other.mLeafAlloc);
+      mInnerAlloc = std::move(other.mInnerAlloc);
+      steal(other);
+    } else {
+      if (mLeafAlloc == other.mLeafAlloc) {
+        steal(other);
+      } else {
+        // The nodes belong to another allocator: move element by element.
+        bulkLoad(std::make_move_iterator(other.begin()), other.size());
+        other.clear();
+      }
+    }
+    return *this;
+  }
+
+  ~BTreeMap() { clear(); }
+
+  // 2. Iterators
+  iterator begin() noexcept { return {mFirst, 0}; }
+  const_iterator begin() const noexcept { return {mFirst, 0}; }
+  iterator end() noexcept { return {mLast, mLast ? mLast->count : 0}; }
+  const_iterator end() const noexcept {
+    return {mLast, mLast ? mLast->count : 0};
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  // Capacity
+  bool empty() const noexcept { return mSize == 0; }
+  size_t size() const noexcept { return mSize; }
+  // Levels of inner nodes above the leaves.
+  size_t height() const noexcept { return mHeight; }
+  key_compare key_comp() const { return mComp; }
+  allocator_type get_allocator() const { return Allocator(mLeafAlloc); }
+
+  // 3. Lookup
+  T& at(const Key& key) {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("BTreeMap::at");
+    return it->second;
+  }
+
+  const T& at(const Key& key) const {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("BTreeMap::at");
+    return it->second;
+  }
+
+  T& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+  iterator find(const Key& key) { return toMutable(findConst(key)); }
+  const_iterator find(const Key& key) const { return findConst(key); }
+  size_t count(const Key& key) const { return find(key) != end(); }
+  bool contains(const Key& key) const { return find(key) != end(); }
+
+  iterator lower_bound(const Key& key) {
+    return toMutable(std::as_const(*this).lower_bound(key));
+  }
+  const_iterator lower_bound(const Key& key) const {
+    if (!mRoot) return end();
+    Leaf* leaf = findLeaf(key);
+    return normalize(leaf, lowerIndex(leaf->keys, leaf->count, key));
+  }
+  iterator upper_bound(const Key& key) {
+    return toMutable(std::as_const(*this).upper_bound(key));
+  }
+  const_iterator upper_bound(const Key& key) const {
+    if (!mRoot) return end();
+    Leaf* leaf = findLeaf(key);
+    return normalize(leaf, upperIndex(leaf->keys, leaf->count, key));
+  }
+  std::pair<iterator, iterator> equal_range(const Key& key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      const Key& key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  // 4. Modifiers
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    if (!mRoot) mRoot = mFirst = mLast = newLeaf();
+    Path path;
+    Leaf* leaf = findLeaf(key, &path);
+    size_t index = lowerIndex(leaf->keys, leaf->count, key);
+    if (index < leaf->count && !mComp(key, leaf->keys[index]))
+      return {iterator(leaf, index), false};
+
+    std::move_backward(leaf->keys + index, leaf->keys + leaf->count,
+                       leaf->keys + leaf->count + 1);
+    std::move_backward(leaf->values + index, leaf->values + leaf->count,
+                       leaf->values + leaf->count + 1);
+    leaf->keys[index] = Key(std::forward<K>(key));
+    leaf->values[index] = T(std::forward<Args>(args)...);
+    ++leaf->count;
+    ++mSize;
+    if (leaf->count <= nodeCapacity) return {iterator(leaf, index), true};
+    return {splitLeaf(path, leaf, index), true};
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type element(std::forward<Args>(args)...);
+    return try_emplace(std::move(element.first), std::move(element.second));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& element) {
+    return try_emplace(element.first, element.second);
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    if (empty()) {
+      *this = BTreeMap(first, last, mComp, get_allocator());
+      return;
+    }
+    for (; first != last; ++first) emplace(*first);
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& value) {
+    auto result = try_emplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second) result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  size_t erase(const Key& key) {
+    if (!mRoot) return 0;
+    Path path;
+    Leaf* leaf = findLeaf(key, &path);
+    size_t index = lowerIndex(leaf->keys, leaf->count, key);
+    if (index == leaf->count || mComp(key, leaf->keys[index])) return 0;
+    removeFromLeaf(leaf, index, 1);
+    rebalance(path, leaf);
+    return 1;
+  }
+
+  // Returns the iterator following the erased element.
+  iterator erase(const_iterator pos) {
+    Key key = pos->first;
+    erase(key);
+    return lower_bound(key);
+  }
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t count = static_cast<size_t>(std::distance(first, last));
+    if (count == 0) return toMutable(last);
+    if (count == mSize) {
+      clear();
+      return end();
+    }
+    // Inside one leaf that stays at least half full: shift it, the
+    // separators above stay valid.
+    Leaf* leaf = first.mLeaf;
+    if (first.mIndex + count <= leaf->count &&
+        (leaf == mRoot || leaf->count - count >= minCount)) {
+      removeFromLeaf(leaf, first.mIndex, count);
+      return toMutable(normalize(leaf, first.mIndex));
+    }
+    if (count <= mSize / 8) {
+      // A short range: one erase per key, each O(log n).
+      Key key = first->first;
+      for (size_t i = 0; i < count; ++i) {
+        key = first->first;
+        erase(key);
+        first = std::as_const(*this).lower_bound(key);
+      }
+      return lower_bound(key);
+    }
+    // A large range: keep the other elements and rebuild in linear time.
+    std::vector<value_type> kept;
+    kept.reserve(mSize - count);
+    bool lastIsEnd = last == cend();
+    Key stop = lastIsEnd ? Key() : last->first;
+    size_t skip = 0;
+    for (Leaf* node = mFirst; node; node = node->next) {
+      for (size_t i = 0; i < node->count; ++i) {
+        if (node == first.mLeaf && i == first.mIndex) skip = count;
+        if (skip > 0) {
+          --skip;
+          continue;
+        }
+        kept.emplace_back(std::move(node->keys[i]),
+                          std::move(node->values[i]));
+      }
+    }
+    clear();
+    bulkLoad(std::make_move_iterator(kept.begin()), kept.size());
+    return lastIsEnd ? end() : lower_bound(stop);
+  }
+
+  // Removes every element for which pred(std::pair<const Key&, T&>) holds.
+  template <typename Predicate>
+  friend size_t erase_if(BTreeMap& map, Predicate pred) {
+    std::vector<value_type> kept;
+    kept.reserve(map.size());
+    for (Leaf* leaf = map.mFirst; leaf; leaf = leaf->next) {
+      for (size_t i = 0; i < leaf->count; ++i) {
+        if (pred(reference(leaf->keys[i], leaf->values[i]))) continue;
+        kept.emplace_back(std::move(leaf->keys[i]),
+                          std::move(leaf->values[i]));
+      }
+    }
+    size_t removed = map.size() - kept.size();
+    if (removed == 0) return 0;
+    map.clear();
+    map.bulkLoad(std::make_move_iterator(kept.begin()), kept.size());
+    return removed;
+  }
+
+  void clear() noexcept {
+    if (mRoot) freeNode(mRoot, mHeight);
+    mRoot = nullptr;
+    mFirst = mLast = nullptr;
+    mHeight = 0;
+    mSize = 0;
+  }
+
+  void swap(BTreeMap& other) noexcept {
+    using std::swap;
+    swap(mRoot, other.mRoot);
+    swap(mFirst, other.mFirst);
+    swap(mLast, other.mLast);
+    swap(mHeight, other.mHeight);
+    swap(mSize, other.mSize);
+    swap(mComp, other.mComp);
+    if constexpr (LeafTraits::propagate_on_container_swap::value) {
+      swap(mLeafAlloc, other.mLeafAlloc);
+      swap(mInnerAlloc, other.mInnerAlloc);
+    }
+  }
+
+  friend bool operator==(const BTreeMap& a, const BTreeMap& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(),
+                      [](const auto& x, const auto& y) {
+                        return x.first == y.first && x.second == y.second;
+                      });
+  }
+
+ private:
+  static constexpr size_t minCount = nodeCapacity / 2;
+  // Enough for any size_t element count with nodes at least half full.
+  static constexpr size_t maxHeight = 64;
+
+  // The arrays have one spare entry: a node takes the extra element first
+  // and is split right after.
+  struct Node {
+    size_t count = 0;
+  };
+
+  struct Leaf : Node {
+    Leaf* prev = nullptr;
+    Leaf* next = nullptr;
+    alignas(64) Key keys[nodeCapacity + 1]{};
+    T values[nodeCapacity + 1]{};
+  };
+
+  struct Inner : Node {
+    alignas(64) Key keys[nodeCapacity + 1]{};
+    Node* children[nodeCapacity + 2]{};
+  };
+
+  using LeafAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Leaf>;
+  using InnerAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Inner>;
+  using LeafTraits = std::allocator_traits<LeafAllocator>;
+  using InnerTraits = std::allocator_traits<InnerAllocator>;
+
+  // The inner nodes visited from the root, and the child taken in each;
+  // index 1 is the parent of the leaf, mHeight the root.
+  struct Path {
+    Inner* nodes[maxHeight + 1];
+    size_t slots[maxHeight + 1];
+  };
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = std::pair<Key, T>;
+    using difference_type = ptrdiff_t;
+    using reference =
+        std::pair<const Key&, std::conditional_t<Const, const T&, T&>>;
+    // The same arrow proxy as FlatMap's iterator (flat_map.h).
+    struct pointer {
+      reference ref;
+      const reference* operator->() const { return &ref; }
+    };
+
+    Iterator() = default;
+    Iterator(Leaf* leaf, size_t index) : mLeaf(leaf), mIndex(index) {}
+    template <bool OtherConst>
+      requires(Const && !OtherConst)
+    Iterator(const Iterator<OtherConst>& other)
+        : mLeaf(other.mLeaf), mIndex(other.mIndex) {}
+
+    reference operator*() const {
+      return {mLeaf->keys[mIndex], mLeaf->values[mIndex]};
+    }
+    pointer operator->() const { return {**this}; }
+
+    // The end iterator is one past the last element of the last leaf.
+    Iterator& operator++() {
+      if (++mIndex == mLeaf->count && mLeaf->next) {
+        mLeaf = mLeaf->next;
+        mIndex = 0;
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+    Iterator& operator--() {
+      if (mIndex == 0) {
+        mLeaf = mLeaf->prev;
+        mIndex = mLeaf->count;
+      }
+      --mIndex;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.mLeaf == b.mLeaf && a.mIndex == b.mIndex;
+    }
+
+   private:
+    friend class BTreeMap;
+    friend class Iterator<!Const>;
+
+    Leaf* mLeaf = nullptr;
+    size_t mIndex = 0;
+  };
+
+  // True when keys can be compared as signed integers in vector registers.
+  static constexpr bool simdKeys =
+      std::is_integral_v<Key> && std::is_signed_v<Key> &&
+      (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+      (std::is_same_v<Compare, std::less<Key>> ||
+       std::is_same_v<Compare, std::less<>>);
+
+  // Counts the keys smaller than key. The keys are sorted, so the scan
+  // stops at the first vector that is not entirely smaller.
+  static size_t countLess(const Key* keys, size_t count, Key key) {
+#if defined(__AVX512F__)
+    if constexpr (sizeof(Key) == 4) {
+      __m512i needle = _mm512_set1_epi32(key);
+      for (size_t i = 0; i < count; i += 16) {
+        uint32_t less = _mm512_cmplt_epi32_mask(
+            _mm512_loadu_si512(keys + i), needle);
+        if (count - i < 16) less &= (1u << (count - i)) - 1;
+        size_t n = static_cast<size_t>(std::popcount(less));
+        if (n < 16) return i + n;
+      }
+      return count;
+    } else {
+      __m512i needle = _mm512_set1_epi64(key);
+      for (size_t i = 0; i < count; i += 8) {
+        uint32_t less = _mm512_cmplt_epi64_mask(
+            _mm512_loadu_si512(keys + i), needle);
+        if (count - i < 8) less &= (1u << (count - i)) - 1;
+        size_t n = static_cast<size_t>(std::popcount(less));
+        if (n < 8) return i + n;
+      }
+      return count;
+    }
+#elif defined(__AVX2__)
+    if constexpr (sizeof(Key) == 4) {
+      __m256i needle = _mm256_set1_epi32(key);
+      for (size_t i = 0; i < count; i += 8) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        uint32_t less = static_cast<uint32_t>(_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpgt_epi32(needle, block))));
+        if (count - i < 8) less &= (1u << (count - i)) - 1;
+        size_t n = static_cast<size_t>(std::popcount(less));
+        if (n < 8) return i + n;
+      }
+      return count;
+    } else {
+      __m256i needle = _mm256_set1_epi64x(key);
+      for (size_t i = 0; i < count; i += 4) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        uint32_t less = static_cast<uint32_t>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(needle, block))));
+        if (count - i < 4) less &= (1u << (count - i)) - 1;
+        size_t n = static_cast<size_t>(std::popcount(less));
+        if (n < 4) return i + n;
+      }
+      return count;
+    }
+#elif defined(__SSE2__)
+    if constexpr (sizeof(Key) == 4) {
+      __m128i needle = _mm_set1_epi32(key);
+      for (size_t i = 0; i < count; i += 4) {
+        __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        uint32_t less = static_cast<uint32_t>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(block, needle))));
+        if (count - i < 4) less &= (1u << (count - i)) - 1;
+        size_t n = static_cast<size_t>(std::popcount(less));
+        if (n < 4) return i + n;
+      }
+      return count;
+    } else {
+      return static_cast<size_t>(std::lower_bound(keys, keys + count, key) -
+                                 keys);
+    }
+#else
+    return static_cast<size_t>(std::lower_bound(keys, keys + count, key) -
+                               keys);
+#endif
+  }
+
+  // Index of the first key not less than key.
+  size_t lowerIndex(const Key* keys, size_t count, const Key& key) const {
+    if constexpr (simdKeys) {
+      return countLess(keys, count, key);
+    } else {
+      return static_cast<size_t>(
+          std::lower_bound(keys, keys + count, key, mComp) - keys);
+    }
+  }
+
+  // Index of the first key greater than key.
+  size_t upperIndex(const Key* keys, size_t count, const Key& key) const {
+    if constexpr (simdKeys) {
+      if (key == std::numeric_limits<Key>::max()) return count;
+      return countLess(keys, count, static_cast<Key>(key + 1));
+    } else {
+      return static_cast<size_t>(
+          std::upper_bound(keys, keys + count, key, mComp) - keys);
+    }
+  }
+
+  // Inner keys are the smallest keys of the subtrees to their right, so
+  // the child to follow is the one after the last key not greater than
+  // key.
+  template <typename K>
+  Leaf* findLeaf(const K& key, Path* path = nullptr) const {
+    Node* node = mRoot;
+    for (size_t level = mHeight; level > 0; --level) {
+      Inner* inner = static_cast<Inner*>(node);
+      size_t slot = upperIndex(inner->keys, inner->count, key);
+      if (path) {
+        path->nodes[level] = inner;
+        path->slots[level] = slot;
+      }
+      node = inner->children[slot];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  const_iterator findConst(const Key& key) const {
+    if (!mRoot) return end();
+    Leaf* leaf = findLeaf(key);
+    size_t index = lowerIndex(leaf->keys, leaf->count, key);
+    if (index == leaf->count || mComp(key, leaf->keys[index])) return end();
+    return {leaf, index};
+  }
+
+  // Position index == leaf->count means the first element of the next
+  // leaf, or end() in the last leaf.
+  static const_iterator normalize(Leaf* leaf, size_t index) {
+    if (index == leaf->count && leaf->next) return {leaf->next, 0};
+    return {leaf, index};
+  }
+
+  static iterator toMutable(const_iterator it) {
+    return {it.mLeaf, it.mIndex};
+  }
+
+  Leaf* newLeaf() {
+    Leaf* leaf = LeafTraits::allocate(mLeafAlloc, 1);
+    LeafTraits::construct(mLeafAlloc, leaf);
+    return leaf;
+  }
+
+  Inner* newInner() {
+    Inner* inner = InnerTraits::allocate(mInnerAlloc, 1);
+    InnerTraits::construct(mInnerAlloc, inner);
+    return inner;
+  }
+
+  void deleteLeaf(Leaf* leaf) {
+    LeafTraits::destroy(mLeafAlloc, leaf);
+    LeafTraits::deallocate(mLeafAlloc, leaf, 1);
+  }
+
+  void deleteInner(Inner* inner) {
+    InnerTraits::destroy(mInnerAlloc, inner);
+    InnerTraits::deallocate(mInnerAlloc, inner, 1);
+  }
+
+  void freeNode(Node* node, size_t level) {
+    if (level == 0) {
+      deleteLeaf(static_cast<Leaf*>(node));
+      return;
+    }
+    Inner* inner = static_cast<Inner*>(node);
+    for (size_t i = 0; i <= inner->count; ++i)
+      freeNode(inner->children[i], level - 1);
+    deleteInner(inner);
+  }
+
+  void steal(BTreeMap& other) noexcept {
+    mRoot = std::exchange(other.mRoot, nullptr);
+    mFirst = std::exchange(other.mFirst, nullptr);
+    mLast = std::exchange(other.mLast, nullptr);
+    mHeight = std::exchange(other.mHeight, 0);
+    mSize = std::exchange(other.mSize, 0);
+  }
+
+  // Splits a leaf holding nodeCapacity + 1 elements in two and returns
+  // the new position of the element at index.
+  iterator splitLeaf(Path& path, Leaf* leaf, size_t index) {
+    Leaf* right = newLeaf();
+    size_t leftCount = leaf->count / 2;
+    std::move(leaf->keys + leftCount, leaf->keys + leaf->count, right->keys);
+    std::move(leaf->values + leftCount, leaf->values + leaf->count,
+              right->values);
+    right->count = leaf->count - leftCount;
+    leaf->count = leftCount;
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+      leaf->next->prev = right;
+    else
+      mLast = right;
+    leaf->next = right;
+    insertIntoParent(path, Key(right->keys[0]), right);
+    if (index < leftCount) return {leaf, index};
+    return {right, index - leftCount};
+  }
+
+  // Adds separator and the node to its right to the parent of the node
+  // that was split, splitting inner nodes up to the root as needed.
+  void insertIntoParent(Path& path, Key separator, Node* right) {
+    for (size_t level = 1;; ++level) {
+      if (level > mHeight) {
+        Inner* root = newInner();
+        root->keys[0] = std::move(separator);
+        root->children[0] = mRoot;
+        root->children[1] = right;
+        root->count = 1;
+        mRoot = root;
+        ++mHeight;
+        return;
+      }
+      Inner* inner = path.nodes[level];
+      size_t slot = path.slots[level];
+      std::move_backward(inner->keys + slot, inner->keys + inner->count,
+                         inner->keys + inner->count + 1);
+      std::move_backward(inner->children + slot + 1,
+                         inner->children + inner->count + 1,
+                         inner->children + inner->count + 2);
+      inner->keys[slot] = std::move(separator);
+      inner->children[slot + 1] = right;
+      if (++inner->count <= nodeCapacity) return;
+
+      // The middle key moves up; the halves keep the keys on either side.
+      Inner* sibling = newInner();
+      size_t mid = inner->count / 2;
+      separator = std::move(inner->keys[mid]);
+      std::move(inner->keys + mid + 1, inner->keys + inner->count,
+                sibling->keys);
+      std::copy(inner->children + mid + 1,
+                inner->children + inner->count + 1, sibling->children);
+      sibling->count = inner->count - mid - 1;
+      inner->count = mid;
+      right = sibling;
+    }
+  }
+
+  void removeFromLeaf(Leaf* leaf, size_t index, size_t count) {
+    std::move(leaf->keys + index + count, leaf->keys + leaf->count,
+              leaf->keys + index);
+    std::move(leaf->values + index + count, leaf->values + leaf->count,
+              leaf->values + index);
+    leaf->count -= count;
+    mSize -= count;
+  }
+
+  // Removes key index and child index + 1 from an inner node.
+  static void removeFromInner(Inner* inner, size_t index) {
+    std::move(inner->keys + index + 1, inner->keys + inner->count,
+              inner->keys + index);
+    std::copy(inner->children + index + 2,
+              inner->children + inner->count + 1,
+              inner->children + index + 1);
+    --inner->count;
+  }
+
+  // Restores the minimum fill after an erase from leaf: borrow an element
+  // from a sibling that can spare one, otherwise merge with it and repeat
+  // one level up.
+  void rebalance(Path& path, Leaf* leaf) {
+    if (mHeight == 0 || leaf->count >= minCount) return;
+    Inner* parent = path.nodes[1];
+    size_t slot = path.slots[1];
+    Leaf* left = slot > 0 ? static_cast<Leaf*>(parent->children[slot - 1])
+                          : nullptr;
+    Leaf* right = slot < parent->count
+                      ? static_cast<Leaf*>(parent->children[slot + 1])
+                      : nullptr;
+    if (left && left->count > minCount) {
+      std::move_backward(leaf->keys, leaf->keys + leaf->count,
+                         leaf->keys + leaf->count + 1);
+      std::move_backward(leaf->values, leaf->values + leaf->count,
+                         leaf->values + leaf->count + 1);
+      leaf->keys[0] = std::move(left->keys[left->count - 1]);
+      leaf->values[0] = std::move(left->values[left->count - 1]);
+      --left->count;
+      ++leaf->count;
+      parent->keys[slot - 1] = leaf->keys[0];
+      return;
+    }
+    if (right && right->count > minCount) {
+      leaf->keys[leaf->count] = std::move(right->keys[0]);
+      leaf->values[leaf->count] = std::move(right->values[0]);
+      ++leaf->count;
+      std::move(right->keys + 1, right->keys + right->count, right->keys);
+      std::move(right->values + 1, right->values + right->count,
+                right->values);
+      --right->count;
+      parent->keys[slot] = right->keys[0];
+      return;
+    }
+    // Merge the right one of the pair into the left one.
+    if (!left) {
+      left = leaf;
+      ++slot;
+    } else {
+      right = leaf;
+    }
+    std::move(right->keys, right->keys + right->count,
+              left->keys + left->count);
+    std::move(right->values, right->values + right->count,
+              left->values + left->count);
+    left->count += right->count;
+    left->next = right->next;
+    if (right->next)
+      right->next->prev = left;
+    else
+      mLast = left;
+    deleteLeaf(right);
+    removeFromInner(parent, slot - 1);
+    rebalanceInner(path, 1);
+  }
+
+  void rebalanceInner(Path& path, size_t level) {
+    for (;; ++level) {
+      Inner* node = path.nodes[level];
+      if (level == mHeight) {
+        if (node->count == 0) {
+          mRoot = node->children[0];
+          deleteInner(node);
+          --mHeight;
+        }
+        return;
+      }
+      if (node->count >= minCount) return;
+      Inner* parent = path.nodes[level + 1];
+      size_t slot = path.slots[level + 1];
+      Inner* left = slot > 0 ? static_cast<Inner*>(parent->children[slot - 1])
+                             : nullptr;
+      Inner* right = slot < parent->count
+                         ? static_cast<Inner*>(parent->children[slot + 1])
+                         : nullptr;
+      if (left && left->count > minCount) {
+        // Rotate right through the parent.
+        std::move_backward(node->keys, node->keys + node->count,
+                           node->keys + node->count + 1);
+        std::copy_backward(node->children, node->children + node->count + 1,
+                           node->children + node->count + 2);
+        node->keys[0] = std::move(parent->keys[slot - 1]);
+        node->children[0] = left->children[left->count];
+        parent->keys[slot - 1] = std::move(left->keys[left->count - 1]);
+        --left->count;
+        ++node->count;
+        return;
+      }
+      if (right && right->count > minCount) {
+        // Rotate left through the parent.
+        node->keys[node->count] = std::move(parent->keys[slot]);
+        node->children[node->count + 1] = right->children[0];
+        parent->keys[slot] = std::move(right->keys[0]);
+        std::move(right->keys + 1, right->keys + right->count, right->keys);
+        std::copy(right->children + 1, right->children + right->count + 1,
+                  right->children);
+        --right->count;
+        ++node->count;
+        return;
+      }
+      // Merge the right node, with the separator between them, into the
+      // left one.
+      if (!left) {
+        left = node;
+        ++slot;
+      } else {
+        right = node;
+      }
+      left->keys[left->count] = std::move(parent->keys[slot - 1]);
+      std::move(right->keys, right->keys + right->count,
+                left->keys + left->count + 1);
+      std::copy(right->children, right->children + right->count + 1,
+                left->children + left->count + 1);
+      left->count += right->count + 1;
+      deleteInner(right);
+      removeFromInner(parent, slot - 1);
+    }
+  }
+
+  // Spreads count items over as few nodes of at most capacity items as
+  // possible, as evenly as possible; returns the size of node i.
+  static size_t evenShare(size_t count, size_t nodes, size_t i) {
+    return count / nodes + (i < count % nodes);
+  }
+
+  // Builds the tree bottom-up from count sorted, unique elements, each
+  // dereferencing to a key/value pair. The tree must be empty.
+  template <typename ForwardIt>
+  void bulkLoad(ForwardIt first, size_t count) {
+    if (count == 0) return;
+    size_t numLeaves = (count + nodeCapacity - 1) / nodeCapacity;
+    std::vector<Node*> level;
+    std::vector<Key> smallest;
+    level.reserve(numLeaves);
+    smallest.reserve(numLeaves);
+    Leaf* prev = nullptr;
+    for (size_t i = 0; i < numLeaves; ++i) {
+      Leaf* leaf = newLeaf();
+      leaf->count = evenShare(count, numLeaves, i);
+      for (size_t j = 0; j < leaf->count; ++j, ++first) {
+        auto&& [key, value] = *first;
+        leaf->keys[j] = std::forward<decltype(key)>(key);
+        leaf->values[j] = std::forward<decltype(value)>(value);
+      }
+      leaf->prev = prev;
+      if (prev)
+        prev->next = leaf;
+      else
+        mFirst = leaf;
+      prev = leaf;
+      level.push_back(leaf);
+      smallest.push_back(leaf->keys[0]);
+    }
+    mLast = prev;
+    mSize = count;
+
+    // Each pass groups up to nodeCapacity + 1 nodes under a new parent.
+    while (level.size() > 1) {
+      size_t numParents = (level.size() + nodeCapacity) / (nodeCapacity + 1);
+      std::vector<Node*> parents;
+      std::vector<Key> parentSmallest;
+      size_t child = 0;
+      for (size_t i = 0; i < numParents; ++i) {
+        Inner* inner = newInner();
+        size_t children = evenShare(level.size(), numParents, i);
+        parentSmallest.push_back(std::move(smallest[child]));
+        inner->children[0] = level[child++];
+        for (size_t j = 1; j < children; ++j, ++child) {
+          inner->keys[j - 1] = std::move(smallest[child]);
+          inner->children[j] = level[child];
+        }
+        inner->count = children - 1;
+        parents.push_back(inner);
+      }
+      level = std::move(parents);
+      smallest = std::move(parentSmallest);
+      ++mHeight;
+    }
+    mRoot = level[0];
+  }
+
+  Node* mRoot = nullptr;
+  Leaf* mFirst = nullptr;
+  Leaf* mLast = nullptr;
+  size_t mHeight = 0;
+  size_t mSize = 0;
+  [[no_unique_address]] Compare mComp;
+  [[no_unique_address]] LeafAllocator mLeafAlloc;
+  [[no_unique_address]] InnerAllocator mInnerAlloc;
+};
+
+#endif  // BTREE_MAP_H
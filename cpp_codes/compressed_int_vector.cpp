@@ -0,0 +1,520 @@
+/* This file implements CompressedIntVector, an append-only int container that
+ * stores most columns in a fraction of the 4 bytes per element a
+ * std::vector<int> needs. Scans decode block by block into a buffer that
+ * stays in L1, so they read less memory than the uncompressed vector.
+ *
+ * 1. Bit packing in 128-element blocks
+ *    Each block stores its values minus a base, using just enough bits for
+ *    the largest difference. The layout is the "vertical" one from SIMD-BP128:
+ *    value j goes to 32-bit lane j % 4, so one SSE2 shift/mask step
+ *    unpacks four consecutive values at once.
+ *    1.1. Frame of reference: base = block minimum, stores value - base
+ *    1.2. Delta: base = first value, stores value - previous value. Sorted
+ *         data gets small deltas; decoding adds a SIMD prefix sum.
+ *    Every block uses whichever of the two needs fewer bits.
+ * 2. CompressedIntVector
+ *    2.1. Block directory: base, bit width, encoding and word offset per
+ *         block, so operator[] finds its block in O(1)
+ *    2.2. push_back() buffers a raw tail and packs it once 128 values arrive
+ *    2.3. Decode-on-scan operators matching std::accumulate(),
+ *         std::count_if(), std::find() and std::lower_bound()
+ * 3. Examples
+ * 4. Benchmark: footprint and scan speed against std::vector<int>
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native compressed_int_vector.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 1. Bit packing in 128-element blocks
+constexpr size_t blockSize = 128;
+constexpr size_t lanes = 4;
+
+// Number of bits needed to store x (0 for x == 0).
+inline uint32_t bitWidth(uint32_t x) {
+  return static_cast<uint32_t>(std::bit_width(x));
+}
+
+// A block packed with `bits` bits per value takes exactly 4 * bits words.
+// Value j sits in lane j % 4 at bit (j / 4) * bits of that lane's stream;
+// lane streams are interleaved word by word.
+void packBlock(const uint32_t* in, uint32_t bits, uint32_t* out) {
+  std::fill(out, out + lanes * bits, 0u);
+  if (bits == 0) return;
+  for (size_t j = 0; j < blockSize; ++j) {
+    size_t lane = j % lanes, bitPos = (j / lanes) * bits;
+    size_t word = bitPos / 32, shift = bitPos % 32;
+    out[word * lanes + lane] |= in[j] << shift;
+    if (shift + bits > 32)
+      out[(word + 1) * lanes + lane] |= in[j] >> (32 - shift);
+  }
+}
+
+// Extracts value j without unpacking the rest of the block.
+inline uint32_t unpackOne(const uint32_t* in, uint32_t bits, size_t j) {
+  if (bits == 0) return 0;
+  size_t lane = j % lanes, bitPos = (j / lanes) * bits;
+  size_t word = bitPos / 32, shift = bitPos % 32;
+  uint64_t value = in[word * lanes + lane] >> shift;
+  if (shift + bits > 32)
+    value |= static_cast<uint64_t>(in[(word + 1) * lanes + lane])
+             << (32 - shift);
+  return static_cast<uint32_t>(value & ((uint64_t{1} << bits) - 1));
+}
+
+#if defined(__SSE2__)
+// Step K unpacks values 4K .. 4K+3. Bits and K are template parameters, so
+// every word index and shift below is a compile-time constant.
+template <uint32_t Bits, size_t K>
+inline void unpackStep(const uint32_t* in, uint32_t* out) {
+  constexpr size_t bitPos = K * Bits;
+  constexpr size_t word = bitPos / 32, shift = bitPos % 32;
+  auto load = [&](size_t w) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + w * lanes));
+  };
+  __m128i v = _mm_srli_epi32(load(word), shift);
+  if constexpr (shift + Bits > 32)
+    v = _mm_or_si128(v, _mm_slli_epi32(load(word + 1), 32 - shift));
+  if constexpr (Bits < 32)
+    v = _mm_and_si128(v, _mm_set1_epi32((1u << Bits) - 1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + K * lanes), v);
+}
+
+template <uint32_t Bits, size_t... K>
+void unpackSteps(const uint32_t* in, uint32_t* out, std::index_sequence<K...>) {
+  (unpackStep<Bits, K>(in, out), ...);
+}
+
+template <uint32_t Bits>
+void unpackBlockFixed(const uint32_t* in, uint32_t* out) {
+  if constexpr (Bits == 0) {
+    std::fill(out, out + blockSize, 0u);
+  } else {
+    unpackSteps<Bits>(in, out, std::make_index_sequence<blockSize / lanes>());
+  }
+}
+#else
+template <uint32_t Bits>
+void unpackBlockFixed(const uint32_t* in, uint32_t* out) {
+  for (size_t j = 0; j < blockSize; ++j) out[j] = unpackOne(in, Bits, j);
+}
+#endif
+
+using UnpackFunction = void (*)(const uint32_t*, uint32_t*);
+
+template <size_t... Bits>
+constexpr std::array<UnpackFunction, sizeof...(Bits)> makeUnpackTable(
+    std::index_sequence<Bits...>) {
+  return {&unpackBlockFixed<static_cast<uint32_t>(Bits)>...};
+}
+
+// One specialized unpacker per bit width 0..32.
+constexpr auto unpackTable = makeUnpackTable(std::make_index_sequence<33>());
+
+// 1.1. Frame of reference: out[j] += base
+void addBase(uint32_t* values, uint32_t base) {
+#if defined(__SSE2__)
+  const __m128i b = _mm_set1_epi32(static_cast<int>(base));
+  for (size_t j = 0; j < blockSize; j += lanes) {
+    __m128i* p = reinterpret_cast<__m128i*>(values + j);
+    _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), b));
+  }
+#else
+  for (size_t j = 0; j < blockSize; ++j) values[j] += base;
+#endif
+}
+
+// 1.2. Delta: out[j] = base + in[0] + ... + in[j]
+void prefixSum(uint32_t* values, uint32_t base) {
+#if defined(__SSE2__)
+  __m128i carry = _mm_set1_epi32(static_cast<int>(base));
+  for (size_t j = 0; j < blockSize; j += lanes) {
+    __m128i* p = reinterpret_cast<__m128i*>(values + j);
+    __m128i v = _mm_loadu_si128(p);
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi32(v, carry);
+    _mm_storeu_si128(p, v);
+    carry = _mm_shuffle_epi32(v, 0xFF);
+  }
+#else
+  uint32_t sum = base;
+  for (size_t j = 0; j < blockSize; ++j) values[j] = sum += values[j];
+#endif
+}
+
+// 2. CompressedIntVector
+class CompressedIntVector {
+ public:
+  CompressedIntVector() = default;
+
+  explicit CompressedIntVector(const std::vector<int>& values) {
+    for (int x : values) push_back(x);
+    shrink_to_fit();
+  }
+
+  // 2.2. push_back()
+  void push_back(int value) {
+    mSorted = mSorted && (mSize == 0 || value >= mLast);
+    mLast = value;
+    mTail.push_back(value);
+    ++mSize;
+    if (mTail.size() == blockSize) flushTail();
+  }
+
+  // Releases the slack that geometric growth of the word array leaves.
+  void shrink_to_fit() {
+    mWords.shrink_to_fit();
+    mBlocks.shrink_to_fit();
+    mTail.shrink_to_fit();
+  }
+
+  size_t size() const { return mSize; }
+  bool empty() const { return mSize == 0; }
+  // Non-decreasing data also enables lowerBound() and the find() shortcut.
+  bool isSorted() const { return mSorted; }
+  size_t numBlocks() const { return mBlocks.size(); }
+
+  size_t memoryBytes() const {
+    return mWords.capacity() * sizeof(uint32_t) +
+           mBlocks.capacity() * sizeof(BlockInfo) +
+           mTail.capacity() * sizeof(int);
+  }
+
+  // Frame-of-reference elements are extracted in place; a delta-encoded
+  // element needs the prefix sum of its block, so the block is decoded.
+  int operator[](size_t index) const {
+    size_t block = index / blockSize, j = index % blockSize;
+    if (block == mBlocks.size()) return mTail[j];
+    const BlockInfo& info = mBlocks[block];
+    if (!info.delta) {
+      const uint32_t* words = mWords.data() + info.wordOffset;
+      return static_cast<int>(info.base + unpackOne(words, info.bits, j));
+    }
+    std::array<int, blockSize> buffer;
+    decodeBlock(block, buffer.data());
+    return buffer[j];
+  }
+
+  int at(size_t index) const {
+    if (index >= mSize) throw std::out_of_range("CompressedIntVector::at");
+    return (*this)[index];
+  }
+
+  // Writes the values of block `block` (the tail counts as the last block)
+  // to out and returns how many there are.
+  size_t decodeBlock(size_t block, int* out) const {
+    if (block == mBlocks.size()) {
+      std::copy(mTail.begin(), mTail.end(), out);
+      return mTail.size();
+    }
+    const BlockInfo& info = mBlocks[block];
+    uint32_t* values = reinterpret_cast<uint32_t*>(out);
+    unpackTable[info.bits](mWords.data() + info.wordOffset, values);
+    if (info.delta) {
+      prefixSum(values, info.base);
+    } else {
+      addBase(values, info.base);
+    }
+    return blockSize;
+  }
+
+  std::vector<int> decode() const {
+    std::vector<int> result(mBlocks.size() * blockSize + mTail.size());
+    for (size_t block = 0; block <= mBlocks.size(); ++block)
+      decodeBlock(block, result.data() + block * blockSize);
+    return result;
+  }
+
+  // Calls f(values, count) for every block in order.
+  template <typename Function>
+  void forEachBlock(Function f) const {
+    alignas(16) std::array<int, blockSize> buffer;
+    for (size_t block = 0; block <= mBlocks.size(); ++block)
+      f(buffer.data(), decodeBlock(block, buffer.data()));
+  }
+
+  // 2.3. Scan operators
+  long long accumulate(long long init = 0) const {
+    forEachBlock([&](const int* values, size_t count) {
+      // A constant trip count lets the compiler vectorize full blocks.
+      if (count == blockSize) {
+        init = std::accumulate(values, values + blockSize, init);
+      } else {
+        init = std::accumulate(values, values + count, init);
+      }
+    });
+    return init;
+  }
+
+  template <typename Predicate>
+  size_t countIf(Predicate pred) const {
+    size_t count = 0;
+    forEachBlock([&](const int* values, size_t n) {
+      if (n == blockSize) {
+        for (size_t j = 0; j < blockSize; ++j) count += pred(values[j]);
+      } else {
+        count += static_cast<size_t>(std::count_if(values, values + n, pred));
+      }
+    });
+    return count;
+  }
+
+  // Index of the first element equal to value, or size(). A frame-of-
+  // reference block whose [base, base + 2^bits) range excludes value is
+  // skipped without decoding it.
+  size_t find(int value) const {
+    if (mSorted) {
+      size_t index = lowerBound(value);
+      return index < mSize && (*this)[index] == value ? index : mSize;
+    }
+    alignas(16) std::array<int, blockSize> buffer;
+    for (size_t block = 0; block <= mBlocks.size(); ++block) {
+      if (block < mBlocks.size() && !mayContain(mBlocks[block], value))
+        continue;
+      size_t count = decodeBlock(block, buffer.data());
+      const int* it = std::find(buffer.data(), buffer.data() + count, value);
+      if (it != buffer.data() + count)
+        return block * blockSize + static_cast<size_t>(it - buffer.data());
+    }
+    return mSize;
+  }
+
+  // Index of the first element >= value; requires isSorted(). Binary search
+  // over the block directory (a block's base is its first value when the
+  // data is sorted), then inside one decoded block.
+  size_t lowerBound(int value) const {
+    if (!mSorted)
+      throw std::logic_error("CompressedIntVector::lowerBound: not sorted");
+    auto it = std::partition_point(
+        mBlocks.begin(), mBlocks.end(), [&](const BlockInfo& info) {
+          return static_cast<int>(info.base) < value;
+        });
+    // Block before `it` may still hold elements < value; start there.
+    size_t block = it == mBlocks.begin()
+                       ? 0
+                       : static_cast<size_t>(it - mBlocks.begin()) - 1;
+    alignas(16) std::array<int, blockSize> buffer;
+    for (; block <= mBlocks.size(); ++block) {
+      size_t count = decodeBlock(block, buffer.data());
+      const int* pos =
+          std::lower_bound(buffer.data(), buffer.data() + count, value);
+      if (pos != buffer.data() + count)
+        return block * blockSize + static_cast<size_t>(pos - buffer.data());
+    }
+    return mSize;
+  }
+
+ private:
+  // 2.1. Block directory
+  struct BlockInfo {
+    uint64_t wordOffset;
+    uint32_t base;  // Minimum (frame of reference) or first value (delta)
+    uint8_t bits;
+    bool delta;
+  };
+
+  static bool mayContain(const BlockInfo& info, int value) {
+    if (info.delta || info.bits == 32) return true;
+    uint32_t offset = static_cast<uint32_t>(value) - info.base;
+    return offset < (uint32_t{1} << info.bits);
+  }
+
+  // Packs the 128 buffered values with the cheaper of the two encodings.
+  // All arithmetic is modulo 2^32, so negative values need no special case.
+  void flushTail() {
+    std::array<uint32_t, blockSize> raw, forValues, deltaValues;
+    for (size_t j = 0; j < blockSize; ++j)
+      raw[j] = static_cast<uint32_t>(mTail[j]);
+
+    int minimum = *std::min_element(mTail.begin(), mTail.end());
+    uint32_t forBits = 0, deltaBits = 0;
+    for (size_t j = 0; j < blockSize; ++j) {
+      forValues[j] = raw[j] - static_cast<uint32_t>(minimum);
+      deltaValues[j] = j == 0 ? 0 : raw[j] - raw[j - 1];
+      forBits = std::max(forBits, bitWidth(forValues[j]));
+      deltaBits = std::max(deltaBits, bitWidth(deltaValues[j]));
+    }
+
+    BlockInfo info{mWords.size(), 0, 0, deltaBits < forBits};
+    const uint32_t* values = info.delta ? deltaValues.data() : forValues.data();
+    info.bits = static_cast<uint8_t>(info.delta ? deltaBits : forBits);
+    info.base = info.delta ? raw[0] : static_cast<uint32_t>(minimum);
+    mWords.resize(mWords.size() + lanes * info.bits);
+    packBlock(values, info.bits, mWords.data() + info.wordOffset);
+    mBlocks.push_back(info);
+    mTail.clear();
+  }
+
+  std::vector<uint32_t> mWords;
+  std::vector<BlockInfo> mBlocks;
+  std::vector<int> mTail;  // Fewer than 128 not yet packed values
+  size_t mSize = 0;
+  int mLast = 0;
+  bool mSorted = true;
+};
+
+// 3. Examples
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void compressedExamples() {
+  std::vector<int> sorted(1000);
+  for (size_t i = 0; i < sorted.size(); ++i)
+    sorted[i] = 1'000'000 + static_cast<int>(3 * i + i % 2);
+  CompressedIntVector vec(sorted);
+
+  std::cout << "3.1. Compressing 1000 sorted values" << std::endl;
+  std::cout << "Blocks: " << vec.numBlocks() << ", bytes: " << vec.memoryBytes()
+            << " instead of " << sorted.size() * sizeof(int) << std::endl;
+  std::cout << "vec[0] = " << vec[0] << ", vec[500] = " << vec[500]
+            << ", vec[999] = " << vec[999] << std::endl;
+
+  std::cout << std::endl << "3.2. Scan operators" << std::endl;
+  std::cout << "accumulate(): " << vec.accumulate() << " (std: "
+            << std::accumulate(sorted.begin(), sorted.end(), 0LL) << ")"
+            << std::endl;
+  std::cout << "countIf(odd): "
+            << vec.countIf([](int x) { return x % 2 != 0; }) << std::endl;
+  std::cout << "find(1001500): " << vec.find(1'001'500)
+            << ", lowerBound(1001500): " << vec.lowerBound(1'001'500)
+            << std::endl;
+
+  std::cout << std::endl << "3.3. Negative and unsorted values" << std::endl;
+  std::vector<int> mixed{-5, 17, 3, -2, 0, 8, -100, 42};
+  CompressedIntVector vec2(mixed);
+  printVector("Decoded vector", vec2.decode());
+  std::cout << "find(-2): " << vec2.find(-2) << std::endl;
+}
+
+bool checkAgainstStd() {
+  std::mt19937 gen(11);
+  bool ok = true;
+  for (int round = 0; round < 20; ++round) {
+    size_t size = gen() % 2000;
+    int range = 1 << (gen() % 31);
+    std::uniform_int_distribution<int> dist(-range, range);
+    std::vector<int> values(size);
+    for (int& x : values) x = dist(gen);
+    if (round % 2 == 0) std::sort(values.begin(), values.end());
+
+    CompressedIntVector vec(values);
+    ok = ok && vec.decode() == values;
+    for (size_t i = 0; i < size; i += 7) ok = ok && vec[i] == values[i];
+    ok = ok && vec.accumulate() ==
+                   std::accumulate(values.begin(), values.end(), 0LL);
+    int probe = dist(gen);
+    if (size > 0 && round % 3 == 0) probe = values[size / 2];
+    auto it = std::find(values.begin(), values.end(), probe);
+    ok = ok && vec.find(probe) == static_cast<size_t>(it - values.begin());
+    if (vec.isSorted()) {
+      auto lb = std::lower_bound(values.begin(), values.end(), probe);
+      ok = ok &&
+           vec.lowerBound(probe) == static_cast<size_t>(lb - values.begin());
+    }
+  }
+  return ok;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmarkColumn(const std::string& name, const std::vector<int>& column) {
+  CompressedIntVector vec(column);
+  const int threshold = column[column.size() / 3];
+  const int probe = column[column.size() - 5];
+
+  std::cout << name << ": " << column.size() * sizeof(int) / (1 << 20)
+            << " MiB -> " << vec.memoryBytes() / (1 << 20) << " MiB ("
+            << static_cast<double>(column.size() * sizeof(int)) /
+                   vec.memoryBytes()
+            << "x)" << std::endl;
+
+  long long stdSum = 0, sum = 0;
+  size_t stdCount = 0, count = 0, stdFound = 0, found = 0;
+  double tStdSum = measureMilliseconds(
+      [&] { stdSum = std::accumulate(column.begin(), column.end(), 0LL); });
+  double tSum = measureMilliseconds([&] { sum = vec.accumulate(); });
+  auto below = [&](int x) { return x < threshold; };
+  double tStdCount = measureMilliseconds([&] {
+    stdCount = static_cast<size_t>(
+        std::count_if(column.begin(), column.end(), below));
+  });
+  double tCount = measureMilliseconds([&] { count = vec.countIf(below); });
+  double tStdFind = measureMilliseconds([&] {
+    stdFound = static_cast<size_t>(
+        std::find(column.begin(), column.end(), probe) - column.begin());
+  });
+  double tFind = measureMilliseconds([&] { found = vec.find(probe); });
+
+  std::cout << "  accumulate: std " << tStdSum << " ms, compressed " << tSum
+            << " ms" << std::endl;
+  std::cout << "  count_if:   std " << tStdCount << " ms, compressed "
+            << tCount << " ms" << std::endl;
+  std::cout << "  find:       std " << tStdFind << " ms, compressed " << tFind
+            << " ms" << std::endl;
+  std::cout << "  same results: " << std::boolalpha
+            << (stdSum == sum && stdCount == count && stdFound == found)
+            << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 26;
+  std::mt19937 gen(42);
+
+  std::vector<int> small(size);
+  std::uniform_int_distribution<int> smallDist(0, 999);
+  for (int& x : small) x = smallDist(gen);
+  benchmarkColumn("Small values in [0, 1000)", small);
+
+  std::vector<int> sorted(size);
+  std::uniform_int_distribution<int> gapDist(0, 20);
+  int value = 0;
+  for (int& x : sorted) x = value += gapDist(gen);
+  benchmarkColumn("Sorted, gaps in [0, 20]", sorted);
+}
+
+int main() {
+  // Compressed vector
+  std::cout << "*** CompressedIntVector ***" << std::endl;
+  compressedExamples();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::vector: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,278 @@
+/* This file shows ConcurrentMap from concurrent_map.h, a map split into
+ * lock-striped shards, and measures it against a std::map guarded by one
+ * std::shared_mutex as in thread_usage.cpp.
+ *
+ * 1. Basic operations: insert, insert_or_assign, find, erase
+ * 2. Atomic operations: counting words with merge_into() and memoizing with
+ *    compute_if_absent() from several threads
+ * 3. Per-shard statistics
+ * 4. Benchmark: threads running a 90% read / 10% write mix
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread concurrent_map.cpp
+ */
+
+#include "concurrent_map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+size_t defaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 1. Basic operations
+void basicOperations() {
+  ConcurrentMap<int, std::string> mp(4);
+
+  std::cout << "1.1. insert() {1, one} and {2, two}, then insert() {1, I}"
+            << std::endl;
+  mp.insert(1, "one");
+  mp.insert(2, "two");
+  std::cout << "insert(1, I) inserted: " << std::boolalpha
+            << mp.insert(1, "I") << ", find(1): " << *mp.find(1) << std::endl;
+
+  std::cout << std::endl
+            << "1.2. insert_or_assign() {1, I} and {3, three}" << std::endl;
+  mp.insert_or_assign(1, "I");
+  mp.insert_or_assign(3, "three");
+  std::cout << "find(1): " << *mp.find(1) << ", find(3): " << *mp.find(3)
+            << std::endl;
+
+  std::cout << std::endl
+            << "1.3. find() returns a copy, visit() reads in place"
+            << std::endl;
+  std::cout << "find(4) has a value: " << mp.find(4).has_value() << std::endl;
+  mp.visit(2, [](const std::string& value) {
+    std::cout << "Visited key 2 with value " << value << std::endl;
+  });
+
+  std::cout << std::endl << "1.4. erase() key 2" << std::endl;
+  mp.erase(2);
+  std::cout << "contains(2): " << mp.contains(2) << ", size(): " << mp.size()
+            << std::endl;
+}
+
+// 2. Atomic operations
+void atomicOperations() {
+  std::cout << "2.1. Four threads count the words of their own sentences "
+               "with merge_into()"
+            << std::endl;
+  const std::vector<std::vector<std::string>> sentences{
+      {"the", "quick", "brown", "fox"},
+      {"the", "lazy", "dog"},
+      {"the", "fox", "jumps"},
+      {"over", "the", "dog"}};
+  ConcurrentMap<std::string, int> counts(8);
+  std::vector<std::thread> threads;
+  for (const auto& sentence : sentences) {
+    threads.emplace_back([&counts, &sentence] {
+      for (const std::string& word : sentence)
+        counts.merge_into(word, 1, std::plus<>());
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::map<std::string, int> sorted;
+  counts.forEach(
+      [&](const std::string& word, int count) { sorted[word] = count; });
+  for (const auto& [word, count] : sorted)
+    std::cout << word << ": " << count << std::endl;
+
+  std::cout << std::endl
+            << "2.2. Four threads ask for the same expensive value with "
+               "compute_if_absent(); it is computed once"
+            << std::endl;
+  ConcurrentMap<int, long long> cache(8);
+  std::atomic<int> computations{0};
+  threads.clear();
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      cache.compute_if_absent(30, [&] {
+        ++computations;
+        long long a = 0, b = 1;
+        for (int i = 0; i < 30; ++i) b = std::exchange(a, b) + b;
+        return a;
+      });
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::cout << "fib(30) = " << *cache.find(30) << ", computed "
+            << computations << " time(s)" << std::endl;
+}
+
+// 3. Per-shard statistics
+void shardStatistics() {
+  ConcurrentMap<int, int> mp(4);
+  for (int key = 0; key < 1000; ++key) mp.insert(key, key);
+  for (int key = 0; key < 4000; ++key) mp.contains(key % 1000);
+  std::cout << "1000 inserts and 4000 reads over 4 shards" << std::endl;
+  const auto stats = mp.stats();
+  for (size_t i = 0; i < stats.size(); ++i)
+    std::cout << "Shard " << i << ": size " << stats[i].size << ", reads "
+              << stats[i].reads << ", writes " << stats[i].writes
+              << ", contended " << stats[i].contended << std::endl;
+}
+
+// Threads hammer shared keys with merge_into(), compute_if_absent() and
+// erase() on their own keys; the result must equal a sequential run.
+bool checkAgainstStd() {
+  constexpr int numThreads = 4;
+  constexpr int steps = 20000;
+  ConcurrentMap<int, int> mp(16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&mp, t] {
+      std::mt19937 gen(t);
+      for (int step = 0; step < steps; ++step) {
+        int shared = static_cast<int>(gen() % 100);
+        mp.merge_into(shared, 1, std::plus<>());
+        // Private keys: 1000 * (t + 1) + k.
+        int own = 1000 * (t + 1) + static_cast<int>(gen() % 50);
+        if (gen() % 2)
+          mp.insert_or_assign(own, step);
+        else
+          mp.erase(own);
+        mp.compute_if_absent(-1, [] { return 7; });
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  std::map<int, int> expected{{-1, 7}};
+  for (int t = 0; t < numThreads; ++t) {
+    std::mt19937 gen(t);
+    for (int step = 0; step < steps; ++step) {
+      ++expected[static_cast<int>(gen() % 100)];
+      int own = 1000 * (t + 1) + static_cast<int>(gen() % 50);
+      if (gen() % 2)
+        expected[own] = step;
+      else
+        expected.erase(own);
+    }
+  }
+  std::map<int, int> actual;
+  mp.forEach([&](int key, int value) { actual[key] = value; });
+  uint64_t writes = 0;
+  for (const auto& shard : mp.stats()) writes += shard.writes;
+  // Each step writes twice; compute_if_absent() writes once, at most.
+  return actual == expected && writes >= 2ull * numThreads * steps;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// The baseline: one std::map behind one std::shared_mutex.
+class LockedMap {
+ public:
+  bool find(int key) const {
+    std::shared_lock lock(mMutex);
+    return mMap.find(key) != mMap.end();
+  }
+
+  void insert_or_assign(int key, int value) {
+    std::unique_lock lock(mMutex);
+    mMap.insert_or_assign(key, value);
+  }
+
+ private:
+  mutable std::shared_mutex mMutex;
+  std::map<int, int> mMap;
+};
+
+// Every thread runs operations on random keys, one in ten a write.
+template <typename Map>
+double runMix(Map& map, size_t numThreads, size_t operations, int keys) {
+  return measureMilliseconds([&] {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t) {
+      threads.emplace_back([&, t] {
+        std::mt19937 gen(static_cast<unsigned>(t));
+        size_t hits = 0;
+        for (size_t i = 0; i < operations / numThreads; ++i) {
+          int key = static_cast<int>(gen() % keys);
+          if (i % 10 == 0)
+            map.insert_or_assign(key, static_cast<int>(i));
+          else
+            hits += static_cast<bool>(map.find(key));
+        }
+        // volatile keeps the compiler from dropping the lookups.
+        volatile size_t sink = hits;
+        (void)sink;
+      });
+    }
+    for (auto& thread : threads) thread.join();
+  });
+}
+
+void benchmark() {
+  constexpr int keys = 1 << 20;
+  constexpr size_t operations = 1 << 21;
+  std::cout << "Machine threads: " << defaultThreadCount() << ", " << keys
+            << " keys, " << operations << " operations" << std::endl;
+  std::vector<size_t> threadCounts{1, 4, defaultThreadCount()};
+  std::sort(threadCounts.begin(), threadCounts.end());
+  threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()),
+                     threadCounts.end());
+  for (size_t numThreads : threadCounts) {
+    // One shard isolates the gain from striping from the gain from the
+    // hash table.
+    LockedMap locked;
+    ConcurrentMap<int, int> oneShard(1);
+    ConcurrentMap<int, int> sharded;
+    for (int key = 0; key < keys; key += 2) {
+      locked.insert_or_assign(key, key);
+      oneShard.insert_or_assign(key, key);
+      sharded.insert_or_assign(key, key);
+    }
+    double lockedTime = runMix(locked, numThreads, operations, keys);
+    double oneShardTime = runMix(oneShard, numThreads, operations, keys);
+    double shardedTime = runMix(sharded, numThreads, operations, keys);
+    uint64_t contended = 0;
+    for (const auto& shard : sharded.stats()) contended += shard.contended;
+    std::cout << numThreads << " threads: std::map + shared_mutex "
+              << lockedTime << " ms, 1 shard " << oneShardTime << " ms, "
+              << sharded.shardCount() << " shards " << shardedTime << " ms ("
+              << lockedTime / shardedTime << "x), " << contended
+              << " contended shard locks" << std::endl;
+  }
+}
+
+int main() {
+  // Basic operations
+  std::cout << "*** Basic operations ***" << std::endl;
+  basicOperations();
+
+  // Atomic operations
+  std::cout << std::endl << "*** Atomic operations ***" << std::endl;
+  atomicOperations();
+
+  // Statistics
+  std::cout << std::endl << "*** Per-shard statistics ***" << std::endl;
+  shardStatistics();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Concurrent results match a sequential std::map: "
+            << std::boolalpha << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
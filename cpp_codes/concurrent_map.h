@@ -0,0 +1,266 @@
+/* This header implements ConcurrentMap<Key, T, Hash, KeyEqual>, a map that
+ * many threads can read and write at once. thread_usage.cpp protects
+ * shared state with one std::shared_mutex; wrapping a whole map that way
+ * lets a single writer stall every reader, so throughput stops at about
+ * one core.
+ *
+ * 1. Lock striping: the keys are spread by hash over N shards (64 by
+ *    default). Each shard is a SwissMap (swiss_map.h) with its own
+ *    std::shared_mutex, on its own cache lines, so threads working on
+ *    different shards never touch the same lock.
+ * 2. Reads take the shard lock shared and return copies (std::optional<T>)
+ *    or run a visitor under the lock; no reference into a shard escapes,
+ *    so a concurrent rehash can never leave a caller with a dangling
+ *    pointer.
+ * 3. Writes: insert(), insert_or_assign() and erase() lock one shard
+ *    exclusively. compute_if_absent() and merge_into() are atomic
+ *    read-modify-write operations on one key.
+ * 4. Statistics: every shard counts its reads, writes and the lock
+ *    acquisitions that had to wait, which shows hot shards and whether
+ *    more shards would help.
+ */
+
+#ifndef CONCURRENT_MAP_H
+#define CONCURRENT_MAP_H
+
+#include "swiss_map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class ConcurrentMap {
+ public:
+  struct ShardStats {
+    size_t size = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    // Lock acquisitions that found the lock taken and had to wait.
+    uint64_t contended = 0;
+  };
+
+  static constexpr size_t defaultShardCount = 64;
+
+  // The shard count is rounded up to a power of two.
+  explicit ConcurrentMap(size_t numShards = defaultShardCount)
+      : mNumShards(std::bit_ceil(std::max<size_t>(numShards, 1))),
+        mShards(std::make_unique<Shard[]>(mNumShards)) {}
+
+  ConcurrentMap(const ConcurrentMap&) = delete;
+  ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+  // 1. Reads
+  std::optional<T> find(const Key& key) const {
+    const Shard& shard = shardFor(key);
+    auto lock = readLock(shard);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return std::nullopt;
+    return it->second;
+  }
+
+  bool contains(const Key& key) const {
+    const Shard& shard = shardFor(key);
+    auto lock = readLock(shard);
+    return shard.map.contains(key);
+  }
+
+  // Calls visitor(const T&) under the shard's shared lock if key exists,
+  // which avoids copying large values. The visitor must not call back into
+  // the map.
+  template <typename Visitor>
+  bool visit(const Key& key, Visitor&& visitor) const {
+    const Shard& shard = shardFor(key);
+    auto lock = readLock(shard);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return false;
+    visitor(std::as_const(it->second));
+    return true;
+  }
+
+  // Calls f(key, value) for every element, one shard at a time; each shard
+  // is seen in a consistent state, but not all shards at the same moment.
+  template <typename Function>
+  void forEach(Function&& f) const {
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::shared_lock lock(mShards[i].mutex);
+      for (const auto& [key, value] : mShards[i].map) f(key, value);
+    }
+  }
+
+  // Exact when no thread is writing.
+  size_t size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::shared_lock lock(mShards[i].mutex);
+      total += mShards[i].map.size();
+    }
+    return total;
+  }
+
+  bool empty() const { return size() == 0; }
+  size_t shardCount() const { return mNumShards; }
+
+  // 2. Writes
+  // Returns false, leaving the map unchanged, if key exists.
+  bool insert(const Key& key, const T& value) {
+    Shard& shard = shardFor(key);
+    auto lock = writeLock(shard);
+    return shard.map.try_emplace(key, value).second;
+  }
+
+  // Returns true if key was inserted, false if its value was replaced.
+  bool insert_or_assign(const Key& key, T value) {
+    Shard& shard = shardFor(key);
+    auto lock = writeLock(shard);
+    return shard.map.insert_or_assign(key, std::move(value)).second;
+  }
+
+  bool erase(const Key& key) {
+    Shard& shard = shardFor(key);
+    auto lock = writeLock(shard);
+    return shard.map.erase(key) != 0;
+  }
+
+  // Calls f(T&) under the shard's exclusive lock if key exists.
+  template <typename Function>
+  bool update(const Key& key, Function&& f) {
+    Shard& shard = shardFor(key);
+    auto lock = writeLock(shard);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) return false;
+    f(it->second);
+    return true;
+  }
+
+  // 3. Atomic read-modify-write
+  // Returns the value of key, inserting factory() first if key is missing.
+  // factory runs at most once per insertion, under the shard's exclusive
+  // lock, so concurrent callers for the same key never build two values.
+  // A key that is present only costs a shared lock.
+  template <typename Factory>
+  T compute_if_absent(const Key& key, Factory&& factory) {
+    Shard& shard = shardFor(key);
+    {
+      auto lock = readLock(shard);
+      auto it = shard.map.find(key);
+      if (it != shard.map.end()) return it->second;
+    }
+    auto lock = writeLock(shard);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) it = shard.map.try_emplace(key, factory()).first;
+    return it->second;
+  }
+
+  // Inserts value for a missing key, otherwise replaces the current value
+  // with combine(current, value); returns the resulting value. E.g.
+  // merge_into(word, 1, std::plus<>()) counts words from many threads.
+  template <typename Combine>
+  T merge_into(const Key& key, T value, Combine&& combine) {
+    Shard& shard = shardFor(key);
+    auto lock = writeLock(shard);
+    auto [it, inserted] = shard.map.try_emplace(key, std::move(value));
+    if (!inserted) it->second = combine(std::as_const(it->second), value);
+    return it->second;
+  }
+
+  void clear() {
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::unique_lock lock(mShards[i].mutex);
+      mShards[i].map.clear();
+    }
+  }
+
+  // Sizes every shard for an even share of count elements.
+  void reserve(size_t count) {
+    size_t perShard = count / mNumShards + count / mNumShards / 8 + 1;
+    for (size_t i = 0; i < mNumShards; ++i) {
+      std::unique_lock lock(mShards[i].mutex);
+      mShards[i].map.reserve(perShard);
+    }
+  }
+
+  // 4. Statistics
+  std::vector<ShardStats> stats() const {
+    std::vector<ShardStats> result(mNumShards);
+    for (size_t i = 0; i < mNumShards; ++i) {
+      const Shard& shard = mShards[i];
+      {
+        std::shared_lock lock(shard.mutex);
+        result[i].size = shard.map.size();
+      }
+      result[i].reads = shard.reads.load(std::memory_order_relaxed);
+      result[i].writes = shard.writes.load(std::memory_order_relaxed);
+      result[i].contended = shard.contended.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  void resetStats() {
+    for (size_t i = 0; i < mNumShards; ++i) {
+      mShards[i].reads.store(0, std::memory_order_relaxed);
+      mShards[i].writes.store(0, std::memory_order_relaxed);
+      mShards[i].contended.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  // Aligned so that two shards never share a cache line.
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    SwissMap<Key, T, Hash, KeyEqual> map;
+    mutable std::atomic<uint64_t> reads{0};
+    mutable std::atomic<uint64_t> writes{0};
+    mutable std::atomic<uint64_t> contended{0};
+  };
+
+  // SwissMap uses the low bits of its own mix of the hash; the shard is
+  // taken from the high bits of a different one, so the two stay
+  // independent.
+  size_t shardIndex(const Key& key) const {
+    uint64_t h = static_cast<uint64_t>(mHash(key)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h >> 40) & (mNumShards - 1);
+  }
+
+  Shard& shardFor(const Key& key) { return mShards[shardIndex(key)]; }
+  const Shard& shardFor(const Key& key) const {
+    return mShards[shardIndex(key)];
+  }
+
+  // Try first, so that waiting can be counted.
+  static std::shared_lock<std::shared_mutex> readLock(const Shard& shard) {
+    std::shared_lock lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      shard.contended.fetch_add(1, std::memory_order_relaxed);
+      lock.lock();
+    }
+    shard.reads.fetch_add(1, std::memory_order_relaxed);
+    return lock;
+  }
+
+  static std::unique_lock<std::shared_mutex> writeLock(Shard& shard) {
+    std::unique_lock lock(shard.mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      shard.contended.fetch_add(1, std::memory_order_relaxed);
+      lock.lock();
+    }
+    shard.writes.fetch_add(1, std::memory_order_relaxed);
+    return lock;
+  }
+
+  size_t mNumShards;
+  std::unique_ptr<Shard[]> mShards;
+  [[no_unique_address]] Hash mHash;
+};
+
+#endif  // CONCURRENT_MAP_H
@@ -16,25 +16,24 @@
  *
  */
 
+#include "fast_output.h"
+
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <map>
 #include <numeric>
+#include <string>
+#include <vector>
 
 template <typename T1, typename T2, typename Compare>
 void printMap(const std::string& mapName, const std::map<T1, T2, Compare>& mp) {
-  std::cout << mapName << ": ";
-  for (auto it = mp.begin(); it != mp.end(); ++it) {
-    if (it == mp.begin()) {
-      std::cout << "{{" << it->first << "," << it->second << "}, ";
-    } else if (std::next(it) == mp.end()) {
-      std::cout << "{" << it->first << "," << it->second << "}}";
-    } else {
-      std::cout << "{" << it->first << "," << it->second << "}, ";
-    }
-  }
-  std::cout << std::endl;
-};
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
 
 bool compare(int a, int b) { return a > b; }
 
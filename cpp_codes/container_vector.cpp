@@ -8,6 +8,8 @@
  * access and additions/removals at the end.
  */
 
+#include "fast_output.h"
+
 #include <algorithm>
 #include <iostream>
 #include <iterator>
@@ -15,22 +17,12 @@
 #include <vector>
 
 void printVector(const std::string& vectorName, const std::vector<int>& vec) {
-  std::cout << vectorName << ": ";
-  if (vec.size() == 1) {
-    std::cout << "[" << vec[0] << "]";
-  } else {
-    for (int i = 0; i < vec.size(); ++i) {
-      if (i == 0) {
-        std::cout << "[" << vec[i] << ", ";
-      } else if (i == vec.size() - 1) {
-        std::cout << vec[i] << "]";
-      } else {
-        std::cout << vec[i] << ", ";
-      }
-    }
-  }
-  std::cout << std::endl;
-};
+  FastOutput& out = fastOut();
+  out << vectorName << ": ";
+  if (!vec.empty()) out.writeRange(vec);
+  out << '\n';
+  out.flush();
+}
 
 // 1.Initializing a vector
 void initialization() {
@@ -623,12 +615,12 @@ void removingAlgorithms() {
   // 8.4. std::erase()
   std::cout << std::endl << "8.4. Using std::erase() to remove all occurrences
   of a 1 and resize the vector" << std::endl; printVector("Initial vector",
-  vec); std::erase(vec.begin(), vec.end()); printVector("Modified vector", vec);
+  vec); std::erase(vec, 1); printVector("Modified vector", vec);
 
   // 8.5. std::erase_if()
   std::cout << std::endl << "8.5. Using std::erase_if() to remove elements
   matching x > 3 and resize the vector" << std::endl; printVector("Initial
-  vector", vec); std::erase_if(vec.begin(), vec.end(), [](int x){return x >
+  vector", vec); std::erase_if(vec, [](int x){return x >
   3;}); printVector("Modified vector", vec);
   */
 }
@@ -709,13 +701,20 @@ void comparingAndCheckingAlgorithms() {
             << std::endl;
   printVector("First vector", vec1);
   printVector("Second vector", vec2);
-  auto itPair = std::mismatch(vec1.begin(), vec1.end(), vec2.begin());
+  // The four-iterator overload stops at the end of the shorter vector;
+  // there is no element to print on a side that ran out.
+  auto itPair =
+      std::mismatch(vec1.begin(), vec1.end(), vec2.begin(), vec2.end());
   auto dist1 = itPair.first - vec1.begin() + 1;
   auto dist2 = itPair.second - vec2.begin() + 1;
-  std::cout << "First vector differs at position: " << dist1
-            << " with value: " << *itPair.first << std::endl;
-  std::cout << "Second vector differs at position: " << dist2
-            << " with value: " << *itPair.second << std::endl;
+  std::cout << "First vector differs at position: " << dist1;
+  if (itPair.first != vec1.end())
+    std::cout << " with value: " << *itPair.first;
+  std::cout << std::endl;
+  std::cout << "Second vector differs at position: " << dist2;
+  if (itPair.second != vec2.end())
+    std::cout << " with value: " << *itPair.second;
+  std::cout << std::endl;
 
   // 10.4. std::all_of()
   std::cout << std::endl
@@ -734,7 +733,7 @@ void comparingAndCheckingAlgorithms() {
             << std::endl;
   printVector("Vector", vec1);
   result =
-      std::any_of(vec1.begin(), vec2.end(), [](int x) { return x % 2 == 0; });
+      std::any_of(vec1.begin(), vec1.end(), [](int x) { return x % 2 == 0; });
   std::cout << "Result: " << std::boolalpha << result << std::endl;
 
   // 10.6. std::none_of()
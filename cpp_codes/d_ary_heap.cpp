@@ -0,0 +1,521 @@
+/* This file implements heap containers that behave like the heaps built by
+ * std::make_heap()/push_heap()/pop_heap() in heapAlgorithms() of
+ * container_vector.cpp, but with better cache behaviour on large inputs.
+ *
+ * A binary heap of n elements is log2(n) levels deep and every level of a
+ * sift-down touches a new cache line. A d-ary heap (4 or 8 children per node)
+ * is only logD(n) levels deep. Storing the root at index D - 1 makes the
+ * children of every node start at an index that is a multiple of D, so with a
+ * 64-byte aligned buffer all D children share one cache line whenever
+ * D * sizeof(T) divides 64 (e.g. 4 or 8 ints, 4 or 8 doubles).
+ *
+ * 1. AlignedAllocator: cache-line aligned storage for std::vector
+ * 2. DaryHeap<T, D, Compare>: push/pop/top and a bulk heapify()
+ * 3. IndexedDaryHeap<Priority, D, Compare>: handles with update() and
+ *    decrease_key() for schedulers and Dijkstra-style workloads
+ * 4. Examples
+ * 5. Benchmark against the std heap algorithms
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t cacheLineSize = 64;
+
+// 1. AlignedAllocator
+template <typename T, size_t Alignment = cacheLineSize>
+struct AlignedAllocator {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(
+        ::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* ptr, size_t) {
+    ::operator delete(ptr, std::align_val_t(Alignment));
+  }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment>&) const {
+    return true;
+  }
+};
+
+// 2. DaryHeap
+// Like std::priority_queue, top() is the largest element according to
+// Compare, so std::less gives a max-heap and std::greater a min-heap. T must
+// be default constructible because the first D - 1 slots are padding.
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+  static_assert(D >= 2, "A heap node needs at least two children");
+
+ public:
+  DaryHeap() : mData(D - 1) {}
+  explicit DaryHeap(const Compare& compare) : mData(D - 1), mCompare(compare) {}
+
+  // Builds the heap from an unordered range in O(n).
+  template <typename InputIt>
+  DaryHeap(InputIt first, InputIt last, const Compare& compare = Compare())
+      : mData(D - 1), mCompare(compare) {
+    mData.insert(mData.end(), first, last);
+    heapify();
+  }
+
+  bool empty() const { return mData.size() == D - 1; }
+  size_t size() const { return mData.size() - (D - 1); }
+  void reserve(size_t capacity) { mData.reserve(capacity + D - 1); }
+  void clear() { mData.resize(D - 1); }
+
+  const T& top() const { return mData[D - 1]; }
+
+  void push(const T& value) { emplace(value); }
+  void push(T&& value) { emplace(std::move(value)); }
+
+  template <typename... Args>
+  void emplace(Args&&... args) {
+    mData.emplace_back(std::forward<Args>(args)...);
+    siftUp(size() - 1);
+  }
+
+  // The element taken from the back almost always belongs near the bottom,
+  // so the hole left by the top is first moved all the way down along the
+  // best children (one comparison per child, none against the moved value)
+  // and the value is then sifted up from there.
+  void pop() {
+    T last = std::move(mData.back());
+    mData.pop_back();
+    if (empty()) return;
+    size_t hole = siftHoleToBottom(0);
+    at(hole) = std::move(last);
+    siftUp(hole);
+  }
+
+  // Removes and returns the top element.
+  T extractTop() {
+    T result = std::move(mData[D - 1]);
+    pop();
+    return result;
+  }
+
+  // Appends a batch of elements and restores the heap property with a single
+  // bottom-up pass instead of one sift-up per element.
+  template <typename InputIt>
+  void pushBulk(InputIt first, InputIt last) {
+    mData.insert(mData.end(), first, last);
+    heapify();
+  }
+
+  // Floyd's bottom-up construction. Every internal node is sifted down once,
+  // starting from the last parent; with D children per node there are only
+  // about n / D internal nodes and the tree is logD(n) levels deep.
+  void heapify() {
+    size_t count = size();
+    if (count < 2) return;
+    for (size_t i = parent(count - 1) + 1; i-- > 0;) {
+      T value = std::move(at(i));
+      siftDown(i, std::move(value));
+    }
+  }
+
+  bool isHeap() const {
+    for (size_t i = 1; i < size(); ++i) {
+      if (mCompare(at(parent(i)), at(i))) return false;
+    }
+    return true;
+  }
+
+  // Leaves the heap empty and returns its elements sorted in ascending order
+  // of Compare (like std::sort_heap()).
+  std::vector<T> sortHeap() {
+    std::vector<T> sorted(size());
+    for (size_t i = sorted.size(); i-- > 0;) sorted[i] = extractTop();
+    return sorted;
+  }
+
+ private:
+  static size_t parent(size_t i) { return (i - 1) / D; }
+  static size_t firstChild(size_t i) { return D * i + 1; }
+
+  // Logical index -> slot in the padded, aligned buffer.
+  T& at(size_t i) { return mData[i + D - 1]; }
+  const T& at(size_t i) const { return mData[i + D - 1]; }
+
+  void siftUp(size_t i) {
+    T value = std::move(at(i));
+    while (i > 0) {
+      size_t p = parent(i);
+      if (!mCompare(at(p), value)) break;
+      at(i) = std::move(at(p));
+      i = p;
+    }
+    at(i) = std::move(value);
+  }
+
+  size_t bestChild(size_t child, size_t count) const {
+    // All D children live in the same cache line; pick the best of them.
+    // A full group is reduced as a tournament (pairs, then pairs of winners)
+    // so the comparisons form a tree of depth log2(D) instead of a chain.
+    if (child + D <= count && (D & (D - 1)) == 0) {
+      size_t winners[D];
+      for (size_t k = 0; k < D; ++k) winners[k] = child + k;
+      for (size_t width = D / 2; width > 0; width /= 2) {
+        for (size_t k = 0; k < width; ++k) {
+          size_t a = winners[2 * k];
+          size_t b = winners[2 * k + 1];
+          winners[k] = mCompare(at(a), at(b)) ? b : a;
+        }
+      }
+      return winners[0];
+    }
+    size_t best = child;
+    size_t last = std::min(child + D, count);
+    for (size_t c = child + 1; c < last; ++c) {
+      best = mCompare(at(best), at(c)) ? c : best;
+    }
+    return best;
+  }
+
+  size_t siftHoleToBottom(size_t i) {
+    size_t count = size();
+    for (size_t child = firstChild(i); child < count; child = firstChild(i)) {
+      size_t best = bestChild(child, count);
+      at(i) = std::move(at(best));
+      i = best;
+    }
+    return i;
+  }
+
+  // Moves the hole at i down until value fits, then fills it.
+  void siftDown(size_t i, T value) {
+    size_t count = size();
+    while (true) {
+      size_t child = firstChild(i);
+      if (child >= count) break;
+      size_t best = bestChild(child, count);
+      if (!mCompare(value, at(best))) break;
+      at(i) = std::move(at(best));
+      i = best;
+    }
+    at(i) = std::move(value);
+  }
+
+  std::vector<T, AlignedAllocator<T>> mData;
+  Compare mCompare;
+};
+
+// 3. IndexedDaryHeap
+// Every push() returns a handle that stays valid until the entry is popped or
+// erased. The heap stores (priority, handle) pairs and keeps the position of
+// every handle up to date, so an entry can be re-prioritised in O(logD n).
+template <typename Priority, size_t D = 4,
+          typename Compare = std::less<Priority>>
+class IndexedDaryHeap {
+ public:
+  using Handle = size_t;
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  IndexedDaryHeap() = default;
+  explicit IndexedDaryHeap(const Compare& compare) : mCompare(compare) {}
+
+  bool empty() const { return mHeap.empty(); }
+  size_t size() const { return mHeap.size(); }
+
+  void reserve(size_t capacity) {
+    mHeap.reserve(capacity);
+    mPositions.reserve(capacity);
+  }
+
+  Handle push(const Priority& priority) {
+    Handle handle;
+    if (mFreeHandles.empty()) {
+      handle = mPositions.size();
+      mPositions.push_back(npos);
+      mPriorities.push_back(priority);
+    } else {
+      handle = mFreeHandles.back();
+      mFreeHandles.pop_back();
+      mPriorities[handle] = priority;
+    }
+    mHeap.push_back(handle);
+    mPositions[handle] = mHeap.size() - 1;
+    siftUp(mHeap.size() - 1);
+    return handle;
+  }
+
+  Handle topHandle() const { return mHeap.front(); }
+  const Priority& top() const { return mPriorities[mHeap.front()]; }
+
+  bool contains(Handle handle) const {
+    return handle < mPositions.size() && mPositions[handle] != npos;
+  }
+
+  const Priority& priority(Handle handle) const { return mPriorities[handle]; }
+
+  void pop() { erase(mHeap.front()); }
+
+  void erase(Handle handle) {
+    if (!contains(handle)) throw std::out_of_range("IndexedDaryHeap::erase");
+    size_t i = mPositions[handle];
+    mPositions[handle] = npos;
+    mFreeHandles.push_back(handle);
+
+    Handle last = mHeap.back();
+    mHeap.pop_back();
+    if (i == mHeap.size()) return;
+    mHeap[i] = last;
+    mPositions[last] = i;
+    restore(i);
+  }
+
+  // Changes the priority of an entry in either direction.
+  void update(Handle handle, const Priority& priority) {
+    if (!contains(handle)) throw std::out_of_range("IndexedDaryHeap::update");
+    mPriorities[handle] = priority;
+    restore(mPositions[handle]);
+  }
+
+  // Moves an entry towards the top. With Compare = std::greater (a min-heap,
+  // as in Dijkstra) this is the classic decrease-key operation.
+  void decrease_key(Handle handle, const Priority& priority) {
+    if (!contains(handle)) {
+      throw std::out_of_range("IndexedDaryHeap::decrease_key");
+    }
+    if (mCompare(priority, mPriorities[handle])) {
+      throw std::invalid_argument(
+          "IndexedDaryHeap::decrease_key would move the entry down");
+    }
+    mPriorities[handle] = priority;
+    siftUp(mPositions[handle]);
+  }
+
+ private:
+  static size_t parent(size_t i) { return (i - 1) / D; }
+
+  bool before(Handle a, Handle b) const {
+    return mCompare(mPriorities[a], mPriorities[b]);
+  }
+
+  void place(size_t i, Handle handle) {
+    mHeap[i] = handle;
+    mPositions[handle] = i;
+  }
+
+  void restore(size_t i) {
+    if (i > 0 && before(mHeap[parent(i)], mHeap[i])) {
+      siftUp(i);
+    } else {
+      siftDown(i);
+    }
+  }
+
+  void siftUp(size_t i) {
+    Handle handle = mHeap[i];
+    while (i > 0) {
+      size_t p = parent(i);
+      if (!before(mHeap[p], handle)) break;
+      place(i, mHeap[p]);
+      i = p;
+    }
+    place(i, handle);
+  }
+
+  void siftDown(size_t i) {
+    Handle handle = mHeap[i];
+    size_t count = mHeap.size();
+    while (true) {
+      size_t child = D * i + 1;
+      if (child >= count) break;
+      size_t last = std::min(child + D, count);
+      size_t best = child;
+      for (size_t c = child + 1; c < last; ++c) {
+        if (before(mHeap[best], mHeap[c])) best = c;
+      }
+      if (!before(handle, mHeap[best])) break;
+      place(i, mHeap[best]);
+      i = best;
+    }
+    place(i, handle);
+  }
+
+  std::vector<Handle> mHeap;        // heap order, holds handles
+  std::vector<size_t> mPositions;   // handle -> index in mHeap (or npos)
+  std::vector<Priority> mPriorities;  // handle -> priority
+  std::vector<Handle> mFreeHandles;
+  Compare mCompare;
+};
+
+// 4. Examples
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+// 4.1. The heapAlgorithms() walk-through with a 4-ary heap
+void heapAlgorithms() {
+  std::vector<int> vec{2, 1, 3, 5, 4};
+  printVector("Vector", vec);
+
+  std::cout << "4.1.1. Building a 4-ary heap with heapify()" << std::endl;
+  DaryHeap<int, 4> heap(vec.begin(), vec.end());
+  std::cout << "Top: " << heap.top() << ", is heap: " << std::boolalpha
+            << heap.isHeap() << std::endl;
+
+  std::cout << std::endl << "4.1.2. Using push() to insert 7" << std::endl;
+  heap.push(7);
+  std::cout << "Top: " << heap.top() << std::endl;
+
+  std::cout << std::endl
+            << "4.1.3. Using pop() to remove the largest element" << std::endl;
+  heap.pop();
+  std::cout << "Top: " << heap.top() << ", size: " << heap.size() << std::endl;
+
+  std::cout << std::endl
+            << "4.1.4. Using sortHeap() to convert the heap to a sorted vector"
+            << std::endl;
+  printVector("Sorted vector", heap.sortHeap());
+}
+
+// 4.2. Dijkstra's shortest paths with decrease_key()
+void dijkstraExample() {
+  struct Edge {
+    size_t to;
+    int weight;
+  };
+  std::vector<std::vector<Edge>> graph{
+      {{1, 4}, {2, 1}}, {{3, 1}}, {{1, 2}, {3, 5}}, {{4, 3}}, {}};
+  constexpr int infinity = std::numeric_limits<int>::max();
+
+  std::vector<int> distance(graph.size(), infinity);
+  std::vector<size_t> handleOf(graph.size());
+  std::vector<size_t> vertexOf;
+  IndexedDaryHeap<int, 4, std::greater<int>> queue;
+
+  distance[0] = 0;
+  for (size_t v = 0; v < graph.size(); ++v) {
+    handleOf[v] = queue.push(distance[v]);
+    vertexOf.push_back(v);
+  }
+
+  while (!queue.empty()) {
+    size_t u = vertexOf[queue.topHandle()];
+    queue.pop();
+    if (distance[u] == infinity) break;
+    for (const Edge& edge : graph[u]) {
+      int candidate = distance[u] + edge.weight;
+      if (candidate < distance[edge.to]) {
+        distance[edge.to] = candidate;
+        queue.decrease_key(handleOf[edge.to], candidate);
+      }
+    }
+  }
+  printVector("Shortest distances from vertex 0", distance);
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <size_t D>
+void benchmarkDaryHeap(const std::vector<int>& input) {
+  DaryHeap<int, D> heap;
+  heap.reserve(input.size());
+  long long checksum = 0;
+  double pushTime = measureMilliseconds([&] {
+    for (int x : input) heap.push(x);
+  });
+  double popTime = measureMilliseconds([&] {
+    while (!heap.empty()) {
+      checksum += heap.top();
+      heap.pop();
+    }
+  });
+  double heapifyTime = measureMilliseconds(
+      [&] { heap.pushBulk(input.begin(), input.end()); });
+  std::cout << D << "-ary heap:      push " << pushTime << " ms, pop "
+            << popTime << " ms, heapify " << heapifyTime << " ms (checksum "
+            << checksum << ", valid " << std::boolalpha << heap.isHeap() << ")"
+            << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = 10'000'000;
+  std::mt19937 gen(42);
+  std::vector<int> input(size);
+  for (int& x : input) x = static_cast<int>(gen() >> 1);
+  std::cout << "Elements: " << size << std::endl;
+
+  std::vector<int> heap;
+  heap.reserve(size);
+  long long checksum = 0;
+  double pushTime = measureMilliseconds([&] {
+    for (int x : input) {
+      heap.push_back(x);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  });
+  double popTime = measureMilliseconds([&] {
+    while (!heap.empty()) {
+      checksum += heap.front();
+      std::pop_heap(heap.begin(), heap.end());
+      heap.pop_back();
+    }
+  });
+  heap = input;
+  double heapifyTime =
+      measureMilliseconds([&] { std::make_heap(heap.begin(), heap.end()); });
+  std::cout << "std heap (binary): push " << pushTime << " ms, pop " << popTime
+            << " ms, make_heap " << heapifyTime << " ms (checksum " << checksum
+            << ")" << std::endl;
+
+  benchmarkDaryHeap<4>(input);
+  benchmarkDaryHeap<8>(input);
+}
+
+int main() {
+  // 4.1. Heap algorithms
+  std::cout << "*** 4.1. Heap algorithms with a 4-ary heap ***" << std::endl;
+  heapAlgorithms();
+
+  // 4.2. Indexed heap
+  std::cout << std::endl
+            << "*** 4.2. Dijkstra with an indexed 4-ary heap ***" << std::endl;
+  dijkstraExample();
+
+  // 5. Benchmark
+  std::cout << std::endl
+            << "*** 5. Benchmark against the std heap algorithms ***"
+            << std::endl;
+  benchmark();
+
+  return 0;
+}
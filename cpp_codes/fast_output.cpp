@@ -0,0 +1,145 @@
+/* This file shows FastOutput from fast_output.h, the writer behind
+ * printVector(), printMap() and print(), and measures it against the
+ * std::cout code those helpers used before.
+ *
+ * 1. Examples: ranges, maps, floating point, mixing with std::cout
+ * 2. Benchmark: dumping large vectors with iostream and with FastOutput
+ *
+ * Build with: g++ -std=c++20 -O2 fast_output.cpp
+ */
+
+#include "fast_output.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// 1. Examples
+void fastOutputExamples() {
+  FastOutput& out = fastOut();
+
+  std::cout << "1.1. writeRange() on a vector and on a raw array" << std::endl;
+  std::vector<int> vec{1, -2, 3, 400000, -5};
+  int arr[3]{7, 8, 9};
+  out << "Vector: ";
+  out.writeRange(vec) << '\n';
+  out << "Array: ";
+  out.writeRange(arr, arr + 3) << '\n';
+  out.flush();
+
+  std::cout << std::endl << "1.2. writeMap()" << std::endl;
+  std::map<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+  out << "Map: ";
+  out.writeMap(mp) << '\n';
+  out.flush();
+
+  std::cout << std::endl
+            << "1.3. Floating point numbers in shortest round-trip form"
+            << std::endl;
+  std::vector<double> doubles{0.1, 1.0 / 3.0, 1e-300, 6.02214076e23, -0.0};
+  out << "Doubles: ";
+  out.writeRange(doubles) << '\n';
+  out.flush();
+
+  std::cout << std::endl
+            << "1.4. Text written through std::cout in between keeps its "
+               "place because fastOut() is tied to std::cout"
+            << std::endl;
+  std::cout << "from std::cout, ";
+  out << "from FastOutput" << '\n';
+  out.flush();
+}
+
+// 2. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// The loop printVector() in container_vector.cpp used before.
+template <typename T>
+void iostreamDump(std::ostream& os, const std::string& name,
+                  const std::vector<T>& vec) {
+  os << name << ": ";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    if (i == 0) {
+      os << "[" << vec[i] << ", ";
+    } else if (i == vec.size() - 1) {
+      os << vec[i] << "]";
+    } else {
+      os << vec[i] << ", ";
+    }
+  }
+  os << std::endl;
+}
+
+template <typename T>
+void fastDump(FastOutput& out, const std::string& name,
+              const std::vector<T>& vec) {
+  out << name << ": ";
+  out.writeRange(vec) << '\n';
+  out.flush();
+}
+
+void benchmark() {
+  constexpr size_t numInts = 10'000'000;
+  constexpr size_t numDoubles = 2'000'000;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> intDist(-1'000'000, 1'000'000);
+  std::uniform_real_distribution<double> doubleDist(-1e6, 1e6);
+  std::vector<int> ints(numInts);
+  for (int& x : ints) x = intDist(gen);
+  std::vector<double> doubles(numDoubles);
+  for (double& x : doubles) x = doubleDist(gen);
+
+  // Standard output is pointed at /dev/null while both helpers run, so the
+  // measurement covers std::cout exactly as printVector() used it.
+  std::cout.flush();
+  int savedStdout = ::dup(STDOUT_FILENO);
+  int devNull = ::open("/dev/null", O_WRONLY);
+  ::dup2(devNull, STDOUT_FILENO);
+  FastOutput& out = fastOut();
+
+  double streamInts =
+      measureMilliseconds([&] { iostreamDump(std::cout, "Vector", ints); });
+  double fastInts = measureMilliseconds([&] { fastDump(out, "Vector", ints); });
+  // iostream prints 6 significant digits by default; to_chars() prints as
+  // many as needed to read the value back exactly, i.e. more work.
+  double streamDoubles = measureMilliseconds(
+      [&] { iostreamDump(std::cout, "Vector", doubles); });
+  double fastDoubles =
+      measureMilliseconds([&] { fastDump(out, "Vector", doubles); });
+
+  ::dup2(savedStdout, STDOUT_FILENO);
+  ::close(savedStdout);
+  ::close(devNull);
+
+  std::cout << numInts << " ints:    iostream " << streamInts
+            << " ms, FastOutput " << fastInts << " ms ("
+            << streamInts / fastInts << "x)" << std::endl;
+  std::cout << numDoubles << " doubles: iostream " << streamDoubles
+            << " ms, FastOutput " << fastDoubles << " ms ("
+            << streamDoubles / fastDoubles << "x)" << std::endl;
+}
+
+int main() {
+  // Examples
+  std::cout << "*** FastOutput ***" << std::endl;
+  fastOutputExamples();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
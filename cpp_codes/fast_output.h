@@ -0,0 +1,273 @@
+/* This header implements FastOutput, a buffered writer shared by the
+ * printVector(), printMap() and print() helpers of container_vector.cpp,
+ * container_map.cpp and memory_management.cpp.
+ *
+ * std::cout formats every element through the locale-aware num_put machinery
+ * and, with std::endl, flushes on every line. FastOutput instead:
+ *
+ * 1. formats numbers straight into one large reusable buffer: integers that
+ *    fit in 32 bits with a branch-free SWAR conversion (all eight digits at
+ *    once in a 64-bit register), everything else with std::to_chars()
+ *    (shortest round-trip form for floating point),
+ * 2. hands a full buffer to the kernel with a single write(2),
+ * 3. can be tied to an std::ostream, like std::cin is tied to std::cout: the
+ *    tied stream is flushed before FastOutput starts filling an empty
+ *    buffer, so text from both keeps its order,
+ * 4. writes ranges, vectors, maps and raw arrays with the bracketed syntax
+ *    the helpers above already print.
+ *
+ * fastOut() returns the instance for standard output, tied to std::cout.
+ */
+
+#ifndef FAST_OUTPUT_H
+#define FAST_OUTPUT_H
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+class FastOutput {
+ public:
+  static constexpr size_t defaultBufferSize = 1 << 20;
+  // Longest to_chars() results: 20 digits plus sign for integers, 24
+  // characters for the shortest round-trip form of a double.
+  static constexpr size_t maxNumberChars = 32;
+
+  explicit FastOutput(int fd = STDOUT_FILENO,
+                      size_t bufferSize = defaultBufferSize,
+                      std::ostream* tie = nullptr)
+      : mFd(fd),
+        mCapacity(std::max(bufferSize, maxNumberChars)),
+        mBuffer(std::make_unique_for_overwrite<char[]>(mCapacity)),
+        mTie(tie) {}
+
+  FastOutput(const FastOutput&) = delete;
+  FastOutput& operator=(const FastOutput&) = delete;
+
+  // A destructor cannot report a failed write, so the bytes are dropped.
+  ~FastOutput() {
+    try {
+      flush();
+    } catch (const std::system_error&) {
+    }
+  }
+
+  // 1. Formatting
+  FastOutput& write(std::string_view text) {
+    prepare();
+    while (text.size() > mCapacity - mSize) {
+      size_t chunk = mCapacity - mSize;
+      std::memcpy(mBuffer.get() + mSize, text.data(), chunk);
+      mSize += chunk;
+      text.remove_prefix(chunk);
+      flush();
+    }
+    std::memcpy(mBuffer.get() + mSize, text.data(), text.size());
+    mSize += text.size();
+    return *this;
+  }
+
+  FastOutput& write(char c) {
+    prepare();
+    if (mSize == mCapacity) flush();
+    mBuffer[mSize++] = c;
+    return *this;
+  }
+
+  // std::ostream prints signed and unsigned char, and so int8_t and
+  // uint8_t, as characters; so does FastOutput.
+  FastOutput& write(signed char c) { return write(static_cast<char>(c)); }
+  FastOutput& write(unsigned char c) { return write(static_cast<char>(c)); }
+
+  // Integers, floating point numbers and bool (as 0/1, like std::cout);
+  // the char types are handled above.
+  template <typename T>
+    requires(std::is_arithmetic_v<T> && !std::same_as<T, char>)
+  FastOutput& write(T value) {
+    if constexpr (std::same_as<T, bool>) {
+      return write(value ? '1' : '0');
+    } else {
+      prepare();
+      if (mCapacity - mSize < maxNumberChars) flush();
+      mSize = static_cast<size_t>(
+          formatNumber(mBuffer.get() + mSize, value) - mBuffer.get());
+      return *this;
+    }
+  }
+
+  template <typename T>
+  FastOutput& operator<<(const T& value) {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+      return write(std::string_view(value));
+    } else {
+      return write(value);
+    }
+  }
+
+  // 2. Flushing: one write(2) per buffer, repeated only on short writes
+  void flush() {
+    size_t written = 0;
+    while (written < mSize) {
+      ssize_t n = ::write(mFd, mBuffer.get() + written, mSize - written);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        mSize = 0;
+        throw std::system_error(errno, std::generic_category(),
+                                "FastOutput::flush");
+      }
+      written += static_cast<size_t>(n);
+    }
+    mSize = 0;
+  }
+
+  // 4. Ranges, written as [a, b, c]
+  template <typename Iterator>
+  FastOutput& writeRange(Iterator first, Iterator last) {
+    using Value = typename std::iterator_traits<Iterator>::value_type;
+    write('[');
+    if constexpr (isNumber<Value>) {
+      // Hot loop of every dump: one capacity check per element.
+      for (Iterator it = first; it != last; ++it) {
+        if (mCapacity - mSize < maxNumberChars + 2) flush();
+        char* p = mBuffer.get() + mSize;
+        if (it != first) {
+          std::memcpy(p, ", ", 2);
+          p += 2;
+        }
+        mSize = static_cast<size_t>(formatNumber(p, *it) - mBuffer.get());
+      }
+    } else {
+      for (Iterator it = first; it != last; ++it) {
+        if (it != first) write(", ");
+        *this << *it;
+      }
+    }
+    return write(']');
+  }
+
+  template <typename Range>
+  FastOutput& writeRange(const Range& range) {
+    return writeRange(std::begin(range), std::end(range));
+  }
+
+  // Map entries, written as {{key,value}, {key,value}}
+  template <typename Map>
+  FastOutput& writeMap(const Map& map) {
+    write('{');
+    for (auto it = map.begin(); it != map.end(); ++it) {
+      if (it != map.begin()) write(", ");
+      *this << '{' << it->first << ',' << it->second << '}';
+    }
+    return write('}');
+  }
+
+ private:
+  template <typename T>
+  static constexpr bool isNumber =
+      std::is_arithmetic_v<T> && !std::same_as<T, char> &&
+      !std::same_as<T, signed char> && !std::same_as<T, unsigned char> &&
+      !std::same_as<T, bool>;
+
+  static constexpr char digitPairs[] =
+      "00010203040506070809101112131415161718192021222324"
+      "25262728293031323334353637383940414243444546474849"
+      "50515253545556575859606162636465666768697071727374"
+      "75767778798081828384858687888990919293949596979899";
+
+  // The eight ASCII digits of v < 10^8, leading zeros included, packed so
+  // that a little-endian store writes the most significant digit first.
+  // Each step splits every lane in two with a multiply-shift division:
+  // 10^4 in 32-bit lanes, then 100 in 16-bit lanes, then 10 in bytes.
+  static uint64_t eightDigits(uint32_t v) {
+    uint64_t merged = (v / 10000) | (static_cast<uint64_t>(v % 10000) << 32);
+    uint64_t div100 = ((merged * 10486) >> 20) & 0x0000007F0000007FULL;
+    uint64_t hundreds = ((merged - div100 * 100) << 16) | div100;
+    uint64_t div10 = ((hundreds * 103) >> 10) & 0x000F000F000F000FULL;
+    uint64_t tens = ((hundreds - div10 * 10) << 8) | div10;
+    return tens | 0x3030303030303030ULL;
+  }
+
+  static int decimalDigits(uint32_t v) {
+    static constexpr uint32_t powersOf10[] = {
+        1,      10,      100,      1000,      10000,
+        100000, 1000000, 10000000, 100000000, 1000000000};
+    v |= 1;
+    int guess = (std::bit_width(v) * 1233) >> 12;  // 1233 / 4096 ~ log10(2)
+    return guess + 1 - (v < powersOf10[guess]);
+  }
+
+  // May store up to 8 bytes past the last digit; callers keep
+  // maxNumberChars bytes free.
+  static char* formatUnsigned(char* p, uint32_t v) {
+    if (v >= 100000000) {
+      uint32_t top = v / 100000000;
+      if (top >= 10) {
+        std::memcpy(p, digitPairs + 2 * top, 2);
+        p += 2;
+      } else {
+        *p++ = static_cast<char>('0' + top);
+      }
+      uint64_t digits = eightDigits(v % 100000000);
+      std::memcpy(p, &digits, 8);
+      return p + 8;
+    }
+    int count = decimalDigits(v);
+    // Leading zeros sit in the low bytes; shifting drops them.
+    uint64_t digits = eightDigits(v) >> (8 * (8 - count));
+    std::memcpy(p, &digits, 8);
+    return p + count;
+  }
+
+  template <typename T>
+  static char* formatNumber(char* p, T value) {
+    if constexpr (std::is_integral_v<T> && std::endian::native ==
+                                               std::endian::little) {
+      using Unsigned = std::make_unsigned_t<T>;
+      Unsigned magnitude = static_cast<Unsigned>(value);
+      if constexpr (std::is_signed_v<T>) {
+        // Branch-free sign: random signs would defeat the predictor.
+        bool negative = value < 0;
+        *p = '-';
+        p += negative;
+        magnitude = negative ? Unsigned(0) - magnitude : magnitude;
+      }
+      if (magnitude <= UINT32_MAX)
+        return formatUnsigned(p, static_cast<uint32_t>(magnitude));
+      return std::to_chars(p, p + maxNumberChars, magnitude).ptr;
+    } else {
+      return std::to_chars(p, p + maxNumberChars, value).ptr;
+    }
+  }
+
+  // 3. Keeps the order of output written through the tied stream.
+  void prepare() {
+    if (mSize == 0 && mTie) mTie->flush();
+  }
+
+  int mFd;
+  size_t mCapacity;
+  std::unique_ptr<char[]> mBuffer;
+  size_t mSize = 0;
+  std::ostream* mTie;
+};
+
+inline FastOutput& fastOut() {
+  static FastOutput out(STDOUT_FILENO, FastOutput::defaultBufferSize,
+                        &std::cout);
+  return out;
+}
+
+#endif  // FAST_OUTPUT_H
@@ -0,0 +1,426 @@
+/* This file shows FlatMap from flat_map.h, a map stored as two sorted
+ * arrays, running the std::map examples of container_map.cpp, and measures
+ * it against std::map.
+ *
+ * 1. Initialization, including from_sorted() for data that is already in
+ *    key order
+ * 2. Accessing and modifying
+ * 3. Inserting and removing
+ * 4. Searching algorithms
+ * 5. Benchmark: building, random lookups and iteration over 1M keys
+ *
+ * Build with: g++ -std=c++20 -O2 flat_map.cpp
+ */
+
+#include "fast_output.h"
+#include "flat_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Initialization
+void initialization() {
+  // 1.1. Default initialization
+  std::cout << "1.1. Default initialization" << std::endl;
+  FlatMap<int, std::string> mp1;
+  printMap("Map", mp1);
+
+  // 1.2. Initializer list; the elements are sorted once and the first of
+  // equal keys is kept
+  std::cout << std::endl
+            << "1.2. Initializer list {{3, three}, {1, one}, {2, two}, "
+               "{1, I}}"
+            << std::endl;
+  FlatMap<int, std::string> mp2{{3, "three"}, {1, "one"}, {2, "two"},
+                                {1, "I"}};
+  printMap("Map", mp2);
+
+  // 1.3. Copying the elements of a std::map
+  std::cout << std::endl
+            << "1.3. Range initialization from a std::map" << std::endl;
+  std::map<int, std::string> source{{1, "one"}, {2, "two"}, {3, "three"}};
+  FlatMap<int, std::string> mp3(source.begin(), source.end());
+  printMap("Map", mp3);
+
+  // 1.4. A custom comparator
+  std::cout << std::endl
+            << "1.4. Initialization with std::greater<int> as comparator"
+            << std::endl;
+  FlatMap<int, std::string, std::greater<int>> mp4{
+      {1, "one"}, {2, "two"}, {3, "three"}};
+  printMap("Map", mp4);
+
+  // 1.5. from_sorted() adopts arrays that are already sorted and unique,
+  // skipping the sort
+  std::cout << std::endl
+            << "1.5. from_sorted() with keys {1, 2, 3} and values "
+               "{one, two, three}"
+            << std::endl;
+  auto mp5 = FlatMap<int, std::string>::from_sorted(
+      {1, 2, 3}, {"one", "two", "three"});
+  printMap("Map", mp5);
+}
+
+// 2. Accessing and modifying
+void accessingAndModifying() {
+  FlatMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  // 2.1. Using at(), which throws std::out_of_range for a missing key
+  std::cout << "2.1. Using at() to access key 2 and the missing key 4"
+            << std::endl;
+  std::cout << "mp.at(2): " << mp.at(2) << std::endl;
+  try {
+    mp.at(4);
+  } catch (const std::out_of_range& e) {
+    std::cout << "mp.at(4) throws: " << e.what() << std::endl;
+  }
+
+  // 2.2. Using iterators; it->second refers into the value array
+  std::cout << std::endl
+            << "2.2. Using an iterator to change the value of key 1 to I"
+            << std::endl;
+  printMap("Initial map", mp);
+  auto it = mp.begin();
+  it->second = "I";
+  printMap("Modified map", mp);
+
+  // 2.3. Reverse iteration
+  std::cout << std::endl << "2.3. Reverse iteration" << std::endl;
+  for (auto rit = mp.rbegin(); rit != mp.rend(); ++rit)
+    std::cout << "{" << rit->first << "," << rit->second << "} ";
+  std::cout << std::endl;
+
+  // 2.4. keys() and values() expose the two sorted arrays
+  std::cout << std::endl << "2.4. keys() and values()" << std::endl;
+  fastOut() << "Keys: ";
+  fastOut().writeRange(mp.keys()) << '\n';
+  fastOut() << "Values: ";
+  fastOut().writeRange(mp.values()) << '\n';
+  fastOut().flush();
+}
+
+// 3. Inserting and removing
+void insertingAndRemoving() {
+  FlatMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+  // 3.1. Using insert() to add elements. If the key already exists, the
+  // insertion is ignored
+  std::cout << "3.1. Using insert() to insert {1, I} and {4, four} to the map"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert({{1, "I"}, {4, "four"}});
+  printMap("Modified map", mp);
+
+  // 3.2. Using insert() to insert from another container. The new elements
+  // are sorted and merged in one pass
+  std::cout << std::endl
+            << "3.2. Using insert() to insert from another container with "
+               "elements {{2, II}, {5, five}}"
+            << std::endl;
+  printMap("Initial map", mp);
+  std::map<int, std::string> mp2{{2, "II"}, {5, "five"}};
+  mp.insert(mp2.begin(), mp2.end());
+  printMap("Modified map", mp);
+
+  // 3.3. Using insert_or_assign(), with and without a hint
+  std::cout << std::endl
+            << "3.3. Using insert_or_assign() to insert {1, I} and {6, six} "
+               "to the map"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert_or_assign(1, "I");
+  auto it = mp.end();
+  mp.insert_or_assign(it, 6, "six");  // the hint is right: no search
+  printMap("Modified map", mp);
+
+  // 3.4. Using emplace()
+  std::cout << std::endl
+            << "3.4. Using emplace() to insert {2, II} and {7, seven}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.emplace(2, "II");
+  mp.emplace(7, "seven");
+  printMap("Modified map", mp);
+
+  // 3.5. Using emplace_hint()
+  std::cout << std::endl
+            << "3.5. Using emplace_hint() to insert {8, eight}" << std::endl;
+  printMap("Initial map", mp);
+  mp.emplace_hint(mp.end(), 8, "eight");
+  printMap("Modified map", mp);
+
+  // 3.6. Using operator []
+  std::cout << std::endl
+            << "3.6. Using operator [] to insert {9, nine}" << std::endl;
+  printMap("Initial map", mp);
+  mp[9] = "nine";
+  printMap("Modified map", mp);
+
+  // 3.7. Using erase() to remove by key
+  std::cout << std::endl
+            << "3.7. Using erase() to remove {9, nine}" << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(9);
+  printMap("Modified map", mp);
+
+  // 3.8. Using erase() with an iterator
+  std::cout << std::endl
+            << "3.8. Using erase() with an iterator to remove {8, eight}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(mp.find(8));
+  printMap("Modified map", mp);
+
+  // 3.9. Using erase() with a range of iterators
+  std::cout << std::endl
+            << "3.9. Using erase() with a range to remove {4, four}, "
+               "{5, five}, {6, six}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(mp.find(4), mp.find(7));
+  printMap("Modified map", mp);
+
+  // 3.10. Using erase_if() to remove every element with an odd key
+  std::cout << std::endl
+            << "3.10. Using erase_if() to remove the odd keys" << std::endl;
+  printMap("Initial map", mp);
+  erase_if(mp, [](const auto& element) { return element.first % 2 != 0; });
+  printMap("Modified map", mp);
+
+  // 3.11. Using clear()
+  std::cout << std::endl << "3.11. Using clear()" << std::endl;
+  printMap("Initial map", mp);
+  mp.clear();
+  printMap("Modified map", mp);
+}
+
+// 4. Searching algorithms
+void searchingAlgorithms() {
+  FlatMap<int, std::string> mp{
+      {1, "one"}, {2, "two"}, {3, "three"}, {5, "five"}, {6, "six"}};
+  printMap("Map", mp);
+
+  // 4.1. find() and contains()
+  std::cout << std::endl << "4.1. find() and contains()" << std::endl;
+  auto it = mp.find(3);
+  if (it != mp.end())
+    std::cout << "Key 3 found with value " << it->second << std::endl;
+  std::cout << "contains(4): " << std::boolalpha << mp.contains(4)
+            << std::endl;
+
+  // 4.2. count()
+  std::cout << std::endl << "4.2. count()" << std::endl;
+  std::cout << "count(2): " << mp.count(2) << ", count(7): " << mp.count(7)
+            << std::endl;
+
+  // 4.3. lower_bound() and upper_bound()
+  std::cout << std::endl
+            << "4.3. lower_bound(4) and upper_bound(5)" << std::endl;
+  auto lower = mp.lower_bound(4);
+  auto upper = mp.upper_bound(5);
+  std::cout << "lower_bound(4): {" << lower->first << "," << lower->second
+            << "}" << std::endl;
+  std::cout << "upper_bound(5): {" << upper->first << "," << upper->second
+            << "}" << std::endl;
+
+  // 4.4. equal_range()
+  std::cout << std::endl << "4.4. equal_range(2)" << std::endl;
+  auto [first, last] = mp.equal_range(2);
+  std::cout << "Range holds " << last - first << " element with key "
+            << first->first << std::endl;
+
+  // 4.5. Heterogeneous lookup: std::less<> lets a std::string_view search
+  // a map of std::string without building a temporary string
+  std::cout << std::endl
+            << "4.5. Heterogeneous find() with a std::string_view"
+            << std::endl;
+  FlatMap<std::string, int, std::less<>> byName{
+      {"one", 1}, {"two", 2}, {"three", 3}};
+  std::string_view name = "two";
+  auto found = byName.find(name);
+  std::cout << "Value of " << name << ": " << found->second << std::endl;
+}
+
+// Applies random operations to a FlatMap and a std::map and compares them.
+bool checkAgainstStd() {
+  std::mt19937 gen(7);
+  bool ok = true;
+  for (int keyRange : {10, 1000}) {
+    FlatMap<int, int> flat;
+    std::map<int, int> reference;
+    for (int step = 0; step < 20000; ++step) {
+      int key = static_cast<int>(gen() % keyRange);
+      int value = static_cast<int>(gen() % 1000);
+      switch (gen() % 9) {
+        case 0:
+          ok = ok && flat.insert({key, value}).second ==
+                         reference.insert({key, value}).second;
+          break;
+        case 1:
+          flat.insert_or_assign(key, value);
+          reference.insert_or_assign(key, value);
+          break;
+        case 2:
+          flat.emplace_hint(flat.lower_bound(key), key, value);
+          reference.emplace_hint(reference.lower_bound(key), key, value);
+          break;
+        case 3:
+          ok = ok && flat.erase(key) == reference.erase(key);
+          break;
+        case 4: {
+          std::vector<std::pair<int, int>> batch(gen() % 20);
+          for (auto& [k, v] : batch) {
+            k = static_cast<int>(gen() % keyRange);
+            v = static_cast<int>(gen() % 1000);
+          }
+          flat.insert(batch.begin(), batch.end());
+          reference.insert(batch.begin(), batch.end());
+          break;
+        }
+        case 5: {
+          int to = key + static_cast<int>(gen() % 5);
+          flat.erase(flat.lower_bound(key), flat.lower_bound(to));
+          reference.erase(reference.lower_bound(key),
+                          reference.lower_bound(to));
+          break;
+        }
+        case 6:
+          flat[key] += value;
+          reference[key] += value;
+          break;
+        default: {
+          auto f = flat.upper_bound(key);
+          auto r = reference.upper_bound(key);
+          ok = ok && (f == flat.end()) == (r == reference.end()) &&
+               (f == flat.end() || f->first == r->first) &&
+               flat.count(key) == reference.count(key);
+          break;
+        }
+      }
+    }
+    ok = ok && flat.size() == reference.size() &&
+         std::equal(flat.begin(), flat.end(), reference.begin(),
+                    [](const auto& a, const auto& b) {
+                      return a.first == b.first && a.second == b.second;
+                    });
+  }
+  return ok;
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  constexpr size_t lookups = 1 << 23;
+  std::mt19937 gen(42);
+  std::vector<std::pair<int, int>> elements(size);
+  for (auto& [key, value] : elements) {
+    key = static_cast<int>(gen());
+    value = static_cast<int>(gen() % 1000);
+  }
+  std::vector<int> queries(lookups);
+  for (int& query : queries) query = elements[gen() % size].first;
+  // volatile keeps the compiler from dropping the unused results.
+  volatile long long sink = 0;
+
+  std::map<int, int> tree;
+  FlatMap<int, int> flat;
+  double treeBuild = measureMilliseconds(
+      [&] { tree.insert(elements.begin(), elements.end()); });
+  double flatBuild = measureMilliseconds(
+      [&] { flat.insert(elements.begin(), elements.end()); });
+  double flatFromSorted = measureMilliseconds([&] {
+    auto copy = FlatMap<int, int>::from_sorted(flat.keys(), flat.values());
+    sink = static_cast<long long>(copy.size());
+  });
+
+  double treeFind = measureMilliseconds([&] {
+    long long sum = 0;
+    for (int query : queries) sum += tree.find(query)->second;
+    sink = sum;
+  });
+  double flatFind = measureMilliseconds([&] {
+    long long sum = 0;
+    for (int query : queries) sum += flat.find(query)->second;
+    sink = sum;
+  });
+
+  constexpr int passes = 20;
+  double treeIterate = measureMilliseconds([&] {
+    long long sum = 0;
+    for (int pass = 0; pass < passes; ++pass)
+      for (const auto& [key, value] : tree) sum += value;
+    sink = sum;
+  });
+  double flatIterate = measureMilliseconds([&] {
+    long long sum = 0;
+    for (int pass = 0; pass < passes; ++pass)
+      for (const auto& [key, value] : flat) sum += value;
+    sink = sum;
+  });
+
+  std::cout << flat.size() << " int keys" << std::endl;
+  std::cout << "Build from unsorted pairs: std::map " << treeBuild
+            << " ms, FlatMap " << flatBuild << " ms ("
+            << treeBuild / flatBuild << "x)" << std::endl;
+  std::cout << "Build from sorted arrays with from_sorted(): "
+            << flatFromSorted << " ms" << std::endl;
+  std::cout << lookups << " random finds: std::map " << treeFind
+            << " ms, FlatMap " << flatFind << " ms ("
+            << treeFind / flatFind << "x)" << std::endl;
+  std::cout << passes << " full iterations: std::map " << treeIterate
+            << " ms, FlatMap " << flatIterate << " ms ("
+            << treeIterate / flatIterate << "x)" << std::endl;
+}
+
+int main() {
+  // Initialization
+  std::cout << "*** Initialization ***" << std::endl;
+  initialization();
+
+  // Accessing and modifying
+  std::cout << std::endl << "*** Accessing and modifying ***" << std::endl;
+  accessingAndModifying();
+
+  // Inserting and removing
+  std::cout << std::endl << "*** Inserting and removing ***" << std::endl;
+  insertingAndRemoving();
+
+  // Searching
+  std::cout << std::endl << "*** Searching algorithms ***" << std::endl;
+  searchingAlgorithms();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::map: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,594 @@
+/* This header implements FlatMap<Key, T, Compare>, a sorted associative
+ * container with the interface of std::map (the parts container_map.cpp
+ * exercises) stored in two contiguous arrays: one of keys, one of values.
+ *
+ * std::map allocates one node per element and follows a pointer per tree
+ * level. A FlatMap keeps the keys next to each other, so a lookup is a
+ * binary search over one array (written without a data-dependent branch)
+ * and iteration is a linear walk over two arrays. Inserting or erasing in
+ * the middle shifts the elements behind it, so the container suits maps
+ * that are built once, or in bulk, and then read many times:
+ *
+ * 1. Construction: from unsorted input (sorted once), or from_sorted() from
+ *    data that is already sorted and unique, which takes the arrays as is.
+ * 2. Iterators: random access. They dereference to
+ *    std::pair<const Key&, T&>, a pair of references into the two arrays,
+ *    so it->first and it->second work as with std::map.
+ * 3. Lookup: find(), count(), contains(), lower_bound(), upper_bound(),
+ *    equal_range(), at() and operator[]; heterogeneous lookup with a
+ *    transparent comparator such as std::less<>.
+ * 4. Modifiers: insert(), insert_or_assign(), emplace(), emplace_hint(),
+ *    try_emplace() and erase() by key, iterator or range. A range insert()
+ *    sorts the new elements and merges them in one linear pass.
+ *
+ * KeyContainer and MappedContainer default to std::vector; any random
+ * access sequence container works, e.g. std::pmr::vector. Iterators are
+ * invalidated by every insertion and erasure, as with std::vector.
+ */
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename KeyContainer = std::vector<Key>,
+          typename MappedContainer = std::vector<T>>
+class FlatMap {
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key, T>;
+  using key_compare = Compare;
+  using reference = std::pair<const Key&, T&>;
+  using const_reference = std::pair<const Key&, const T&>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using key_container_type = KeyContainer;
+  using mapped_container_type = MappedContainer;
+
+  // 1. Construction
+  FlatMap() = default;
+
+  explicit FlatMap(const Compare& comp) : mComp(comp) {}
+
+  // Allocator-aware containers (e.g. std::pmr::vector) can be passed in
+  // empty to choose where the elements live.
+  FlatMap(KeyContainer keys, MappedContainer values,
+          const Compare& comp = Compare())
+      : mKeys(std::move(keys)), mValues(std::move(values)), mComp(comp) {
+    checkSizes();
+    sortAndDeduplicate();
+  }
+
+  template <typename InputIt>
+  FlatMap(InputIt first, InputIt last, const Compare& comp = Compare())
+      : mComp(comp) {
+    insert(first, last);
+  }
+
+  FlatMap(std::initializer_list<value_type> init,
+          const Compare& comp = Compare())
+      : FlatMap(init.begin(), init.end(), comp) {}
+
+  // Takes arrays that are already sorted by comp and free of duplicates;
+  // nothing is sorted or copied.
+  static FlatMap from_sorted(KeyContainer keys, MappedContainer values,
+                             const Compare& comp = Compare()) {
+    FlatMap map(comp);
+    map.mKeys = std::move(keys);
+    map.mValues = std::move(values);
+    map.checkSizes();
+    return map;
+  }
+
+  // The same from a range of key/value pairs in ascending key order.
+  template <typename InputIt>
+  static FlatMap from_sorted(InputIt first, InputIt last,
+                             const Compare& comp = Compare()) {
+    FlatMap map(comp);
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+      map.reserve(static_cast<size_t>(std::distance(first, last)));
+    for (; first != last; ++first) {
+      auto&& [key, value] = *first;
+      map.mKeys.push_back(key);
+      map.mValues.push_back(value);
+    }
+    return map;
+  }
+
+  // 2. Iterators
+  iterator begin() noexcept { return {mKeys.cbegin(), mValues.begin()}; }
+  const_iterator begin() const noexcept {
+    return {mKeys.cbegin(), mValues.cbegin()};
+  }
+  iterator end() noexcept { return {mKeys.cend(), mValues.end()}; }
+  const_iterator end() const noexcept {
+    return {mKeys.cend(), mValues.cend()};
+  }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+  reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  // Capacity
+  bool empty() const noexcept { return mKeys.empty(); }
+  size_t size() const noexcept { return mKeys.size(); }
+  size_t max_size() const noexcept {
+    return std::min(mKeys.max_size(), mValues.max_size());
+  }
+
+  void reserve(size_t capacity) {
+    if constexpr (requires { mKeys.reserve(capacity); })
+      mKeys.reserve(capacity);
+    if constexpr (requires { mValues.reserve(capacity); })
+      mValues.reserve(capacity);
+  }
+
+  void shrink_to_fit() {
+    if constexpr (requires { mKeys.shrink_to_fit(); }) mKeys.shrink_to_fit();
+    if constexpr (requires { mValues.shrink_to_fit(); })
+      mValues.shrink_to_fit();
+  }
+
+  // Direct access to the sorted arrays.
+  const KeyContainer& keys() const noexcept { return mKeys; }
+  const MappedContainer& values() const noexcept { return mValues; }
+  key_compare key_comp() const { return mComp; }
+
+  // 3. Lookup
+  T& at(const Key& key) {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("FlatMap::at");
+    return it->second;
+  }
+
+  const T& at(const Key& key) const {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("FlatMap::at");
+    return it->second;
+  }
+
+  T& operator[](const Key& key) { return try_emplace(key).first->second; }
+  T& operator[](Key&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  iterator find(const Key& key) { return begin() + findIndex(key); }
+  const_iterator find(const Key& key) const {
+    return begin() + findIndex(key);
+  }
+  size_t count(const Key& key) const { return findIndex(key) != size(); }
+  bool contains(const Key& key) const { return findIndex(key) != size(); }
+
+  iterator lower_bound(const Key& key) {
+    return begin() + lowerBoundIndex(key);
+  }
+  const_iterator lower_bound(const Key& key) const {
+    return begin() + lowerBoundIndex(key);
+  }
+  iterator upper_bound(const Key& key) {
+    return begin() + upperBoundIndex(key);
+  }
+  const_iterator upper_bound(const Key& key) const {
+    return begin() + upperBoundIndex(key);
+  }
+  std::pair<iterator, iterator> equal_range(const Key& key) {
+    return {lower_bound(key), upper_bound(key)};
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      const Key& key) const {
+    return {lower_bound(key), upper_bound(key)};
+  }
+
+  // Heterogeneous lookup, e.g. std::string_view keys in a map of
+  // std::string with Compare = std::less<>.
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  iterator find(const K& key) {
+    return begin() + findIndex(key);
+  }
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  const_iterator find(const K& key) const {
+    return begin() + findIndex(key);
+  }
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  size_t count(const K& key) const {
+    return findIndex(key) != size();
+  }
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  bool contains(const K& key) const {
+    return findIndex(key) != size();
+  }
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  const_iterator lower_bound(const K& key) const {
+    return begin() + lowerBoundIndex(key);
+  }
+  template <typename K>
+    requires requires { typename Compare::is_transparent; }
+  const_iterator upper_bound(const K& key) const {
+    return begin() + upperBoundIndex(key);
+  }
+
+  // 4. Modifiers
+  // Inserts key with a value constructed from args unless key exists.
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    size_t index = lowerBoundIndex(key);
+    if (index != size() && !mComp(key, mKeys[index]))
+      return {begin() + index, false};
+    return {insertAt(index, std::forward<K>(key), std::forward<Args>(args)...),
+            true};
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+
+  // Inserts right before hint without a search if that keeps the keys
+  // sorted, as std::map does; otherwise behaves like emplace().
+  template <typename... Args>
+  iterator emplace_hint(const_iterator hint, Args&&... args) {
+    value_type value(std::forward<Args>(args)...);
+    size_t index = static_cast<size_t>(hint - cbegin());
+    if (hintFits(index, value.first))
+      return insertAt(index, std::move(value.first), std::move(value.second));
+    return try_emplace(std::move(value.first), std::move(value.second)).first;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return try_emplace(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+  iterator insert(const_iterator hint, const value_type& value) {
+    return emplace_hint(hint, value);
+  }
+
+  // Sorts the new elements and merges them with the existing ones in one
+  // pass. Like std::map, existing keys keep their value, and among equal
+  // new keys the first one wins.
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    std::vector<value_type> incoming(first, last);
+    if (incoming.empty()) return;
+    std::stable_sort(incoming.begin(), incoming.end(),
+                     [&](const value_type& a, const value_type& b) {
+                       return mComp(a.first, b.first);
+                     });
+
+    KeyContainer keys = emptyLike(mKeys);
+    MappedContainer values = emptyLike(mValues);
+    if constexpr (requires { keys.reserve(size_t{}); })
+      keys.reserve(size() + incoming.size());
+    if constexpr (requires { values.reserve(size_t{}); })
+      values.reserve(size() + incoming.size());
+    size_t i = 0;
+    auto next = incoming.begin();
+    auto append = [&](auto&& key, auto&& value) {
+      keys.push_back(std::forward<decltype(key)>(key));
+      values.push_back(std::forward<decltype(value)>(value));
+    };
+    while (i < size() || next != incoming.end()) {
+      if (next == incoming.end() ||
+          (i < size() && !mComp(next->first, mKeys[i]))) {
+        // The existing element is smaller or equal; an equal new key is
+        // dropped.
+        if (next != incoming.end() && !mComp(mKeys[i], next->first)) ++next;
+        append(std::move(mKeys[i]), std::move(mValues[i]));
+        ++i;
+      } else {
+        if (keys.empty() || mComp(keys.back(), next->first))
+          append(std::move(next->first), std::move(next->second));
+        ++next;
+      }
+    }
+    mKeys = std::move(keys);
+    mValues = std::move(values);
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& value) {
+    auto [it, inserted] =
+        try_emplace(std::forward<K>(key), std::forward<M>(value));
+    if (!inserted) it->second = std::forward<M>(value);
+    return {it, inserted};
+  }
+
+  template <typename K, typename M>
+  iterator insert_or_assign(const_iterator hint, K&& key, M&& value) {
+    size_t index = static_cast<size_t>(hint - cbegin());
+    if (index < size() && !mComp(key, mKeys[index]) &&
+        !mComp(mKeys[index], key)) {
+      mValues[index] = std::forward<M>(value);
+      return begin() + index;
+    }
+    if (hintFits(index, key))
+      return insertAt(index, std::forward<K>(key), std::forward<M>(value));
+    return insert_or_assign(std::forward<K>(key), std::forward<M>(value))
+        .first;
+  }
+
+  iterator erase(const_iterator pos) {
+    size_t index = static_cast<size_t>(pos - cbegin());
+    mKeys.erase(mKeys.begin() + index);
+    mValues.erase(mValues.begin() + index);
+    return begin() + index;
+  }
+
+  // Also accepts iterator, which would otherwise be ambiguous between the
+  // const_iterator and the key overload.
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t from = static_cast<size_t>(first - cbegin());
+    size_t to = static_cast<size_t>(last - cbegin());
+    mKeys.erase(mKeys.begin() + from, mKeys.begin() + to);
+    mValues.erase(mValues.begin() + from, mValues.begin() + to);
+    return begin() + from;
+  }
+
+  size_t erase(const Key& key) {
+    size_t index = findIndex(key);
+    if (index == size()) return 0;
+    erase(cbegin() + index);
+    return 1;
+  }
+
+  // Removes every element for which pred(std::pair<const Key&, T&>) holds,
+  // compacting both arrays in one pass.
+  template <typename Predicate>
+  friend size_t erase_if(FlatMap& map, Predicate pred) {
+    size_t kept = 0;
+    for (size_t i = 0; i < map.size(); ++i) {
+      if (pred(reference(map.mKeys[i], map.mValues[i]))) continue;
+      if (kept != i) {
+        map.mKeys[kept] = std::move(map.mKeys[i]);
+        map.mValues[kept] = std::move(map.mValues[i]);
+      }
+      ++kept;
+    }
+    size_t removed = map.size() - kept;
+    map.mKeys.erase(map.mKeys.begin() + kept, map.mKeys.end());
+    map.mValues.erase(map.mValues.begin() + kept, map.mValues.end());
+    return removed;
+  }
+
+  void clear() noexcept {
+    mKeys.clear();
+    mValues.clear();
+  }
+
+  void swap(FlatMap& other) noexcept {
+    using std::swap;
+    swap(mKeys, other.mKeys);
+    swap(mValues, other.mValues);
+    swap(mComp, other.mComp);
+  }
+
+  // Hands the arrays over, leaving the map empty.
+  std::pair<KeyContainer, MappedContainer> extract() && {
+    return {std::move(mKeys), std::move(mValues)};
+  }
+
+  friend bool operator==(const FlatMap& a, const FlatMap& b) {
+    return a.mKeys == b.mKeys && a.mValues == b.mValues;
+  }
+
+ private:
+  template <bool Const>
+  class Iterator {
+    using KeyIt = typename KeyContainer::const_iterator;
+    using MappedIt =
+        std::conditional_t<Const, typename MappedContainer::const_iterator,
+                           typename MappedContainer::iterator>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::pair<Key, T>;
+    using difference_type = ptrdiff_t;
+    using reference = std::pair<const Key&, std::conditional_t<Const, const T&,
+                                                               T&>>;
+    // Keys and values live in separate containers, so there is no pair in
+    // memory for operator-> to point to. It returns this proxy instead,
+    // which holds the pair of references; the proxy's own operator->
+    // yields its address, valid until the end of the full expression.
+    struct pointer {
+      reference ref;
+      const reference* operator->() const { return &ref; }
+    };
+
+    Iterator() = default;
+    Iterator(KeyIt key, MappedIt value) : mKey(key), mValue(value) {}
+    // A template, so that it does not replace the implicit copy
+    // constructor of the mutable iterator.
+    template <bool OtherConst>
+      requires(Const && !OtherConst)
+    Iterator(const Iterator<OtherConst>& other)
+        : mKey(other.mKey), mValue(other.mValue) {}
+
+    reference operator*() const { return {*mKey, *mValue}; }
+    pointer operator->() const { return {**this}; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() {
+      ++mKey;
+      ++mValue;
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+    Iterator& operator--() {
+      --mKey;
+      --mValue;
+      return *this;
+    }
+    Iterator operator--(int) {
+      Iterator old = *this;
+      --*this;
+      return old;
+    }
+    Iterator& operator+=(difference_type n) {
+      mKey += n;
+      mValue += n;
+      return *this;
+    }
+    Iterator& operator-=(difference_type n) { return *this += -n; }
+    friend Iterator operator+(Iterator it, difference_type n) {
+      return it += n;
+    }
+    friend Iterator operator+(difference_type n, Iterator it) {
+      return it += n;
+    }
+    friend Iterator operator-(Iterator it, difference_type n) {
+      return it -= n;
+    }
+    friend difference_type operator-(const Iterator& a, const Iterator& b) {
+      return a.mKey - b.mKey;
+    }
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.mKey == b.mKey;
+    }
+    friend auto operator<=>(const Iterator& a, const Iterator& b) {
+      return a.mKey <=> b.mKey;
+    }
+
+   private:
+    friend class FlatMap;
+    friend class Iterator<!Const>;
+
+    KeyIt mKey{};
+    MappedIt mValue{};
+  };
+
+  void checkSizes() const {
+    if (mKeys.size() != mValues.size())
+      throw std::invalid_argument("FlatMap: keys and values differ in size");
+  }
+
+  // An empty container using the same allocator as c.
+  template <typename Container>
+  static Container emptyLike(const Container& c) {
+    if constexpr (requires { c.get_allocator(); })
+      return Container(c.get_allocator());
+    else
+      return Container();
+  }
+
+  // Sorts both arrays by key through a permutation and keeps the first of
+  // equal keys.
+  void sortAndDeduplicate() {
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return mComp(mKeys[a], mKeys[b]);
+    });
+    KeyContainer keys = emptyLike(mKeys);
+    MappedContainer values = emptyLike(mValues);
+    for (size_t index : order) {
+      if (!keys.empty() && !mComp(keys.back(), mKeys[index])) continue;
+      keys.push_back(std::move(mKeys[index]));
+      values.push_back(std::move(mValues[index]));
+    }
+    mKeys = std::move(keys);
+    mValues = std::move(values);
+  }
+
+  // Binary search without a data-dependent branch: the range halves every
+  // step whatever the comparison says, and the result only selects the
+  // base, which compiles to a conditional move for simple keys.
+  template <typename K>
+  size_t lowerBoundIndex(const K& key) const {
+    size_t n = size();
+    if (n == 0) return 0;
+    auto base = mKeys.begin();
+    while (n > 1) {
+      size_t half = n / 2;
+      base = mComp(base[half], key) ? base + half : base;
+      n -= half;
+    }
+    return static_cast<size_t>(base - mKeys.begin()) + mComp(*base, key);
+  }
+
+  template <typename K>
+  size_t upperBoundIndex(const K& key) const {
+    size_t n = size();
+    if (n == 0) return 0;
+    auto base = mKeys.begin();
+    while (n > 1) {
+      size_t half = n / 2;
+      base = mComp(key, base[half]) ? base : base + half;
+      n -= half;
+    }
+    return static_cast<size_t>(base - mKeys.begin()) + !mComp(key, *base);
+  }
+
+  template <typename K>
+  size_t findIndex(const K& key) const {
+    size_t index = lowerBoundIndex(key);
+    if (index != size() && !mComp(key, mKeys[index])) return index;
+    return size();
+  }
+
+  // True if key belongs right before position index.
+  template <typename K>
+  bool hintFits(size_t index, const K& key) const {
+    return (index == 0 || mComp(mKeys[index - 1], key)) &&
+           (index == size() || mComp(key, mKeys[index]));
+  }
+
+  template <typename K, typename... Args>
+  iterator insertAt(size_t index, K&& key, Args&&... args) {
+    mKeys.insert(mKeys.begin() + index, std::forward<K>(key));
+    try {
+      mValues.emplace(mValues.begin() + index, std::forward<Args>(args)...);
+    } catch (...) {
+      mKeys.erase(mKeys.begin() + index);
+      throw;
+    }
+    return begin() + index;
+  }
+
+  KeyContainer mKeys;
+  MappedContainer mValues;
+  [[no_unique_address]] Compare mComp;
+};
+
+#endif  // FLAT_MAP_H
@@ -0,0 +1,258 @@
+/* This file shows IndexedMap from indexed_map.h, a std::map with an index
+ * on its values, on the value searches of container_map.cpp, and measures
+ * it against scanning a std::map with std::find_if and std::count.
+ *
+ * 1. Finding a key by its value (container_map.cpp 5.6)
+ * 2. Counting the elements that hold a value (container_map.cpp 8.1)
+ * 3. Keeping the index in step: insert_or_assign(), modify(), erase() and
+ *    erase_value()
+ * 4. OrderedValues: walking the elements in value order
+ * 5. Benchmark: building, then value lookups and counts against full scans
+ *
+ * Build with: g++ -std=c++20 -O2 indexed_map.cpp
+ */
+
+#include "fast_output.h"
+#include "indexed_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Finding a key by its value
+void findingByValue() {
+  IndexedMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+  std::cout << "1.1. find_value(two) instead of std::find_if" << std::endl;
+  printMap("Map", mp);
+  auto it = mp.find_value("two");
+  if (it != mp.end()) std::cout << "Found key: " << it->first << std::endl;
+  std::cout << "contains_value(four): " << std::boolalpha
+            << mp.contains_value("four") << std::endl;
+}
+
+// 2. Counting values
+void countingValues() {
+  IndexedMap<int, std::string> mp{{1, "one"}, {2, "one"}, {3, "three"}};
+  std::cout << "2.1. count_value(one) instead of std::count, and the keys "
+               "from equal_range_value(one)"
+            << std::endl;
+  printMap("Map", mp);
+  std::cout << "Result: " << mp.count_value("one") << std::endl;
+  std::vector<int> keys;
+  for (const auto& [key, value] : mp.equal_range_value("one"))
+    keys.push_back(key);
+  std::sort(keys.begin(), keys.end());
+  std::cout << "Keys:";
+  for (int key : keys) std::cout << " " << key;
+  std::cout << std::endl;
+}
+
+// 3. Keeping the index in step
+void modifiers() {
+  IndexedMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  std::cout << "3.1. insert_or_assign() {3, two}, then modify() key 1 to "
+               "append !"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert_or_assign(3, "two");
+  mp.modify(1, [](std::string& value) { value += "!"; });
+  printMap("Modified map", mp);
+  std::cout << "count_value(two): " << mp.count_value("two")
+            << ", count_value(three): " << mp.count_value("three")
+            << ", find_value(one!): key " << mp.find_value("one!")->first
+            << std::endl;
+
+  std::cout << std::endl
+            << "3.2. erase_value(two) removes every element holding it"
+            << std::endl;
+  std::cout << "Removed: " << mp.erase_value("two") << std::endl;
+  printMap("Modified map", mp);
+
+  std::cout << std::endl << "3.3. erase() key 1" << std::endl;
+  mp.erase(1);
+  std::cout << "Size: " << mp.size() << ", contains_value(one!): "
+            << std::boolalpha << mp.contains_value("one!") << std::endl;
+}
+
+// 4. OrderedValues
+void orderedValues() {
+  IndexedMap<std::string, int, std::less<std::string>, OrderedValues<int>>
+      scores{{"ann", 72}, {"bob", 95}, {"cid", 64}, {"dee", 95}};
+  std::cout << "4.1. The elements in key order, then in value order"
+            << std::endl;
+  printMap("By key", scores);
+  std::cout << "By value:";
+  for (const auto& [name, score] : scores.by_value())
+    std::cout << " {" << name << "," << score << "}";
+  std::cout << std::endl;
+  std::cout << "count_value(95): " << scores.count_value(95) << std::endl;
+}
+
+// Applies random operations to IndexedMaps with both indexes and to a
+// std::map, and compares every value lookup against a scan.
+template <typename ValueIndex>
+bool checkAgainstStd(uint32_t seed) {
+  std::mt19937 gen(seed);
+  IndexedMap<int, int, std::less<int>, ValueIndex> indexed;
+  std::map<int, int> reference;
+  bool ok = true;
+  for (int step = 0; step < 20000 && ok; ++step) {
+    int key = static_cast<int>(gen() % 500);
+    int value = static_cast<int>(gen() % 50);
+    switch (gen() % 7) {
+      case 0:
+        indexed.insert({key, value});
+        reference.insert({key, value});
+        break;
+      case 1:
+        indexed.insert_or_assign(key, value);
+        reference.insert_or_assign(key, value);
+        break;
+      case 2:
+        indexed.modify(key, [](int& v) { v = (v * 7 + 3) % 50; });
+        if (auto it = reference.find(key); it != reference.end())
+          it->second = (it->second * 7 + 3) % 50;
+        break;
+      case 3:
+        ok = indexed.erase(key) == reference.erase(key);
+        break;
+      case 4:
+        ok = indexed.erase_value(value) ==
+             std::erase_if(reference,
+                           [&](const auto& e) { return e.second == value; });
+        break;
+      default: {
+        auto it = indexed.find_value(value);
+        size_t count = static_cast<size_t>(std::count_if(
+            reference.begin(), reference.end(),
+            [&](const auto& e) { return e.second == value; }));
+        ok = indexed.count_value(value) == count &&
+             indexed.equal_range_value(value).size() == count &&
+             (count == 0 ? it == indexed.end() : it->second == value);
+        break;
+      }
+    }
+  }
+  IndexedMap<int, int, std::less<int>, ValueIndex> copy = indexed;
+  indexed.clear();
+  return ok && copy.map() == reference &&
+         copy.by_value().size() == reference.size();
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  constexpr size_t scans = 100;
+  constexpr size_t lookups = 1 << 20;
+  std::mt19937 gen(42);
+  std::vector<std::pair<int, int>> elements(size);
+  for (size_t i = 0; i < size; ++i)
+    elements[i] = {static_cast<int>(i), static_cast<int>(gen() % size)};
+  std::vector<int> queries(lookups);
+  for (int& query : queries) query = static_cast<int>(gen() % size);
+  // volatile keeps the compiler from dropping the unused results.
+  volatile long long sink = 0;
+
+  std::map<int, int> plain;
+  IndexedMap<int, int> hashed;
+  IndexedMap<int, int, std::less<int>, OrderedValues<int>> ordered;
+  double plainBuild = measureMilliseconds(
+      [&] { plain.insert(elements.begin(), elements.end()); });
+  double hashedBuild = measureMilliseconds(
+      [&] { hashed.insert(elements.begin(), elements.end()); });
+  double orderedBuild = measureMilliseconds(
+      [&] { ordered.insert(elements.begin(), elements.end()); });
+
+  // Per query: find the key holding a value, and count the value.
+  double scanTime = measureMilliseconds([&] {
+    long long sum = 0;
+    for (size_t q = 0; q < scans; ++q) {
+      int value = queries[q];
+      auto it = std::find_if(plain.begin(), plain.end(), [&](const auto& e) {
+        return e.second == value;
+      });
+      if (it != plain.end()) sum += it->first;
+      sum += std::count_if(plain.begin(), plain.end(),
+                           [&](const auto& e) { return e.second == value; });
+    }
+    sink = sum;
+  }) / scans;
+  auto lookupAll = [&](const auto& map) {
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (int value : queries) {
+        auto it = map.find_value(value);
+        if (it != map.end()) sum += it->first;
+        sum += static_cast<long long>(map.count_value(value));
+      }
+      sink = sum;
+    }) / lookups;
+  };
+  double hashedTime = lookupAll(hashed);
+  double orderedTime = lookupAll(ordered);
+
+  std::cout << size << " elements with random int values" << std::endl;
+  std::cout << "Building: std::map " << plainBuild << " ms, hashed index "
+            << hashedBuild << " ms, ordered index " << orderedBuild << " ms"
+            << std::endl;
+  std::cout << "One find + count by value: std::find_if + std::count_if "
+            << scanTime * 1000 << " us, HashedValues " << hashedTime * 1000
+            << " us (" << scanTime / hashedTime << "x), OrderedValues "
+            << orderedTime * 1000 << " us (" << scanTime / orderedTime << "x)"
+            << std::endl;
+}
+
+int main() {
+  // Finding by value
+  std::cout << "*** Finding a key by its value ***" << std::endl;
+  findingByValue();
+
+  // Counting values
+  std::cout << std::endl << "*** Counting values ***" << std::endl;
+  countingValues();
+
+  // Modifiers
+  std::cout << std::endl << "*** Keeping the index in step ***" << std::endl;
+  modifiers();
+
+  // OrderedValues
+  std::cout << std::endl << "*** OrderedValues ***" << std::endl;
+  orderedValues();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Value lookups match scanning a std::map: "
+            << std::boolalpha
+            << (checkAgainstStd<HashedValues<int>>(1) &&
+                checkAgainstStd<OrderedValues<int>>(2))
+            << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
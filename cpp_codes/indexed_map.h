@@ -0,0 +1,393 @@
+/* This header implements IndexedMap<Key, T, Compare, ValueIndex>, a
+ * std::map that also indexes its values. container_map.cpp finds a key by
+ * value with std::find_if and counts values with std::count, each a walk
+ * over the whole tree; here the same questions are answered by the index:
+ *
+ * 1. The index holds one std::map iterator per element. Map nodes never
+ *    move, so the iterators stay valid until the element is erased, the
+ *    values are not stored twice, and a value lookup lands directly on its
+ *    element.
+ * 2. ValueIndex chooses the index: HashedValues<T> (the default) finds and
+ *    counts a value in O(1) on average, OrderedValues<T> in O(log n) and
+ *    also walks the elements in value order, equal values in key order.
+ * 3. Modifiers keep both sides in step: insert(), emplace(),
+ *    insert_or_assign(), modify(), erase() by key, iterator or value, and
+ *    clear(). Iterators are const, since assigning through one would
+ *    bypass the index; values change through insert_or_assign() or
+ *    modify().
+ * 4. Value lookup: find_value(), contains_value(), count_value(),
+ *    equal_range_value() and erase_value().
+ *
+ * Replacing or erasing an element first removes its index entry.
+ * OrderedValues orders equal values by key, so the entry is found in
+ * O(log n). HashedValues has no order among equal values and walks them,
+ * so the cost is O(k) for k elements sharing the old value; prefer
+ * OrderedValues when many elements hold the same value.
+ */
+
+#ifndef INDEXED_MAP_H
+#define INDEXED_MAP_H
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+// Index policies. Both index iterators to the map's elements by the T they
+// point to; lookups take a T directly. KeyCompare is the map's comparator.
+template <typename T, typename Hash = std::hash<T>,
+          typename Equal = std::equal_to<T>>
+struct HashedValues {
+  template <typename Iterator>
+  struct Hasher {
+    using is_transparent = void;
+    size_t operator()(const Iterator& it) const { return hash(it->second); }
+    size_t operator()(const T& value) const { return hash(value); }
+    [[no_unique_address]] Hash hash;
+  };
+
+  template <typename Iterator>
+  struct KeyEqual {
+    using is_transparent = void;
+    static const T& get(const Iterator& it) { return it->second; }
+    static const T& get(const T& value) { return value; }
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+      return equal(get(a), get(b));
+    }
+    [[no_unique_address]] Equal equal;
+  };
+
+  template <typename Iterator, typename KeyCompare>
+  using Index = std::unordered_multiset<Iterator, Hasher<Iterator>,
+                                        KeyEqual<Iterator>>;
+};
+
+template <typename T, typename Compare = std::less<T>>
+struct OrderedValues {
+  template <typename Iterator, typename KeyCompare>
+  struct Less {
+    using is_transparent = void;
+    static const T& get(const Iterator& it) { return it->second; }
+    static const T& get(const T& value) { return value; }
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+      return comp(get(a), get(b));
+    }
+    // Between two elements, equal values fall back to the keys, so every
+    // element has a single place in the index.
+    bool operator()(const Iterator& a, const Iterator& b) const {
+      if (comp(a->second, b->second)) return true;
+      if (comp(b->second, a->second)) return false;
+      return keyComp(a->first, b->first);
+    }
+    [[no_unique_address]] Compare comp;
+    [[no_unique_address]] KeyCompare keyComp;
+  };
+
+  template <typename Iterator, typename KeyCompare>
+  using Index = std::set<Iterator, Less<Iterator, KeyCompare>>;
+};
+
+template <typename Key, typename T, typename Compare = std::less<Key>,
+          typename ValueIndex = HashedValues<T>>
+class IndexedMap {
+  using Map = std::map<Key, T, Compare>;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = typename Map::value_type;
+  using size_type = size_t;
+  using key_compare = Compare;
+  using const_iterator = typename Map::const_iterator;
+  using iterator = const_iterator;
+
+ private:
+  using Index = typename ValueIndex::template Index<const_iterator, Compare>;
+
+  // An ordered index needs the map's comparator to order equal values.
+  static Index makeIndex(const Compare& comp) {
+    if constexpr (requires { typename Index::key_compare; })
+      return Index(typename Index::key_compare{{}, comp});
+    else
+      return Index();
+  }
+
+ public:
+  // Walks index entries, dereferencing to the elements they refer to.
+  class ValueIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = IndexedMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    ValueIterator() = default;
+    explicit ValueIterator(typename Index::const_iterator it) : mIt(it) {}
+
+    reference operator*() const { return **mIt; }
+    pointer operator->() const { return &**mIt; }
+    ValueIterator& operator++() {
+      ++mIt;
+      return *this;
+    }
+    ValueIterator operator++(int) { return ValueIterator(mIt++); }
+    bool operator==(const ValueIterator&) const = default;
+
+   private:
+    typename Index::const_iterator mIt;
+  };
+
+  struct ValueRange {
+    ValueIterator first;
+    ValueIterator last;
+    ValueIterator begin() const { return first; }
+    ValueIterator end() const { return last; }
+    size_t size() const {
+      return static_cast<size_t>(std::distance(first, last));
+    }
+  };
+
+  // 1. Construction
+  IndexedMap() = default;
+
+  explicit IndexedMap(const Compare& comp)
+      : mMap(comp), mIndex(makeIndex(comp)) {}
+
+  template <typename InputIt>
+  IndexedMap(InputIt first, InputIt last, const Compare& comp = Compare())
+      : mMap(first, last, comp), mIndex(makeIndex(comp)) {
+    rebuildIndex();
+  }
+
+  IndexedMap(std::initializer_list<value_type> init,
+             const Compare& comp = Compare())
+      : IndexedMap(init.begin(), init.end(), comp) {}
+
+  // The index of a copy must point into the copy's own nodes.
+  IndexedMap(const IndexedMap& other)
+      : mMap(other.mMap), mIndex(makeIndex(other.key_comp())) {
+    rebuildIndex();
+  }
+
+  // Moving a std::map keeps its nodes, so the index moves along.
+  IndexedMap(IndexedMap&&) = default;
+
+  IndexedMap& operator=(const IndexedMap& other) {
+    if (this != &other) {
+      IndexedMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  IndexedMap& operator=(IndexedMap&&) = default;
+
+  // 2. Iterators and capacity, in key order
+  const_iterator begin() const noexcept { return mMap.begin(); }
+  const_iterator end() const noexcept { return mMap.end(); }
+  const_iterator cbegin() const noexcept { return mMap.cbegin(); }
+  const_iterator cend() const noexcept { return mMap.cend(); }
+  auto rbegin() const noexcept { return mMap.rbegin(); }
+  auto rend() const noexcept { return mMap.rend(); }
+
+  bool empty() const noexcept { return mMap.empty(); }
+  size_t size() const noexcept { return mMap.size(); }
+  key_compare key_comp() const { return mMap.key_comp(); }
+
+  // 3. Key lookup
+  const_iterator find(const Key& key) const { return mMap.find(key); }
+  bool contains(const Key& key) const { return mMap.contains(key); }
+  size_t count(const Key& key) const { return mMap.count(key); }
+  const_iterator lower_bound(const Key& key) const {
+    return mMap.lower_bound(key);
+  }
+  const_iterator upper_bound(const Key& key) const {
+    return mMap.upper_bound(key);
+  }
+  std::pair<const_iterator, const_iterator> equal_range(
+      const Key& key) const {
+    return mMap.equal_range(key);
+  }
+
+  const T& at(const Key& key) const {
+    auto it = mMap.find(key);
+    if (it == mMap.end()) throw std::out_of_range("IndexedMap::at");
+    return it->second;
+  }
+
+  // 4. Value lookup
+  // Some element holding value, or end().
+  const_iterator find_value(const T& value) const {
+    auto it = mIndex.find(value);
+    return it == mIndex.end() ? end() : *it;
+  }
+
+  bool contains_value(const T& value) const {
+    return mIndex.find(value) != mIndex.end();
+  }
+
+  size_t count_value(const T& value) const { return mIndex.count(value); }
+
+  // Every element holding value: in no particular order for HashedValues,
+  // in key order for OrderedValues.
+  ValueRange equal_range_value(const T& value) const {
+    auto [first, last] = mIndex.equal_range(value);
+    return {ValueIterator(first), ValueIterator(last)};
+  }
+
+  // Every element, grouped by value; sorted by value for OrderedValues.
+  ValueRange by_value() const {
+    return {ValueIterator(mIndex.begin()), ValueIterator(mIndex.end())};
+  }
+
+  // 5. Modifiers
+  std::pair<const_iterator, bool> insert(const value_type& element) {
+    return emplace(element);
+  }
+
+  template <typename... Args>
+  std::pair<const_iterator, bool> emplace(Args&&... args) {
+    auto result = mMap.emplace(std::forward<Args>(args)...);
+    if (result.second) indexNew(result.first);
+    return result;
+  }
+
+  template <typename... Args>
+  std::pair<const_iterator, bool> try_emplace(const Key& key,
+                                              Args&&... args) {
+    auto result = mMap.try_emplace(key, std::forward<Args>(args)...);
+    if (result.second) indexNew(result.first);
+    return result;
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) emplace(*first);
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <typename V>
+  std::pair<const_iterator, bool> insert_or_assign(const Key& key,
+                                                   V&& value) {
+    auto it = mMap.find(key);
+    if (it == mMap.end()) return try_emplace(key, std::forward<V>(value));
+    reindex(it, [&](T& current) { current = std::forward<V>(value); });
+    return {it, false};
+  }
+
+  // Calls f(T&) on the value of key and reindexes it; returns false if the
+  // key is missing.
+  template <typename Function>
+  bool modify(const Key& key, Function&& f) {
+    auto it = mMap.find(key);
+    if (it == mMap.end()) return false;
+    reindex(it, std::forward<Function>(f));
+    return true;
+  }
+
+  const_iterator erase(const_iterator pos) {
+    unindex(pos);
+    return mMap.erase(pos);
+  }
+
+  size_t erase(const Key& key) {
+    auto it = mMap.find(key);
+    if (it == mMap.end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  // Erases every element holding value, without walking the map.
+  size_t erase_value(const T& value) {
+    auto [first, last] = mIndex.equal_range(value);
+    size_t removed = 0;
+    while (first != last) {
+      const_iterator element = *first;
+      first = mIndex.erase(first);
+      mMap.erase(element);
+      ++removed;
+    }
+    return removed;
+  }
+
+  void clear() noexcept {
+    mIndex.clear();
+    mMap.clear();
+  }
+
+  void swap(IndexedMap& other) noexcept {
+    mMap.swap(other.mMap);
+    mIndex.swap(other.mIndex);
+  }
+
+  friend bool operator==(const IndexedMap& a, const IndexedMap& b) {
+    return a.mMap == b.mMap;
+  }
+
+  // The elements as a plain std::map, for code that expects one.
+  const Map& map() const noexcept { return mMap; }
+
+ private:
+  // Undoes the map insertion if the index cannot take the element.
+  void indexNew(typename Map::iterator it) {
+    try {
+      mIndex.insert(it);
+    } catch (...) {
+      mMap.erase(it);
+      throw;
+    }
+  }
+
+  // Removes exactly this element's entry: a keyed lookup in an ordered
+  // index, a walk over the equal values in a hashed one.
+  void unindex(const_iterator element) {
+    if constexpr (requires { typename Index::key_compare; }) {
+      mIndex.erase(element);
+    } else {
+      auto [first, last] = mIndex.equal_range(element->second);
+      for (; first != last; ++first) {
+        if (*first == element) {
+          mIndex.erase(first);
+          return;
+        }
+      }
+    }
+  }
+
+  // If the index cannot take the element back, the element is erased so
+  // that the map and the index still agree.
+  template <typename Function>
+  void reindex(typename Map::iterator it, Function&& f) {
+    unindex(it);
+    try {
+      f(it->second);
+    } catch (...) {
+      indexNew(it);
+      throw;
+    }
+    indexNew(it);
+  }
+
+  void rebuildIndex() {
+    mIndex.clear();
+    if constexpr (requires { mIndex.reserve(size_t()); })
+      mIndex.reserve(mMap.size());
+    for (auto it = mMap.cbegin(); it != mMap.cend(); ++it) mIndex.insert(it);
+  }
+
+  Map mMap;
+  Index mIndex = makeIndex(Compare());
+};
+
+#endif  // INDEXED_MAP_H
@@ -0,0 +1,498 @@
+/* This file implements lazy, fused range pipelines. modifyingAlgorithms() and
+ * reversingAndRotatingAlgorithms() in container_vector.cpp write every step
+ * into a temporary vector (vec3 for std::transform(), vec2 for
+ * std::reverse_copy() and std::rotate_copy()), so a chain of k steps reads
+ * and writes the data k times. Here each step is a view that only describes
+ * the work; nothing runs until a terminal operation pulls the elements
+ * through all stages in a single loop.
+ *
+ * 1. Pipeline model
+ *    Every view has forEach(sink), which pushes its elements into a
+ *    callable. Views that keep random access (everything but filter) also
+ *    have size() and operator[], so reverse and rotate can be stacked on
+ *    top of them and collect() can write straight into a sized vector.
+ * 2. Views
+ *    2.1. view(vec): the source
+ *    2.2. transform(f)
+ *    2.3. replaceIf(pred, value)
+ *    2.4. filter(pred)
+ *    2.5. reverse()
+ *    2.6. rotate(middle)
+ * 3. Terminal operations: reduce(), count(), collect()
+ * 4. Examples mirroring container_vector.cpp
+ * 5. Benchmark: eager temporaries against one fused pass
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native lazy_pipeline.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1. Pipeline model
+template <typename View>
+concept RandomAccessView = requires(const View& view, size_t i) {
+  { view.size() } -> std::convertible_to<size_t>;
+  view[i];
+};
+
+// Adaptors (transform(f), reverse(), reduce(), ...) are small objects that
+// remember their arguments. `view | adaptor` calls adaptor(view), which
+// returns either a new view or, for terminal operations, the result.
+struct AdaptorTag {};
+
+template <typename Adaptor>
+concept PipelineAdaptor = std::derived_from<Adaptor, AdaptorTag>;
+
+template <typename View, PipelineAdaptor Adaptor>
+auto operator|(const View& view, const Adaptor& adaptor) {
+  return adaptor(view);
+}
+
+// Pushes every element of a random-access view into sink in index order.
+template <RandomAccessView View, typename Sink>
+void forEachIndex(const View& view, Sink&& sink) {
+  const size_t size = view.size();
+  for (size_t i = 0; i < size; ++i) sink(view[i]);
+}
+
+// 2.1. view(vec)
+template <typename T>
+class VectorView {
+ public:
+  using value_type = T;
+
+  explicit VectorView(const std::vector<T>& vec)
+      : mData(vec.data()), mSize(vec.size()) {}
+
+  size_t size() const { return mSize; }
+  const T& operator[](size_t i) const { return mData[i]; }
+
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    forEachIndex(*this, sink);
+  }
+
+ private:
+  const T* mData;
+  size_t mSize;
+};
+
+// The vector must outlive the pipeline.
+template <typename T>
+VectorView<T> view(const std::vector<T>& vec) {
+  return VectorView<T>(vec);
+}
+
+// 2.2. transform(f)
+template <typename Base, typename Function>
+class TransformView {
+ public:
+  using value_type = std::decay_t<
+      std::invoke_result_t<const Function&, typename Base::value_type>>;
+
+  TransformView(Base base, Function function)
+      : mBase(std::move(base)), mFunction(std::move(function)) {}
+
+  size_t size() const
+    requires RandomAccessView<Base>
+  {
+    return mBase.size();
+  }
+  value_type operator[](size_t i) const
+    requires RandomAccessView<Base>
+  {
+    return mFunction(mBase[i]);
+  }
+
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    mBase.forEach([&](const auto& x) { sink(mFunction(x)); });
+  }
+
+ private:
+  Base mBase;
+  Function mFunction;
+};
+
+template <typename Function>
+struct TransformAdaptor : AdaptorTag {
+  Function function;
+
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    return TransformView<Base, Function>(base, function);
+  }
+};
+
+template <typename Function>
+TransformAdaptor<Function> transform(Function function) {
+  return {{}, std::move(function)};
+}
+
+// 2.3. replaceIf(pred, value)
+// Lazy std::replace_if(): elements matching pred are seen as value. Written
+// as a select rather than a branch so the fused loop still vectorizes.
+template <typename Base, typename Predicate>
+class ReplaceIfView {
+ public:
+  using value_type = typename Base::value_type;
+
+  ReplaceIfView(Base base, Predicate pred, value_type value)
+      : mBase(std::move(base)), mPred(std::move(pred)), mValue(value) {}
+
+  size_t size() const
+    requires RandomAccessView<Base>
+  {
+    return mBase.size();
+  }
+  value_type operator[](size_t i) const
+    requires RandomAccessView<Base>
+  {
+    return replace(mBase[i]);
+  }
+
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    mBase.forEach([&](const auto& x) { sink(replace(x)); });
+  }
+
+ private:
+  value_type replace(const value_type& x) const {
+    return mPred(x) ? mValue : x;
+  }
+
+  Base mBase;
+  Predicate mPred;
+  value_type mValue;
+};
+
+template <typename Predicate, typename T>
+struct ReplaceIfAdaptor : AdaptorTag {
+  Predicate pred;
+  T value;
+
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    return ReplaceIfView<Base, Predicate>(base, pred, value);
+  }
+};
+
+template <typename Predicate, typename T>
+ReplaceIfAdaptor<Predicate, T> replaceIf(Predicate pred, T value) {
+  return {{}, std::move(pred), std::move(value)};
+}
+
+// 2.4. filter(pred)
+// The number of survivors is unknown until the elements are visited, so a
+// filtered view is push-only: it has no size() or operator[].
+template <typename Base, typename Predicate>
+class FilterView {
+ public:
+  using value_type = typename Base::value_type;
+
+  FilterView(Base base, Predicate pred)
+      : mBase(std::move(base)), mPred(std::move(pred)) {}
+
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    mBase.forEach([&](const auto& x) {
+      if (mPred(x)) sink(x);
+    });
+  }
+
+ private:
+  Base mBase;
+  Predicate mPred;
+};
+
+template <typename Predicate>
+struct FilterAdaptor : AdaptorTag {
+  Predicate pred;
+
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    return FilterView<Base, Predicate>(base, pred);
+  }
+};
+
+template <typename Predicate>
+FilterAdaptor<Predicate> filter(Predicate pred) {
+  return {{}, std::move(pred)};
+}
+
+// 2.5. reverse()
+template <RandomAccessView Base>
+class ReverseView {
+ public:
+  using value_type = typename Base::value_type;
+
+  explicit ReverseView(Base base) : mBase(std::move(base)) {}
+
+  size_t size() const { return mBase.size(); }
+  decltype(auto) operator[](size_t i) const {
+    return mBase[mBase.size() - 1 - i];
+  }
+
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    for (size_t i = mBase.size(); i-- > 0;) sink(mBase[i]);
+  }
+
+ private:
+  Base mBase;
+};
+
+struct ReverseAdaptor : AdaptorTag {
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    static_assert(RandomAccessView<Base>,
+                  "reverse() needs a random-access view; apply it before "
+                  "filter() or collect() first");
+    return ReverseView<Base>(base);
+  }
+};
+
+inline ReverseAdaptor reverse() { return {}; }
+
+// 2.6. rotate(middle)
+// Lazy std::rotate_copy(): element `middle` becomes the first one.
+template <RandomAccessView Base>
+class RotateView {
+ public:
+  using value_type = typename Base::value_type;
+
+  RotateView(Base base, size_t middle)
+      : mBase(std::move(base)),
+        mMiddle(mBase.size() == 0 ? 0 : middle % mBase.size()) {}
+
+  size_t size() const { return mBase.size(); }
+  decltype(auto) operator[](size_t i) const {
+    size_t j = i + mMiddle;
+    if (j >= mBase.size()) j -= mBase.size();
+    return mBase[j];
+  }
+
+  // Two straight loops instead of a wrap-around test per element.
+  template <typename Sink>
+  void forEach(Sink&& sink) const {
+    const size_t size = mBase.size();
+    for (size_t i = mMiddle; i < size; ++i) sink(mBase[i]);
+    for (size_t i = 0; i < mMiddle; ++i) sink(mBase[i]);
+  }
+
+ private:
+  Base mBase;
+  size_t mMiddle;
+};
+
+struct RotateAdaptor : AdaptorTag {
+  size_t middle;
+
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    static_assert(RandomAccessView<Base>,
+                  "rotate() needs a random-access view; apply it before "
+                  "filter() or collect() first");
+    return RotateView<Base>(base, middle);
+  }
+};
+
+inline RotateAdaptor rotate(size_t middle) { return {{}, middle}; }
+
+// 3. Terminal operations
+template <typename T, typename BinaryOp>
+struct ReduceAdaptor : AdaptorTag {
+  T init;
+  BinaryOp op;
+
+  template <typename Base>
+  T operator()(const Base& base) const {
+    T result = init;
+    base.forEach([&](const auto& x) { result = op(result, x); });
+    return result;
+  }
+};
+
+template <typename T, typename BinaryOp = std::plus<>>
+ReduceAdaptor<T, BinaryOp> reduce(T init, BinaryOp op = {}) {
+  return {{}, std::move(init), std::move(op)};
+}
+
+struct CountAdaptor : AdaptorTag {
+  template <typename Base>
+  size_t operator()(const Base& base) const {
+    if constexpr (RandomAccessView<Base>) {
+      return base.size();
+    } else {
+      size_t count = 0;
+      base.forEach([&](const auto&) { ++count; });
+      return count;
+    }
+  }
+};
+
+inline CountAdaptor count() { return {}; }
+
+struct CollectAdaptor : AdaptorTag {
+  template <typename Base>
+  auto operator()(const Base& base) const {
+    std::vector<typename Base::value_type> result;
+    if constexpr (RandomAccessView<Base>) {
+      // Known size: one allocation and plain indexed stores.
+      result.resize(base.size());
+      auto* out = result.data();
+      base.forEach([&](const auto& x) { *out++ = x; });
+    } else {
+      base.forEach([&](const auto& x) { result.push_back(x); });
+    }
+    return result;
+  }
+};
+
+inline CollectAdaptor collect() { return {}; }
+
+// 4. Examples mirroring container_vector.cpp
+template <typename T>
+void printVector(const std::string& vectorName, const std::vector<T>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void pipelineExamples() {
+  std::vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  auto square = [](int x) { return x * x; };
+
+  // 4.1. transform (7.7. std::transform())
+  std::cout << "4.1. Using transform() to apply x^2 without a second vector"
+            << std::endl;
+  printVector("Initial vector", vec);
+  printVector("Collected vector", view(vec) | transform(square) | collect());
+
+  // 4.2. replaceIf (7.6. std::replace_if())
+  std::cout << std::endl
+            << "4.2. Using replaceIf() to see elements x >= 10 as 1"
+            << std::endl;
+  printVector("Collected vector",
+              view(vec) | replaceIf([](int x) { return x >= 10; }, 1) |
+                  collect());
+
+  // 4.3. reverse and rotate (9.2. std::reverse_copy(), 9.4. rotate_copy())
+  std::cout << std::endl
+            << "4.3. Using reverse() and rotate(2) instead of reverse_copy() "
+               "and rotate_copy()"
+            << std::endl;
+  printVector("Reversed", view(vec) | reverse() | collect());
+  printVector("Rotated", view(vec) | rotate(2) | collect());
+  printVector("Reversed, then rotated",
+              view(vec) | reverse() | rotate(2) | collect());
+
+  // 4.4. A whole chain, one pass
+  std::cout << std::endl
+            << "4.4. Chaining reverse, rotate, transform, filter and reduce"
+            << std::endl;
+  auto pipeline = view(vec) | reverse() | rotate(2) | transform(square) |
+                  filter([](int x) { return x % 2 == 0; });
+  printVector("Even squares", pipeline | collect());
+  std::cout << "Count: " << (pipeline | count())
+            << ", sum: " << (pipeline | reduce(0)) << std::endl;
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 25;
+  constexpr size_t middle = size / 3;
+  constexpr double bytesPerElement = sizeof(double);
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> input(size);
+  for (double& x : input) x = dist(gen);
+
+  auto scale = [](double x) { return 3.0 * x + 1.0; };
+  auto isNegative = [](double x) { return x < 0.0; };
+  auto isLarge = [](double x) { return x > 2.0; };
+
+  std::cout << "Elements: " << size << " ("
+            << size * bytesPerElement / (1 << 20) << " MiB)" << std::endl;
+
+  // Eager: every step writes a temporary, as container_vector.cpp does.
+  double eagerSum = 0.0;
+  double eager = measureMilliseconds([&] {
+    std::vector<double> vec2(size);
+    std::transform(input.begin(), input.end(), vec2.begin(), scale);
+    std::replace_if(vec2.begin(), vec2.end(), isNegative, 0.0);
+    std::vector<double> vec3(size);
+    std::reverse_copy(vec2.begin(), vec2.end(), vec3.begin());
+    std::vector<double> vec4(size);
+    std::rotate_copy(vec3.begin(), vec3.begin() + middle, vec3.end(),
+                     vec4.begin());
+    std::vector<double> vec5;
+    std::copy_if(vec4.begin(), vec4.end(), std::back_inserter(vec5), isLarge);
+    eagerSum = std::accumulate(vec5.begin(), vec5.end(), 0.0);
+  });
+
+  // Lazy: one loop over the input, nothing is stored.
+  double lazySum = 0.0;
+  double lazy = measureMilliseconds([&] {
+    lazySum = view(input) | transform(scale) | replaceIf(isNegative, 0.0) |
+              reverse() | rotate(middle) | filter(isLarge) | reduce(0.0);
+  });
+
+  // Both read the input once; the eager version also writes and re-reads
+  // four temporaries.
+  double inputGiB = size * bytesPerElement / (1 << 30);
+  std::cout << "Eager (5 passes): " << eager << " ms, "
+            << inputGiB / (eager / 1000) << " GiB/s of input" << std::endl;
+  std::cout << "Fused (1 pass):   " << lazy << " ms, "
+            << inputGiB / (lazy / 1000) << " GiB/s of input" << std::endl;
+  std::cout << "Same sum: " << std::boolalpha << (eagerSum == lazySum)
+            << std::endl;
+
+  std::vector<double> eagerVec, lazyVec;
+  double eagerCollect = measureMilliseconds([&] {
+    std::vector<double> vec2(size);
+    std::transform(input.begin(), input.end(), vec2.begin(), scale);
+    eagerVec.resize(size);
+    std::reverse_copy(vec2.begin(), vec2.end(), eagerVec.begin());
+  });
+  double lazyCollect = measureMilliseconds([&] {
+    lazyVec = view(input) | transform(scale) | reverse() | collect();
+  });
+  std::cout << "transform + reverse_copy: " << eagerCollect
+            << " ms, fused collect(): " << lazyCollect
+            << " ms, same result: " << (eagerVec == lazyVec) << std::endl;
+}
+
+int main() {
+  // Pipelines
+  std::cout << "*** Lazy pipelines ***" << std::endl;
+  pipelineExamples();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
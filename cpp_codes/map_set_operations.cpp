@@ -0,0 +1,263 @@
+/* This file shows the map set operations of map_set_operations.h on the
+ * examples of setOperationAlgorithms() in container_map.cpp, and measures
+ * them against std::set_union() and friends writing through std::inserter().
+ *
+ * 1. Union, intersection, difference and symmetric difference of two
+ *    std::maps
+ * 2. Conflict policies: KeepLeft, KeepRight and a combine function
+ * 3. Result types: FlatMap, BTreeMap and std::map, and mixed inputs
+ * 4. Benchmark: union and intersection of two maps of 1M elements
+ *
+ * Build with: g++ -std=c++20 -O2 map_set_operations.cpp
+ */
+
+#include "btree_map.h"
+#include "fast_output.h"
+#include "flat_map.h"
+#include "indexed_map.h"
+#include "map_set_operations.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. The four operations
+void setOperations() {
+  std::map<int, std::string> mp1{{1, "one"}, {2, "two"}, {3, "three"}};
+  std::map<int, std::string> mp2{{2, "II"}, {3, "III"}, {4, "IV"}};
+  printMap("First map", mp1);
+  printMap("Second map", mp2);
+
+  std::cout << std::endl << "1.1. mapUnion()" << std::endl;
+  printMap("Result", mapUnion(mp1, mp2));
+
+  std::cout << std::endl << "1.2. mapIntersection()" << std::endl;
+  printMap("Result", mapIntersection(mp1, mp2));
+
+  std::cout << std::endl << "1.3. mapDifference()" << std::endl;
+  printMap("Result", mapDifference(mp1, mp2));
+
+  std::cout << std::endl << "1.4. mapSymmetricDifference()" << std::endl;
+  printMap("Result", mapSymmetricDifference(mp1, mp2));
+}
+
+// 2. Conflict policies
+void conflictPolicies() {
+  std::map<int, std::string> mp1{{1, "one"}, {2, "two"}, {3, "three"}};
+  std::map<int, std::string> mp2{{2, "II"}, {3, "III"}, {4, "IV"}};
+
+  std::cout << "2.1. mapUnion() with KeepRight: the second map wins"
+            << std::endl;
+  printMap("Result", mapUnion(mp1, mp2, KeepRight()));
+
+  std::cout << std::endl
+            << "2.2. mapIntersection() joining both values" << std::endl;
+  printMap("Result",
+           mapIntersection(mp1, mp2,
+                           [](const std::string& a, const std::string& b) {
+                             return a + "/" + b;
+                           }));
+
+  std::cout << std::endl
+            << "2.3. mapUnion() with std::plus<>() adds word counts"
+            << std::endl;
+  std::map<std::string, int> monday{{"apple", 3}, {"pear", 1}};
+  std::map<std::string, int> tuesday{{"apple", 2}, {"plum", 5}};
+  printMap("Monday", monday);
+  printMap("Tuesday", tuesday);
+  printMap("Both days", mapUnion(monday, tuesday, std::plus<>()));
+}
+
+// 3. Result types and mixed inputs
+void resultTypes() {
+  std::map<int, std::string> mp1{{1, "one"}, {2, "two"}, {3, "three"}};
+  std::map<int, std::string> mp2{{2, "II"}, {3, "III"}, {4, "IV"}};
+
+  std::cout << "3.1. mapUnion() into a BTreeMap and into a std::map"
+            << std::endl;
+  auto btree = mapUnion<BTreeMap<int, std::string>>(mp1, mp2);
+  auto tree = mapUnion<std::map<int, std::string>>(mp1, mp2);
+  printMap("BTreeMap", btree);
+  printMap("std::map", tree);
+
+  std::cout << std::endl
+            << "3.2. mapDifference() of a FlatMap and an IndexedMap"
+            << std::endl;
+  FlatMap<int, std::string> flat{{1, "one"}, {2, "two"}, {5, "five"}};
+  IndexedMap<int, std::string> indexed{{2, "II"}, {5, "V"}};
+  printMap("FlatMap", flat);
+  printMap("IndexedMap", indexed);
+  printMap("Result", mapDifference(flat, indexed));
+}
+
+// Compares the results with the std algorithms writing into a std::map,
+// whose first-range-wins rule is KeepLeft; KeepRight and std::plus<>() are
+// checked by swapping the inputs and by adding the values, and a descending
+// key order by running on std::maps with std::greater.
+bool checkAgainstStd() {
+  std::mt19937 gen(1);
+  auto byKey = [](const auto& a, const auto& b) { return a.first < b.first; };
+  auto same = [](const auto& result, const auto& expected) {
+    return result.size() == expected.size() &&
+           std::equal(result.begin(), result.end(), expected.begin(),
+                      [](const auto& a, const auto& b) {
+                        return a.first == b.first && a.second == b.second;
+                      });
+  };
+  bool ok = true;
+  for (int round = 0; round < 200 && ok; ++round) {
+    std::map<int, int> a, b;
+    int range = 1 + static_cast<int>(gen() % 300);
+    for (int i = static_cast<int>(gen() % 200); i > 0; --i)
+      a[static_cast<int>(gen() % range)] = static_cast<int>(gen() % 100);
+    for (int i = static_cast<int>(gen() % 200); i > 0; --i)
+      b[static_cast<int>(gen() % range)] = static_cast<int>(gen() % 100);
+
+    std::map<int, int> unionAB, unionBA, intersection, difference, symDiff;
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                   std::inserter(unionAB, unionAB.end()), byKey);
+    std::set_union(b.begin(), b.end(), a.begin(), a.end(),
+                   std::inserter(unionBA, unionBA.end()), byKey);
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                          std::inserter(intersection, intersection.end()),
+                          byKey);
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                        std::inserter(difference, difference.end()), byKey);
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(),
+                                  std::inserter(symDiff, symDiff.end()),
+                                  byKey);
+    // A descending order, which the inputs and the results share.
+    using Descending = std::map<int, int, std::greater<int>>;
+    Descending descA(a.begin(), a.end()), descB(b.begin(), b.end());
+    Descending descUnion(unionAB.begin(), unionAB.end());
+    Descending descDifference(difference.begin(), difference.end());
+    std::map<int, int> sums = a;
+    for (const auto& [key, value] : b) sums[key] += value;
+
+    ok = same(mapUnion(a, b), unionAB) &&
+         same(mapUnion<BTreeMap<int, int>>(a, b, KeepRight()), unionBA) &&
+         same(mapUnion<std::map<int, int>>(a, b, std::plus<>()), sums) &&
+         same(mapIntersection(a, b), intersection) &&
+         same(mapDifference<BTreeMap<int, int>>(a, b), difference) &&
+         same(mapSymmetricDifference<std::map<int, int>>(a, b), symDiff) &&
+         same(mapUnion(descA, descB), descUnion) &&
+         same(mapDifference<BTreeMap<int, int, std::greater<int>>>(descA,
+                                                                   descB),
+              descDifference);
+  }
+  return ok;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  std::mt19937 gen(42);
+  // Keys from a range twice the size, so that about half of them overlap.
+  auto makeMap = [&] {
+    std::map<int, int> mp;
+    while (mp.size() < size)
+      mp.emplace(static_cast<int>(gen() % (2 * size)),
+                 static_cast<int>(gen() % 1000));
+    return mp;
+  };
+  const std::map<int, int> a = makeMap();
+  const std::map<int, int> b = makeMap();
+  auto flatA = FlatMap<int, int>(a.begin(), a.end());
+  auto flatB = FlatMap<int, int>(b.begin(), b.end());
+  auto byKey = [](const auto& x, const auto& y) { return x.first < y.first; };
+  // volatile keeps the compiler from dropping the unused results.
+  volatile size_t sink = 0;
+
+  auto report = [&](const std::string& what, const auto& stdAlgorithm,
+                    const auto& toMap, const auto& toFlat,
+                    const auto& toBTree, const auto& flatToFlat) {
+    double stdTime = measureMilliseconds(stdAlgorithm);
+    double mapTime = measureMilliseconds(toMap);
+    double flatTime = measureMilliseconds(toFlat);
+    double btreeTime = measureMilliseconds(toBTree);
+    double flatInputTime = measureMilliseconds(flatToFlat);
+    std::cout << what << ": std algorithm + std::inserter " << stdTime
+              << " ms; from std::maps into std::map " << mapTime << " ms ("
+              << stdTime / mapTime << "x), FlatMap " << flatTime << " ms ("
+              << stdTime / flatTime << "x), BTreeMap " << btreeTime
+              << " ms (" << stdTime / btreeTime << "x); FlatMap inputs "
+              << flatInputTime << " ms (" << stdTime / flatInputTime << "x)"
+              << std::endl;
+  };
+
+  std::cout << "Two maps of " << size << " int keys from [0, " << 2 * size
+            << ")" << std::endl;
+  report(
+      "Union",
+      [&] {
+        std::map<int, int> result;
+        std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                       std::inserter(result, result.end()), byKey);
+        sink = result.size();
+      },
+      [&] { sink = mapUnion<std::map<int, int>>(a, b).size(); },
+      [&] { sink = mapUnion(a, b).size(); },
+      [&] { sink = mapUnion<BTreeMap<int, int>>(a, b).size(); },
+      [&] { sink = mapUnion(flatA, flatB).size(); });
+  report(
+      "Intersection",
+      [&] {
+        std::map<int, int> result;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                              std::inserter(result, result.end()), byKey);
+        sink = result.size();
+      },
+      [&] { sink = mapIntersection<std::map<int, int>>(a, b).size(); },
+      [&] { sink = mapIntersection(a, b).size(); },
+      [&] { sink = mapIntersection<BTreeMap<int, int>>(a, b).size(); },
+      [&] { sink = mapIntersection(flatA, flatB).size(); });
+}
+
+int main() {
+  // Set operations
+  std::cout << "*** Set operations ***" << std::endl;
+  setOperations();
+
+  // Conflict policies
+  std::cout << std::endl << "*** Conflict policies ***" << std::endl;
+  conflictPolicies();
+
+  // Result types
+  std::cout << std::endl << "*** Result types ***" << std::endl;
+  resultTypes();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match the std algorithms: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,215 @@
+/* This header implements union, intersection, difference and symmetric
+ * difference of two ordered maps in one linear merge.
+ * setOperationAlgorithms() in container_map.cpp runs std::set_union() and
+ * friends into std::inserter(), which costs a tree insert with a guessed
+ * hint per output element; these functions instead walk both maps once in
+ * key order and build the result from its sorted elements.
+ *
+ * 1. Inputs: any two maps iterated in key order with ->first and ->second,
+ *    e.g. std::map, FlatMap (flat_map.h), BTreeMap (btree_map.h) or
+ *    IndexedMap (indexed_map.h). Both maps and the result must have the
+ *    same key_compare type (checked at compile time); the first map's
+ *    key_comp() orders the merge and is passed on to the result.
+ * 2. Conflicts: when both maps hold a key, union and intersection ask a
+ *    policy for the value: KeepLeft (the default, as std::set_union does),
+ *    KeepRight, or any function f(left, right), e.g. std::plus<>() to add
+ *    counts.
+ * 3. Results: a FlatMap by default, which takes the merged key and value
+ *    arrays as they are; a BTreeMap is bulk-loaded with from_sorted(); any
+ *    other map (e.g. std::map) is filled with emplace_hint() at its end,
+ *    which is constant time per element for sorted input.
+ */
+
+#ifndef MAP_SET_OPERATIONS_H
+#define MAP_SET_OPERATIONS_H
+
+#include "flat_map.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1. Conflict policies
+struct KeepLeft {
+  template <typename T>
+  const T& operator()(const T& left, const T&) const {
+    return left;
+  }
+};
+
+struct KeepRight {
+  template <typename T>
+  const T& operator()(const T&, const T& right) const {
+    return right;
+  }
+};
+
+enum class MapSetOperation {
+  Union,
+  Intersection,
+  Difference,
+  SymmetricDifference
+};
+
+// Collects the elements of a result in key order and builds the result
+// once at the end, in the cheapest way it offers.
+template <typename Result, typename Comp>
+class SortedMapBuilder {
+  using Key = typename Result::key_type;
+  using T = typename Result::mapped_type;
+
+  // A FlatMap over std::vectors adopts the two arrays.
+  static constexpr bool takesArrays = requires {
+    requires std::same_as<typename Result::key_container_type,
+                          std::vector<Key>>;
+    requires std::same_as<typename Result::mapped_container_type,
+                          std::vector<T>>;
+  };
+  static constexpr bool takesPairs =
+      !takesArrays && requires(std::pair<Key, T>* p, Comp comp) {
+        Result::from_sorted(std::make_move_iterator(p),
+                            std::make_move_iterator(p), comp);
+      };
+
+ public:
+  SortedMapBuilder(const Comp& comp, size_t capacity) : mComp(comp) {
+    if constexpr (takesArrays) {
+      mKeys.reserve(capacity);
+      mValues.reserve(capacity);
+    } else if constexpr (takesPairs) {
+      mPairs.reserve(capacity);
+    } else {
+      mResult.emplace(comp);
+    }
+  }
+
+  template <typename V>
+  void add(const Key& key, V&& value) {
+    if constexpr (takesArrays) {
+      mKeys.push_back(key);
+      mValues.push_back(std::forward<V>(value));
+    } else if constexpr (takesPairs) {
+      mPairs.emplace_back(key, std::forward<V>(value));
+    } else {
+      mResult->emplace_hint(mResult->end(), key, std::forward<V>(value));
+    }
+  }
+
+  Result finish() && {
+    if constexpr (takesArrays) {
+      return Result::from_sorted(std::move(mKeys), std::move(mValues),
+                                 mComp);
+    } else if constexpr (takesPairs) {
+      return Result::from_sorted(std::make_move_iterator(mPairs.begin()),
+                                 std::make_move_iterator(mPairs.end()),
+                                 mComp);
+    } else {
+      return std::move(*mResult);
+    }
+  }
+
+ private:
+  Comp mComp;
+  std::vector<Key> mKeys;
+  std::vector<T> mValues;
+  std::vector<std::pair<Key, T>> mPairs;
+  std::optional<Result> mResult;
+};
+
+// The default result: a FlatMap of the first map's key, value and order.
+template <typename Result, typename Map>
+using SetResultOf = std::conditional_t<
+    std::is_void_v<Result>,
+    FlatMap<typename Map::key_type, typename Map::mapped_type,
+            typename Map::key_compare>,
+    Result>;
+
+template <MapSetOperation op, typename Result, typename MapA, typename MapB,
+          typename Policy>
+Result mergeMaps(const MapA& a, const MapB& b, Policy& policy,
+                 size_t capacity) {
+  constexpr bool keepLeft = op != MapSetOperation::Intersection;
+  constexpr bool keepRight = op == MapSetOperation::Union ||
+                             op == MapSetOperation::SymmetricDifference;
+  constexpr bool keepBoth =
+      op == MapSetOperation::Union || op == MapSetOperation::Intersection;
+
+  // The merge walks both maps in one order and hands the result its
+  // elements in that order, so all three must agree on it.
+  using Comp = typename Result::key_compare;
+  static_assert(std::is_same_v<typename MapA::key_compare, Comp> &&
+                    std::is_same_v<typename MapB::key_compare, Comp>,
+                "Both maps and the result must use the same key_compare");
+  Comp comp = a.key_comp();
+  SortedMapBuilder<Result, Comp> out(comp, capacity);
+
+  auto i = a.begin();
+  auto j = b.begin();
+  while (i != a.end() && j != b.end()) {
+    if (comp(i->first, j->first)) {
+      if constexpr (keepLeft) out.add(i->first, i->second);
+      ++i;
+    } else if (comp(j->first, i->first)) {
+      if constexpr (keepRight) out.add(j->first, j->second);
+      ++j;
+    } else {
+      if constexpr (keepBoth)
+        out.add(i->first, policy(std::as_const(i->second),
+                                 std::as_const(j->second)));
+      ++i;
+      ++j;
+    }
+  }
+  if constexpr (keepLeft)
+    for (; i != a.end(); ++i) out.add(i->first, i->second);
+  if constexpr (keepRight)
+    for (; j != b.end(); ++j) out.add(j->first, j->second);
+  return std::move(out).finish();
+}
+
+// 2. Set operations. Result defaults to a FlatMap; pass e.g. BTreeMap<Key,
+// T> or std::map<Key, T> to build that instead.
+
+// Every key of either map; policy(left, right) picks the value of a key
+// in both.
+template <typename Result = void, typename MapA, typename MapB,
+          typename Policy = KeepLeft>
+auto mapUnion(const MapA& a, const MapB& b, Policy policy = Policy()) {
+  using R = SetResultOf<Result, MapA>;
+  return mergeMaps<MapSetOperation::Union, R>(a, b, policy,
+                                              a.size() + b.size());
+}
+
+// The keys in both maps, with the value policy(left, right).
+template <typename Result = void, typename MapA, typename MapB,
+          typename Policy = KeepLeft>
+auto mapIntersection(const MapA& a, const MapB& b,
+                     Policy policy = Policy()) {
+  using R = SetResultOf<Result, MapA>;
+  return mergeMaps<MapSetOperation::Intersection, R>(
+      a, b, policy, std::min(a.size(), b.size()));
+}
+
+// The elements of a whose keys are not in b.
+template <typename Result = void, typename MapA, typename MapB>
+auto mapDifference(const MapA& a, const MapB& b) {
+  using R = SetResultOf<Result, MapA>;
+  KeepLeft unused;
+  return mergeMaps<MapSetOperation::Difference, R>(a, b, unused, a.size());
+}
+
+// The elements whose keys are in exactly one of the maps.
+template <typename Result = void, typename MapA, typename MapB>
+auto mapSymmetricDifference(const MapA& a, const MapB& b) {
+  using R = SetResultOf<Result, MapA>;
+  KeepLeft unused;
+  return mergeMaps<MapSetOperation::SymmetricDifference, R>(
+      a, b, unused, a.size() + b.size());
+}
+
+#endif  // MAP_SET_OPERATIONS_H
@@ -1,27 +1,25 @@
+#include "fast_output.h"
+
 #include <iostream>
 #include <new>
 
 void print(int *ptr, const size_t &size) {
-  std::cout << "data = [";
-  for (size_t i = 0; i < size; ++i) {
-    std::cout << ptr[i];
-    if (i < size - 1) std::cout << ", ";
-  }
-  std::cout << "]" << std::endl;
+  FastOutput &out = fastOut();
+  out << "data = ";
+  out.writeRange(ptr, ptr + size);
+  out << '\n';
+  out.flush();
 }
 
 void print(int **ptr, const size_t &numRows, const size_t &numColumns) {
-  std::cout << "data = [";
+  FastOutput &out = fastOut();
+  out << "data = [";
   for (size_t i = 0; i < numRows; ++i) {
-    std::cout << "[";
-    for (size_t j = 0; j < numColumns; ++j) {
-      std::cout << ptr[i][j];
-      if (j < numColumns - 1) std::cout << ", ";
-    }
-    std ::cout << "]";
-    if (i < numRows - 1) std::cout << ", ";
+    out.writeRange(ptr[i], ptr[i] + numColumns);
+    if (i < numRows - 1) out << ", ";
   }
-  std::cout << "]" << std::endl;
+  out << "]\n";
+  out.flush();
 }
 
 void staticMemoryAllocation() {
@@ -0,0 +1,527 @@
+/* This file implements MmapVector<T>, a vector of trivially copyable elements
+ * that lives in a file instead of on the heap. The file is mapped into the
+ * address space with mmap(), so reopening a dataset costs one system call
+ * instead of parsing it again; pages are read from disk (or the page cache)
+ * only when they are touched.
+ *
+ * File layout: one page holding a small header (magic, element size, size,
+ * capacity), followed by `capacity` elements. The data therefore starts
+ * page-aligned and the logical size survives a restart.
+ *
+ * 1. Options: open mode, access pattern hint, huge pages
+ * 2. MmapVector<T>
+ *    2.1. Opening, mapping and validating the file
+ *    2.2. std::vector-like interface with contiguous iterators (T*)
+ *    2.3. Growth through ftruncate() and mremap()
+ *    2.4. madvise() hints and msync() checkpoints
+ * 3. Examples mirroring container_vector.cpp: the std algorithms on a mapped
+ *    vector, persistence across reopening
+ * 4. Benchmark: parsing a text file against mapping the binary file
+ *
+ * Linux only (mremap, MADV_HUGEPAGE); on other POSIX systems growth falls back
+ * to munmap() + mmap().
+ *
+ * Build with: g++ -std=c++20 -O2 mmap_vector.cpp
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1. Options
+enum class OpenMode {
+  OpenOrCreate,  // Keep the existing contents, create an empty file if needed
+  Truncate,      // Always start empty
+  ReadOnly       // Map with PROT_READ; every mutating call throws, and so
+                 // do the non-const accessors: read through a const vector
+};
+
+enum class AccessPattern { Normal, Sequential, Random, WillNeed };
+
+struct MmapOptions {
+  OpenMode mode = OpenMode::OpenOrCreate;
+  AccessPattern pattern = AccessPattern::Normal;
+  // Asks for transparent huge pages. Only honoured for file mappings on
+  // tmpfs or kernels with CONFIG_READ_ONLY_THP_FOR_FS; elsewhere a no-op.
+  bool hugePages = false;
+};
+
+[[noreturn]] inline void throwErrno(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+// 2. MmapVector<T>
+template <typename T>
+class MmapVector {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "MmapVector stores raw bytes; T must be trivially copyable");
+
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  // 2.1. Opening, mapping and validating the file
+  explicit MmapVector(const std::string& path, MmapOptions options = {})
+      : mPath(path), mOptions(options) {
+    const bool readOnly = options.mode == OpenMode::ReadOnly;
+    int flags = readOnly ? O_RDONLY : O_RDWR | O_CREAT;
+    if (options.mode == OpenMode::Truncate) flags |= O_TRUNC;
+    mFd = ::open(path.c_str(), flags, 0644);
+    if (mFd < 0) throwErrno("MmapVector: open " + path);
+
+    struct stat st;
+    if (::fstat(mFd, &st) != 0) {
+      ::close(mFd);
+      throwErrno("MmapVector: fstat " + path);
+    }
+    try {
+      if (st.st_size == 0) {
+        if (readOnly) throw std::runtime_error("MmapVector: empty " + path);
+        resizeFile(headerBytes);
+        map(headerBytes);
+        *header() = Header{magic, sizeof(T), 0, 0};
+      } else {
+        if (static_cast<size_t>(st.st_size) < headerBytes)
+          throw std::runtime_error("MmapVector: truncated " + path);
+        map(static_cast<size_t>(st.st_size));
+        validate(static_cast<size_t>(st.st_size));
+      }
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  MmapVector(const MmapVector&) = delete;
+  MmapVector& operator=(const MmapVector&) = delete;
+
+  MmapVector(MmapVector&& other) noexcept
+      : mPath(std::move(other.mPath)),
+        mOptions(other.mOptions),
+        mFd(std::exchange(other.mFd, -1)),
+        mBase(std::exchange(other.mBase, nullptr)),
+        mLength(std::exchange(other.mLength, 0)) {}
+
+  MmapVector& operator=(MmapVector&& other) noexcept {
+    if (this != &other) {
+      release();
+      mPath = std::move(other.mPath);
+      mOptions = other.mOptions;
+      mFd = std::exchange(other.mFd, -1);
+      mBase = std::exchange(other.mBase, nullptr);
+      mLength = std::exchange(other.mLength, 0);
+    }
+    return *this;
+  }
+
+  // Unmapping writes dirty pages back eventually, but not durably; call
+  // checkpoint() first if the data must survive a crash.
+  ~MmapVector() { release(); }
+
+  // 2.2. std::vector-like interface
+  size_t size() const { return header()->size; }
+  size_t capacity() const { return header()->capacity; }
+  bool empty() const { return size() == 0; }
+  const std::string& path() const { return mPath; }
+
+  // The non-const accessors hand out writable references, which a
+  // PROT_READ mapping would answer with SIGSEGV; they throw instead.
+  T* data() {
+    requireWritable();
+    return reinterpret_cast<T*>(mBase + headerBytes);
+  }
+  const T* data() const {
+    return reinterpret_cast<const T*>(mBase + headerBytes);
+  }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  T& operator[](size_t index) { return data()[index]; }
+  const T& operator[](size_t index) const { return data()[index]; }
+  T& at(size_t index) {
+    if (index >= size()) throw std::out_of_range("MmapVector::at");
+    return data()[index];
+  }
+  const T& at(size_t index) const {
+    if (index >= size()) throw std::out_of_range("MmapVector::at");
+    return data()[index];
+  }
+  T& front() { return data()[0]; }
+  const T& front() const { return data()[0]; }
+  T& back() { return data()[size() - 1]; }
+  const T& back() const { return data()[size() - 1]; }
+
+  void push_back(const T& value) {
+    Header* h = header();
+    if (h->size == h->capacity) {
+      // value may live inside the mapping that is about to move.
+      T copy = value;
+      grow(h->size + 1);
+      h = header();
+      data()[h->size++] = copy;
+      return;
+    }
+    requireWritable();
+    data()[h->size++] = value;
+  }
+
+  void pop_back() {
+    requireWritable();
+    --header()->size;
+  }
+
+  void clear() {
+    requireWritable();
+    header()->size = 0;
+  }
+
+  // New elements are value-initialized (zero for arithmetic types).
+  void resize(size_t newSize, const T& value = T()) {
+    size_t oldSize = size();
+    if (newSize > capacity()) {
+      T copy = value;
+      grow(newSize);
+      std::fill(data() + oldSize, data() + newSize, copy);
+    } else {
+      requireWritable();
+      if (newSize > oldSize)
+        std::fill(data() + oldSize, data() + newSize, value);
+    }
+    header()->size = newSize;
+  }
+
+  // Appends [first, last) with one growth step and one memcpy.
+  void append(const T* first, const T* last) {
+    size_t count = static_cast<size_t>(last - first);
+    size_t oldSize = size();
+    if (oldSize + count > capacity()) {
+      std::vector<T> copy(first, last);  // source may be inside the mapping
+      grow(oldSize + count);
+      std::memcpy(data() + oldSize, copy.data(), count * sizeof(T));
+    } else {
+      requireWritable();
+      std::memmove(data() + oldSize, first, count * sizeof(T));
+    }
+    header()->size = oldSize + count;
+  }
+
+  // 2.3. Growth
+  void reserve(size_t newCapacity) {
+    if (newCapacity > capacity()) remap(newCapacity);
+  }
+
+  // Gives the unused tail of the file back to the file system.
+  void shrink_to_fit() {
+    if (capacity() > size()) remap(size());
+  }
+
+  // 2.4. Hints and checkpoints
+  void advise(AccessPattern pattern) {
+    mOptions.pattern = pattern;
+    applyAdvice();
+  }
+
+  // Flushes dirty pages (and the header with the current size) to disk.
+  // With async = true the call only schedules the write-back.
+  void checkpoint(bool async = false) {
+    if (mOptions.mode == OpenMode::ReadOnly) return;
+    if (::msync(mBase, mLength, async ? MS_ASYNC : MS_SYNC) != 0)
+      throwErrno("MmapVector: msync " + mPath);
+  }
+
+ private:
+  struct Header {
+    uint64_t magic;
+    uint64_t elementSize;
+    uint64_t size;
+    uint64_t capacity;
+  };
+
+  static constexpr uint64_t magic = 0x524f544345564d4dULL;  // "MMVECTOR"
+  static constexpr size_t headerBytes = 4096;
+  static_assert(alignof(T) <= headerBytes);
+
+  Header* header() { return reinterpret_cast<Header*>(mBase); }
+  const Header* header() const {
+    return reinterpret_cast<const Header*>(mBase);
+  }
+
+  void validate(size_t fileBytes) const {
+    const Header* h = header();
+    if (h->magic != magic)
+      throw std::runtime_error("MmapVector: not an MmapVector file " + mPath);
+    if (h->elementSize != sizeof(T))
+      throw std::runtime_error("MmapVector: element size mismatch " + mPath);
+    if (h->size > h->capacity ||
+        headerBytes + h->capacity * sizeof(T) > fileBytes)
+      throw std::runtime_error("MmapVector: corrupt header " + mPath);
+  }
+
+  void requireWritable() const {
+    if (mOptions.mode == OpenMode::ReadOnly)
+      throw std::logic_error("MmapVector: modifying a read-only mapping");
+  }
+
+  // Geometric growth, at least one page worth of elements.
+  void grow(size_t required) {
+    size_t newCapacity = std::max(capacity() * 2, required);
+    newCapacity = std::max(newCapacity, headerBytes / sizeof(T));
+    remap(newCapacity);
+  }
+
+  void remap(size_t newCapacity) {
+    requireWritable();
+    size_t newLength = headerBytes + newCapacity * sizeof(T);
+    // Shrinking must unmap the tail before the file loses it; growing must
+    // extend the file before the new pages are touched.
+    if (newLength > mLength) resizeFile(newLength);
+#if defined(__linux__)
+    void* base = ::mremap(mBase, mLength, newLength, MREMAP_MAYMOVE);
+    if (base == MAP_FAILED) throwErrno("MmapVector: mremap " + mPath);
+    mBase = static_cast<char*>(base);
+    mLength = newLength;
+    applyAdvice();
+#else
+    ::munmap(mBase, mLength);
+    mBase = nullptr;
+    map(newLength);
+#endif
+    if (newLength < headerBytes + capacity() * sizeof(T))
+      resizeFile(newLength);
+    header()->capacity = newCapacity;
+  }
+
+  void resizeFile(size_t bytes) {
+    if (::ftruncate(mFd, static_cast<off_t>(bytes)) != 0)
+      throwErrno("MmapVector: ftruncate " + mPath);
+  }
+
+  void map(size_t length) {
+    int protection = mOptions.mode == OpenMode::ReadOnly
+                         ? PROT_READ
+                         : PROT_READ | PROT_WRITE;
+    void* base = ::mmap(nullptr, length, protection, MAP_SHARED, mFd, 0);
+    if (base == MAP_FAILED) throwErrno("MmapVector: mmap " + mPath);
+    mBase = static_cast<char*>(base);
+    mLength = length;
+    applyAdvice();
+  }
+
+  // Hints are best effort: a kernel that rejects one still maps the file.
+  void applyAdvice() {
+    int advice = MADV_NORMAL;
+    switch (mOptions.pattern) {
+      case AccessPattern::Normal: advice = MADV_NORMAL; break;
+      case AccessPattern::Sequential: advice = MADV_SEQUENTIAL; break;
+      case AccessPattern::Random: advice = MADV_RANDOM; break;
+      case AccessPattern::WillNeed: advice = MADV_WILLNEED; break;
+    }
+    ::madvise(mBase, mLength, advice);
+#if defined(MADV_HUGEPAGE)
+    if (mOptions.hugePages) ::madvise(mBase, mLength, MADV_HUGEPAGE);
+#endif
+  }
+
+  void release() {
+    if (mBase) ::munmap(mBase, mLength);
+    if (mFd >= 0) ::close(mFd);
+    mBase = nullptr;
+    mFd = -1;
+    mLength = 0;
+  }
+
+  std::string mPath;
+  MmapOptions mOptions;
+  int mFd = -1;
+  char* mBase = nullptr;
+  size_t mLength = 0;  // Mapped bytes, header included
+};
+
+// 3. Examples
+template <typename Vector>
+void printVector(const std::string& vectorName, const Vector& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void mappedVectorExamples(const std::filesystem::path& directory) {
+  const std::string path = (directory / "example.mmv").string();
+
+  // 3.1. Writing
+  std::cout << "3.1. Creating " << path << " and pushing elements"
+            << std::endl;
+  {
+    MmapVector<int> vec(path, {OpenMode::Truncate});
+    for (int x : {5, 3, 8, 1, 2, 7, 4, 6}) vec.push_back(x);
+    printVector("Mapped vector", vec);
+    std::cout << "size: " << vec.size() << ", capacity: " << vec.capacity()
+              << std::endl;
+
+    // 3.2. The std algorithms take the contiguous iterators directly
+    std::cout << std::endl
+              << "3.2. Using std::sort(), std::accumulate() and "
+                 "std::lower_bound() on the mapping"
+              << std::endl;
+    std::sort(vec.begin(), vec.end());
+    printVector("Sorted vector", vec);
+    std::cout << "Sum: " << std::accumulate(vec.begin(), vec.end(), 0)
+              << ", first element >= 5 at index "
+              << std::lower_bound(vec.begin(), vec.end(), 5) - vec.begin()
+              << std::endl;
+    vec.checkpoint();
+  }
+
+  // 3.3. Reopening
+  std::cout << std::endl
+            << "3.3. Reopening the file read-only after the vector was "
+               "destroyed"
+            << std::endl;
+  {
+    MmapVector<int> vec(path, {OpenMode::ReadOnly});
+    printVector("Reopened vector", vec);
+    try {
+      vec.push_back(9);
+    } catch (const std::logic_error& e) {
+      std::cout << "push_back() threw: " << e.what() << std::endl;
+    }
+    try {
+      vec[0] = 1;
+    } catch (const std::logic_error& e) {
+      std::cout << "Non-const operator[] threw: " << e.what() << std::endl;
+    }
+  }
+  try {
+    MmapVector<double> wrongType(path, {OpenMode::ReadOnly});
+  } catch (const std::runtime_error& e) {
+    std::cout << "Opening as MmapVector<double> threw: " << e.what()
+              << std::endl;
+  }
+
+  // 3.4. Shrinking
+  std::cout << std::endl << "3.4. Using shrink_to_fit()" << std::endl;
+  {
+    MmapVector<int> vec(path);
+    vec.resize(3);
+    std::cout << "After resize(3) file size: "
+              << std::filesystem::file_size(path) << " bytes" << std::endl;
+    vec.shrink_to_fit();
+    std::cout << "After shrink_to_fit() file size: "
+              << std::filesystem::file_size(path) << " bytes" << std::endl;
+    printVector("Vector", vec);
+  }
+  std::filesystem::remove(path);
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark(const std::filesystem::path& directory) {
+  constexpr size_t size = 1 << 24;
+  const std::string textPath = (directory / "dataset.txt").string();
+  const std::string mappedPath = (directory / "dataset.mmv").string();
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 1'000'000'000);
+  {
+    std::ofstream text(textPath);
+    MmapVector<int> mapped(mappedPath, {OpenMode::Truncate});
+    mapped.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      int x = dist(gen);
+      text << x << '\n';
+      mapped.push_back(x);
+    }
+    mapped.checkpoint();
+  }
+  std::cout << "Elements: " << size << ", text file "
+            << std::filesystem::file_size(textPath) / (1 << 20)
+            << " MiB, mapped file "
+            << std::filesystem::file_size(mappedPath) / (1 << 20) << " MiB"
+            << std::endl;
+
+  // Startup: what a restart pays before the first query can run.
+  std::vector<int> parsed;
+  double parse = measureMilliseconds([&] {
+    std::ifstream text(textPath);
+    int x;
+    while (text >> x) parsed.push_back(x);
+  });
+  double open = 0.0;
+  {
+    std::unique_ptr<MmapVector<int>> mapped;
+    open = measureMilliseconds([&] {
+      mapped = std::make_unique<MmapVector<int>>(
+          mappedPath, MmapOptions{OpenMode::ReadOnly});
+    });
+    std::cout << "Startup: parsing text " << parse << " ms, mapping " << open
+              << " ms" << std::endl;
+
+    // A full scan afterwards touches every page once.
+    long long heapSum = 0, mappedSum = 0;
+    double heapScan = measureMilliseconds(
+        [&] { heapSum = std::accumulate(parsed.begin(), parsed.end(), 0LL); });
+    mapped->advise(AccessPattern::Sequential);
+    double mappedScan = measureMilliseconds([&] {
+      const MmapVector<int>& view = *mapped;  // read-only: const access
+      mappedSum = std::accumulate(view.begin(), view.end(), 0LL);
+    });
+    std::cout << "First scan: heap vector " << heapScan << " ms, mapping "
+              << mappedScan << " ms, same sum: " << std::boolalpha
+              << (heapSum == mappedSum) << std::endl;
+  }
+
+  std::filesystem::remove(textPath);
+  std::filesystem::remove(mappedPath);
+}
+
+int main() {
+  const std::filesystem::path directory =
+      std::filesystem::temp_directory_path();
+
+  // Mapped vector
+  std::cout << "*** MmapVector ***" << std::endl;
+  mappedVectorExamples(directory);
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark(directory);
+
+  return 0;
+}
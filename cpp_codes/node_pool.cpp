@@ -0,0 +1,281 @@
+/* This file shows NodePool and SharedNodePool from node_pool.h, memory
+ * resources that serve the one-node-at-a-time allocations of
+ * insertingAndRemoving() in container_map.cpp from slabs, and measures them
+ * against the default allocator.
+ *
+ * 1. std::pmr::map on a NodePool: erased nodes are reused
+ * 2. The other containers on a NodePool: BTreeMap, SwissMap and FlatMap
+ * 3. Bulk release: dropping a map with the pool instead of node by node
+ * 4. SharedNodePool: maps built and destroyed by several threads
+ * 5. Benchmark: insert/erase churn, then resident memory (RSS) after the
+ *    churn and after erasing most elements; every allocator runs in its
+ *    own process so that the RSS figures do not mix
+ *
+ * Linux only (the RSS is read from /proc/self/statm).
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread node_pool.cpp
+ */
+
+#include "btree_map.h"
+#include "flat_map.h"
+#include "node_pool.h"
+#include "swiss_map.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+void printStats(const std::string& what, const NodePool::Stats& stats) {
+  std::cout << what << ": " << stats.bytesInUse << " bytes in use, "
+            << stats.bytesReserved << " bytes reserved in " << stats.slabs
+            << " slabs and " << stats.largeBlocks << " large blocks"
+            << std::endl;
+}
+
+// 1. std::pmr::map on a NodePool
+void pmrMap() {
+  NodePool pool;
+  std::pmr::map<int, int> mp(&pool);
+
+  std::cout << "1.1. insert() 10000 elements" << std::endl;
+  for (int i = 0; i < 10000; ++i) mp.emplace(i, i);
+  printStats("Pool", pool.stats());
+
+  std::cout << std::endl
+            << "1.2. erase() the even keys and insert() 5000 new keys; the "
+               "freed nodes are reused"
+            << std::endl;
+  for (int i = 0; i < 10000; i += 2) mp.erase(i);
+  for (int i = 10000; i < 15000; ++i) mp.emplace(i, i);
+  printStats("Pool", pool.stats());
+
+  std::cout << std::endl << "1.3. clear()" << std::endl;
+  mp.clear();
+  printStats("Pool", pool.stats());
+}
+
+// 2. The other containers on a NodePool
+void otherContainers() {
+  NodePool pool;
+  using Allocator = std::pmr::polymorphic_allocator<std::pair<const int, int>>;
+
+  std::cout << "2.1. BTreeMap with 10000 elements: one block per node"
+            << std::endl;
+  {
+    BTreeMap<int, int, std::less<int>, Allocator> btree(std::less<int>(),
+                                                        &pool);
+    for (int i = 0; i < 10000; ++i) btree.emplace(i, i);
+    printStats("Pool", pool.stats());
+  }
+
+  std::cout << std::endl
+            << "2.2. SwissMap with 10000 elements: its arrays are larger "
+               "than maxBlockSize and go to upstream"
+            << std::endl;
+  {
+    SwissMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> swiss(
+        &pool);
+    for (int i = 0; i < 10000; ++i) swiss.emplace(i, i);
+    printStats("Pool", pool.stats());
+  }
+
+  std::cout << std::endl
+            << "2.3. FlatMap over std::pmr::vector with 100 elements"
+            << std::endl;
+  {
+    FlatMap<int, int, std::less<int>, std::pmr::vector<int>,
+            std::pmr::vector<int>>
+        flat{std::pmr::vector<int>(&pool), std::pmr::vector<int>(&pool)};
+    for (int i = 0; i < 100; ++i) flat.emplace(i, i);
+    printStats("Pool", pool.stats());
+  }
+  printStats("Pool after all three are destroyed", pool.stats());
+}
+
+// 3. Bulk release
+void bulkRelease() {
+  NodePool pool;
+  std::cout << "3.1. A std::pmr::map allocated from the pool and never "
+               "destroyed; release() frees it with the pool"
+            << std::endl;
+  std::pmr::polymorphic_allocator<> alloc(&pool);
+  // int elements need no destructor, so skipping ~map() is safe.
+  auto* mp = alloc.new_object<std::pmr::map<int, int>>();
+  for (int i = 0; i < 10000; ++i) mp->emplace(i, i);
+  printStats("Before release()", pool.stats());
+  pool.release();
+  printStats("After release()", pool.stats());
+}
+
+// 4. SharedNodePool
+void sharedPool() {
+  SharedNodePool pool;
+  std::cout << "4.1. Four threads fill their own maps from one pool"
+            << std::endl;
+  std::vector<std::pmr::map<int, int>> maps;
+  for (int t = 0; t < 4; ++t) maps.emplace_back(&pool);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&maps, t] {
+      for (int i = 0; i < 10000; ++i) maps[t].emplace(i, t);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  printStats("Pool", pool.stats());
+
+  std::cout << std::endl
+            << "4.2. Other threads clear the maps; blocks return to the "
+               "pool when a thread's cache overflows or the thread exits"
+            << std::endl;
+  threads.clear();
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([&maps, t] { maps[(t + 1) % 4].clear(); });
+  for (auto& thread : threads) thread.join();
+  printStats("Pool", pool.stats());
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Resident set size of this process in MiB.
+double residentMiB() {
+  std::ifstream statm("/proc/self/statm");
+  size_t total = 0, resident = 0;
+  statm >> total >> resident;
+  return static_cast<double>(resident * sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+// Runs function in a child process and waits for it, so that each run
+// starts from a fresh heap.
+void runInChild(const std::function<void()>& function) {
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid == 0) {
+    function();
+    std::cout.flush();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+// Inserts size random keys, then runs rounds that each erase half of the
+// keys and insert as many new ones, one node at a time, then erases all
+// but every tenth key. destroy() frees the map.
+template <typename Map, typename Destroy>
+void churn(const std::string& name, Map& map, Destroy destroy) {
+  constexpr size_t size = 1 << 18;
+  constexpr int rounds = 4;
+  std::mt19937 gen(42);
+  std::vector<int> keys(size);
+  for (int& key : keys) key = static_cast<int>(gen());
+  double baseline = residentMiB();
+
+  double time = measureMilliseconds([&] {
+    for (int key : keys) map.emplace(key, key);
+    for (int round = 0; round < rounds; ++round) {
+      std::shuffle(keys.begin(), keys.end(), gen);
+      for (size_t i = 0; i < size / 2; ++i) {
+        map.erase(keys[i]);
+        keys[i] = static_cast<int>(gen());
+        map.emplace(keys[i], keys[i]);
+      }
+    }
+  });
+  double afterChurn = residentMiB() - baseline;
+  for (size_t i = 0; i < size; ++i)
+    if (i % 10 != 0) map.erase(keys[i]);
+  double afterErase = residentMiB() - baseline;
+  double destroyTime = measureMilliseconds(destroy);
+  double afterDestroy = residentMiB() - baseline;
+
+  double operations = size + rounds * size;
+  std::cout << name << ": " << time << " ms (" << operations / time / 1000
+            << " M inserts+erases/s), RSS after churn " << afterChurn
+            << " MiB, after erasing 90% " << afterErase << " MiB, destroyed in "
+            << destroyTime << " ms, RSS then " << afterDestroy << " MiB"
+            << std::endl;
+}
+
+void benchmark() {
+  std::cout << "256K int keys, 4 rounds replacing half of them" << std::endl;
+  runInChild([] {
+    auto map = std::make_unique<std::map<int, int>>();
+    churn("std::map, default allocator", *map, [&] { map.reset(); });
+  });
+  runInChild([] {
+    auto pool = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    auto map = std::make_unique<std::pmr::map<int, int>>(pool.get());
+    churn("std::pmr::map, unsynchronized_pool_resource", *map, [&] {
+      map.reset();
+      pool.reset();
+    });
+  });
+  runInChild([] {
+    auto pool = std::make_unique<NodePool>();
+    auto map = std::make_unique<std::pmr::map<int, int>>(pool.get());
+    churn("std::pmr::map, NodePool", *map, [&] {
+      map.reset();
+      pool.reset();
+    });
+  });
+  runInChild([] {
+    // The map lives in the pool and is dropped with it.
+    auto pool = std::make_unique<NodePool>();
+    std::pmr::polymorphic_allocator<> alloc(pool.get());
+    auto* map = alloc.new_object<std::pmr::map<int, int>>();
+    churn("std::pmr::map, NodePool, dropped by release()", *map,
+          [&] { pool.reset(); });
+  });
+  runInChild([] {
+    auto pool = std::make_unique<SharedNodePool>();
+    auto map = std::make_unique<std::pmr::map<int, int>>(pool.get());
+    churn("std::pmr::map, SharedNodePool", *map, [&] {
+      map.reset();
+      pool.reset();
+    });
+  });
+}
+
+int main() {
+  // std::pmr::map
+  std::cout << "*** std::pmr::map on a NodePool ***" << std::endl;
+  pmrMap();
+
+  // Other containers
+  std::cout << std::endl << "*** Other containers ***" << std::endl;
+  otherContainers();
+
+  // Bulk release
+  std::cout << std::endl << "*** Bulk release ***" << std::endl;
+  bulkRelease();
+
+  // SharedNodePool
+  std::cout << std::endl << "*** SharedNodePool ***" << std::endl;
+  sharedPool();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
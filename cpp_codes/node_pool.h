@@ -0,0 +1,380 @@
+/* This header implements NodePool and SharedNodePool, two
+ * std::pmr::memory_resource classes for node-based containers such as
+ * std::pmr::map, BTreeMap (btree_map.h) and SwissMap (swiss_map.h).
+ *
+ * A std::map allocates one node per insert and frees it on erase, each a
+ * separate call into malloc. A node pool serves those requests from large
+ * slabs instead:
+ *
+ * 1. Size classes: requests up to maxBlockSize bytes are rounded up to a
+ *    multiple of 8 (or of their alignment) and served from that size's
+ *    free list. Freed blocks go back on the list, so a map that erases and
+ *    inserts reuses the same memory without touching malloc. Larger
+ *    requests go straight to the upstream resource.
+ * 2. Slabs: a free list that runs dry takes a 64 KiB slab from upstream
+ *    and hands out its blocks in address order, so nodes allocated
+ *    together sit next to each other, with no per-block header.
+ * 3. Bulk release: release(), or destroying the pool, returns every slab
+ *    at once. Containers whose elements need no destructor can be left
+ *    undestroyed and dropped with the pool, skipping the per-node frees.
+ *    Slabs are not returned while the pool lives; a pool sized for a peak
+ *    keeps that memory until it is released.
+ * 4. Threads: NodePool is for one thread at a time. SharedNodePool shares
+ *    one NodePool behind a mutex; every thread keeps a small cache of free
+ *    blocks per size class and moves them to and from the shared pool in
+ *    batches, so most allocations take no lock. A block may be freed by a
+ *    different thread than the one that allocated it.
+ */
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+class NodePool : public std::pmr::memory_resource {
+ public:
+  struct Stats {
+    // Bytes handed out and not yet returned, after rounding.
+    size_t bytesInUse = 0;
+    // Bytes taken from upstream: slabs and large blocks.
+    size_t bytesReserved = 0;
+    size_t slabs = 0;
+    size_t largeBlocks = 0;
+  };
+
+  static constexpr size_t granularity = 8;
+  static constexpr size_t maxBlockSize = 1024;
+  static constexpr size_t numClasses = maxBlockSize / granularity;
+  static constexpr size_t slabSize = 64 * 1024;
+  static constexpr size_t slabAlignment = 64;
+
+  explicit NodePool(
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : mUpstream(upstream) {}
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  ~NodePool() override { release(); }
+
+  // Returns all memory to upstream, including blocks still in use.
+  void release() {
+    for (std::byte* slab : mSlabs)
+      mUpstream->deallocate(slab, slabSize, slabAlignment);
+    for (const auto& [block, large] : mLargeBlocks)
+      mUpstream->deallocate(block, large.bytes, large.alignment);
+    mSlabs.clear();
+    mLargeBlocks.clear();
+    mClasses = {};
+    mBytesInUse = 0;
+  }
+
+  Stats stats() const {
+    Stats result;
+    result.bytesInUse = mBytesInUse;
+    result.slabs = mSlabs.size();
+    result.largeBlocks = mLargeBlocks.size();
+    result.bytesReserved = mSlabs.size() * slabSize;
+    for (const auto& [block, large] : mLargeBlocks)
+      result.bytesReserved += large.bytes;
+    return result;
+  }
+
+  std::pmr::memory_resource* upstream_resource() const { return mUpstream; }
+
+  // The size class of a request, or 0 if it bypasses the classes. Every
+  // block of size s starts at a multiple of s from a 64-byte aligned slab,
+  // so rounding s up to the alignment aligns the block.
+  static size_t blockSize(size_t bytes, size_t alignment) noexcept {
+    if (alignment > slabAlignment) return 0;
+    size_t unit = std::max(alignment, granularity);
+    size_t size = (std::max<size_t>(bytes, 1) + unit - 1) / unit * unit;
+    return size <= maxBlockSize ? size : 0;
+  }
+
+ protected:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    size_t size = blockSize(bytes, alignment);
+    return size ? allocateBlock(size) : allocateLarge(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    size_t size = blockSize(bytes, alignment);
+    if (size)
+      freeBlock(p, size);
+    else
+      freeLarge(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other)
+      const noexcept override {
+    return this == &other;
+  }
+
+ private:
+  friend class SharedNodePool;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SizeClass {
+    FreeBlock* freeList = nullptr;
+    // The part of the newest slab that has not been handed out yet.
+    std::byte* next = nullptr;
+    std::byte* end = nullptr;
+  };
+
+  struct LargeBlock {
+    size_t bytes;
+    size_t alignment;
+  };
+
+  SizeClass& sizeClass(size_t size) {
+    return mClasses[size / granularity - 1];
+  }
+
+  void* allocateBlock(size_t size) {
+    SizeClass& sc = sizeClass(size);
+    if (FreeBlock* block = sc.freeList) {
+      sc.freeList = block->next;
+      mBytesInUse += size;
+      return block;
+    }
+    if (static_cast<size_t>(sc.end - sc.next) < size) {
+      // Reserved before the slab is taken, so that push_back cannot fail
+      // and leak it; geometrically, since reserve() allocates exactly.
+      if (mSlabs.size() == mSlabs.capacity())
+        mSlabs.reserve(std::max<size_t>(16, 2 * mSlabs.size()));
+      auto* slab = static_cast<std::byte*>(
+          mUpstream->allocate(slabSize, slabAlignment));
+      mSlabs.push_back(slab);
+      sc.next = slab;
+      sc.end = slab + slabSize / size * size;
+    }
+    void* block = sc.next;
+    sc.next += size;
+    mBytesInUse += size;
+    return block;
+  }
+
+  void freeBlock(void* p, size_t size) noexcept {
+    SizeClass& sc = sizeClass(size);
+    sc.freeList = ::new (p) FreeBlock{sc.freeList};
+    mBytesInUse -= size;
+  }
+
+  void* allocateLarge(size_t bytes, size_t alignment) {
+    void* block = mUpstream->allocate(bytes, alignment);
+    try {
+      mLargeBlocks.emplace(block, LargeBlock{bytes, alignment});
+    } catch (...) {
+      mUpstream->deallocate(block, bytes, alignment);
+      throw;
+    }
+    mBytesInUse += bytes;
+    return block;
+  }
+
+  void freeLarge(void* p, size_t bytes, size_t alignment) {
+    mLargeBlocks.erase(p);
+    mUpstream->deallocate(p, bytes, alignment);
+    mBytesInUse -= bytes;
+  }
+
+  std::pmr::memory_resource* mUpstream;
+  std::array<SizeClass, numClasses> mClasses{};
+  std::vector<std::byte*> mSlabs;
+  std::unordered_map<void*, LargeBlock> mLargeBlocks;
+  size_t mBytesInUse = 0;
+};
+
+class SharedNodePool : public std::pmr::memory_resource {
+ public:
+  // Free blocks a thread keeps per size class, and how many move between
+  // the thread and the shared pool at once.
+  static constexpr size_t cacheCapacity = 64;
+  static constexpr size_t batchSize = 32;
+
+  explicit SharedNodePool(
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : mState(std::make_shared<State>(upstream)) {}
+
+  SharedNodePool(const SharedNodePool&) = delete;
+  SharedNodePool& operator=(const SharedNodePool&) = delete;
+
+  // Must not run while another thread uses the pool. Blocks left in thread
+  // caches are dropped the next time their thread uses the pool.
+  void release() {
+    std::lock_guard lock(mState->mutex);
+    mState->generation.fetch_add(1, std::memory_order_relaxed);
+    mState->pool.release();
+  }
+
+  // Blocks held in thread caches count as in use.
+  NodePool::Stats stats() const {
+    std::lock_guard lock(mState->mutex);
+    return mState->pool.stats();
+  }
+
+  std::pmr::memory_resource* upstream_resource() const {
+    return mState->pool.upstream_resource();
+  }
+
+ protected:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    size_t size = NodePool::blockSize(bytes, alignment);
+    if (size == 0) {
+      std::lock_guard lock(mState->mutex);
+      return mState->pool.allocateLarge(bytes, alignment);
+    }
+    Bin& bin = localCache().bins[size / NodePool::granularity - 1];
+    if (!bin.head) refill(bin, size);
+    NodePool::FreeBlock* block = bin.head;
+    bin.head = block->next;
+    --bin.count;
+    return block;
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    size_t size = NodePool::blockSize(bytes, alignment);
+    if (size == 0) {
+      std::lock_guard lock(mState->mutex);
+      mState->pool.freeLarge(p, bytes, alignment);
+      return;
+    }
+    Bin& bin = localCache().bins[size / NodePool::granularity - 1];
+    bin.head = ::new (p) NodePool::FreeBlock{bin.head};
+    if (++bin.count > cacheCapacity) flush(bin, size, batchSize);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other)
+      const noexcept override {
+    return this == &other;
+  }
+
+ private:
+  // Owned jointly with the thread caches' weak pointers, so that a thread
+  // that exits after the pool is gone can tell.
+  struct State {
+    explicit State(std::pmr::memory_resource* upstream) : pool(upstream) {}
+
+    // Unlike the State's address, never reused by a later pool.
+    const uint64_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    std::mutex mutex;
+    NodePool pool;
+    // Bumped by release(); cached blocks of an older generation are stale.
+    std::atomic<uint64_t> generation{0};
+  };
+
+  struct Bin {
+    NodePool::FreeBlock* head = nullptr;
+    size_t count = 0;
+  };
+
+  // One thread's free blocks for one pool.
+  struct ThreadCache {
+    std::weak_ptr<State> state;
+    uint64_t id = 0;
+    uint64_t generation = 0;
+    std::array<Bin, NodePool::numClasses> bins{};
+
+    // Hands every cached block back; the caller holds the pool's mutex.
+    void returnAll(NodePool& pool) {
+      for (size_t i = 0; i < bins.size(); ++i) {
+        while (NodePool::FreeBlock* block = bins[i].head) {
+          bins[i].head = block->next;
+          pool.freeBlock(block, (i + 1) * NodePool::granularity);
+        }
+        bins[i].count = 0;
+      }
+    }
+  };
+
+  // The caches of the calling thread, one per pool it has used. When the
+  // thread exits, blocks go back to pools that still exist.
+  struct ThreadCaches {
+    std::vector<std::unique_ptr<ThreadCache>> caches;
+    ThreadCache* last = nullptr;
+
+    ~ThreadCaches() {
+      for (auto& cache : caches) {
+        std::shared_ptr<State> state = cache->state.lock();
+        if (!state) continue;
+        std::lock_guard lock(state->mutex);
+        if (cache->generation ==
+            state->generation.load(std::memory_order_relaxed))
+          cache->returnAll(state->pool);
+      }
+    }
+  };
+
+  ThreadCache& localCache() {
+    static thread_local ThreadCaches threadCaches;
+    ThreadCache* cache = threadCaches.last;
+    if (!cache || cache->id != mState->id) {
+      cache = findCache(threadCaches);
+      threadCaches.last = cache;
+    }
+    uint64_t generation = mState->generation.load(std::memory_order_relaxed);
+    if (cache->generation != generation) {
+      cache->bins = {};
+      cache->generation = generation;
+    }
+    return *cache;
+  }
+
+  // The slow path: drops the caches of pools that no longer exist, then
+  // finds or adds this pool's cache.
+  ThreadCache* findCache(ThreadCaches& threadCaches) {
+    auto& caches = threadCaches.caches;
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [](const auto& cache) {
+                                  return cache->state.expired();
+                                }),
+                 caches.end());
+    for (auto& cache : caches)
+      if (cache->id == mState->id) return cache.get();
+    auto cache = std::make_unique<ThreadCache>();
+    cache->state = mState;
+    cache->id = mState->id;
+    cache->generation = mState->generation.load(std::memory_order_relaxed);
+    caches.push_back(std::move(cache));
+    return caches.back().get();
+  }
+
+  void refill(Bin& bin, size_t size) {
+    std::lock_guard lock(mState->mutex);
+    for (size_t i = 0; i < batchSize; ++i) {
+      void* block = mState->pool.allocateBlock(size);
+      bin.head = ::new (block) NodePool::FreeBlock{bin.head};
+      ++bin.count;
+    }
+  }
+
+  void flush(Bin& bin, size_t size, size_t count) {
+    std::lock_guard lock(mState->mutex);
+    for (size_t i = 0; i < count; ++i) {
+      NodePool::FreeBlock* block = bin.head;
+      bin.head = block->next;
+      mState->pool.freeBlock(block, size);
+    }
+    bin.count -= count;
+  }
+
+  static inline std::atomic<uint64_t> nextId{1};
+
+  std::shared_ptr<State> mState;
+};
+
+#endif  // NODE_POOL_H
@@ -0,0 +1,569 @@
+/* This file implements multi-threaded versions of the numeric algorithms shown
+ * in numericAlgorithms() of container_vector.cpp. Every function takes the
+ * number of threads as its first argument, in the same place where the
+ * standard library takes an execution policy.
+ *
+ * All of them use the same two-pass (reduce-then-scan) decomposition:
+ *   Pass 1: The input is cut into fixed-size blocks and every block is
+ *           reduced independently, spread over the threads.
+ *   Pass 2: The block results are combined serially, in block order, and
+ *           (for scans) every block is scanned again starting from its offset.
+ *
+ * Block boundaries depend only on the input size and never on the number of
+ * threads, and each block is reduced with a fixed set of accumulator lanes
+ * (scans with an operation other than + or * on numbers fold each block
+ * left to right instead, since the lanes reorder the operands).
+ * The grouping of floating point operations is therefore identical for any
+ * thread count, so float/double results are bitwise reproducible. The lanes
+ * are independent of each other, which lets the compiler turn the inner loop
+ * into SIMD instructions; an SSE2 path is used for integer prefix sums.
+ *
+ * 1. parallelReduce() / parallelTransformReduce()
+ * 2. parallelInnerProduct()
+ * 3. parallelInclusiveScan() / parallelPartialSum()
+ * 4. parallelExclusiveScan()
+ * 5. parallelAdjacentDifference()
+ * 6. Examples and benchmark
+ *
+ * Build with: g++ -std=c++20 -O3 -march=native -pthread parallel_numeric.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Number of elements per block. Large enough to amortize the per-block work,
+// small enough for a block of doubles to stay in L2.
+constexpr size_t blockSize = 1 << 15;
+
+// Number of independent accumulators used inside a block.
+constexpr size_t laneCount = 8;
+
+size_t defaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls blockFunction(blockIndex) for every block, giving each thread a
+// contiguous range of blocks.
+template <typename BlockFunction>
+void forEachBlock(size_t numBlocks, size_t numThreads,
+                  BlockFunction blockFunction) {
+  numThreads =
+      std::clamp<size_t>(numThreads, 1, std::max<size_t>(numBlocks, 1));
+  if (numThreads == 1) {
+    for (size_t b = 0; b < numBlocks; ++b) blockFunction(b);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  auto runRange = [&](size_t t) {
+    size_t begin = numBlocks * t / numThreads;
+    size_t end = numBlocks * (t + 1) / numThreads;
+    for (size_t b = begin; b < end; ++b) blockFunction(b);
+  };
+  for (size_t t = 1; t < numThreads; ++t) threads.emplace_back(runRange, t);
+  runRange(0);
+  for (auto& thread : threads) thread.join();
+}
+
+size_t blockCount(size_t size) { return (size + blockSize - 1) / blockSize; }
+
+// Reduces load(0) ... load(count - 1) with laneCount interleaved accumulators
+// followed by a fixed pairwise combination of the lanes. count must be > 0.
+template <typename T, typename BinaryOp, typename Load>
+T reduceBlock(size_t count, BinaryOp op, Load load) {
+  if (count < laneCount) {
+    T result = load(0);
+    for (size_t i = 1; i < count; ++i) result = op(result, load(i));
+    return result;
+  }
+
+  std::array<T, laneCount> lanes;
+  for (size_t k = 0; k < laneCount; ++k) lanes[k] = load(k);
+  size_t i = laneCount;
+  for (; i + laneCount <= count; i += laneCount) {
+    for (size_t k = 0; k < laneCount; ++k) {
+      lanes[k] = op(lanes[k], load(i + k));
+    }
+  }
+  for (size_t width = laneCount / 2; width > 0; width /= 2) {
+    for (size_t k = 0; k < width; ++k) {
+      lanes[k] = op(lanes[k], lanes[k + width]);
+    }
+  }
+  T result = lanes[0];
+  for (; i < count; ++i) result = op(result, load(i));
+  return result;
+}
+
+// Reduces load(0) ... load(count - 1) strictly left to right. count must be
+// > 0.
+template <typename T, typename BinaryOp, typename Load>
+T foldBlock(size_t count, BinaryOp op, Load load) {
+  T result = load(0);
+  for (size_t i = 1; i < count; ++i) result = op(result, load(i));
+  return result;
+}
+
+// Operations whose operands reduceBlock() may reorder without changing the
+// result (up to floating point rounding).
+template <typename T, typename BinaryOp>
+constexpr bool isCommutative =
+    std::is_arithmetic_v<T> &&
+    (std::is_same_v<BinaryOp, std::plus<>> ||
+     std::is_same_v<BinaryOp, std::plus<T>> ||
+     std::is_same_v<BinaryOp, std::multiplies<>> ||
+     std::is_same_v<BinaryOp, std::multiplies<T>>);
+
+// Pass 1 for every algorithm: one partial result per block. inOrder keeps
+// the operands of each block in their order, for scans with an operation
+// that is associative but not commutative.
+template <typename T, bool inOrder = false, typename BinaryOp, typename Load>
+std::vector<T> reduceBlocks(size_t numThreads, size_t size, BinaryOp op,
+                            Load load) {
+  std::vector<T> partials(blockCount(size));
+  forEachBlock(partials.size(), numThreads, [&](size_t b) {
+    size_t begin = b * blockSize;
+    size_t count = std::min(blockSize, size - begin);
+    auto loadFromBegin = [&](size_t i) { return load(begin + i); };
+    if constexpr (inOrder)
+      partials[b] = foldBlock<T>(count, op, loadFromBegin);
+    else
+      partials[b] = reduceBlock<T>(count, op, loadFromBegin);
+  });
+  return partials;
+}
+
+// 1. parallelReduce() / parallelTransformReduce()
+template <typename RandomIt, typename T, typename BinaryOp, typename UnaryOp>
+T parallelTransformReduce(size_t numThreads, RandomIt first, RandomIt last,
+                          T init, BinaryOp reduceOp, UnaryOp transformOp) {
+  size_t size = static_cast<size_t>(last - first);
+  if (size == 0) return init;
+  auto partials = reduceBlocks<T>(
+      numThreads, size, reduceOp,
+      [&](size_t i) -> T { return transformOp(first[i]); });
+  for (const T& partial : partials) init = reduceOp(init, partial);
+  return init;
+}
+
+template <typename RandomIt1, typename RandomIt2, typename T,
+          typename BinaryReduceOp, typename BinaryTransformOp>
+T parallelTransformReduce(size_t numThreads, RandomIt1 first1, RandomIt1 last1,
+                          RandomIt2 first2, T init, BinaryReduceOp reduceOp,
+                          BinaryTransformOp transformOp) {
+  size_t size = static_cast<size_t>(last1 - first1);
+  if (size == 0) return init;
+  auto partials = reduceBlocks<T>(
+      numThreads, size, reduceOp,
+      [&](size_t i) -> T { return transformOp(first1[i], first2[i]); });
+  for (const T& partial : partials) init = reduceOp(init, partial);
+  return init;
+}
+
+template <typename RandomIt, typename T, typename BinaryOp = std::plus<>>
+T parallelReduce(size_t numThreads, RandomIt first, RandomIt last, T init,
+                 BinaryOp op = {}) {
+  return parallelTransformReduce(numThreads, first, last, init, op,
+                                 [](const auto& x) { return x; });
+}
+
+// 2. parallelInnerProduct()
+template <typename RandomIt1, typename RandomIt2, typename T>
+T parallelInnerProduct(size_t numThreads, RandomIt1 first1, RandomIt1 last1,
+                       RandomIt2 first2, T init) {
+  return parallelTransformReduce(numThreads, first1, last1, first2, init,
+                                 std::plus<>(), std::multiplies<>());
+}
+
+// Scans one block sequentially. carry holds the value that precedes the
+// block, if any. Returns nothing; the next block gets its carry from pass 1.
+template <typename InIt, typename OutIt, typename T, typename BinaryOp>
+void scanBlock(InIt in, OutIt out, size_t count, std::optional<T> carry,
+               BinaryOp op, bool inclusive) {
+  size_t i = 0;
+  if (!carry) {  // first block of an inclusive scan without init
+    carry = static_cast<T>(in[0]);
+    out[0] = *carry;
+    i = 1;
+  }
+  T running = *carry;
+  if (inclusive) {
+    for (; i < count; ++i) {
+      running = op(running, in[i]);
+      out[i] = running;
+    }
+  } else {
+    for (; i < count; ++i) {
+      T value = in[i];
+      out[i] = running;
+      running = op(running, value);
+    }
+  }
+}
+
+#if defined(__SSE2__)
+// Inclusive/exclusive prefix sum of 32-bit integers, four lanes at a time:
+// two shifted adds build the prefix inside a register, then the carry from
+// the previous register is broadcast and added.
+inline void scanBlockSse2(const int* in, int* out, size_t count, int carry,
+                          bool inclusive) {
+  __m128i running = _mm_set1_epi32(carry);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i prefix = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    prefix = _mm_add_epi32(prefix, _mm_slli_si128(prefix, 8));
+    prefix = _mm_add_epi32(prefix, running);
+    __m128i result =
+        inclusive ? prefix : _mm_sub_epi32(prefix, x);  // exclusive drops x
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    running = _mm_shuffle_epi32(prefix, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  int tail = _mm_cvtsi128_si32(running);
+  for (; i < count; ++i) {
+    int value = in[i];
+    if (inclusive) tail += value;
+    out[i] = tail;
+    if (!inclusive) tail += value;
+  }
+}
+#endif
+
+template <typename InIt, typename OutIt, typename T, typename BinaryOp>
+constexpr bool useSse2Scan() {
+#if defined(__SSE2__)
+  return std::contiguous_iterator<InIt> && std::contiguous_iterator<OutIt> &&
+         std::is_same_v<std::iter_value_t<InIt>, int> &&
+         std::is_same_v<std::iter_value_t<OutIt>, int> &&
+         std::is_same_v<T, int> &&
+         (std::is_same_v<BinaryOp, std::plus<>> ||
+          std::is_same_v<BinaryOp, std::plus<int>>);
+#else
+  return false;
+#endif
+}
+
+template <typename T, typename RandomIt, typename OutIt, typename BinaryOp>
+OutIt scanImpl(size_t numThreads, RandomIt first, RandomIt last, OutIt dFirst,
+               BinaryOp op, std::optional<T> init, bool inclusive) {
+  size_t size = static_cast<size_t>(last - first);
+  if (size == 0) return dFirst;
+
+  // Pass 1: reduce every block. Unlike std::reduce(), a scan only needs op
+  // to be associative, so the lanes are used only when op is commutative.
+  auto partials = reduceBlocks<T, !isCommutative<T, BinaryOp>>(
+      numThreads, size, op, [&](size_t i) -> T { return first[i]; });
+
+  // Combine the block totals serially into per-block starting offsets.
+  std::vector<std::optional<T>> offsets(partials.size());
+  std::optional<T> running = init;
+  for (size_t b = 0; b < partials.size(); ++b) {
+    offsets[b] = running;
+    running = running ? op(*running, partials[b]) : partials[b];
+  }
+
+  // Pass 2: scan every block from its offset.
+  forEachBlock(partials.size(), numThreads, [&](size_t b) {
+    size_t begin = b * blockSize;
+    size_t count = std::min(blockSize, size - begin);
+    if constexpr (useSse2Scan<RandomIt, OutIt, T, BinaryOp>()) {
+#if defined(__SSE2__)
+      if (offsets[b]) {
+        scanBlockSse2(std::to_address(first) + begin,
+                      std::to_address(dFirst) + begin, count, *offsets[b],
+                      inclusive);
+        return;
+      }
+#endif
+    }
+    scanBlock(first + begin, dFirst + begin, count, offsets[b], op, inclusive);
+  });
+  return dFirst + size;
+}
+
+// 3. parallelInclusiveScan() / parallelPartialSum()
+template <typename RandomIt, typename OutIt, typename BinaryOp = std::plus<>>
+OutIt parallelInclusiveScan(size_t numThreads, RandomIt first, RandomIt last,
+                            OutIt dFirst, BinaryOp op = {}) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  return scanImpl<T>(numThreads, first, last, dFirst, op, std::nullopt, true);
+}
+
+template <typename RandomIt, typename OutIt, typename BinaryOp, typename T>
+OutIt parallelInclusiveScan(size_t numThreads, RandomIt first, RandomIt last,
+                            OutIt dFirst, BinaryOp op, T init) {
+  return scanImpl<T>(numThreads, first, last, dFirst, op,
+                     std::optional<T>(init), true);
+}
+
+// std::partial_sum() is an inclusive scan whose operation is applied strictly
+// left to right; for an associative operation both are the same, since the
+// scans never reorder the operands of an operation they cannot prove
+// commutative.
+template <typename RandomIt, typename OutIt, typename BinaryOp = std::plus<>>
+OutIt parallelPartialSum(size_t numThreads, RandomIt first, RandomIt last,
+                         OutIt dFirst, BinaryOp op = {}) {
+  return parallelInclusiveScan(numThreads, first, last, dFirst, op);
+}
+
+// 4. parallelExclusiveScan()
+template <typename RandomIt, typename OutIt, typename T,
+          typename BinaryOp = std::plus<>>
+OutIt parallelExclusiveScan(size_t numThreads, RandomIt first, RandomIt last,
+                            OutIt dFirst, T init, BinaryOp op = {}) {
+  return scanImpl<T>(numThreads, first, last, dFirst, op,
+                     std::optional<T>(init), false);
+}
+
+// 5. parallelAdjacentDifference()
+// Every output element depends only on two inputs, so a single pass is
+// enough. For in-place use the last input of each block is saved before any
+// block is overwritten.
+template <typename RandomIt, typename OutIt, typename BinaryOp = std::minus<>>
+OutIt parallelAdjacentDifference(size_t numThreads, RandomIt first,
+                                 RandomIt last, OutIt dFirst,
+                                 BinaryOp op = {}) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  size_t size = static_cast<size_t>(last - first);
+  if (size == 0) return dFirst;
+
+  size_t numBlocks = blockCount(size);
+  std::vector<T> previous(numBlocks);
+  for (size_t b = 1; b < numBlocks; ++b) previous[b] = first[b * blockSize - 1];
+
+  forEachBlock(numBlocks, numThreads, [&](size_t b) {
+    size_t begin = b * blockSize;
+    size_t end = std::min(begin + blockSize, size);
+    T before = b == 0 ? first[0] : previous[b];
+    size_t i = begin;
+    if (b == 0) {
+      dFirst[0] = first[0];
+      i = 1;
+    }
+    for (; i < end; ++i) {
+      T current = first[i];
+      dFirst[i] = op(current, before);
+      before = current;
+    }
+  });
+  return dFirst + size;
+}
+
+// 6. Examples and benchmark
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void numericAlgorithms() {
+  size_t numThreads = defaultThreadCount();
+  std::vector<int> vec1{1, 2, 3, 4, 5};
+  std::vector<int> vec2{6, 7, 8, 9, 10};
+  printVector("First vector", vec1);
+  printVector("Second vector", vec2);
+
+  std::cout << "6.1. parallelReduce(): "
+            << parallelReduce(numThreads, vec1.begin(), vec1.end(), 0)
+            << std::endl;
+
+  std::cout << "6.2. parallelTransformReduce() of squares: "
+            << parallelTransformReduce(numThreads, vec1.begin(), vec1.end(), 0,
+                                       std::plus<>(),
+                                       [](int x) { return x * x; })
+            << std::endl;
+
+  std::cout << "6.3. parallelInnerProduct(): "
+            << parallelInnerProduct(numThreads, vec1.begin(), vec1.end(),
+                                    vec2.begin(), 0)
+            << std::endl;
+
+  std::vector<int> result(vec1.size());
+  parallelAdjacentDifference(numThreads, vec1.begin(), vec1.end(),
+                             result.begin());
+  printVector("6.4. parallelAdjacentDifference()", result);
+
+  parallelPartialSum(numThreads, vec1.begin(), vec1.end(), result.begin());
+  printVector("6.5. parallelPartialSum()", result);
+
+  parallelExclusiveScan(numThreads, vec1.begin(), vec1.end(), result.begin(),
+                        0);
+  printVector("6.6. parallelExclusiveScan()", result);
+
+  parallelInclusiveScan(numThreads, vec1.begin(), vec1.end(), result.begin());
+  printVector("6.7. parallelInclusiveScan()", result);
+}
+
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void checkAgainstStd() {
+  constexpr size_t size = 1'000'003;  // not a multiple of the block size
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  std::vector<int> input(size);
+  for (int& x : input) x = dist(gen);
+
+  std::vector<int> expected(size), actual(size);
+  bool ok = true;
+  for (size_t numThreads : {1, 3, 8}) {
+    std::inclusive_scan(input.begin(), input.end(), expected.begin());
+    parallelInclusiveScan(numThreads, input.begin(), input.end(),
+                          actual.begin());
+    ok = ok && expected == actual;
+
+    std::exclusive_scan(input.begin(), input.end(), expected.begin(), 7);
+    parallelExclusiveScan(numThreads, input.begin(), input.end(),
+                          actual.begin(), 7);
+    ok = ok && expected == actual;
+
+    std::adjacent_difference(input.begin(), input.end(), expected.begin());
+    actual = input;  // in place
+    parallelAdjacentDifference(numThreads, actual.begin(), actual.end(),
+                               actual.begin());
+    ok = ok && expected == actual;
+
+    ok = ok && std::reduce(input.begin(), input.end(), 0LL) ==
+                   parallelReduce(numThreads, input.begin(), input.end(), 0LL);
+
+    // Composing x -> a * x + b functions is associative but not
+    // commutative, so a scan that reorders operands gets it wrong.
+    using Affine = std::pair<uint32_t, uint32_t>;
+    auto compose = [](const Affine& f, const Affine& g) {
+      return Affine(g.first * f.first, g.first * f.second + g.second);
+    };
+    std::vector<Affine> functions(blockSize + 10);
+    for (auto& [a, b] : functions) {
+      a = static_cast<uint32_t>(gen());
+      b = static_cast<uint32_t>(gen());
+    }
+    std::vector<Affine> expectedFunctions(functions.size());
+    std::vector<Affine> actualFunctions(functions.size());
+    std::partial_sum(functions.begin(), functions.end(),
+                     expectedFunctions.begin(), compose);
+    parallelPartialSum(numThreads, functions.begin(), functions.end(),
+                       actualFunctions.begin(), compose);
+    ok = ok && expectedFunctions == actualFunctions;
+  }
+  std::cout << "Integer results match the standard library: " << std::boolalpha
+            << ok << std::endl;
+}
+
+void checkDeterminism() {
+  constexpr size_t size = 3'000'000;
+  std::mt19937_64 gen(7);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> input(size);
+  for (double& x : input) x = dist(gen) * 1e8;
+
+  double reference = parallelReduce(1, input.begin(), input.end(), 0.0);
+  std::vector<double> referenceScan(size), scan(size);
+  parallelInclusiveScan(1, input.begin(), input.end(), referenceScan.begin());
+
+  bool identical = true;
+  for (size_t numThreads : {2, 3, 4, 7, 16}) {
+    double sum = parallelReduce(numThreads, input.begin(), input.end(), 0.0);
+    parallelInclusiveScan(numThreads, input.begin(), input.end(), scan.begin());
+    identical = identical &&
+                std::memcmp(&sum, &reference, sizeof(double)) == 0 &&
+                std::memcmp(scan.data(), referenceScan.data(),
+                            size * sizeof(double)) == 0;
+  }
+  std::cout << "Double results are bitwise identical for 1..16 threads: "
+            << std::boolalpha << identical << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 24;
+  std::vector<int> input(size);
+  for (size_t i = 0; i < size; ++i) input[i] = static_cast<int>(i % 64);
+  std::vector<int> output(size);
+  std::vector<double> doubles(input.begin(), input.end());
+  size_t numThreads = defaultThreadCount();
+  std::cout << "Elements: " << size << ", threads: " << numThreads << std::endl;
+
+  std::cout << "std::inclusive_scan<int>:       "
+            << measureMilliseconds([&] {
+                 std::inclusive_scan(input.begin(), input.end(),
+                                     output.begin());
+               })
+            << " ms" << std::endl;
+  std::cout << "parallelInclusiveScan<int>:     "
+            << measureMilliseconds([&] {
+                 parallelInclusiveScan(numThreads, input.begin(), input.end(),
+                                       output.begin());
+               })
+            << " ms" << std::endl;
+
+  double sink = 0;
+  std::cout << "std::reduce<double>:            "
+            << measureMilliseconds([&] {
+                 sink += std::reduce(doubles.begin(), doubles.end(), 0.0);
+               })
+            << " ms" << std::endl;
+  std::cout << "parallelReduce<double>:         "
+            << measureMilliseconds([&] {
+                 sink += parallelReduce(numThreads, doubles.begin(),
+                                        doubles.end(), 0.0);
+               })
+            << " ms" << std::endl;
+  std::cout << "std::inner_product<double>:     "
+            << measureMilliseconds([&] {
+                 sink += std::inner_product(doubles.begin(), doubles.end(),
+                                            doubles.begin(), 0.0);
+               })
+            << " ms" << std::endl;
+  std::cout << "parallelInnerProduct<double>:   "
+            << measureMilliseconds([&] {
+                 sink += parallelInnerProduct(numThreads, doubles.begin(),
+                                              doubles.end(), doubles.begin(),
+                                              0.0);
+               })
+            << " ms" << std::endl;
+  std::cout << "(checksum " << sink + output.back() << ")" << std::endl;
+}
+
+int main() {
+  // 6.1 - 6.7. Numeric algorithms
+  std::cout << "*** Parallel numeric algorithms ***" << std::endl;
+  numericAlgorithms();
+
+  // Correctness
+  std::cout << std::endl << "*** Correctness checks ***" << std::endl;
+  checkAgainstStd();
+  checkDeterminism();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,595 @@
+/* This file implements multi-threaded versions of std::partition() and
+ * std::stable_partition() from partitioningAllgorithms() in
+ * container_vector.cpp, and a k-way merge of sorted runs built on a loser
+ * tree: the merge step of an external sort, and the k-run generalization of
+ * the std::inplace_merge() shown in additionalAlgorithms(). As in
+ * parallel_numeric.cpp, every function takes the number of threads as its
+ * first argument. std::partition_point() is a binary search and stays
+ * serial.
+ *
+ * 1. parallelPartition(): in place, not stable
+ *    Pass 1: every thread partitions its own contiguous chunk.
+ *    Pass 2: with K elements satisfying the predicate in total, the false
+ *            elements left of K and the true elements right of K are the
+ *            only misplaced ones, and there are equally many of both. They
+ *            form at most one segment per chunk on each side, so the
+ *            swaps are split evenly over the threads.
+ * 2. parallelStablePartition(): count, then scatter
+ *    Pass 1: every thread evaluates the predicate over its chunk, keeps the
+ *            result in a flag array and counts the true elements.
+ *    Pass 2: prefix sums of the counts give every chunk its output offsets,
+ *            the elements are moved into a buffer and back, in parallel.
+ * 3. LoserTree and multiwayMerge()
+ *    A tournament tree over k runs. Every internal node stores the loser of
+ *    the match played there, so replacing the winner only replays the
+ *    matches on one leaf-to-root path: log2(k) comparisons per element,
+ *    against about 2 log2(k) for a binary heap. Ties go to the earlier run,
+ *    which makes the merge stable.
+ * 4. parallelMultiwayMerge()
+ *    splitRuns() finds, for any output rank r, how many elements of each run
+ *    come before r (multi-sequence selection). Cutting the output into one
+ *    equal part per thread gives independent k-way merges.
+ * 5. Examples and benchmark
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread parallel_partition_merge.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Below this many elements per thread, starting threads costs more than the
+// work they would do.
+constexpr size_t minChunkSize = 1 << 14;
+
+size_t defaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Limits numThreads so every thread gets at least minChunkSize elements.
+size_t usefulThreads(size_t numThreads, size_t size) {
+  return std::clamp<size_t>(numThreads, 1,
+                            std::max<size_t>(size / minChunkSize, 1));
+}
+
+// Calls function(t) for t = 0 .. numThreads - 1, one thread each; thread 0 is
+// the calling thread.
+template <typename Function>
+void runOnThreads(size_t numThreads, Function function) {
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t t = 1; t < numThreads; ++t) threads.emplace_back(function, t);
+  function(0);
+  for (auto& thread : threads) thread.join();
+}
+
+// 1. parallelPartition()
+template <typename RandomIt, typename Predicate>
+RandomIt parallelPartition(size_t numThreads, RandomIt first, RandomIt last,
+                           Predicate pred) {
+  const size_t size = static_cast<size_t>(last - first);
+  numThreads = usefulThreads(numThreads, size);
+  if (numThreads == 1) return std::partition(first, last, pred);
+
+  auto chunkBegin = [&](size_t t) { return size * t / numThreads; };
+  std::vector<size_t> trueCounts(numThreads);
+  runOnThreads(numThreads, [&](size_t t) {
+    RandomIt begin = first + chunkBegin(t), end = first + chunkBegin(t + 1);
+    trueCounts[t] = static_cast<size_t>(std::partition(begin, end, pred) -
+                                        begin);
+  });
+  const size_t split =
+      std::accumulate(trueCounts.begin(), trueCounts.end(), size_t{0});
+
+  // Misplaced segments [begin, end) in chunk order, on both sides of split.
+  struct Segment {
+    size_t begin, end;
+  };
+  std::vector<Segment> misplacedFalse, misplacedTrue;
+  for (size_t t = 0; t < numThreads; ++t) {
+    size_t begin = chunkBegin(t), end = chunkBegin(t + 1);
+    size_t middle = begin + trueCounts[t];
+    if (middle < split)
+      misplacedFalse.push_back({middle, std::min(end, split)});
+    if (middle > split)
+      misplacedTrue.push_back({std::max(begin, split), middle});
+  }
+  size_t misplaced = 0;
+  for (const Segment& s : misplacedFalse) misplaced += s.end - s.begin;
+  if (misplaced == 0) return first + split;
+
+  // Position of the j-th element in a list of segments.
+  auto locate = [](const std::vector<Segment>& segments, size_t j) {
+    size_t index = 0;
+    while (j >= segments[index].end - segments[index].begin) {
+      j -= segments[index].end - segments[index].begin;
+      ++index;
+    }
+    return std::make_pair(index, segments[index].begin + j);
+  };
+
+  runOnThreads(numThreads, [&](size_t t) {
+    size_t j = misplaced * t / numThreads;
+    size_t jEnd = misplaced * (t + 1) / numThreads;
+    if (j == jEnd) return;
+    auto [f, fPos] = locate(misplacedFalse, j);
+    auto [g, tPos] = locate(misplacedTrue, j);
+    while (j < jEnd) {
+      size_t count = std::min({misplacedFalse[f].end - fPos,
+                               misplacedTrue[g].end - tPos, jEnd - j});
+      std::swap_ranges(first + fPos, first + fPos + count, first + tPos);
+      j += count;
+      fPos += count;
+      tPos += count;
+      if (fPos == misplacedFalse[f].end && ++f < misplacedFalse.size())
+        fPos = misplacedFalse[f].begin;
+      if (tPos == misplacedTrue[g].end && ++g < misplacedTrue.size())
+        tPos = misplacedTrue[g].begin;
+    }
+  });
+  return first + split;
+}
+
+// 2. parallelStablePartition()
+// Applies pred exactly once per element, like std::stable_partition().
+template <typename RandomIt, typename Predicate>
+RandomIt parallelStablePartition(size_t numThreads, RandomIt first,
+                                 RandomIt last, Predicate pred) {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  const size_t size = static_cast<size_t>(last - first);
+  numThreads = usefulThreads(numThreads, size);
+  if (numThreads == 1) return std::stable_partition(first, last, pred);
+
+  auto chunkBegin = [&](size_t t) { return size * t / numThreads; };
+  std::vector<uint8_t> flags(size);
+  std::vector<size_t> trueCounts(numThreads);
+  runOnThreads(numThreads, [&](size_t t) {
+    size_t count = 0;
+    for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+      flags[i] = pred(first[i]) ? 1 : 0;
+      count += flags[i];
+    }
+    trueCounts[t] = count;
+  });
+
+  // Chunk t writes its true elements after the true elements of chunks
+  // 0 .. t-1, and its false elements after all true elements and the false
+  // elements of chunks 0 .. t-1.
+  std::vector<size_t> trueOffsets(numThreads), falseOffsets(numThreads);
+  const size_t split =
+      std::accumulate(trueCounts.begin(), trueCounts.end(), size_t{0});
+  for (size_t t = 0, trues = 0, falses = split; t < numThreads; ++t) {
+    trueOffsets[t] = trues;
+    falseOffsets[t] = falses;
+    trues += trueCounts[t];
+    falses += chunkBegin(t + 1) - chunkBegin(t) - trueCounts[t];
+  }
+
+  std::allocator<T> allocator;
+  T* buffer = allocator.allocate(size);
+  runOnThreads(numThreads, [&](size_t t) {
+    size_t trueOut = trueOffsets[t], falseOut = falseOffsets[t];
+    for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+      size_t& out = flags[i] ? trueOut : falseOut;
+      std::construct_at(buffer + out++, std::move(first[i]));
+    }
+  });
+  runOnThreads(numThreads, [&](size_t t) {
+    for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i) {
+      first[i] = std::move(buffer[i]);
+      std::destroy_at(buffer + i);
+    }
+  });
+  allocator.deallocate(buffer, size);
+  return first + split;
+}
+
+// 3. LoserTree
+// Leaves k .. 2k-1 stand for the runs, internal nodes 1 .. k-1 hold losers
+// and node 0 holds the overall winner. This shape works for any k, not only
+// powers of two.
+template <typename RandomIt, typename Compare = std::less<>>
+class LoserTree {
+ public:
+  using Run = std::pair<RandomIt, RandomIt>;
+  using Value = typename std::iterator_traits<RandomIt>::value_type;
+
+  LoserTree(std::vector<Run> runs, Compare comp = {})
+      : mRuns(std::move(runs)),
+        mComp(comp),
+        mNodes(mRuns.size()),
+        mKeys(mRuns.size()),
+        mExhausted(mRuns.size()) {
+    for (size_t run = 0; run < mRuns.size(); ++run) load(run);
+    if (!mRuns.empty()) mNodes[0] = build(1);
+  }
+
+  bool empty() const { return mRuns.empty() || mExhausted[mNodes[0]]; }
+
+  // Index of the run holding the smallest head element, and that element.
+  size_t winner() const { return mNodes[0]; }
+  const Value& top() const { return mKeys[mNodes[0]]; }
+
+  // Advances the winning run and replays its path to the root.
+  void pop() {
+    size_t candidate = mNodes[0];
+    ++mRuns[candidate].first;
+    load(candidate);
+    for (size_t node = (candidate + mRuns.size()) / 2; node > 0; node /= 2) {
+      size_t loser = mNodes[node];
+      bool swap = beats(loser, candidate);
+      mNodes[node] = swap ? candidate : loser;
+      candidate = swap ? loser : candidate;
+    }
+    mNodes[0] = candidate;
+  }
+
+ private:
+  // The head of every run is copied next to the others, so a match
+  // compares two entries of one small array instead of following two
+  // iterators into different runs.
+  void load(size_t run) {
+    mExhausted[run] = mRuns[run].first == mRuns[run].second;
+    if (!mExhausted[run]) mKeys[run] = *mRuns[run].first;
+  }
+
+  // Exhausted runs lose every match; equal heads go to the earlier run.
+  bool beats(size_t a, size_t b) const {
+    if (mExhausted[a] | mExhausted[b]) [[unlikely]]
+      return !mExhausted[a];
+    return mComp(mKeys[a], mKeys[b]) | ((a < b) & !mComp(mKeys[b], mKeys[a]));
+  }
+
+  // Plays all matches below node and returns the winner of the subtree.
+  size_t build(size_t node) {
+    const size_t k = mRuns.size();
+    if (node >= k) return node - k;
+    size_t left = build(2 * node), right = build(2 * node + 1);
+    if (beats(left, right)) {
+      mNodes[node] = right;
+      return left;
+    }
+    mNodes[node] = left;
+    return right;
+  }
+
+  std::vector<Run> mRuns;
+  Compare mComp;
+  std::vector<size_t> mNodes;
+  std::vector<Value> mKeys;
+  std::vector<uint8_t> mExhausted;
+};
+
+// Merges the sorted runs into out; stable across runs.
+template <typename RandomIt, typename OutIt, typename Compare = std::less<>>
+OutIt multiwayMerge(std::vector<std::pair<RandomIt, RandomIt>> runs, OutIt out,
+                    Compare comp = {}) {
+  size_t total = 0;
+  for (const auto& run : runs) total += static_cast<size_t>(run.second -
+                                                            run.first);
+  LoserTree<RandomIt, Compare> tree(std::move(runs), comp);
+  for (size_t i = 0; i < total; ++i) {
+    *out++ = tree.top();
+    tree.pop();
+  }
+  return out;
+}
+
+// 4. parallelMultiwayMerge()
+// Returns p with sum(p) == rank such that the first p[i] elements of every
+// run i are exactly the first `rank` elements of the stable merge.
+template <typename RandomIt, typename Compare>
+std::vector<size_t> splitRuns(
+    const std::vector<std::pair<RandomIt, RandomIt>>& runs, size_t rank,
+    Compare comp) {
+  const size_t k = runs.size();
+  std::vector<size_t> lo(k, 0), hi(k), positions(k);
+  size_t total = 0;
+  for (size_t i = 0; i < k; ++i) {
+    hi[i] = static_cast<size_t>(runs[i].second - runs[i].first);
+    total += hi[i];
+  }
+  if (rank >= total) return hi;
+
+  // The pivot comes from the run with the widest remaining window, so
+  // every round at least halves that window.
+  std::vector<size_t> less(k), lessOrEqual(k);
+  while (true) {
+    size_t widest = 0;
+    for (size_t i = 1; i < k; ++i) {
+      if (hi[i] - lo[i] > hi[widest] - lo[widest]) widest = i;
+    }
+    const auto& pivot =
+        runs[widest].first[(lo[widest] + hi[widest]) / 2];
+
+    size_t below = 0, belowOrEqual = 0;
+    for (size_t i = 0; i < k; ++i) {
+      RandomIt begin = runs[i].first;
+      less[i] = static_cast<size_t>(
+          std::lower_bound(begin + lo[i], begin + hi[i], pivot, comp) -
+          begin);
+      lessOrEqual[i] = static_cast<size_t>(
+          std::upper_bound(begin + less[i], begin + hi[i], pivot, comp) -
+          begin);
+      below += less[i];
+      belowOrEqual += lessOrEqual[i];
+    }
+
+    if (rank < below) {
+      for (size_t i = 0; i < k; ++i) hi[i] = less[i];
+    } else if (rank >= belowOrEqual) {
+      for (size_t i = 0; i < k; ++i) lo[i] = lessOrEqual[i];
+    } else {
+      // The cut falls among the elements equal to pivot; they are handed
+      // out in run order, matching the tie-breaking of the loser tree.
+      size_t remaining = rank - below;
+      for (size_t i = 0; i < k; ++i) {
+        size_t take = std::min(remaining, lessOrEqual[i] - less[i]);
+        positions[i] = less[i] + take;
+        remaining -= take;
+      }
+      return positions;
+    }
+  }
+}
+
+template <typename RandomIt, typename OutRandomIt,
+          typename Compare = std::less<>>
+OutRandomIt parallelMultiwayMerge(
+    size_t numThreads, const std::vector<std::pair<RandomIt, RandomIt>>& runs,
+    OutRandomIt out, Compare comp = {}) {
+  size_t total = 0;
+  for (const auto& run : runs) total += static_cast<size_t>(run.second -
+                                                            run.first);
+  numThreads = usefulThreads(numThreads, total);
+  if (numThreads == 1) return multiwayMerge(runs, out, comp);
+
+  std::vector<std::vector<size_t>> cuts(numThreads + 1);
+  runOnThreads(numThreads + 1, [&](size_t t) {
+    cuts[t] = splitRuns(runs, total * t / numThreads, comp);
+  });
+  runOnThreads(numThreads, [&](size_t t) {
+    std::vector<std::pair<RandomIt, RandomIt>> parts;
+    for (size_t i = 0; i < runs.size(); ++i) {
+      parts.emplace_back(runs[i].first + cuts[t][i],
+                         runs[i].first + cuts[t + 1][i]);
+    }
+    multiwayMerge(std::move(parts), out + total * t / numThreads, comp);
+  });
+  return out + total;
+}
+
+// Two-run case: a parallel std::merge().
+template <typename RandomIt1, typename OutRandomIt,
+          typename Compare = std::less<>>
+OutRandomIt parallelMerge(size_t numThreads, RandomIt1 first1, RandomIt1 last1,
+                          RandomIt1 first2, RandomIt1 last2, OutRandomIt out,
+                          Compare comp = {}) {
+  return parallelMultiwayMerge(numThreads, {{first1, last1}, {first2, last2}},
+                               out, comp);
+}
+
+// 5. Examples and benchmark
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void partitionAndMergeExamples() {
+  auto isEven = [](int x) { return x % 2 == 0; };
+  std::vector<int> vec{1, 4, 3, 2, 5, 8, 7, 6};
+
+  // 5.1. parallelPartition()
+  std::cout << "5.1. Using parallelPartition() to move x % 2 == 0 to the "
+               "front"
+            << std::endl;
+  std::vector<int> vec2 = vec;
+  printVector("Initial vector", vec2);
+  parallelPartition(2, vec2.begin(), vec2.end(), isEven);
+  printVector("Modified vector", vec2);
+
+  // 5.2. parallelStablePartition()
+  std::cout << std::endl
+            << "5.2. Using parallelStablePartition(), keeping the relative "
+               "order"
+            << std::endl;
+  std::vector<int> vec3 = vec;
+  printVector("Initial vector", vec3);
+  parallelStablePartition(2, vec3.begin(), vec3.end(), isEven);
+  printVector("Modified vector", vec3);
+
+  // 5.3. multiwayMerge()
+  std::cout << std::endl
+            << "5.3. Using multiwayMerge() on three sorted runs" << std::endl;
+  std::vector<int> run1{1, 4, 7, 10}, run2{2, 5, 8}, run3{0, 3, 6, 9, 11};
+  printVector("Run 1", run1);
+  printVector("Run 2", run2);
+  printVector("Run 3", run3);
+  using It = std::vector<int>::const_iterator;
+  std::vector<std::pair<It, It>> runs{{run1.cbegin(), run1.cend()},
+                                      {run2.cbegin(), run2.cend()},
+                                      {run3.cbegin(), run3.cend()}};
+  std::vector<int> merged(12);
+  multiwayMerge(runs, merged.begin());
+  printVector("Merged vector", merged);
+}
+
+bool checkAgainstStd() {
+  std::mt19937 gen(3);
+  bool ok = true;
+  for (size_t size : {0u, 1u, 1000u, 100000u, 1000003u}) {
+    std::uniform_int_distribution<int> dist(0, 999);
+    std::vector<int> input(size);
+    for (int& x : input) x = dist(gen);
+    auto pred = [](int x) { return x < 300; };
+
+    std::vector<int> vec = input;
+    auto middle = parallelPartition(4, vec.begin(), vec.end(), pred);
+    ok = ok && std::is_partitioned(vec.begin(), vec.end(), pred) &&
+         middle == std::partition_point(vec.begin(), vec.end(), pred);
+    std::vector<int> sortedInput = input;
+    std::sort(sortedInput.begin(), sortedInput.end());
+    std::sort(vec.begin(), vec.end());
+    ok = ok && vec == sortedInput;
+
+    std::vector<int> expected = input;
+    vec = input;
+    std::stable_partition(expected.begin(), expected.end(), pred);
+    parallelStablePartition(4, vec.begin(), vec.end(), pred);
+    ok = ok && vec == expected;
+
+    // Stability of the merge: equal keys must keep run order, so the
+    // elements carry (key, run) and only the key is compared.
+    using Item = std::pair<int, int>;
+    auto byKey = [](const Item& a, const Item& b) { return a.first < b.first; };
+    std::vector<std::vector<Item>> runs(7);
+    for (size_t i = 0; i < size; ++i) {
+      size_t r = gen() % runs.size();
+      runs[r].emplace_back(dist(gen) % 50, static_cast<int>(r));
+    }
+    std::vector<Item> all;
+    std::vector<std::pair<std::vector<Item>::const_iterator,
+                          std::vector<Item>::const_iterator>>
+        ranges;
+    for (auto& run : runs) {
+      std::stable_sort(run.begin(), run.end(), byKey);
+      all.insert(all.end(), run.begin(), run.end());
+      ranges.emplace_back(run.cbegin(), run.cend());
+    }
+    std::stable_sort(all.begin(), all.end(), byKey);
+    std::vector<Item> merged(all.size());
+    multiwayMerge(ranges, merged.begin(), byKey);
+    ok = ok && merged == all;
+    std::fill(merged.begin(), merged.end(), Item{});
+    parallelMultiwayMerge(4, ranges, merged.begin(), byKey);
+    ok = ok && merged == all;
+  }
+  return ok;
+}
+
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 25;
+  constexpr size_t numRuns = 16;
+  const size_t numThreads = defaultThreadCount();
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 1'000'000'000);
+  std::vector<int> input(size);
+  for (int& x : input) x = dist(gen);
+  auto pred = [](int x) { return x < 500'000'000; };
+  std::cout << "Elements: " << size << ", threads: " << numThreads
+            << std::endl;
+
+  std::vector<int> vec = input;
+  double stdPartition = measureMilliseconds(
+      [&] { std::partition(vec.begin(), vec.end(), pred); });
+  vec = input;
+  double partition = measureMilliseconds(
+      [&] { parallelPartition(numThreads, vec.begin(), vec.end(), pred); });
+  vec = input;
+  double stdStable = measureMilliseconds(
+      [&] { std::stable_partition(vec.begin(), vec.end(), pred); });
+  vec = input;
+  double stable = measureMilliseconds([&] {
+    parallelStablePartition(numThreads, vec.begin(), vec.end(), pred);
+  });
+  std::cout << "partition:        std " << stdPartition << " ms, parallel "
+            << partition << " ms" << std::endl;
+  std::cout << "stable_partition: std " << stdStable << " ms, parallel "
+            << stable << " ms" << std::endl;
+
+  // Merging sorted runs: repeated std::inplace_merge() of neighbours, a
+  // binary heap, the loser tree, and the loser tree on all threads.
+  std::vector<int> sortedRuns = input;
+  const size_t runSize = size / numRuns;
+  using It = std::vector<int>::const_iterator;
+  std::vector<std::pair<It, It>> runs;
+  for (size_t r = 0; r < numRuns; ++r) {
+    auto begin = sortedRuns.begin() + r * runSize;
+    std::sort(begin, begin + runSize);
+    runs.emplace_back(begin, begin + runSize);
+  }
+
+  vec = sortedRuns;
+  double inplace = measureMilliseconds([&] {
+    for (size_t width = runSize; width < size; width *= 2) {
+      for (size_t begin = 0; begin + width < size; begin += 2 * width) {
+        std::inplace_merge(vec.begin() + begin, vec.begin() + begin + width,
+                           vec.begin() + std::min(begin + 2 * width, size));
+      }
+    }
+  });
+  std::vector<int> expected = vec;
+
+  std::vector<int> heapOut(size);
+  double heap = measureMilliseconds([&] {
+    using Head = std::pair<int, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> queue;
+    std::vector<It> heads;
+    for (size_t r = 0; r < numRuns; ++r) {
+      heads.push_back(runs[r].first);
+      queue.emplace(*heads[r], r);
+    }
+    for (size_t i = 0; i < size; ++i) {
+      auto [value, r] = queue.top();
+      queue.pop();
+      heapOut[i] = value;
+      if (++heads[r] != runs[r].second) queue.emplace(*heads[r], r);
+    }
+  });
+
+  std::vector<int> loserOut(size), parallelOut(size);
+  double loser =
+      measureMilliseconds([&] { multiwayMerge(runs, loserOut.begin()); });
+  double parallel = measureMilliseconds([&] {
+    parallelMultiwayMerge(numThreads, runs, parallelOut.begin());
+  });
+  std::cout << "Merging " << numRuns << " runs: inplace_merge passes "
+            << inplace << " ms, binary heap " << heap << " ms, loser tree "
+            << loser << " ms, parallel loser tree " << parallel << " ms"
+            << std::endl;
+  std::cout << "Same result: " << std::boolalpha
+            << (heapOut == expected && loserOut == expected &&
+                parallelOut == expected)
+            << std::endl;
+}
+
+int main() {
+  // Partitioning and merging
+  std::cout << "*** Parallel partition and k-way merge ***" << std::endl;
+  partitionAndMergeExamples();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match the std algorithms: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
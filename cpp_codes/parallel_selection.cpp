@@ -0,0 +1,541 @@
+/* This file implements a selection engine for percentiles of large vectors.
+ * sortingAndOrderingAlgorithms() of container_vector.cpp uses
+ * std::nth_element() for a single rank; computing p50/p99/p999 that way means
+ * three full passes, and libstdc++ falls back to an O(n log n) heap select in
+ * the worst case.
+ *
+ * 1. introSelect(): quickselect with median-of-3 pivots that switches to
+ *    median-of-medians pivots once it has done more than a linear amount of
+ *    work, which bounds the total to O(n) in the worst case.
+ * 2. multiSelect(): places several ranks at once. It selects the middle rank
+ *    and recurses into both sides with only the ranks that fall there, so k
+ *    ranks cost O(n log k) instead of k full passes.
+ * 3. parallelQuantiles(): leaves the input untouched. A random sample picks
+ *    two splitters around every requested rank, all threads then make a
+ *    single pass that counts the elements below each bracket and copies the
+ *    few inside it, and the exact answer is selected from the small copies.
+ *    If a bracket misses its rank the engine falls back to multiSelect().
+ * 4. QuantileSketch: approximate streaming quantiles with a bounded
+ *    relative error (DDSketch) for data that is never held in memory at once.
+ * 5. Examples and benchmark against one std::nth_element() per percentile
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread parallel_selection.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1. introSelect()
+constexpr ptrdiff_t insertionSortThreshold = 16;
+
+template <typename RandomIt, typename Compare>
+void insertionSort(RandomIt first, RandomIt last, Compare comp) {
+  for (RandomIt it = first + 1; it < last; ++it) {
+    auto value = std::move(*it);
+    RandomIt hole = it;
+    for (; hole != first && comp(value, *(hole - 1)); --hole) {
+      *hole = std::move(*(hole - 1));
+    }
+    *hole = std::move(value);
+  }
+}
+
+template <typename RandomIt, typename Compare>
+void introSelect(RandomIt first, RandomIt nth, RandomIt last, Compare comp);
+
+// Median of medians of groups of five. The medians are gathered at the front
+// of the range and their median is selected recursively.
+template <typename RandomIt, typename Compare>
+auto medianOfMedians(RandomIt first, RandomIt last, Compare comp) {
+  ptrdiff_t size = last - first;
+  RandomIt medians = first;
+  for (ptrdiff_t i = 0; i < size; i += 5) {
+    RandomIt groupFirst = first + i;
+    RandomIt groupLast = first + std::min(i + 5, size);
+    insertionSort(groupFirst, groupLast, comp);
+    std::iter_swap(medians++, groupFirst + (groupLast - groupFirst) / 2);
+  }
+  RandomIt middle = first + (medians - first) / 2;
+  introSelect(first, middle, medians, comp);
+  return *middle;
+}
+
+template <typename RandomIt, typename Compare>
+auto medianOfThree(RandomIt first, RandomIt last, Compare comp) {
+  RandomIt a = first, b = first + (last - first) / 2, c = last - 1;
+  if (comp(*b, *a)) std::swap(a, b);
+  if (comp(*c, *b)) b = comp(*c, *a) ? a : c;
+  return *b;
+}
+
+template <typename RandomIt, typename Compare>
+void introSelect(RandomIt first, RandomIt nth, RandomIt last, Compare comp) {
+  // Median-of-3 quickselect touches about 3n elements on average. Once it
+  // has touched more than 8n the remaining steps use the median of medians,
+  // which always discards at least 30% of the range. Both phases are O(n).
+  ptrdiff_t budget = 8 * (last - first);
+  while (last - first > insertionSortThreshold) {
+    budget -= last - first;
+    auto pivot = budget < 0 ? medianOfMedians(first, last, comp)
+                            : medianOfThree(first, last, comp);
+    RandomIt less = std::partition(
+        first, last, [&](const auto& x) { return comp(x, pivot); });
+    if (nth < less) {
+      last = less;
+      continue;
+    }
+    if (less == first) {
+      // The pivot is the smallest value: split off the run of keys equal to
+      // it, so ranges full of duplicates still shrink every step.
+      RandomIt equal = std::partition(
+          first, last, [&](const auto& x) { return !comp(pivot, x); });
+      if (nth < equal) return;
+      less = equal;
+    }
+    first = less;
+  }
+  if (last - first > 1) insertionSort(first, last, comp);
+}
+
+template <typename RandomIt>
+void introSelect(RandomIt first, RandomIt nth, RandomIt last) {
+  introSelect(first, nth, last, std::less<>());
+}
+
+// 2. multiSelect()
+// ranks must be sorted and relative to first. Afterwards first[r] holds the
+// element of rank r for every requested r.
+template <typename RandomIt, typename Compare>
+void multiSelect(RandomIt first, RandomIt last, const size_t* ranksFirst,
+                 const size_t* ranksLast, Compare comp) {
+  if (ranksFirst == ranksLast) return;
+  if (last - first <= insertionSortThreshold) {
+    insertionSort(first, last, comp);
+    return;
+  }
+  const size_t* middle = ranksFirst + (ranksLast - ranksFirst) / 2;
+  size_t pivotRank = *middle;
+  introSelect(first, first + pivotRank, last, comp);
+
+  multiSelect(first, first + pivotRank, ranksFirst,
+              std::lower_bound(ranksFirst, middle, pivotRank), comp);
+
+  // Ranks above the pivot become relative to the element after it.
+  std::vector<size_t> upper(std::upper_bound(middle, ranksLast, pivotRank),
+                            ranksLast);
+  for (size_t& rank : upper) rank -= pivotRank + 1;
+  multiSelect(first + pivotRank + 1, last, upper.data(),
+              upper.data() + upper.size(), comp);
+}
+
+std::vector<size_t> quantileRanks(size_t size,
+                                  const std::vector<double>& probabilities) {
+  std::vector<size_t> ranks;
+  for (double p : probabilities) {
+    double rank = std::clamp(p, 0.0, 1.0) * static_cast<double>(size - 1);
+    ranks.push_back(static_cast<size_t>(std::llround(rank)));
+  }
+  return ranks;
+}
+
+// Exact quantiles by partially reordering data in place.
+template <typename T>
+std::vector<T> selectQuantiles(std::vector<T>& data,
+                               const std::vector<double>& probabilities) {
+  if (data.empty()) return {};
+  std::vector<size_t> ranks = quantileRanks(data.size(), probabilities);
+  std::vector<size_t> sortedRanks = ranks;
+  std::sort(sortedRanks.begin(), sortedRanks.end());
+  multiSelect(data.begin(), data.end(), sortedRanks.data(),
+              sortedRanks.data() + sortedRanks.size(), std::less<>());
+  std::vector<T> result;
+  for (size_t r : ranks) result.push_back(data[r]);
+  return result;
+}
+
+// 3. parallelQuantiles()
+// Closed value range [low, high] that is expected to contain some ranks.
+template <typename T>
+struct Bracket {
+  T low;
+  T high;
+  std::vector<size_t> ranks;
+};
+
+template <typename T>
+std::vector<Bracket<T>> makeBrackets(const std::vector<T>& data,
+                                     const std::vector<size_t>& sortedRanks,
+                                     std::mt19937_64& gen) {
+  constexpr size_t sampleSize = 1 << 16;
+  std::uniform_int_distribution<size_t> pick(0, data.size() - 1);
+  std::vector<T> sample(sampleSize);
+  for (T& x : sample) x = data[pick(gen)];
+  std::sort(sample.begin(), sample.end());
+
+  // A rank's position in the sample has a standard deviation of about
+  // sqrt(sampleSize) / 2; a margin of four of those misses very rarely.
+  const double margin = 2.0 * std::sqrt(static_cast<double>(sampleSize));
+  std::vector<Bracket<T>> brackets;
+  for (size_t rank : sortedRanks) {
+    double center = static_cast<double>(rank) / data.size() * sampleSize;
+    double lowIndex = center - margin;
+    double highIndex = center + margin;
+    T low = lowIndex < 0 ? std::numeric_limits<T>::lowest()
+                         : sample[static_cast<size_t>(lowIndex)];
+    T high = highIndex >= sampleSize ? std::numeric_limits<T>::max()
+                                     : sample[static_cast<size_t>(highIndex)];
+    if (!brackets.empty() && low <= brackets.back().high) {
+      brackets.back().high = std::max(brackets.back().high, high);
+      brackets.back().ranks.push_back(rank);
+    } else {
+      brackets.push_back({low, high, {rank}});
+    }
+  }
+  return brackets;
+}
+
+template <typename T>
+std::vector<T> parallelQuantiles(size_t numThreads, const std::vector<T>& data,
+                                 const std::vector<double>& probabilities) {
+  static_assert(std::is_arithmetic_v<T>, "Brackets need numeric limits");
+  if (data.empty()) return {};
+  std::vector<size_t> ranks = quantileRanks(data.size(), probabilities);
+  std::vector<size_t> sortedRanks = ranks;
+  std::sort(sortedRanks.begin(), sortedRanks.end());
+  sortedRanks.erase(std::unique(sortedRanks.begin(), sortedRanks.end()),
+                    sortedRanks.end());
+
+  std::mt19937_64 gen(data.size());
+  std::vector<Bracket<T>> brackets = makeBrackets(data, sortedRanks, gen);
+  size_t numBrackets = brackets.size();
+  std::vector<T> lows;
+  for (const auto& bracket : brackets) lows.push_back(bracket.low);
+
+  // Per thread: elements strictly below each bracket (gap counts) and the
+  // elements inside each bracket.
+  struct Partial {
+    std::vector<size_t> gapCounts;
+    std::vector<std::vector<T>> inside;
+  };
+  numThreads = std::clamp<size_t>(numThreads, 1, data.size() / 4096 + 1);
+  std::vector<Partial> partials(numThreads);
+  auto classify = [&](size_t t) {
+    Partial& partial = partials[t];
+    partial.gapCounts.assign(numBrackets + 1, 0);
+    partial.inside.resize(numBrackets);
+    size_t begin = data.size() * t / numThreads;
+    size_t end = data.size() * (t + 1) / numThreads;
+    for (size_t i = begin; i < end; ++i) {
+      const T& x = data[i];
+      size_t b = std::upper_bound(lows.begin(), lows.end(), x) - lows.begin();
+      if (b > 0 && !(brackets[b - 1].high < x)) {
+        partial.inside[b - 1].push_back(x);
+      } else {
+        ++partial.gapCounts[b];
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < numThreads; ++t) threads.emplace_back(classify, t);
+  classify(0);
+  for (auto& thread : threads) thread.join();
+
+  std::vector<std::pair<size_t, T>> found;  // (rank, value)
+  size_t below = 0;
+  for (size_t b = 0; b < numBrackets; ++b) {
+    for (const auto& partial : partials) below += partial.gapCounts[b];
+    std::vector<T> inside;
+    for (auto& partial : partials) {
+      inside.insert(inside.end(), partial.inside[b].begin(),
+                    partial.inside[b].end());
+    }
+    const auto& bracketRanks = brackets[b].ranks;
+    if (bracketRanks.front() < below ||
+        bracketRanks.back() >= below + inside.size()) {
+      // The sample was unlucky: answer exactly on a private copy.
+      std::vector<T> copy = data;
+      return selectQuantiles(copy, probabilities);
+    }
+    std::vector<size_t> local;
+    for (size_t rank : bracketRanks) local.push_back(rank - below);
+    multiSelect(inside.begin(), inside.end(), local.data(),
+                local.data() + local.size(), std::less<>());
+    for (size_t rank : bracketRanks) {
+      found.emplace_back(rank, inside[rank - below]);
+    }
+    below += inside.size();
+  }
+
+  std::vector<T> result;
+  for (size_t rank : ranks) {
+    auto it = std::lower_bound(
+        found.begin(), found.end(), rank,
+        [](const auto& entry, size_t r) { return entry.first < r; });
+    result.push_back(it->second);
+  }
+  return result;
+}
+
+// 4. QuantileSketch
+// A relative-error sketch (DDSketch): values are counted by magnitude in
+// logarithmic buckets [gamma^(i-1), gamma^i) with gamma = (1 + a) / (1 - a),
+// so every quantile is returned within a relative error a of the true value,
+// at p50 as well as p999. Positive and negative values have one bucket array
+// each, the negative one mirroring the positive one, and zeros are counted
+// apart. Insertion is O(1) and the memory only depends on the ratio between
+// the largest and smallest magnitude, not on the count.
+template <typename T>
+class QuantileSketch {
+ public:
+  explicit QuantileSketch(double relativeAccuracy = 0.01)
+      : mGamma((1 + relativeAccuracy) / (1 - relativeAccuracy)),
+        mLogGamma(std::log(mGamma)) {}
+
+  void insert(T value) {
+    ++mCount;
+    if (value > 0) {
+      mPositive.add(bucketIndex(static_cast<double>(value)), 1);
+    } else if (value == 0) {
+      ++mZeroCount;
+    } else {
+      mNegative.add(bucketIndex(-static_cast<double>(value)), 1);
+    }
+  }
+
+  // Adds everything another sketch with the same accuracy has seen (e.g. one
+  // sketch per thread).
+  void merge(const QuantileSketch& other) {
+    mPositive.merge(other.mPositive);
+    mNegative.merge(other.mNegative);
+    mZeroCount += other.mZeroCount;
+    mCount += other.mCount;
+  }
+
+  size_t count() const { return mCount; }
+  size_t bucketCount() const {
+    return mPositive.buckets.size() + mNegative.buckets.size();
+  }
+
+  T quantile(double p) const {
+    if (mCount == 0) return T{};
+    double rank = std::clamp(p, 0.0, 1.0) * static_cast<double>(mCount - 1);
+    uint64_t cumulative = 0;
+    // Negative values in ascending order: the largest magnitudes first.
+    for (size_t slot = mNegative.buckets.size(); slot-- > 0;) {
+      cumulative += mNegative.buckets[slot];
+      if (static_cast<double>(cumulative) > rank)
+        return toValue(-bucketValue(mNegative.offset, slot));
+    }
+    cumulative += mZeroCount;
+    if (static_cast<double>(cumulative) > rank) return T{};
+    for (size_t slot = 0; slot < mPositive.buckets.size(); ++slot) {
+      cumulative += mPositive.buckets[slot];
+      if (static_cast<double>(cumulative) > rank)
+        return toValue(bucketValue(mPositive.offset, slot));
+    }
+    // Not reached: the counts add up to mCount, which exceeds any rank.
+    return T{};
+  }
+
+ private:
+  // Bucket counts for the values of one sign, indexed by bucket index minus
+  // offset.
+  struct Store {
+    std::vector<uint64_t> buckets;
+    int offset = 0;
+
+    void add(int index, uint64_t n) {
+      if (buckets.empty()) {
+        offset = index;
+      } else if (index < offset) {
+        buckets.insert(buckets.begin(), offset - index, 0);
+        offset = index;
+      }
+      size_t slot = static_cast<size_t>(index - offset);
+      if (slot >= buckets.size()) buckets.resize(slot + 1, 0);
+      buckets[slot] += n;
+    }
+
+    void merge(const Store& other) {
+      for (size_t slot = 0; slot < other.buckets.size(); ++slot) {
+        if (other.buckets[slot] != 0)
+          add(other.offset + static_cast<int>(slot), other.buckets[slot]);
+      }
+    }
+  };
+
+  int bucketIndex(double magnitude) const {
+    return static_cast<int>(std::ceil(std::log(magnitude) / mLogGamma));
+  }
+
+  // The point of the bucket with the same relative distance to both of its
+  // ends.
+  double bucketValue(int offset, size_t slot) const {
+    double upper = std::pow(mGamma, offset + static_cast<int>(slot));
+    return 2 * upper / (mGamma + 1);
+  }
+
+  // Integer sketches round to the nearest value; floating point ones keep
+  // the fraction.
+  static T toValue(double x) {
+    if constexpr (std::is_integral_v<T>) return static_cast<T>(std::lround(x));
+    return static_cast<T>(x);
+  }
+
+  double mGamma;
+  double mLogGamma;
+  Store mPositive;
+  Store mNegative;
+  uint64_t mZeroCount{0};
+  size_t mCount{0};
+};
+
+// 5. Examples and benchmark
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void sortingAndOrderingAlgorithms() {
+  std::cout << "5.1. Using introSelect() to place the 5th element in the "
+               "correct order"
+            << std::endl;
+  std::vector<int> vec{5, 3, 8, 1, 2, 7, 4, 6};
+  printVector("Initial vector", vec);
+  introSelect(vec.begin(), vec.begin() + 5, vec.end());
+  printVector("Modified vector", vec);
+
+  std::cout << std::endl
+            << "5.2. Using selectQuantiles() for the minimum, median and "
+               "maximum in one call"
+            << std::endl;
+  std::vector<int> vec2{5, 3, 8, 1, 2, 7, 4, 6, 9};
+  printVector("Initial vector", vec2);
+  printVector("Quantiles {0, 0.5, 1}", selectQuantiles(vec2, {0, 0.5, 1}));
+}
+
+// A killer input for median-of-3 quickselect: every pivot is close to the
+// smallest remaining value unless the guarantee kicks in.
+std::vector<int> makeOrganPipe(size_t size) {
+  std::vector<int> vec(size);
+  for (size_t i = 0; i < size; ++i) {
+    vec[i] = static_cast<int>(i < size / 2 ? 2 * i : 2 * (size - i) - 1);
+  }
+  return vec;
+}
+
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 10'000'000;
+  const std::vector<double> percentiles{0.5, 0.99, 0.999};
+  std::mt19937_64 gen(42);
+  std::lognormal_distribution<double> latency(5.0, 1.0);
+  std::vector<int> latencies(size);
+  for (int& x : latencies) x = static_cast<int>(latency(gen));
+  size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "Elements: " << size << ", threads: " << numThreads
+            << std::endl;
+
+  auto print = [](const std::string& name, double ms,
+                  const std::vector<int>& values) {
+    std::cout << name << ms << " ms, p50/p99/p999 = " << values[0] << "/"
+              << values[1] << "/" << values[2] << std::endl;
+  };
+
+  std::vector<int> expected;
+  double nthTime = measureMilliseconds([&] {
+    std::vector<int> copy = latencies;
+    for (size_t r : quantileRanks(size, percentiles)) {
+      std::nth_element(copy.begin(), copy.begin() + r, copy.end());
+      expected.push_back(copy[r]);
+    }
+  });
+  print("nth_element per percentile: ", nthTime, expected);
+
+  std::vector<int> exact;
+  double multiTime = measureMilliseconds([&] {
+    std::vector<int> copy = latencies;
+    exact = selectQuantiles(copy, percentiles);
+  });
+  print("selectQuantiles():          ", multiTime, exact);
+
+  std::vector<int> parallel;
+  double parallelTime = measureMilliseconds([&] {
+    parallel = parallelQuantiles(numThreads, latencies, percentiles);
+  });
+  print("parallelQuantiles():        ", parallelTime, parallel);
+
+  QuantileSketch<int> sketch;
+  std::vector<int> approximate;
+  double sketchTime = measureMilliseconds([&] {
+    for (int x : latencies) sketch.insert(x);
+    for (double p : percentiles) approximate.push_back(sketch.quantile(p));
+  });
+  print("QuantileSketch (approx):    ", sketchTime, approximate);
+  std::cout << "Sketch uses " << sketch.bucketCount() << " buckets for "
+            << sketch.count() << " values (1% relative error)" << std::endl;
+  std::cout << "Exact results agree: " << std::boolalpha
+            << (exact == expected && parallel == expected) << std::endl;
+
+  QuantileSketch<double> fractions;
+  for (int i = 1; i <= 1000; ++i) fractions.insert(i / 1000.0);
+  std::cout << "QuantileSketch<double> of 0.001 .. 1: p37 "
+            << fractions.quantile(0.37) << ", p99 " << fractions.quantile(0.99)
+            << std::endl;
+
+  QuantileSketch<int> temperatures;
+  for (int t = -40; t <= 40; ++t) temperatures.insert(t);
+  std::cout << "QuantileSketch<int> of -40 .. 40: p10 "
+            << temperatures.quantile(0.1) << ", p50 "
+            << temperatures.quantile(0.5) << ", p90 "
+            << temperatures.quantile(0.9) << std::endl;
+
+  std::vector<int> organPipe = makeOrganPipe(size);
+  std::vector<int> copy = organPipe;
+  double stdAdversarial = measureMilliseconds([&] {
+    std::nth_element(copy.begin(), copy.begin() + size / 2, copy.end());
+  });
+  copy = organPipe;
+  double introAdversarial = measureMilliseconds(
+      [&] { introSelect(copy.begin(), copy.begin() + size / 2, copy.end()); });
+  std::cout << "Organ-pipe median: nth_element " << stdAdversarial
+            << " ms, introSelect " << introAdversarial << " ms" << std::endl;
+}
+
+int main() {
+  // Selection
+  std::cout << "*** Selection ***" << std::endl;
+  sortingAndOrderingAlgorithms();
+
+  // Benchmark
+  std::cout << std::endl
+            << "*** Benchmark against nth_element per percentile ***"
+            << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,289 @@
+/* This file shows PersistentMap from persistent_map.h, an immutable hash
+ * map whose copies are O(1) snapshots, and measures it against copying a
+ * std::map or std::unordered_map to take a consistent snapshot.
+ *
+ * 1. Versions: set() and erase() return new maps and leave the old ones
+ *    intact
+ * 2. Transient: a batch of edits applied in place, then frozen
+ * 3. Publishing: a writer swaps new versions into a
+ *    std::atomic<std::shared_ptr> while readers use consistent snapshots
+ * 4. Benchmark: snapshots, small updates published as new versions,
+ *    building, and lookups
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread persistent_map.cpp
+ */
+
+#include "fast_output.h"
+#include "persistent_map.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Prints the elements in key order; a PersistentMap iterates in hash order.
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  std::map<typename Map::key_type, typename Map::mapped_type> sorted(
+      mp.begin(), mp.end());
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!sorted.empty()) out.writeMap(sorted);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Versions
+void versions() {
+  PersistentMap<int, std::string> v1{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  std::cout << "1.1. set() {4, four} and {1, I} on the first version, then "
+               "erase() key 2 on the second"
+            << std::endl;
+  auto v2 = v1.set(4, "four").set(1, "I");
+  auto v3 = v2.erase(2);
+  printMap("Version 1", v1);
+  printMap("Version 2", v2);
+  printMap("Version 3", v3);
+
+  std::cout << std::endl
+            << "1.2. update() appends ! to the value of key 3" << std::endl;
+  auto v4 = v3.update(3, [](const std::string& value) { return value + "!"; });
+  printMap("Version 3", v3);
+  printMap("Version 4", v4);
+  std::cout << "at(3) in version 4: " << v4.at(3)
+            << ", contains(2) in version 1: " << std::boolalpha
+            << v1.contains(2) << std::endl;
+}
+
+// 2. Transient
+void transientEdits() {
+  PersistentMap<std::string, int> stock{{"apple", 3}, {"pear", 1}};
+  std::cout << "2.1. One transient batch: restock apple and pear, add plum, "
+               "remove pear"
+            << std::endl;
+  auto batch = stock.transient();
+  batch.set("apple", 10);
+  batch.set("pear", 10);
+  batch.insert("plum", 5);
+  batch.erase("pear");
+  auto restocked = batch.persistent();
+  printMap("Before", stock);
+  printMap("After", restocked);
+}
+
+// 3. Publishing
+void publishing() {
+  using Config = PersistentMap<int, int>;
+  constexpr int numKeys = 1000;
+  constexpr int numVersions = 200;
+
+  std::cout << "3.1. A writer publishes " << numVersions
+            << " versions where every key maps to the version number; "
+               "readers check that each snapshot is whole"
+            << std::endl;
+  Config::Transient initial = Config().transient();
+  for (int key = 0; key < numKeys; ++key) initial.set(key, 0);
+  std::atomic<std::shared_ptr<const Config>> current(
+      std::make_shared<const Config>(initial.persistent()));
+
+  std::atomic<bool> done{false};
+  std::atomic<int> mixed{0};
+  std::atomic<int> snapshots{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; ++r) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        std::shared_ptr<const Config> snapshot = current.load();
+        int version = snapshot->at(0);
+        for (const auto& [key, value] : *snapshot)
+          if (value != version) ++mixed;
+        ++snapshots;
+      }
+    });
+  }
+  for (int version = 1; version <= numVersions; ++version) {
+    auto next = current.load()->transient();
+    for (int key = 0; key < numKeys; ++key) next.set(key, version);
+    current.store(std::make_shared<const Config>(next.persistent()));
+  }
+  done = true;
+  for (auto& reader : readers) reader.join();
+  std::cout << "Final version: " << current.load()->at(0)
+            << ", snapshots read: " << (snapshots > 0 ? "some" : "none")
+            << ", mixed snapshots: " << mixed << std::endl;
+}
+
+// Maps every key to one of 7 hashes, so that keys share collision nodes.
+struct PoorHash {
+  size_t operator()(int key) const { return static_cast<size_t>(key % 7); }
+};
+
+// Applies random operations to a PersistentMap, a transient and a
+// std::map, keeping old versions and checking that they never change.
+template <typename Hash>
+bool checkAgainstStd(uint32_t seed) {
+  std::mt19937 gen(seed);
+  bool ok = true;
+  auto same = [](const auto& map, const std::map<int, int>& expected) {
+    std::map<int, int> elements(map.begin(), map.end());
+    return map.size() == expected.size() && elements == expected;
+  };
+  for (int keyRange : {32, 3000, 1 << 30}) {
+    PersistentMap<int, int, Hash> map;
+    std::map<int, int> reference;
+    std::vector<std::pair<PersistentMap<int, int, Hash>, std::map<int, int>>>
+        old;
+    auto transient = map.transient();
+    for (int step = 0; step < 20000; ++step) {
+      int key = static_cast<int>(gen() % keyRange);
+      int value = static_cast<int>(gen() % 1000);
+      if (gen() % 3 == 0) {
+        map = map.erase(key);
+        ok = ok && transient.erase(key) == (reference.erase(key) == 1);
+      } else {
+        map = map.set(key, value);
+        transient.set(key, value);
+        reference[key] = value;
+      }
+      if (step % 2000 == 0) old.emplace_back(map, reference);
+      const int* found = map.find(key);
+      auto it = reference.find(key);
+      ok = ok && (found != nullptr) == (it != reference.end()) &&
+           (!found || *found == it->second);
+    }
+    ok = ok && same(map, reference) && same(transient.persistent(), reference);
+    for (const auto& [version, expected] : old)
+      ok = ok && same(version, expected);
+  }
+  return ok;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  constexpr size_t pushes = 100;
+  constexpr size_t keysPerPush = 10;
+  constexpr size_t lookups = 1 << 20;
+  std::mt19937 gen(42);
+  std::vector<int> keys(size);
+  for (int& key : keys) key = static_cast<int>(gen());
+  // volatile keeps the compiler from dropping the unused results.
+  volatile long long sink = 0;
+
+  std::map<int, int> tree;
+  std::unordered_map<int, int> hash;
+  PersistentMap<int, int> persistent;
+  double treeBuild = measureMilliseconds([&] {
+    for (int key : keys) tree[key] = key;
+  });
+  double hashBuild = measureMilliseconds([&] {
+    for (int key : keys) hash[key] = key;
+  });
+  double persistentBuild = measureMilliseconds([&] {
+    for (int key : keys) persistent = persistent.set(key, key);
+  });
+  double transientBuild = measureMilliseconds([&] {
+    auto transient = PersistentMap<int, int>().transient();
+    for (int key : keys) transient.set(key, key);
+    sink = static_cast<long long>(transient.persistent().size());
+  });
+
+  // A config push: change keysPerPush values and publish a whole new
+  // version while the previous one stays readable.
+  double treePush = measureMilliseconds([&] {
+    for (size_t p = 0; p < pushes; ++p) {
+      std::map<int, int> next = tree;
+      for (size_t k = 0; k < keysPerPush; ++k) next[keys[gen() % size]] = 0;
+      sink = static_cast<long long>(next.size());
+    }
+  });
+  double hashPush = measureMilliseconds([&] {
+    for (size_t p = 0; p < pushes; ++p) {
+      std::unordered_map<int, int> next = hash;
+      for (size_t k = 0; k < keysPerPush; ++k) next[keys[gen() % size]] = 0;
+      sink = static_cast<long long>(next.size());
+    }
+  });
+  double persistentPush = measureMilliseconds([&] {
+    for (size_t p = 0; p < pushes; ++p) {
+      PersistentMap<int, int> next = persistent;
+      for (size_t k = 0; k < keysPerPush; ++k)
+        next = next.set(keys[gen() % size], 0);
+      sink = static_cast<long long>(next.size());
+    }
+  });
+
+  std::vector<int> queries(lookups);
+  for (int& query : queries) query = keys[gen() % size];
+  auto lookupAll = [&](const auto& find) {
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (int query : queries) sum += find(query);
+      sink = sum;
+    });
+  };
+  double treeFind = lookupAll([&](int key) { return tree.find(key)->second; });
+  double hashFind = lookupAll([&](int key) { return hash.find(key)->second; });
+  double persistentFind =
+      lookupAll([&](int key) { return *persistent.find(key); });
+
+  std::cout << size << " int keys" << std::endl;
+  std::cout << "Building: std::map " << treeBuild
+            << " ms, std::unordered_map " << hashBuild
+            << " ms, PersistentMap set() " << persistentBuild
+            << " ms, transient " << transientBuild << " ms" << std::endl;
+  std::cout << "One push of " << keysPerPush
+            << " updates as a new version: copying std::map "
+            << treePush / pushes << " ms, copying std::unordered_map "
+            << hashPush / pushes << " ms, PersistentMap "
+            << persistentPush / pushes * 1000 << " us ("
+            << treePush / persistentPush << "x faster than std::map)"
+            << std::endl;
+  std::cout << lookups << " lookups: std::map " << treeFind
+            << " ms, std::unordered_map " << hashFind << " ms, PersistentMap "
+            << persistentFind << " ms" << std::endl;
+}
+
+int main() {
+  // Versions
+  std::cout << "*** Versions ***" << std::endl;
+  versions();
+
+  // Transient
+  std::cout << std::endl << "*** Transient ***" << std::endl;
+  transientEdits();
+
+  // Publishing
+  std::cout << std::endl << "*** Publishing ***" << std::endl;
+  publishing();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::map and old versions are intact: "
+            << std::boolalpha
+            << (checkAgainstStd<std::hash<int>>(1) &&
+                checkAgainstStd<PoorHash>(2))
+            << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
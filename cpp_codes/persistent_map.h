@@ -0,0 +1,521 @@
+/* This header implements PersistentMap<Key, T, Hash, KeyEqual>, an
+ * immutable hash map whose versions share structure. The maps of
+ * container_map.cpp are changed in place, so a reader that needs a
+ * consistent view has to copy the whole std::map; a PersistentMap is never
+ * changed, so a copy is a snapshot and costs one reference count.
+ *
+ * 1. Layout: a hash array mapped trie. Each node covers 5 bits of the
+ *    64-bit hash and holds up to 32 slots, as two bitmaps and two dense
+ *    arrays: the elements stored in the node and the child nodes (the
+ *    CHAMP layout). Keys whose hashes are equal in all 64 bits share a
+ *    collision node that is searched linearly.
+ * 2. Updates: set() and erase() return a new map and leave the old one as
+ *    it was. Only the nodes on the path to the key are copied, at most 13
+ *    of them; every other node is shared between the versions. erase()
+ *    moves an element that is left alone in a node back up into the
+ *    parent, so the trie stays as shallow as its contents allow.
+ * 3. Sharing: nodes are reference counted with atomic counters, so
+ *    versions can be handed between threads and dropped by any of them.
+ *    Publishing a new version to readers is one atomic pointer swap, e.g.
+ *    of a std::atomic<std::shared_ptr<const PersistentMap>>.
+ * 4. Transient: a batch of updates copies each path once instead of once
+ *    per update. transient() returns an editable map that owns the nodes
+ *    it has copied and changes them in place; persistent() freezes them
+ *    into a new PersistentMap.
+ *
+ * Iteration visits the elements in hash order, as with
+ * std::unordered_map. Hash and KeyEqual are default constructed where they
+ * are needed, so they must be stateless.
+ */
+
+#ifndef PERSISTENT_MAP_H
+#define PERSISTENT_MAP_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class PersistentMap {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  // Elements are never changed through the map, so the key need not be
+  // const in the pair.
+  using value_type = std::pair<Key, T>;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+ private:
+  static constexpr int bitsPerLevel = 5;
+  static constexpr int hashBits = 64;
+  // Levels 0..12 use the hash; below them is the collision level.
+  static constexpr int maxDepth =
+      (hashBits + bitsPerLevel - 1) / bitsPerLevel + 1;
+
+  struct Node {
+    explicit Node(uint64_t editId) : edit(editId) {}
+
+    std::atomic<uint32_t> refs{1};
+    uint32_t dataMap = 0;
+    uint32_t nodeMap = 0;
+    // The transient that may change this node in place; 0 for none.
+    uint64_t edit;
+    std::vector<value_type> entries;
+    std::vector<Node*> children;
+  };
+
+ public:
+  class Transient;
+
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PersistentMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+      return mStack[mDepth].node->entries[mStack[mDepth].entry];
+    }
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++() {
+      ++mStack[mDepth].entry;
+      settle();
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      if (mDepth < 0 || other.mDepth < 0) return mDepth == other.mDepth;
+      return mDepth == other.mDepth &&
+             mStack[mDepth].node == other.mStack[mDepth].node &&
+             mStack[mDepth].entry == other.mStack[mDepth].entry;
+    }
+
+   private:
+    friend class PersistentMap;
+
+    struct Frame {
+      const Node* node;
+      uint32_t entry;
+      uint32_t child;
+    };
+
+    explicit const_iterator(const Node* root) {
+      if (!root) return;
+      mDepth = 0;
+      mStack[0] = {root, 0, 0};
+      settle();
+    }
+
+    // Moves to the next element at or after the current position: the
+    // elements of a node come first, then its children, depth first.
+    void settle() {
+      while (mDepth >= 0) {
+        Frame& frame = mStack[mDepth];
+        if (frame.entry < frame.node->entries.size()) return;
+        if (frame.child < frame.node->children.size()) {
+          const Node* child = frame.node->children[frame.child++];
+          mStack[++mDepth] = {child, 0, 0};
+        } else {
+          --mDepth;
+        }
+      }
+    }
+
+    Frame mStack[maxDepth]{};
+    int mDepth = -1;
+  };
+
+  using iterator = const_iterator;
+
+  // 1. Construction. Copies are snapshots: O(1), sharing every node.
+  PersistentMap() = default;
+
+  PersistentMap(std::initializer_list<value_type> init) {
+    Transient transient = this->transient();
+    for (const auto& [key, value] : init) transient.insert(key, value);
+    *this = transient.persistent();
+  }
+
+  PersistentMap(const PersistentMap& other)
+      : mRoot(other.mRoot), mSize(other.mSize) {
+    retain(mRoot);
+  }
+
+  PersistentMap(PersistentMap&& other) noexcept
+      : mRoot(std::exchange(other.mRoot, nullptr)),
+        mSize(std::exchange(other.mSize, 0)) {}
+
+  PersistentMap& operator=(PersistentMap other) noexcept {
+    std::swap(mRoot, other.mRoot);
+    std::swap(mSize, other.mSize);
+    return *this;
+  }
+
+  ~PersistentMap() { release(mRoot); }
+
+  // 2. Lookup
+  bool empty() const noexcept { return mSize == 0; }
+  size_t size() const noexcept { return mSize; }
+
+  const T* find(const Key& key) const {
+    const value_type* entry = findEntry(mRoot, hashOf(key), key);
+    return entry ? &entry->second : nullptr;
+  }
+
+  bool contains(const Key& key) const { return find(key) != nullptr; }
+  size_t count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+  const T& at(const Key& key) const {
+    const T* value = find(key);
+    if (!value) throw std::out_of_range("PersistentMap::at");
+    return *value;
+  }
+
+  const_iterator begin() const { return const_iterator(mRoot); }
+  const_iterator end() const { return const_iterator(); }
+
+  // 3. Updates: each returns a new version and leaves this one unchanged.
+  [[nodiscard]] PersistentMap set(const Key& key, T value) const {
+    bool added = false;
+    Node* root = assoc(mRoot, 0, hashOf(key), key, std::move(value), 0,
+                       added);
+    return PersistentMap(root, mSize + added);
+  }
+
+  // Adds key unless it is present; returns this version if it is.
+  [[nodiscard]] PersistentMap insert(const Key& key, T value) const {
+    if (contains(key)) return *this;
+    return set(key, std::move(value));
+  }
+
+  // Calls f(const T&) on the value of key and stores the T it returns.
+  template <typename Function>
+  [[nodiscard]] PersistentMap update(const Key& key, Function&& f) const {
+    const T* current = find(key);
+    if (!current) return *this;
+    return set(key, f(*current));
+  }
+
+  [[nodiscard]] PersistentMap erase(const Key& key) const {
+    bool removed = false;
+    Node* root = dissoc(mRoot, 0, hashOf(key), key, 0, removed);
+    if (!removed) return *this;
+    return PersistentMap(root, mSize - 1);
+  }
+
+  // 4. Batch updates
+  Transient transient() const { return Transient(*this); }
+
+  // Edits a map in place through the nodes it copied; nodes that still
+  // belong to other versions are copied on first touch, once.
+  class Transient {
+   public:
+    explicit Transient(const PersistentMap& map)
+        : mRoot(map.mRoot), mSize(map.mSize), mEdit(newEditId()) {
+      retain(mRoot);
+    }
+
+    Transient(const Transient&) = delete;
+    Transient& operator=(const Transient&) = delete;
+
+    ~Transient() { release(mRoot); }
+
+    size_t size() const noexcept { return mSize; }
+
+    const T* find(const Key& key) const {
+      const value_type* entry = findEntry(mRoot, hashOf(key), key);
+      return entry ? &entry->second : nullptr;
+    }
+
+    void set(const Key& key, T value) {
+      bool added = false;
+      replaceRoot(
+          assoc(mRoot, 0, hashOf(key), key, std::move(value), mEdit, added));
+      mSize += added;
+    }
+
+    bool insert(const Key& key, T value) {
+      if (find(key)) return false;
+      set(key, std::move(value));
+      return true;
+    }
+
+    bool erase(const Key& key) {
+      bool removed = false;
+      Node* root = dissoc(mRoot, 0, hashOf(key), key, mEdit, removed);
+      if (!removed) return false;
+      replaceRoot(root);
+      --mSize;
+      return true;
+    }
+
+    // Returns the edits as a PersistentMap. The transient stays usable;
+    // later edits copy the nodes they share with the returned map.
+    PersistentMap persistent() {
+      mEdit = newEditId();
+      retain(mRoot);
+      return PersistentMap(mRoot, mSize);
+    }
+
+   private:
+    void replaceRoot(Node* root) {
+      if (root == mRoot) return;
+      release(mRoot);
+      mRoot = root;
+    }
+
+    Node* mRoot;
+    size_t mSize;
+    uint64_t mEdit;
+  };
+
+ private:
+  PersistentMap(Node* root, size_t size) : mRoot(root), mSize(size) {}
+
+  static uint64_t newEditId() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void retain(Node* node) {
+    if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static void release(Node* node) {
+    if (!node || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    for (Node* child : node->children) release(child);
+    delete node;
+  }
+
+  // std::hash is the identity for integers in libstdc++; the bits are mixed
+  // so that every level of the trie depends on the whole key.
+  static uint64_t hashOf(const Key& key) {
+    uint64_t h = static_cast<uint64_t>(Hash()(key));
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static bool isCollisionLevel(int shift) { return shift >= hashBits; }
+
+  static uint32_t bitFor(uint64_t hash, int shift) {
+    return 1u << ((hash >> shift) & 31);
+  }
+
+  static size_t indexOf(uint32_t map, uint32_t bit) {
+    return static_cast<size_t>(std::popcount(map & (bit - 1)));
+  }
+
+  static const value_type* findEntry(const Node* node, uint64_t hash,
+                                     const Key& key) {
+    for (int shift = 0; node; shift += bitsPerLevel) {
+      if (isCollisionLevel(shift)) {
+        for (const value_type& entry : node->entries)
+          if (KeyEqual()(entry.first, key)) return &entry;
+        return nullptr;
+      }
+      uint32_t bit = bitFor(hash, shift);
+      if (node->dataMap & bit) {
+        const value_type& entry = node->entries[indexOf(node->dataMap, bit)];
+        return KeyEqual()(entry.first, key) ? &entry : nullptr;
+      }
+      if (!(node->nodeMap & bit)) return nullptr;
+      node = node->children[indexOf(node->nodeMap, bit)];
+    }
+    return nullptr;
+  }
+
+  // The node itself if the transient edit owns it, otherwise a copy that
+  // edit owns. The copy holds its own references to the children.
+  static Node* editable(Node* node, uint64_t edit) {
+    if (edit != 0 && node->edit == edit) return node;
+    Node* copy = new Node(edit);
+    copy->dataMap = node->dataMap;
+    copy->nodeMap = node->nodeMap;
+    copy->entries = node->entries;
+    copy->children = node->children;
+    for (Node* child : copy->children) retain(child);
+    return copy;
+  }
+
+  // A node holding two elements whose hashes agree below shift.
+  static Node* makePair(int shift, uint64_t edit, value_type a, uint64_t hashA,
+                        value_type b, uint64_t hashB) {
+    Node* node = new Node(edit);
+    if (isCollisionLevel(shift)) {
+      node->entries.push_back(std::move(a));
+      node->entries.push_back(std::move(b));
+      return node;
+    }
+    uint32_t bitA = bitFor(hashA, shift);
+    uint32_t bitB = bitFor(hashB, shift);
+    if (bitA == bitB) {
+      node->nodeMap = bitA;
+      node->children.push_back(makePair(shift + bitsPerLevel, edit,
+                                        std::move(a), hashA, std::move(b),
+                                        hashB));
+    } else {
+      node->dataMap = bitA | bitB;
+      if (bitA > bitB) std::swap(a, b);
+      node->entries.push_back(std::move(a));
+      node->entries.push_back(std::move(b));
+    }
+    return node;
+  }
+
+  // Returns the node that replaces node after setting key: node itself if
+  // it was changed in place, otherwise a new reference the caller owns.
+  static Node* assoc(Node* node, int shift, uint64_t hash, const Key& key,
+                     T&& value, uint64_t edit, bool& added) {
+    if (!node) {
+      Node* leaf = new Node(edit);
+      leaf->dataMap = bitFor(hash, shift);
+      leaf->entries.emplace_back(key, std::move(value));
+      added = true;
+      return leaf;
+    }
+    if (isCollisionLevel(shift)) {
+      for (size_t i = 0; i < node->entries.size(); ++i) {
+        if (KeyEqual()(node->entries[i].first, key)) {
+          Node* result = editable(node, edit);
+          result->entries[i].second = std::move(value);
+          return result;
+        }
+      }
+      Node* result = editable(node, edit);
+      result->entries.emplace_back(key, std::move(value));
+      added = true;
+      return result;
+    }
+    uint32_t bit = bitFor(hash, shift);
+    if (node->dataMap & bit) {
+      size_t index = indexOf(node->dataMap, bit);
+      const value_type& existing = node->entries[index];
+      if (KeyEqual()(existing.first, key)) {
+        Node* result = editable(node, edit);
+        result->entries[index].second = std::move(value);
+        return result;
+      }
+      // Two keys in one slot: both move down into a new child.
+      Node* child = makePair(shift + bitsPerLevel, edit, existing,
+                             hashOf(existing.first),
+                             value_type(key, std::move(value)), hash);
+      Node* result = editable(node, edit);
+      result->entries.erase(result->entries.begin() + index);
+      result->dataMap ^= bit;
+      result->nodeMap |= bit;
+      result->children.insert(
+          result->children.begin() + indexOf(result->nodeMap, bit), child);
+      added = true;
+      return result;
+    }
+    if (node->nodeMap & bit) {
+      size_t index = indexOf(node->nodeMap, bit);
+      Node* child = node->children[index];
+      Node* newChild = assoc(child, shift + bitsPerLevel, hash, key,
+                             std::move(value), edit, added);
+      if (newChild == child) return node;
+      Node* result = editable(node, edit);
+      result->children[index] = newChild;
+      release(child);
+      return result;
+    }
+    Node* result = editable(node, edit);
+    result->dataMap |= bit;
+    result->entries.emplace(
+        result->entries.begin() + indexOf(result->dataMap, bit), key,
+        std::move(value));
+    added = true;
+    return result;
+  }
+
+  static bool isSingleton(const Node* node) {
+    return node->entries.size() == 1 && node->children.empty();
+  }
+
+  // Returns the node that replaces node after erasing key: node itself if
+  // nothing changed or it was changed in place, nullptr if it became empty,
+  // otherwise a new reference the caller owns. Either way the caller still
+  // owns its reference to node.
+  static Node* dissoc(Node* node, int shift, uint64_t hash, const Key& key,
+                      uint64_t edit, bool& removed) {
+    if (!node) return nullptr;
+    if (isCollisionLevel(shift)) {
+      for (size_t i = 0; i < node->entries.size(); ++i) {
+        if (KeyEqual()(node->entries[i].first, key)) {
+          removed = true;
+          Node* result = editable(node, edit);
+          result->entries.erase(result->entries.begin() + i);
+          return result;
+        }
+      }
+      return node;
+    }
+    uint32_t bit = bitFor(hash, shift);
+    if (node->dataMap & bit) {
+      size_t index = indexOf(node->dataMap, bit);
+      if (!KeyEqual()(node->entries[index].first, key)) return node;
+      removed = true;
+      // Only the root can be left empty; lower nodes hold two or more.
+      if (isSingleton(node)) return nullptr;
+      Node* result = editable(node, edit);
+      result->entries.erase(result->entries.begin() + index);
+      result->dataMap ^= bit;
+      return result;
+    }
+    if (!(node->nodeMap & bit)) return node;
+    size_t index = indexOf(node->nodeMap, bit);
+    Node* child = node->children[index];
+    Node* newChild = dissoc(child, shift + bitsPerLevel, hash, key, edit,
+                            removed);
+    if (!removed) return node;
+    if (newChild && !isSingleton(newChild)) {
+      if (newChild == child) return node;
+      Node* result = editable(node, edit);
+      result->children[index] = newChild;
+      release(child);
+      return result;
+    }
+    // The child is left with one element: it moves up into this node.
+    Node* result = editable(node, edit);
+    result->children.erase(result->children.begin() + index);
+    result->nodeMap ^= bit;
+    if (newChild) {
+      result->dataMap |= bit;
+      result->entries.insert(
+          result->entries.begin() + indexOf(result->dataMap, bit),
+          newChild->entries[0]);
+      if (newChild != child) release(newChild);
+    }
+    release(child);
+    return result;
+  }
+
+  Node* mRoot = nullptr;
+  size_t mSize = 0;
+};
+
+#endif  // PERSISTENT_MAP_H
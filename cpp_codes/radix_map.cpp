@@ -0,0 +1,340 @@
+/* This file shows RadixMap from radix_map.h, an adaptive radix tree keyed
+ * by byte strings, on the std::map<std::string, int> examples of
+ * container_map.cpp, and measures it against std::map<std::string, int> on
+ * long keys that share most of their bytes.
+ *
+ * 1. Min/max and numeric algorithms over a RadixMap (container_map.cpp 10
+ *    and 11)
+ * 2. Ordered lookups: lower_bound(), upper_bound() and prefix_range()
+ * 3. memoryStats(): nodes by kind and bytes
+ * 4. Benchmark: building, lookups, a full scan, prefix scans and heap
+ *    memory
+ *
+ * Linux with glibc only (the heap is measured with mallinfo2()).
+ *
+ * Build with: g++ -std=c++20 -O2 radix_map.cpp
+ */
+
+#include "fast_output.h"
+#include "radix_map.h"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Algorithms
+void algorithms() {
+  RadixMap<int> mp{{"one", 1}, {"two", 2}, {"three", 3}};
+
+  std::cout << "1.1. std::min_element and std::max_element by value"
+            << std::endl;
+  printMap("Map", mp);
+  auto byValue = [](const auto& a, const auto& b) {
+    return a.second < b.second;
+  };
+  auto min = std::min_element(mp.begin(), mp.end(), byValue);
+  auto max = std::max_element(mp.begin(), mp.end(), byValue);
+  std::cout << "Minimum: {" << min->first << "," << min->second
+            << "}, maximum: {" << max->first << "," << max->second << "}"
+            << std::endl;
+
+  std::cout << std::endl
+            << "1.2. std::accumulate and std::inner_product of the values"
+            << std::endl;
+  RadixMap<int> mp1{{"first", 1}, {"second", 2}, {"third", 3}};
+  RadixMap<int> mp2{{"first", 2}, {"second", 3}, {"third", 4}};
+  printMap("First map", mp1);
+  printMap("Second map", mp2);
+  int sum = std::accumulate(
+      mp1.begin(), mp1.end(), 0,
+      [](int total, const auto& a) { return total + a.second; });
+  int innerProduct = std::inner_product(
+      mp1.begin(), mp1.end(), mp2.begin(), 0, std::plus<>(),
+      [](const auto& a, const auto& b) { return a.second * b.second; });
+  std::cout << "Sum: " << sum << ", inner product: " << innerProduct
+            << std::endl;
+}
+
+// 2. Ordered lookups
+void orderedLookups() {
+  RadixMap<int> metrics{{"eu.db.cpu", 71},  {"eu.db.mem", 64},
+                        {"eu.web.cpu", 23}, {"eu.web.cpu.max", 90},
+                        {"us.db.cpu", 48},  {"us.web.cpu", 12}};
+  printMap("Metrics", metrics);
+
+  std::cout << std::endl
+            << "2.1. lower_bound(eu.e) and upper_bound(eu.web.cpu)"
+            << std::endl;
+  std::cout << "lower_bound: " << metrics.lower_bound("eu.e")->first
+            << ", upper_bound: " << metrics.upper_bound("eu.web.cpu")->first
+            << std::endl;
+
+  std::cout << std::endl
+            << "2.2. prefix_range(eu.web) and prefix_range(us.)" << std::endl;
+  for (const char* prefix : {"eu.web", "us."}) {
+    std::cout << prefix << ":";
+    for (const auto& [key, value] : metrics.prefix_range(prefix))
+      std::cout << " {" << key << "," << value << "}";
+    std::cout << std::endl;
+  }
+
+  std::cout << std::endl
+            << "2.3. erase(eu.web.cpu) keeps eu.web.cpu.max" << std::endl;
+  metrics.erase("eu.web.cpu");
+  printMap("Metrics", metrics);
+}
+
+// 3. Memory statistics
+void memoryStatistics() {
+  RadixMap<int> hosts;
+  for (int i = 0; i < 1000; ++i)
+    hosts["cluster-eu-west.rack-" + std::to_string(i / 100) + ".host-" +
+          std::to_string(i)] = i;
+  std::cout << "3.1. 1000 keys of the form "
+               "cluster-eu-west.rack-<i / 100>.host-<i>"
+            << std::endl;
+  auto stats = hosts.memoryStats();
+  std::cout << "Leaves: " << stats.leaves << ", Node4: " << stats.node4
+            << ", Node16: " << stats.node16 << ", Node48: " << stats.node48
+            << ", Node256: " << stats.node256 << ", bytes: " << stats.bytes
+            << " (" << static_cast<double>(stats.bytes) / hosts.size()
+            << " per key)" << std::endl;
+}
+
+// Applies random operations to a RadixMap and a std::map<std::string, int>
+// and compares lookups, bounds, prefix ranges and the order. Keys are up to
+// maxLength bytes out of alphabetSize values spread over 0x00..0xff: a small
+// alphabet makes keys prefixes of each other, a large one fills Node48 and
+// Node256. Erasures take over in the second half to shrink the nodes again.
+bool checkAgainstStd(uint32_t seed, size_t alphabetSize, size_t maxLength) {
+  constexpr int steps = 60000;
+  std::mt19937 gen(seed);
+  auto randomKey = [&] {
+    std::string key(gen() % (maxLength + 1), ' ');
+    for (char& c : key)
+      c = static_cast<char>(gen() % alphabetSize * 255 / (alphabetSize - 1));
+    return key;
+  };
+  auto same = [](const RadixMap<int>& map,
+                 const std::map<std::string, int>& expected) {
+    return map.size() == expected.size() &&
+           std::equal(map.begin(), map.end(), expected.begin(),
+                      expected.end(), [](const auto& a, const auto& b) {
+                        return a.first == b.first && a.second == b.second;
+                      });
+  };
+  RadixMap<int> map;
+  std::map<std::string, int> reference;
+  bool ok = true;
+  for (int step = 0; step < steps && ok; ++step) {
+    std::string key = randomKey();
+    int value = static_cast<int>(gen() % 1000);
+    unsigned op = gen() % 6;
+    if (step > steps / 2 && op < 2) op = 2;
+    switch (op) {
+      case 0:
+        ok = map.insert({key, value}).second ==
+             reference.insert({key, value}).second;
+        break;
+      case 1:
+        map.insert_or_assign(key, value);
+        reference.insert_or_assign(key, value);
+        break;
+      case 2:
+        ok = map.erase(key) == reference.erase(key);
+        break;
+      case 3: {
+        auto lower = map.lower_bound(key);
+        auto upper = map.upper_bound(key);
+        auto expectedLower = reference.lower_bound(key);
+        auto expectedUpper = reference.upper_bound(key);
+        ok = (lower == map.end() ? expectedLower == reference.end()
+                                 : lower->first == expectedLower->first) &&
+             (upper == map.end() ? expectedUpper == reference.end()
+                                 : upper->first == expectedUpper->first);
+        break;
+      }
+      case 4: {
+        std::vector<std::string> keys, expected;
+        for (const auto& [k, v] : map.prefix_range(key)) keys.push_back(k);
+        for (const auto& [k, v] : reference)
+          if (k.starts_with(key)) expected.push_back(k);
+        ok = keys == expected;
+        break;
+      }
+      default: {
+        auto it = map.find(key);
+        auto expected = reference.find(key);
+        ok = (it == map.end()) == (expected == reference.end()) &&
+             (it == map.end() || (it->second == expected->second &&
+                                  std::next(it) == map.upper_bound(key)));
+        break;
+      }
+    }
+    if (step % 5000 == 0) ok = ok && same(map, reference);
+  }
+  RadixMap<int> copy = map;
+  map.clear();
+  return ok && same(copy, reference) && map.memoryStats().bytes == 0;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Bytes allocated on the heap, with malloc's overhead.
+size_t heapBytes() { return mallinfo2().uordblks; }
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  constexpr size_t lookups = 1 << 20;
+  std::mt19937 gen(42);
+  // Metric names: a few regions, services and hosts, then a metric, so
+  // that most of every key is shared with many others.
+  const std::vector<std::string> regions{"eu-west-1", "eu-central-1",
+                                         "us-east-1", "ap-south-1"};
+  const std::vector<std::string> services{"checkout", "search", "payments",
+                                          "inventory", "accounts"};
+  std::vector<std::string> keys;
+  keys.reserve(size);
+  for (size_t i = 0; keys.size() < size; ++i) {
+    keys.push_back("com.example.prod." + regions[i % regions.size()] + "." +
+                   services[i / 4 % services.size()] + ".host-" +
+                   std::to_string(i / 20 % 10000) + ".metric-" +
+                   std::to_string(i / 200000 * 4 + i % 4));
+  }
+  std::shuffle(keys.begin(), keys.end(), gen);
+  size_t keyBytes = 0;
+  for (const auto& key : keys) keyBytes += key.size();
+  std::vector<std::string> queries(lookups);
+  for (auto& query : queries) query = keys[gen() % size];
+  // volatile keeps the compiler from dropping the unused results.
+  volatile long long sink = 0;
+
+  size_t heapBefore = heapBytes();
+  std::map<std::string, int> tree;
+  double treeBuild = measureMilliseconds([&] {
+    for (size_t i = 0; i < size; ++i)
+      tree.emplace(keys[i], static_cast<int>(i));
+  });
+  size_t treeBytes = heapBytes() - heapBefore;
+
+  heapBefore = heapBytes();
+  RadixMap<int> radix;
+  double radixBuild = measureMilliseconds([&] {
+    for (size_t i = 0; i < size; ++i)
+      radix.try_emplace(keys[i], static_cast<int>(i));
+  });
+  size_t radixBytes = heapBytes() - heapBefore;
+
+  double treeFind = measureMilliseconds([&] {
+    long long sum = 0;
+    for (const auto& query : queries) sum += tree.find(query)->second;
+    sink = sum;
+  });
+  double radixFind = measureMilliseconds([&] {
+    long long sum = 0;
+    for (const auto& query : queries) sum += radix.find(query)->second;
+    sink = sum;
+  });
+
+  auto scanAll = [&](const auto& map) {
+    return measureMilliseconds([&] {
+      long long sum = 0;
+      for (const auto& [key, value] : map) sum += value + key.size();
+      sink = sum;
+    });
+  };
+  double treeScan = scanAll(tree);
+  double radixScan = scanAll(radix);
+
+  // One service in one region, on the hosts whose number starts with 1.
+  const std::string prefix = "com.example.prod.eu-west-1.search.host-1";
+  double treePrefix = measureMilliseconds([&] {
+    long long sum = 0;
+    for (auto it = tree.lower_bound(prefix);
+         it != tree.end() && it->first.starts_with(prefix); ++it)
+      sum += it->second;
+    sink = sum;
+  });
+  double radixPrefix = measureMilliseconds([&] {
+    long long sum = 0;
+    for (const auto& element : radix.prefix_range(prefix))
+      sum += element.second;
+    sink = sum;
+  });
+
+  auto stats = radix.memoryStats();
+  std::cout << size << " keys of " << keyBytes / size
+            << " bytes on average, e.g. " << keys[0] << std::endl;
+  std::cout << "Building: std::map " << treeBuild << " ms, RadixMap "
+            << radixBuild << " ms (" << treeBuild / radixBuild << "x)"
+            << std::endl;
+  std::cout << lookups << " lookups: std::map " << treeFind
+            << " ms, RadixMap " << radixFind << " ms ("
+            << treeFind / radixFind << "x)" << std::endl;
+  std::cout << "Full scan: std::map " << treeScan << " ms, RadixMap "
+            << radixScan << " ms (" << treeScan / radixScan << "x)"
+            << std::endl;
+  std::cout << "prefix_range(" << prefix << "): std::map lower_bound + scan "
+            << treePrefix << " ms, RadixMap " << radixPrefix << " ms ("
+            << treePrefix / radixPrefix << "x)" << std::endl;
+  std::cout << "Heap: std::map " << treeBytes / size << " bytes per key, "
+            << "RadixMap " << radixBytes / size << " bytes per key ("
+            << static_cast<double>(treeBytes) / radixBytes
+            << "x less); memoryStats(): " << stats.bytes / size
+            << " bytes per key in " << stats.leaves << " leaves, "
+            << stats.node4 << " Node4, " << stats.node16 << " Node16, "
+            << stats.node48 << " Node48, " << stats.node256 << " Node256"
+            << std::endl;
+}
+
+int main() {
+  // Algorithms
+  std::cout << "*** Algorithms ***" << std::endl;
+  algorithms();
+
+  // Ordered lookups
+  std::cout << std::endl << "*** Ordered lookups ***" << std::endl;
+  orderedLookups();
+
+  // Memory statistics
+  std::cout << std::endl << "*** Memory statistics ***" << std::endl;
+  memoryStatistics();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::map<std::string, int>: "
+            << std::boolalpha
+            << (checkAgainstStd(1, 4, 6) && checkAgainstStd(2, 256, 3))
+            << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
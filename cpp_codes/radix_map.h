@@ -0,0 +1,1021 @@
+/* This header implements RadixMap<T>, an ordered map from byte strings to
+ * T stored as an adaptive radix tree (ART), for the std::map<std::string,
+ * int> of minMaxAlgorithms() and numericAlgorithms() in container_map.cpp.
+ * A std::map compares the whole key at each of its ~log2(n) levels, and
+ * keys with a long shared prefix compare equal for most of their length
+ * every time. A radix tree looks at each byte of the key once.
+ *
+ * 1. Nodes: an inner node branches on one key byte and comes in four sizes
+ *    that grow and shrink with its number of children. Node4 and Node16
+ *    hold a sorted array of bytes next to the child pointers (Node16 is
+ *    searched with one SSE2 compare), Node48 maps all 256 bytes to 48
+ *    child slots, and Node256 holds one pointer per byte.
+ * 2. Path compression: the bytes that all keys below a node share are
+ *    stored once, in the node (its prefix), and a leaf stores only the
+ *    bytes of its key below its parent, so a shared prefix costs no memory
+ *    per key. A key that ends at a node, e.g. "ab" next to "abc", is held
+ *    in the node's terminal slot.
+ * 3. Order: children are visited by unsigned byte value after the
+ *    terminal key, which is the order of std::string's operator<.
+ *    Iterators are forward iterators that rebuild the key on the way down,
+ *    so it->first refers into the iterator and lasts until it moves.
+ * 4. Lookup: find(), count(), contains(), at(), lower_bound(),
+ *    upper_bound() and prefix_range(), all taking a std::string_view.
+ * 5. memoryStats(): the number of nodes of each kind and the bytes they
+ *    take.
+ *
+ * Insertions and erasures invalidate iterators.
+ */
+
+#ifndef RADIX_MAP_H
+#define RADIX_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+template <typename T>
+class RadixMap {
+  struct Node;
+  struct Leaf;
+  template <bool Const>
+  class Iterator;
+
+ public:
+  using key_type = std::string;
+  using mapped_type = T;
+  using value_type = std::pair<std::string, T>;
+  using reference = std::pair<const std::string&, T&>;
+  using const_reference = std::pair<const std::string&, const T&>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // The elements whose keys start with a given prefix.
+  template <typename It>
+  struct Range {
+    It first;
+    It last;
+    It begin() const { return first; }
+    It end() const { return last; }
+    bool empty() const { return first == last; }
+  };
+
+  struct MemoryStats {
+    size_t bytes = 0;  // asked of operator new, without malloc's overhead
+    size_t leaves = 0;
+    size_t node4 = 0;
+    size_t node16 = 0;
+    size_t node48 = 0;
+    size_t node256 = 0;
+  };
+
+  // 1. Construction
+  RadixMap() = default;
+
+  template <typename InputIt>
+  RadixMap(InputIt first, InputIt last) {
+    insert(first, last);
+  }
+
+  RadixMap(std::initializer_list<value_type> init)
+      : RadixMap(init.begin(), init.end()) {}
+
+  RadixMap(const RadixMap& other) : mSize(other.mSize) {
+    if (other.mRoot) mRoot = clone(other.mRoot);
+  }
+
+  RadixMap(RadixMap&& other) noexcept { steal(other); }
+
+  ~RadixMap() { clear(); }
+
+  RadixMap& operator=(const RadixMap& other) {
+    if (this != &other) {
+      RadixMap copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  RadixMap& operator=(RadixMap&& other) noexcept {
+    if (this != &other) {
+      clear();
+      steal(other);
+    }
+    return *this;
+  }
+
+  // 2. Iterators
+  iterator begin() { return leftmost<iterator>(); }
+  const_iterator begin() const { return leftmost<const_iterator>(); }
+  iterator end() { return iterator(); }
+  const_iterator end() const { return const_iterator(); }
+
+  // Capacity
+  size_t size() const noexcept { return mSize; }
+  bool empty() const noexcept { return mSize == 0; }
+  MemoryStats memoryStats() const noexcept { return mStats; }
+
+  // 3. Lookup
+  T& at(std::string_view key) {
+    Leaf* leaf = findLeaf(key);
+    if (!leaf) throw std::out_of_range("RadixMap::at");
+    return leaf->value;
+  }
+
+  const T& at(std::string_view key) const {
+    Leaf* leaf = findLeaf(key);
+    if (!leaf) throw std::out_of_range("RadixMap::at");
+    return leaf->value;
+  }
+
+  T& operator[](std::string_view key) { return insertLeaf(key).first->value; }
+
+  iterator find(std::string_view key) {
+    return found<iterator>(findLeaf(key), key);
+  }
+  const_iterator find(std::string_view key) const {
+    return found<const_iterator>(findLeaf(key), key);
+  }
+  size_t count(std::string_view key) const { return findLeaf(key) != nullptr; }
+  bool contains(std::string_view key) const {
+    return findLeaf(key) != nullptr;
+  }
+
+  iterator lower_bound(std::string_view key) {
+    return seek<iterator>(key);
+  }
+  const_iterator lower_bound(std::string_view key) const {
+    return seek<const_iterator>(key);
+  }
+
+  iterator upper_bound(std::string_view key) {
+    return after<iterator>(key);
+  }
+  const_iterator upper_bound(std::string_view key) const {
+    return after<const_iterator>(key);
+  }
+
+  // The keys that start with prefix, in order: from lower_bound(prefix) to
+  // the lower bound of the first string past them.
+  Range<iterator> prefix_range(std::string_view prefix) {
+    return prefixRange<iterator>(prefix);
+  }
+  Range<const_iterator> prefix_range(std::string_view prefix) const {
+    return prefixRange<const_iterator>(prefix);
+  }
+
+  // 4. Modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(std::string_view key,
+                                        Args&&... args) {
+    auto [leaf, inserted] = insertLeaf(key, std::forward<Args>(args)...);
+    return {found<iterator>(leaf, key), inserted};
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(std::string_view key, Args&&... args) {
+    return try_emplace(key, std::forward<Args>(args)...);
+  }
+
+  std::pair<iterator, bool> insert(const value_type& element) {
+    return try_emplace(element.first, element.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& element) {
+    return try_emplace(element.first, std::move(element.second));
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) insertLeaf(first->first, first->second);
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <typename M>
+  std::pair<iterator, bool> insert_or_assign(std::string_view key,
+                                             M&& value) {
+    auto [leaf, inserted] = insertLeaf(key, std::forward<M>(value));
+    if (!inserted) leaf->value = std::forward<M>(value);
+    return {found<iterator>(leaf, key), inserted};
+  }
+
+  size_t erase(std::string_view key) {
+    size_t removed = eraseFrom(&mRoot, key, 0);
+    mSize -= removed;
+    return removed;
+  }
+
+  void clear() noexcept {
+    if (mRoot) freeTree(mRoot);
+    mRoot = nullptr;
+    mSize = 0;
+  }
+
+  void swap(RadixMap& other) noexcept {
+    using std::swap;
+    swap(mRoot, other.mRoot);
+    swap(mSize, other.mSize);
+    swap(mStats, other.mStats);
+  }
+
+  friend bool operator==(const RadixMap& a, const RadixMap& b) {
+    if (a.size() != b.size()) return false;
+    for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j)
+      if (i->first != j->first || !(i->second == j->second)) return false;
+    return true;
+  }
+
+ private:
+  enum NodeType : uint8_t {
+    leafType,
+    node4Type,
+    node16Type,
+    node48Type,
+    node256Type
+  };
+
+  // Every node is followed in memory by prefixCapacity bytes, of which
+  // the first prefixLength are its prefix.
+  struct Node {
+    NodeType type;
+    uint16_t count = 0;  // children of an inner node
+    uint32_t prefixLength = 0;
+    uint32_t prefixCapacity = 0;
+  };
+
+  struct Leaf : Node {
+    static constexpr NodeType nodeType = leafType;
+    template <typename... Args>
+    explicit Leaf(Args&&... args) : value(std::forward<Args>(args)...) {}
+    T value;
+  };
+
+  // terminal is the leaf of the key that ends at this node, if any; its
+  // prefix is empty.
+  struct Inner : Node {
+    Node* terminal = nullptr;
+  };
+
+  struct Node4 : Inner {
+    static constexpr NodeType nodeType = node4Type;
+    uint8_t keys[4];
+    Node* children[4];
+  };
+
+  struct Node16 : Inner {
+    static constexpr NodeType nodeType = node16Type;
+    uint8_t keys[16];
+    Node* children[16];
+  };
+
+  // index[byte] is the child's slot + 1, or 0 when there is none.
+  struct Node48 : Inner {
+    static constexpr NodeType nodeType = node48Type;
+    uint8_t index[256];
+    Node* children[48];
+  };
+
+  struct Node256 : Inner {
+    static constexpr NodeType nodeType = node256Type;
+    Node* children[256];
+  };
+
+  static_assert(alignof(Leaf) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+  // A child position in an inner node: -1 is the terminal key, then the
+  // children in byte order (a slot in Node4 and Node16, the byte itself in
+  // Node48 and Node256).
+  static constexpr int terminalPosition = -1;
+  static constexpr int noPosition = 256;
+
+  // An inner node on the path of an iterator, the position taken in it and
+  // the key length up to the end of its prefix.
+  struct Frame {
+    Node* node;
+    int position;
+    size_t keyLength;
+  };
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<std::string, T>;
+    using difference_type = ptrdiff_t;
+    using reference = std::pair<const std::string&,
+                                std::conditional_t<Const, const T&, T&>>;
+    // The same arrow proxy as FlatMap's iterator (flat_map.h).
+    struct pointer {
+      reference ref;
+      const reference* operator->() const { return &ref; }
+    };
+
+    Iterator() = default;
+    template <bool OtherConst>
+      requires(Const && !OtherConst)
+    Iterator(const Iterator<OtherConst>& other)
+        : mRoot(other.mRoot),
+          mLeaf(other.mLeaf),
+          mKey(other.mKey),
+          mPath(other.mPath),
+          mHasPath(other.mHasPath) {}
+
+    reference operator*() const { return {mKey, mLeaf->value}; }
+    pointer operator->() const { return {**this}; }
+
+    Iterator& operator++() {
+      // find() only looks the leaf up; walk down again to get its path.
+      if (!mHasPath) {
+        std::string key = std::move(mKey);
+        seek(mRoot, key);
+      }
+      next();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.mLeaf == b.mLeaf;
+    }
+
+   private:
+    friend class RadixMap;
+    friend class Iterator<!Const>;
+
+    // Appends the prefixes on the way down to the smallest key under node.
+    void descend(Node* node) {
+      for (;;) {
+        mKey.append(prefixOf(node), node->prefixLength);
+        if (node->type == leafType) {
+          mLeaf = static_cast<Leaf*>(node);
+          return;
+        }
+        mPath.push_back({node, terminalPosition - 1, mKey.size()});
+        node = enterNext(mPath.back());
+      }
+    }
+
+    // Moves frame to its next child and appends that child's byte; nullptr
+    // when the node has no children left.
+    Node* enterNext(Frame& frame) {
+      int position = nextPosition(frame.node, frame.position + 1);
+      if (position == noPosition) return nullptr;
+      frame.position = position;
+      mKey.resize(frame.keyLength);
+      if (position != terminalPosition)
+        mKey.push_back(static_cast<char>(byteAt(frame.node, position)));
+      return *childSlot(frame.node, position);
+    }
+
+    void next() {
+      while (!mPath.empty()) {
+        if (Node* child = enterNext(mPath.back())) {
+          descend(child);
+          return;
+        }
+        mPath.pop_back();
+      }
+      mLeaf = nullptr;
+      mKey.clear();
+    }
+
+    // Positions the iterator on the first key not less than key.
+    void seek(Node* root, std::string_view key) {
+      mRoot = root;
+      mLeaf = nullptr;
+      mKey.clear();
+      mPath.clear();
+      mHasPath = true;
+      Node* node = root;
+      size_t depth = 0;
+      while (node) {
+        std::string_view prefix(prefixOf(node), node->prefixLength);
+        std::string_view rest = key.substr(depth);
+        size_t common = commonLength(prefix, rest);
+        if (common < prefix.size() || node->type == leafType) {
+          // The subtree holds only keys past key, or only keys before it.
+          bool past = common == rest.size() ||
+                      (common < prefix.size() &&
+                       byteOf(prefix[common]) > byteOf(rest[common]));
+          if (past) {
+            descend(node);
+            return;
+          }
+          break;
+        }
+        mKey.append(prefix);
+        depth += prefix.size();
+        mPath.push_back({node, terminalPosition - 1, mKey.size()});
+        if (depth == key.size()) {
+          descend(enterNext(mPath.back()));
+          return;
+        }
+        uint8_t byte = byteOf(key[depth]);
+        int position = lowerPosition(node, byte);
+        if (!hasChild(node, position, byte)) {
+          // The next child is the first one past byte.
+          mPath.back().position = position - 1;
+          break;
+        }
+        mPath.back().position = position;
+        mKey.push_back(key[depth]);
+        node = *childSlot(node, position);
+        ++depth;
+      }
+      next();
+    }
+
+    Node* mRoot = nullptr;
+    Leaf* mLeaf = nullptr;
+    std::string mKey;
+    std::vector<Frame> mPath;
+    bool mHasPath = true;
+  };
+
+  static uint8_t byteOf(char c) { return static_cast<uint8_t>(c); }
+
+  static size_t commonLength(std::string_view a, std::string_view b) {
+    size_t length = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < length && a[i] == b[i]) ++i;
+    return i;
+  }
+
+  static size_t nodeSize(NodeType type) {
+    switch (type) {
+      case leafType:
+        return sizeof(Leaf);
+      case node4Type:
+        return sizeof(Node4);
+      case node16Type:
+        return sizeof(Node16);
+      case node48Type:
+        return sizeof(Node48);
+      default:
+        return sizeof(Node256);
+    }
+  }
+
+  static char* prefixOf(Node* node) {
+    return reinterpret_cast<char*>(node) + nodeSize(node->type);
+  }
+
+  size_t& countOf(NodeType type) {
+    switch (type) {
+      case leafType:
+        return mStats.leaves;
+      case node4Type:
+        return mStats.node4;
+      case node16Type:
+        return mStats.node16;
+      case node48Type:
+        return mStats.node48;
+      default:
+        return mStats.node256;
+    }
+  }
+
+  // Allocates a node of type N with room for capacity prefix bytes and
+  // sets its prefix; args construct the value of a leaf.
+  template <typename N, typename... Args>
+  N* newNode(std::string_view prefix, size_t capacity, Args&&... args) {
+    size_t bytes = sizeof(N) + capacity;
+    void* memory = ::operator new(bytes);
+    N* node;
+    try {
+      node = new (memory) N(std::forward<Args>(args)...);
+    } catch (...) {
+      ::operator delete(memory);
+      throw;
+    }
+    node->type = N::nodeType;
+    node->prefixLength = static_cast<uint32_t>(prefix.size());
+    node->prefixCapacity = static_cast<uint32_t>(capacity);
+    if (!prefix.empty())
+      std::memcpy(prefixOf(node), prefix.data(), prefix.size());
+    mStats.bytes += bytes;
+    ++countOf(N::nodeType);
+    return node;
+  }
+
+  template <typename... Args>
+  Leaf* newLeaf(std::string_view suffix, Args&&... args) {
+    return newNode<Leaf>(suffix, suffix.size(), std::forward<Args>(args)...);
+  }
+
+  // Frees one node, not its children.
+  void freeNode(Node* node) {
+    mStats.bytes -= nodeSize(node->type) + node->prefixCapacity;
+    --countOf(node->type);
+    if (node->type == leafType) static_cast<Leaf*>(node)->~Leaf();
+    ::operator delete(node);
+  }
+
+  void freeTree(Node* node) {
+    if (node->type != leafType) {
+      for (int p = nextPosition(node, terminalPosition); p != noPosition;
+           p = nextPosition(node, p + 1))
+        freeTree(*childSlot(node, p));
+    }
+    freeNode(node);
+  }
+
+  Node* clone(Node* node) {
+    std::string_view prefix(prefixOf(node), node->prefixLength);
+    if (node->type == leafType)
+      return newLeaf(prefix, static_cast<Leaf*>(node)->value);
+    // The arrays of an inner node are plain bytes and pointers: copy them,
+    // then replace the children with their copies.
+    size_t size = nodeSize(node->type);
+    Node* copy = static_cast<Node*>(::operator new(size + prefix.size()));
+    std::memcpy(static_cast<void*>(copy), node, size);
+    copy->prefixCapacity = copy->prefixLength;
+    std::memcpy(prefixOf(copy), prefix.data(), prefix.size());
+    mStats.bytes += size + prefix.size();
+    ++countOf(node->type);
+    for (int p = nextPosition(node, terminalPosition); p != noPosition;
+         p = nextPosition(node, p + 1))
+      *childSlot(copy, p) = clone(*childSlot(node, p));
+    return copy;
+  }
+
+  void steal(RadixMap& other) noexcept {
+    mRoot = std::exchange(other.mRoot, nullptr);
+    mSize = std::exchange(other.mSize, 0);
+    mStats = std::exchange(other.mStats, MemoryStats());
+  }
+
+  // Removes the first count bytes of the prefix, in place.
+  static void dropPrefix(Node* node, size_t count) {
+    char* prefix = prefixOf(node);
+    std::memmove(prefix, prefix + count, node->prefixLength - count);
+    node->prefixLength -= static_cast<uint32_t>(count);
+  }
+
+  // Puts head in front of the prefix of node; returns the node, which is
+  // reallocated when its prefix does not fit.
+  Node* prependPrefix(Node* node, std::string_view head) {
+    std::string prefix(head);
+    prefix.append(prefixOf(node), node->prefixLength);
+    if (prefix.size() <= node->prefixCapacity) {
+      std::memcpy(prefixOf(node), prefix.data(), prefix.size());
+      node->prefixLength = static_cast<uint32_t>(prefix.size());
+      return node;
+    }
+    Node* moved;
+    if (node->type == leafType) {
+      moved = newLeaf(prefix, std::move(static_cast<Leaf*>(node)->value));
+    } else {
+      size_t size = nodeSize(node->type);
+      moved = static_cast<Node*>(::operator new(size + prefix.size()));
+      std::memcpy(static_cast<void*>(moved), node, size);
+      moved->prefixLength = static_cast<uint32_t>(prefix.size());
+      moved->prefixCapacity = moved->prefixLength;
+      std::memcpy(prefixOf(moved), prefix.data(), prefix.size());
+      mStats.bytes += size + prefix.size();
+      ++countOf(node->type);
+    }
+    freeNode(node);
+    return moved;
+  }
+
+  // Index of byte among the first count keys, or -1.
+  static int findByte16(const uint8_t* keys, size_t count, uint8_t byte) {
+#if defined(__SSE2__)
+    __m128i matches =
+        _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys)));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(matches)) &
+                    ((1u << count) - 1);
+    return mask ? std::countr_zero(mask) : -1;
+#else
+    for (size_t i = 0; i < count; ++i)
+      if (keys[i] == byte) return static_cast<int>(i);
+    return -1;
+#endif
+  }
+
+  // The slot of the child for byte, or nullptr.
+  static Node** findChild(Node* node, uint8_t byte) {
+    switch (node->type) {
+      case node4Type: {
+        auto* n = static_cast<Node4*>(node);
+        for (size_t i = 0; i < n->count; ++i)
+          if (n->keys[i] == byte) return &n->children[i];
+        return nullptr;
+      }
+      case node16Type: {
+        auto* n = static_cast<Node16*>(node);
+        int i = findByte16(n->keys, n->count, byte);
+        return i < 0 ? nullptr : &n->children[i];
+      }
+      case node48Type: {
+        auto* n = static_cast<Node48*>(node);
+        return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+      }
+      case node256Type: {
+        auto* n = static_cast<Node256*>(node);
+        return n->children[byte] ? &n->children[byte] : nullptr;
+      }
+      default:
+        return nullptr;
+    }
+  }
+
+  // The first position not before from that holds a child, or noPosition.
+  static int nextPosition(Node* node, int from) {
+    if (from <= terminalPosition) {
+      if (static_cast<Inner*>(node)->terminal) return terminalPosition;
+      from = 0;
+    }
+    switch (node->type) {
+      case node4Type:
+      case node16Type:
+        return from < node->count ? from : noPosition;
+      case node48Type: {
+        auto* n = static_cast<Node48*>(node);
+        for (int byte = from; byte < 256; ++byte)
+          if (n->index[byte]) return byte;
+        return noPosition;
+      }
+      default: {
+        auto* n = static_cast<Node256*>(node);
+        for (int byte = from; byte < 256; ++byte)
+          if (n->children[byte]) return byte;
+        return noPosition;
+      }
+    }
+  }
+
+  // The first position whose byte is not less than byte.
+  static int lowerPosition(Node* node, uint8_t byte) {
+    if (node->type == node4Type || node->type == node16Type) {
+      const uint8_t* keys = node->type == node4Type
+                                ? static_cast<Node4*>(node)->keys
+                                : static_cast<Node16*>(node)->keys;
+      int i = 0;
+      while (i < node->count && keys[i] < byte) ++i;
+      return i;
+    }
+    return byte;
+  }
+
+  static bool hasChild(Node* node, int position, uint8_t byte) {
+    switch (node->type) {
+      case node4Type:
+      case node16Type:
+        return position < node->count && byteAt(node, position) == byte;
+      case node48Type:
+        return static_cast<Node48*>(node)->index[byte] != 0;
+      default:
+        return static_cast<Node256*>(node)->children[byte] != nullptr;
+    }
+  }
+
+  static uint8_t byteAt(Node* node, int position) {
+    switch (node->type) {
+      case node4Type:
+        return static_cast<Node4*>(node)->keys[position];
+      case node16Type:
+        return static_cast<Node16*>(node)->keys[position];
+      default:
+        return static_cast<uint8_t>(position);
+    }
+  }
+
+  static Node** childSlot(Node* node, int position) {
+    if (position == terminalPosition)
+      return &static_cast<Inner*>(node)->terminal;
+    switch (node->type) {
+      case node4Type:
+        return &static_cast<Node4*>(node)->children[position];
+      case node16Type:
+        return &static_cast<Node16*>(node)->children[position];
+      case node48Type: {
+        auto* n = static_cast<Node48*>(node);
+        return &n->children[n->index[position] - 1];
+      }
+      default:
+        return &static_cast<Node256*>(node)->children[position];
+    }
+  }
+
+  // Inserts into a sorted Node4 or Node16 that has room.
+  template <typename N>
+  static void addSorted(N* node, uint8_t byte, Node* child) {
+    int i = node->count;
+    for (; i > 0 && node->keys[i - 1] > byte; --i) {
+      node->keys[i] = node->keys[i - 1];
+      node->children[i] = node->children[i - 1];
+    }
+    node->keys[i] = byte;
+    node->children[i] = child;
+    ++node->count;
+  }
+
+  template <typename N>
+  static void removeSorted(N* node, uint8_t byte) {
+    int i = 0;
+    while (node->keys[i] != byte) ++i;
+    for (++i; i < node->count; ++i) {
+      node->keys[i - 1] = node->keys[i];
+      node->children[i - 1] = node->children[i];
+    }
+    --node->count;
+  }
+
+  // Moves the prefix, terminal and children of node into a new node of
+  // type To, which must have room for them, and frees node.
+  template <typename To>
+  Node* convert(Node* node) {
+    Node* to = newNode<To>(std::string_view(prefixOf(node), node->prefixLength),
+                           node->prefixLength);
+    static_cast<Inner*>(to)->terminal = static_cast<Inner*>(node)->terminal;
+    for (int p = nextPosition(node, 0); p != noPosition;
+         p = nextPosition(node, p + 1))
+      addChild(&to, byteAt(node, p), *childSlot(node, p));
+    freeNode(node);
+    return to;
+  }
+
+  // Adds a child for byte, which must be new, growing the node when full.
+  void addChild(Node** ref, uint8_t byte, Node* child) {
+    Node* node = *ref;
+    switch (node->type) {
+      case node4Type:
+        if (node->count < 4)
+          return addSorted(static_cast<Node4*>(node), byte, child);
+        *ref = convert<Node16>(node);
+        break;
+      case node16Type:
+        if (node->count < 16)
+          return addSorted(static_cast<Node16*>(node), byte, child);
+        *ref = convert<Node48>(node);
+        break;
+      case node48Type: {
+        auto* n = static_cast<Node48*>(node);
+        if (n->count < 48) {
+          int slot = 0;
+          while (n->children[slot]) ++slot;
+          n->children[slot] = child;
+          n->index[byte] = static_cast<uint8_t>(slot + 1);
+          ++n->count;
+          return;
+        }
+        *ref = convert<Node256>(node);
+        break;
+      }
+      default: {
+        auto* n = static_cast<Node256*>(node);
+        n->children[byte] = child;
+        ++n->count;
+        return;
+      }
+    }
+    addChild(ref, byte, child);
+  }
+
+  static void removeChild(Node* node, uint8_t byte) {
+    switch (node->type) {
+      case node4Type:
+        return removeSorted(static_cast<Node4*>(node), byte);
+      case node16Type:
+        return removeSorted(static_cast<Node16*>(node), byte);
+      case node48Type: {
+        auto* n = static_cast<Node48*>(node);
+        n->children[n->index[byte] - 1] = nullptr;
+        n->index[byte] = 0;
+        --n->count;
+        return;
+      }
+      default: {
+        auto* n = static_cast<Node256*>(node);
+        n->children[byte] = nullptr;
+        --n->count;
+        return;
+      }
+    }
+  }
+
+  // After a removal: a node left with one entry is merged into it, and a
+  // node that has become sparse moves to a smaller type. The thresholds
+  // lie below the growth points so that a node at the edge does not flip
+  // back and forth.
+  void shrink(Node** ref) {
+    Node* node = *ref;
+    auto* inner = static_cast<Inner*>(node);
+    if (inner->count + (inner->terminal != nullptr) == 1) {
+      std::string head(prefixOf(node), node->prefixLength);
+      Node* only = inner->terminal;
+      if (!only) {
+        int position = nextPosition(node, 0);
+        head.push_back(static_cast<char>(byteAt(node, position)));
+        only = *childSlot(node, position);
+      }
+      freeNode(node);
+      *ref = prependPrefix(only, head);
+    } else if (node->type == node16Type && node->count <= 3) {
+      *ref = convert<Node4>(node);
+    } else if (node->type == node48Type && node->count <= 12) {
+      *ref = convert<Node16>(node);
+    } else if (node->type == node256Type && node->count <= 36) {
+      *ref = convert<Node48>(node);
+    }
+  }
+
+  Leaf* findLeaf(std::string_view key) const {
+    Node* node = mRoot;
+    size_t depth = 0;
+    while (node) {
+      size_t length = node->prefixLength;
+      if (key.size() - depth < length ||
+          std::memcmp(prefixOf(node), key.data() + depth, length) != 0)
+        return nullptr;
+      depth += length;
+      if (node->type == leafType)
+        return depth == key.size() ? static_cast<Leaf*>(node) : nullptr;
+      if (depth == key.size())
+        return static_cast<Leaf*>(static_cast<Inner*>(node)->terminal);
+      Node** child = findChild(node, byteOf(key[depth]));
+      if (!child) return nullptr;
+      node = *child;
+      ++depth;
+    }
+    return nullptr;
+  }
+
+  // Returns the leaf of key and whether it is new; args construct the
+  // value of a new leaf.
+  template <typename... Args>
+  std::pair<Leaf*, bool> insertLeaf(std::string_view key, Args&&... args) {
+    Node** ref = &mRoot;
+    size_t depth = 0;
+    for (;;) {
+      Node* node = *ref;
+      if (!node) {
+        Leaf* leaf = newLeaf(key.substr(depth), std::forward<Args>(args)...);
+        *ref = leaf;
+        ++mSize;
+        return {leaf, true};
+      }
+      std::string_view prefix(prefixOf(node), node->prefixLength);
+      std::string_view rest = key.substr(depth);
+      size_t common = commonLength(prefix, rest);
+      bool isLeaf = node->type == leafType;
+      if (isLeaf && common == prefix.size() && common == rest.size())
+        return {static_cast<Leaf*>(node), false};
+
+      if (isLeaf || common < prefix.size()) {
+        // Split: a Node4 takes the common part of the prefix and branches
+        // between node and the new key.
+        std::string_view suffix;
+        if (common < rest.size()) suffix = rest.substr(common + 1);
+        Leaf* leaf = newLeaf(suffix, std::forward<Args>(args)...);
+        Node* parent = newNode<Node4>(prefix.substr(0, common), common);
+        if (common == prefix.size()) {
+          dropPrefix(node, common);
+          static_cast<Inner*>(parent)->terminal = node;
+        } else {
+          uint8_t byte = byteOf(prefix[common]);
+          dropPrefix(node, common + 1);
+          addChild(&parent, byte, node);
+        }
+        if (common == rest.size())
+          static_cast<Inner*>(parent)->terminal = leaf;
+        else
+          addChild(&parent, byteOf(rest[common]), leaf);
+        *ref = parent;
+        ++mSize;
+        return {leaf, true};
+      }
+
+      depth += prefix.size();
+      auto* inner = static_cast<Inner*>(node);
+      if (depth == key.size()) {
+        if (inner->terminal)
+          return {static_cast<Leaf*>(inner->terminal), false};
+        Leaf* leaf = newLeaf(std::string_view(), std::forward<Args>(args)...);
+        inner->terminal = leaf;
+        ++mSize;
+        return {leaf, true};
+      }
+      uint8_t byte = byteOf(key[depth]);
+      if (Node** child = findChild(node, byte)) {
+        ref = child;
+        ++depth;
+        continue;
+      }
+      Leaf* leaf = newLeaf(key.substr(depth + 1), std::forward<Args>(args)...);
+      addChild(ref, byte, leaf);
+      ++mSize;
+      return {leaf, true};
+    }
+  }
+
+  size_t eraseFrom(Node** ref, std::string_view key, size_t depth) {
+    Node* node = *ref;
+    if (!node) return 0;
+    size_t length = node->prefixLength;
+    if (key.size() - depth < length ||
+        std::memcmp(prefixOf(node), key.data() + depth, length) != 0)
+      return 0;
+    depth += length;
+    if (node->type == leafType) {
+      if (depth != key.size()) return 0;
+      freeNode(node);
+      *ref = nullptr;
+      return 1;
+    }
+    auto* inner = static_cast<Inner*>(node);
+    if (depth == key.size()) {
+      if (!inner->terminal) return 0;
+      freeNode(inner->terminal);
+      inner->terminal = nullptr;
+    } else {
+      uint8_t byte = byteOf(key[depth]);
+      Node** child = findChild(node, byte);
+      if (!child || eraseFrom(child, key, depth + 1) == 0) return 0;
+      if (*child) return 1;
+      removeChild(node, byte);
+    }
+    shrink(ref);
+    return 1;
+  }
+
+  template <typename It>
+  It leftmost() const {
+    It it;
+    it.mRoot = mRoot;
+    if (mRoot) it.descend(mRoot);
+    return it;
+  }
+
+  // An iterator on a leaf found by key, without its path; operator++
+  // builds the path when it is needed.
+  template <typename It>
+  It found(Leaf* leaf, std::string_view key) const {
+    It it;
+    if (leaf) {
+      it.mRoot = mRoot;
+      it.mLeaf = leaf;
+      it.mKey = key;
+      it.mHasPath = false;
+    }
+    return it;
+  }
+
+  template <typename It>
+  It seek(std::string_view key) const {
+    It it;
+    it.seek(mRoot, key);
+    return it;
+  }
+
+  template <typename It>
+  It after(std::string_view key) const {
+    It it = seek<It>(key);
+    if (it.mLeaf && it.mKey == key) ++it;
+    return it;
+  }
+
+  template <typename It>
+  Range<It> prefixRange(std::string_view prefix) const {
+    // The smallest string greater than every string that starts with
+    // prefix: drop trailing 0xff bytes, then increment the last byte.
+    std::string bound(prefix);
+    while (!bound.empty() && byteOf(bound.back()) == 0xff) bound.pop_back();
+    if (bound.empty()) return {seek<It>(prefix), It()};
+    bound.back() = static_cast<char>(byteOf(bound.back()) + 1);
+    return {seek<It>(prefix), seek<It>(bound)};
+  }
+
+  Node* mRoot = nullptr;
+  size_t mSize = 0;
+  MemoryStats mStats;
+};
+
+#endif  // RADIX_MAP_H
@@ -0,0 +1,553 @@
+/* This file extends randomizationAlgorithms() of container_vector.cpp, which
+ * shuffles a small vector with std::shuffle() and std::mt19937, to inputs
+ * that are too large to shuffle serially or to hold in memory at all.
+ *
+ * 1. Faster generators behind the standard URBG interface, so they can be
+ *    passed to std::shuffle(), std::sample() and the distributions:
+ *    1.1. Xoshiro256StarStar, with jump() for independent parallel streams
+ *    1.2. Pcg32
+ *    1.3. boundedRandom(): Lemire's multiply-shift reduction to [0, range)
+ * 2. ReservoirSampler: uniform sample of k items from a stream of unknown
+ *    length (Algorithm L). After the reservoir fills, it draws how many
+ *    items to skip instead of a random number per item, so a stream of n
+ *    items costs O(k log(n / k)) random numbers and skipped records can be
+ *    seeked over instead of read.
+ * 3. WeightedReservoirSampler: weighted sample without replacement
+ *    (Efraimidis-Spirakis A-ExpJ, also skip-based).
+ * 4. Shuffles
+ *    4.1. fisherYates(): serial shuffle with boundedRandom()
+ *    4.2. parallelMergeShuffle(): MergeShuffle. Blocks are shuffled in
+ *         parallel, then neighbouring blocks are merged by coin flips level
+ *         by level. The result is a uniformly random permutation.
+ * 5. Examples and benchmark
+ *
+ * Build with: g++ -std=c++20 -O2 -pthread reservoir_sampling_and_shuffle.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1.1. Xoshiro256StarStar
+class Xoshiro256StarStar {
+ public:
+  using result_type = uint64_t;
+
+  explicit Xoshiro256StarStar(uint64_t seed = 1) {
+    // Expand the seed with SplitMix64, as recommended by the authors.
+    for (uint64_t& word : mState) {
+      seed += 0x9e3779b97f4a7c15ull;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    uint64_t result = rotl(mState[1] * 5, 7) * 9;
+    uint64_t t = mState[1] << 17;
+    mState[2] ^= mState[0];
+    mState[3] ^= mState[1];
+    mState[1] ^= mState[2];
+    mState[0] ^= mState[3];
+    mState[2] ^= t;
+    mState[3] = rotl(mState[3], 45);
+    return result;
+  }
+
+  // Advances the state by 2^128 steps. Calling jump() t times on copies of
+  // one generator gives t non-overlapping streams for t threads.
+  void jump() {
+    static constexpr uint64_t jumpTable[] = {
+        0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa,
+        0x39abdc4529b1661c};
+    std::array<uint64_t, 4> next{};
+    for (uint64_t word : jumpTable) {
+      for (int bit = 0; bit < 64; ++bit) {
+        if (word & (uint64_t{1} << bit)) {
+          for (int i = 0; i < 4; ++i) next[i] ^= mState[i];
+        }
+        (*this)();
+      }
+    }
+    mState = next;
+  }
+
+ private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  std::array<uint64_t, 4> mState;
+};
+
+// 1.2. Pcg32
+class Pcg32 {
+ public:
+  using result_type = uint32_t;
+
+  explicit Pcg32(uint64_t seed = 1, uint64_t stream = 1)
+      : mIncrement((stream << 1) | 1) {
+    (*this)();
+    mState += seed;
+    (*this)();
+  }
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() {
+    uint64_t old = mState;
+    mState = old * 6364136223846793005ull + mIncrement;
+    uint32_t xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+  }
+
+ private:
+  uint64_t mState{0};
+  uint64_t mIncrement;
+};
+
+// 1.3. boundedRandom()
+// Uniform integer in [0, range) from a 64-bit generator with one multiply in
+// the common case (Lemire, "Fast Random Integer Generation in an Interval").
+template <typename URBG>
+uint64_t boundedRandom(URBG& gen, uint64_t range) {
+  static_assert(URBG::max() == std::numeric_limits<uint64_t>::max(),
+                "boundedRandom() needs a 64-bit generator");
+  unsigned __int128 product = static_cast<unsigned __int128>(gen()) *
+                              static_cast<unsigned __int128>(range);
+  uint64_t low = static_cast<uint64_t>(product);
+  if (low < range) {
+    uint64_t threshold = -range % range;
+    while (low < threshold) {
+      product = static_cast<unsigned __int128>(gen()) *
+                static_cast<unsigned __int128>(range);
+      low = static_cast<uint64_t>(product);
+    }
+  }
+  return static_cast<uint64_t>(product >> 64);
+}
+
+// Uniform double in (0, 1): never 0, so its logarithm is finite.
+template <typename URBG>
+double uniformOpen(URBG& gen) {
+  return (static_cast<double>(gen() >> 11) + 0.5) * 0x1.0p-53;
+}
+
+// 2. ReservoirSampler
+template <typename T, typename URBG = Xoshiro256StarStar>
+class ReservoirSampler {
+ public:
+  // With k == 0 no item is ever sampled: nextIndex() never arrives.
+  explicit ReservoirSampler(size_t k, uint64_t seed = 1) : mK(k), mGen(seed) {
+    mReservoir.reserve(k);
+    if (k == 0) mNext = std::numeric_limits<uint64_t>::max();
+  }
+
+  // Position (0-based) of the next stream item that will enter the sample.
+  // Items before it can be skipped without being read.
+  uint64_t nextIndex() const { return mSeen < mK ? mSeen : mNext; }
+  uint64_t seen() const { return mSeen; }
+
+  // Offers the item at position seen(). Returns true if it was sampled.
+  bool offer(const T& item) {
+    uint64_t index = mSeen++;
+    if (index < mK) {
+      mReservoir.push_back(item);
+      if (mReservoir.size() == mK) {
+        mW = std::exp(std::log(uniformOpen(mGen)) / mK);
+        advance();
+      }
+      return true;
+    }
+    if (index != mNext) return false;
+    mReservoir[boundedRandom(mGen, mK)] = item;
+    mW *= std::exp(std::log(uniformOpen(mGen)) / mK);
+    advance();
+    return true;
+  }
+
+  // Tells the sampler that count items were skipped unread. count must not
+  // pass nextIndex().
+  void skip(uint64_t count) { mSeen += count; }
+
+  // Samples a whole range. Random access iterators jump straight to the
+  // next sampled item.
+  template <typename InputIt>
+  void offerAll(InputIt first, InputIt last) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                    Category>) {
+      while (first != last) {
+        if (mSeen >= mK) {
+          uint64_t gap = std::min<uint64_t>(mNext - mSeen, last - first);
+          first += gap;
+          skip(gap);
+          if (first == last) break;
+        }
+        offer(*first++);
+      }
+    } else {
+      for (; first != last; ++first) offer(*first);
+    }
+  }
+
+  const std::vector<T>& sample() const { return mReservoir; }
+
+ private:
+  void advance() {
+    double skipLength =
+        std::floor(std::log(uniformOpen(mGen)) / std::log1p(-mW));
+    mNext = mSeen + static_cast<uint64_t>(
+                        std::min(skipLength, 9.0e18));  // guard against inf
+  }
+
+  size_t mK;
+  URBG mGen;
+  std::vector<T> mReservoir;
+  uint64_t mSeen{0};
+  uint64_t mNext{0};
+  double mW{0};
+};
+
+// 3. WeightedReservoirSampler
+// Every item gets the key u^(1 / weight) and the k largest keys win, so an
+// item's chance to be picked is proportional to its weight. Keys are kept
+// as logarithms for numerical stability; after the reservoir fills, an
+// exponential jump decides how much weight to skip before the next entry.
+template <typename T, typename URBG = Xoshiro256StarStar>
+class WeightedReservoirSampler {
+ public:
+  explicit WeightedReservoirSampler(size_t k, uint64_t seed = 1)
+      : mK(k), mGen(seed) {}
+
+  void offer(const T& item, double weight) {
+    if (weight <= 0 || mK == 0) return;
+    if (mHeap.size() < mK) {
+      mHeap.push({std::log(uniformOpen(mGen)) / weight, item});
+      if (mHeap.size() == mK) drawJump();
+      return;
+    }
+    mSkippedWeight += weight;
+    if (mSkippedWeight < mJump) return;
+
+    // This item enters: its key is drawn from (threshold, 1].
+    double logThreshold = mHeap.top().first;
+    double thresholdPower = std::exp(logThreshold * weight);  // t^weight
+    double r = thresholdPower + (1 - thresholdPower) * uniformOpen(mGen);
+    mHeap.pop();
+    mHeap.push({std::log(r) / weight, item});
+    drawJump();
+  }
+
+  std::vector<T> sample() const {
+    auto heap = mHeap;
+    std::vector<T> result;
+    for (; !heap.empty(); heap.pop()) result.push_back(heap.top().second);
+    return result;
+  }
+
+ private:
+  void drawJump() {
+    mSkippedWeight = 0;
+    mJump = std::log(uniformOpen(mGen)) / mHeap.top().first;
+  }
+
+  using Entry = std::pair<double, T>;  // (log key, item)
+  struct Greater {
+    bool operator()(const Entry& a, const Entry& b) const {
+      return a.first > b.first;
+    }
+  };
+
+  size_t mK;
+  URBG mGen;
+  std::priority_queue<Entry, std::vector<Entry>, Greater> mHeap;
+  double mSkippedWeight{0};
+  double mJump{0};
+};
+
+// 4.1. fisherYates()
+template <typename RandomIt, typename URBG>
+void fisherYates(RandomIt first, RandomIt last, URBG& gen) {
+  uint64_t size = static_cast<uint64_t>(last - first);
+  for (uint64_t i = size; i > 1; --i) {
+    std::iter_swap(first + (i - 1), first + boundedRandom(gen, i));
+  }
+}
+
+// 4.2. parallelMergeShuffle()
+// Merges the shuffled ranges [first, middle) and [middle, last) into one
+// shuffled range: a coin decides whether the next slot takes an element of
+// the second range; when either range runs out, the rest is inserted at
+// random positions.
+template <typename RandomIt, typename URBG>
+void mergeShuffled(RandomIt first, RandomIt middle, RandomIt last, URBG& gen) {
+  RandomIt u = first, v = middle;
+  uint64_t bits = 0;
+  int bitsLeft = 0;
+  while (true) {
+    if (bitsLeft == 0) {
+      bits = gen();
+      bitsLeft = 64;
+    }
+    bool coin = bits & 1;
+    bits >>= 1;
+    --bitsLeft;
+    if (coin) {
+      if (v == last) break;
+      std::iter_swap(u, v++);
+    } else if (u == v) {
+      break;
+    }
+    ++u;
+  }
+  for (; u < last; ++u) {
+    std::iter_swap(first + boundedRandom(gen, (u - first) + 1), u);
+  }
+}
+
+template <typename RandomIt>
+void parallelMergeShuffle(size_t numThreads, RandomIt first, RandomIt last,
+                          uint64_t seed) {
+  size_t size = static_cast<size_t>(last - first);
+  // A power of two number of blocks, at least one per thread.
+  size_t numBlocks = 1;
+  while (numBlocks < numThreads * 4 && size / (numBlocks * 2) >= 4096) {
+    numBlocks *= 2;
+  }
+
+  Xoshiro256StarStar base(seed);
+  std::vector<Xoshiro256StarStar> generators;
+  for (size_t b = 0; b < numBlocks; ++b) {
+    generators.push_back(base);
+    base.jump();
+  }
+  auto bound = [&](size_t b) { return first + size * b / numBlocks; };
+
+  // Runs task(i) for i in [0, count) on up to numThreads threads.
+  auto runParallel = [&](size_t count, auto task) {
+    size_t threadsToUse = std::min(numThreads, count);
+    std::vector<std::thread> threads;
+    auto worker = [&](size_t t) {
+      for (size_t i = t; i < count; i += threadsToUse) task(i);
+    };
+    for (size_t t = 1; t < threadsToUse; ++t) threads.emplace_back(worker, t);
+    worker(0);
+    for (auto& thread : threads) thread.join();
+  };
+
+  runParallel(numBlocks, [&](size_t b) {
+    fisherYates(bound(b), bound(b + 1), generators[b]);
+  });
+  for (size_t width = 1; width < numBlocks; width *= 2) {
+    runParallel(numBlocks / (2 * width), [&](size_t pair) {
+      size_t b = pair * 2 * width;
+      mergeShuffled(bound(b), bound(b + width), bound(b + 2 * width),
+                    generators[b]);
+    });
+  }
+}
+
+// 5. Examples and benchmark
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void randomizationAlgorithms() {
+  std::vector<int> vec{1, 2, 3, 4, 5};
+
+  std::cout << "5.1. Using std::shuffle() with Xoshiro256StarStar" << std::endl;
+  printVector("Initial vector", vec);
+  Xoshiro256StarStar gen(42);
+  std::shuffle(vec.begin(), vec.end(), gen);
+  printVector("Modified vector", vec);
+
+  std::cout << std::endl
+            << "5.2. Using ReservoirSampler to pick 3 of 1000000 streamed "
+               "numbers"
+            << std::endl;
+  ReservoirSampler<int> sampler(3, 42);
+  for (int i = 0; i < 1'000'000; ++i) sampler.offer(i);
+  printVector("Sample", sampler.sample());
+
+  std::cout << std::endl
+            << "5.3. Using ReservoirSampler::offerAll() to jump through a "
+               "vector of 1000000 numbers"
+            << std::endl;
+  std::vector<int> numbers(1'000'000);
+  std::iota(numbers.begin(), numbers.end(), 0);
+  ReservoirSampler<int> jumping(3, 42);
+  jumping.offerAll(numbers.begin(), numbers.end());
+  printVector("Sample", jumping.sample());
+
+  std::cout << std::endl
+            << "5.4. Using WeightedReservoirSampler where item i has weight i"
+            << std::endl;
+  WeightedReservoirSampler<int> weighted(3, 42);
+  for (int i = 1; i <= 100; ++i) weighted.offer(i, i);
+  printVector("Sample", weighted.sample());
+}
+
+// Every permutation of 4 elements should appear about equally often when two
+// shuffled halves are merged, and every 2-subset equally often in a sample.
+void checkUniformity() {
+  constexpr int trials = 240'000;
+  std::map<std::vector<int>, int> reservoirCounts, shuffleCounts;
+  for (int t = 0; t < trials; ++t) {
+    std::vector<int> vec{0, 1, 2, 3};
+    Xoshiro256StarStar gen(t + 1);
+    fisherYates(vec.begin(), vec.begin() + 2, gen);
+    fisherYates(vec.begin() + 2, vec.end(), gen);
+    mergeShuffled(vec.begin(), vec.begin() + 2, vec.end(), gen);
+    ++shuffleCounts[vec];
+
+    ReservoirSampler<int> sampler(2, t + 1);
+    for (int i = 0; i < 4; ++i) sampler.offer(i);
+    std::vector<int> sample = sampler.sample();
+    std::sort(sample.begin(), sample.end());
+    ++reservoirCounts[sample];
+  }
+  auto chiSquare = [](const std::map<std::vector<int>, int>& counts,
+                      double expected) {
+    double sum = 0;
+    for (const auto& [key, count] : counts) {
+      sum += (count - expected) * (count - expected) / expected;
+    }
+    return sum;
+  };
+  std::cout << "MergeShuffle: " << shuffleCounts.size()
+            << " permutations, chi-square "
+            << chiSquare(shuffleCounts, trials / 24.0) << " (23 dof)"
+            << std::endl;
+  std::cout << "Reservoir:    " << reservoirCounts.size()
+            << " subsets, chi-square "
+            << chiSquare(reservoirCounts, trials / 6.0) << " (5 dof)"
+            << std::endl;
+}
+
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 10'000'000;
+  size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> vec(size);
+  std::iota(vec.begin(), vec.end(), 0);
+  std::cout << "Shuffling " << size << " ints, threads: " << numThreads
+            << std::endl;
+
+  std::mt19937 mt(42);
+  std::cout << "std::shuffle + std::mt19937:      "
+            << measureMilliseconds(
+                   [&] { std::shuffle(vec.begin(), vec.end(), mt); })
+            << " ms" << std::endl;
+  Xoshiro256StarStar xoshiro(42);
+  std::cout << "std::shuffle + Xoshiro256**:      "
+            << measureMilliseconds(
+                   [&] { std::shuffle(vec.begin(), vec.end(), xoshiro); })
+            << " ms" << std::endl;
+  Pcg32 pcg(42);
+  std::cout << "std::shuffle + Pcg32:             "
+            << measureMilliseconds(
+                   [&] { std::shuffle(vec.begin(), vec.end(), pcg); })
+            << " ms" << std::endl;
+  std::cout << "fisherYates + Xoshiro256**:       "
+            << measureMilliseconds(
+                   [&] { fisherYates(vec.begin(), vec.end(), xoshiro); })
+            << " ms" << std::endl;
+  std::cout << "parallelMergeShuffle:             "
+            << measureMilliseconds([&] {
+                 parallelMergeShuffle(numThreads, vec.begin(), vec.end(), 42);
+               })
+            << " ms" << std::endl;
+  std::sort(vec.begin(), vec.end());
+  bool isPermutation = true;
+  for (size_t i = 0; i < size; ++i) isPermutation &= vec[i] == int(i);
+  std::cout << "Still a permutation: " << std::boolalpha << isPermutation
+            << std::endl;
+
+  constexpr uint64_t streamSize = 100'000'000;
+  constexpr size_t k = 100;
+  std::cout << std::endl
+            << "Sampling " << k << " of " << streamSize << " streamed items"
+            << std::endl;
+  std::vector<uint64_t> reservoirR;
+  std::cout << "Algorithm R (one random per item): "
+            << measureMilliseconds([&] {
+                 Xoshiro256StarStar gen(42);
+                 for (uint64_t i = 0; i < streamSize; ++i) {
+                   if (i < k) {
+                     reservoirR.push_back(i);
+                   } else {
+                     uint64_t j = boundedRandom(gen, i + 1);
+                     if (j < k) reservoirR[j] = i;
+                   }
+                 }
+               })
+            << " ms" << std::endl;
+  ReservoirSampler<uint64_t> sampler(k, 42);
+  std::cout << "Algorithm L (offer every item):    "
+            << measureMilliseconds([&] {
+                 for (uint64_t i = 0; i < streamSize; ++i) sampler.offer(i);
+               })
+            << " ms" << std::endl;
+  ReservoirSampler<uint64_t> skipping(k, 42);
+  std::cout << "Algorithm L (skip to nextIndex()): "
+            << measureMilliseconds([&] {
+                 while (skipping.nextIndex() < streamSize) {
+                   skipping.skip(skipping.nextIndex() - skipping.seen());
+                   skipping.offer(skipping.seen());
+                 }
+               })
+            << " ms" << std::endl;
+}
+
+int main() {
+  // Randomization algorithms
+  std::cout << "*** Randomization algorithms ***" << std::endl;
+  randomizationAlgorithms();
+
+  // Uniformity
+  std::cout << std::endl << "*** Uniformity checks ***" << std::endl;
+  checkUniformity();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,442 @@
+/* This file implements SegmentedVector<T, ChunkBits>, a sequence stored in
+ * fixed chunks of 2^ChunkBits elements. capacityManagement() in
+ * container_vector.cpp shows std::vector growing by reallocating: every
+ * element is moved, every pointer into the vector dangles, and the push_back
+ * that triggers it costs time proportional to size(). A segmented vector
+ * never moves an element. Growing allocates one more chunk, so push_back()
+ * costs the same at any size.
+ *
+ * 1. Chunk directory
+ *    Element i lives in chunk i >> ChunkBits at offset i & (chunkSize - 1).
+ *    Chunk pointers are kept in directory levels of 1, 2, 4, 8, ... slots.
+ *    A new level is added next to the old ones instead of replacing them,
+ *    so the directory is never copied either, and readers never see a
+ *    pointer move.
+ * 2. SegmentedVector<T, ChunkBits>
+ *    2.1. Indexing, random-access iterators
+ *    2.2. push_back() / emplace_back() for one thread
+ *    2.3. concurrent_push_back(): producers claim an index with one atomic
+ *         fetch_add and construct their element in place
+ *    2.4. forEachChunk(): contiguous spans for vectorized kernels
+ * 3. Examples mirroring capacityManagement()
+ * 4. Benchmark: worst-case push_back latency, concurrent append, chunked
+ *    scan
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native -pthread segmented_vector.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 2. SegmentedVector<T, ChunkBits>
+template <typename T, size_t ChunkBits = 10>
+class SegmentedVector {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using reference = T&;
+  using const_reference = const T&;
+
+  static constexpr size_t chunkSize = size_t{1} << ChunkBits;
+  static constexpr size_t chunkMask = chunkSize - 1;
+  // Chunks start on a cache line so vector loads inside a chunk never split
+  // across two lines more than necessary.
+  static constexpr size_t chunkAlignment = std::max(alignof(T), size_t{64});
+
+  SegmentedVector() = default;
+
+  SegmentedVector(std::initializer_list<T> init) {
+    for (const T& value : init) push_back(value);
+  }
+
+  SegmentedVector(const SegmentedVector&) = delete;
+  SegmentedVector& operator=(const SegmentedVector&) = delete;
+
+  ~SegmentedVector() {
+    clear();
+    for (size_t level = 0; level < maxLevels; ++level) {
+      T** slots = mLevels[level].load(std::memory_order_relaxed);
+      if (!slots) continue;
+      for (size_t i = 0; i < (size_t{1} << level); ++i) {
+        if (slots[i])
+          ::operator delete(slots[i], std::align_val_t(chunkAlignment));
+      }
+      std::free(slots);
+    }
+  }
+
+  // 2.1. Indexing
+  // Elements claimed by concurrent_push_back() count from the moment they
+  // are claimed; read them only after synchronizing with their producers.
+  size_t size() const { return mSize.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  size_t numChunks() const { return (size() + chunkMask) >> ChunkBits; }
+
+  T& operator[](size_t index) {
+    return chunk(index >> ChunkBits)[index & chunkMask];
+  }
+  const T& operator[](size_t index) const {
+    return chunk(index >> ChunkBits)[index & chunkMask];
+  }
+  T& at(size_t index) {
+    if (index >= size()) throw std::out_of_range("SegmentedVector::at");
+    return (*this)[index];
+  }
+  const T& at(size_t index) const {
+    if (index >= size()) throw std::out_of_range("SegmentedVector::at");
+    return (*this)[index];
+  }
+  T& front() { return (*this)[0]; }
+  const T& front() const { return (*this)[0]; }
+  T& back() { return (*this)[size() - 1]; }
+  const T& back() const { return (*this)[size() - 1]; }
+
+  template <bool Const>
+  class Iterator {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+    using Container =
+        std::conditional_t<Const, const SegmentedVector, SegmentedVector>;
+
+    Iterator() = default;
+    Iterator(Container* vec, size_t index) : mVec(vec), mIndex(index) {}
+    operator Iterator<true>() const { return {mVec, mIndex}; }
+
+    reference operator*() const { return (*mVec)[mIndex]; }
+    pointer operator->() const { return &(*mVec)[mIndex]; }
+    reference operator[](difference_type n) const {
+      return (*mVec)[mIndex + n];
+    }
+
+    Iterator& operator++() { ++mIndex; return *this; }
+    Iterator& operator--() { --mIndex; return *this; }
+    Iterator operator++(int) { Iterator old = *this; ++mIndex; return old; }
+    Iterator operator--(int) { Iterator old = *this; --mIndex; return old; }
+    Iterator& operator+=(difference_type n) { mIndex += n; return *this; }
+    Iterator& operator-=(difference_type n) { mIndex -= n; return *this; }
+    Iterator operator+(difference_type n) const { return {mVec, mIndex + n}; }
+    Iterator operator-(difference_type n) const { return {mVec, mIndex - n}; }
+    friend Iterator operator+(difference_type n, const Iterator& it) {
+      return it + n;
+    }
+    difference_type operator-(const Iterator& other) const {
+      return static_cast<difference_type>(mIndex) -
+             static_cast<difference_type>(other.mIndex);
+    }
+    bool operator==(const Iterator& other) const {
+      return mIndex == other.mIndex;
+    }
+    auto operator<=>(const Iterator& other) const {
+      return mIndex <=> other.mIndex;
+    }
+
+   private:
+    Container* mVec = nullptr;
+    size_t mIndex = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  iterator begin() { return {this, 0}; }
+  iterator end() { return {this, size()}; }
+  const_iterator begin() const { return {this, 0}; }
+  const_iterator end() const { return {this, size()}; }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  // 2.2. Single-threaded appends
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    size_t index = mSize.load(std::memory_order_relaxed);
+    T* slot = ensureChunk(index >> ChunkBits) + (index & chunkMask);
+    ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    mSize.store(index + 1, std::memory_order_release);
+    return *slot;
+  }
+
+  // Keeps the chunk for later appends.
+  void pop_back() {
+    size_t index = mSize.load(std::memory_order_relaxed) - 1;
+    (*this)[index].~T();
+    mSize.store(index, std::memory_order_release);
+  }
+
+  void clear() {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      forEachChunk(
+          [](T* values, size_t count) { std::destroy_n(values, count); });
+    }
+    mSize.store(0, std::memory_order_release);
+  }
+
+  // 2.3. concurrent_push_back()
+  // Safe to call from any number of threads at once, but not together with
+  // push_back(), pop_back() or clear(). Returns the element's index. The
+  // constructor must not throw: a claimed slot cannot be given back, so an
+  // exception terminates the program.
+  template <typename... Args>
+  size_t concurrent_emplace_back(Args&&... args) noexcept {
+    size_t index = mSize.fetch_add(1, std::memory_order_acq_rel);
+    T* slot = ensureChunk(index >> ChunkBits) + (index & chunkMask);
+    ::new (static_cast<void*>(slot)) T(std::forward<Args>(args)...);
+    return index;
+  }
+
+  size_t concurrent_push_back(const T& value) noexcept {
+    return concurrent_emplace_back(value);
+  }
+
+  // 2.4. forEachChunk()
+  // Calls f(pointer, count) once per chunk; every span is contiguous.
+  template <typename Function>
+  void forEachChunk(Function f) {
+    const size_t n = size();
+    for (size_t first = 0; first < n; first += chunkSize)
+      f(chunk(first >> ChunkBits), std::min(chunkSize, n - first));
+  }
+
+  template <typename Function>
+  void forEachChunk(Function f) const {
+    const size_t n = size();
+    for (size_t first = 0; first < n; first += chunkSize)
+      f(static_cast<const T*>(chunk(first >> ChunkBits)),
+        std::min(chunkSize, n - first));
+  }
+
+ private:
+  // 1. Chunk directory
+  // Level L holds the 2^L pointers of chunks 2^L - 1 .. 2^(L+1) - 2.
+  static constexpr size_t maxLevels = 64 - ChunkBits;
+
+  static size_t levelOf(size_t chunkIndex) {
+    return static_cast<size_t>(std::bit_width(chunkIndex + 1)) - 1;
+  }
+
+  T** slotOf(size_t chunkIndex) const {
+    size_t level = levelOf(chunkIndex);
+    T** slots = mLevels[level].load(std::memory_order_acquire);
+    return slots ? slots + (chunkIndex + 1 - (size_t{1} << level)) : nullptr;
+  }
+
+  // Only valid for chunks that hold elements, so no null checks.
+  T* chunk(size_t chunkIndex) const {
+    return std::atomic_ref<T*>(*slotOf(chunkIndex))
+        .load(std::memory_order_acquire);
+  }
+
+  // Lock-free when the chunk exists; otherwise allocates it (and its
+  // directory level) under mGrowMutex.
+  T* ensureChunk(size_t chunkIndex) {
+    if (T** slot = slotOf(chunkIndex)) {
+      if (T* existing =
+              std::atomic_ref<T*>(*slot).load(std::memory_order_acquire))
+        return existing;
+    }
+    std::lock_guard<std::mutex> lock(mGrowMutex);
+    size_t level = levelOf(chunkIndex);
+    T** slots = mLevels[level].load(std::memory_order_relaxed);
+    if (!slots) {
+      // calloc() hands out zeroed pages without touching them, so even a
+      // level with millions of slots costs no time proportional to its size.
+      slots = static_cast<T**>(std::calloc(size_t{1} << level, sizeof(T*)));
+      if (!slots) throw std::bad_alloc();
+      mLevels[level].store(slots, std::memory_order_release);
+    }
+    std::atomic_ref<T*> slot(slots[chunkIndex + 1 - (size_t{1} << level)]);
+    T* existing = slot.load(std::memory_order_relaxed);
+    if (existing) return existing;
+    T* fresh = static_cast<T*>(::operator new(
+        chunkSize * sizeof(T), std::align_val_t(chunkAlignment)));
+    slot.store(fresh, std::memory_order_release);
+    return fresh;
+  }
+
+  std::array<std::atomic<T**>, maxLevels> mLevels{};
+  std::atomic<size_t> mSize{0};
+  std::mutex mGrowMutex;
+};
+
+// 3. Examples
+template <typename Vector>
+void printVector(const std::string& vectorName, const Vector& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void capacityManagement() {
+  // 3.1. Stable references
+  std::cout << "3.1. References survive growth" << std::endl;
+  std::vector<int> vec{1, 2, 3, 4, 5};
+  SegmentedVector<int, 2> segmented{1, 2, 3, 4, 5};
+  const int* vecFirst = &vec[0];
+  const int* segmentedFirst = &segmented[0];
+  for (int i = 6; i <= 20; ++i) {
+    vec.push_back(i);
+    segmented.push_back(i);
+  }
+  printVector("Segmented vector", segmented);
+  std::cout << "std::vector moved its first element: " << std::boolalpha
+            << (vecFirst != &vec[0]) << std::endl;
+  std::cout << "SegmentedVector moved its first element: "
+            << (segmentedFirst != &segmented[0]) << std::endl;
+
+  // 3.2. Chunks
+  std::cout << std::endl
+            << "3.2. forEachChunk() with 4-element chunks" << std::endl;
+  segmented.forEachChunk([](const int* values, size_t count) {
+    std::cout << "[";
+    for (size_t i = 0; i < count; ++i)
+      std::cout << values[i] << (i + 1 < count ? ", " : "");
+    std::cout << "] ";
+  });
+  std::cout << std::endl;
+
+  // 3.3. std algorithms through the iterators
+  std::cout << std::endl
+            << "3.3. Using std::sort() with std::greater<>() and "
+               "std::accumulate()"
+            << std::endl;
+  std::sort(segmented.begin(), segmented.end(), std::greater<>());
+  printVector("Sorted vector", segmented);
+  std::cout << "Sum: "
+            << std::accumulate(segmented.begin(), segmented.end(), 0)
+            << std::endl;
+}
+
+// 4. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Total time, slowest single push_back and the number of push_backs slower
+// than 100 us. Single outliers also come from the scheduler; reallocation
+// shows up as a series of them that grows with the size.
+struct PushBackLatency {
+  double totalMilliseconds = 0.0;
+  double worstMicroseconds = 0.0;
+  size_t slowPushes = 0;
+};
+
+template <typename Vector>
+PushBackLatency measurePushBack(Vector& vec, size_t count) {
+  PushBackLatency latency;
+  latency.totalMilliseconds = measureMilliseconds([&] {
+    for (size_t i = 0; i < count; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      vec.push_back(static_cast<int>(i));
+      auto stop = std::chrono::steady_clock::now();
+      double us = std::chrono::duration<double, std::micro>(stop - start)
+                      .count();
+      latency.worstMicroseconds = std::max(latency.worstMicroseconds, us);
+      latency.slowPushes += us > 100.0;
+    }
+  });
+  return latency;
+}
+
+void printLatency(const std::string& name, const PushBackLatency& latency) {
+  std::cout << "  " << name << "total " << latency.totalMilliseconds
+            << " ms, worst " << latency.worstMicroseconds << " us, "
+            << latency.slowPushes << " pushes over 100 us" << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 25;
+
+  // Worst case latency
+  std::vector<int> vec;
+  SegmentedVector<int> segmented;
+  PushBackLatency vecLatency = measurePushBack(vec, size);
+  PushBackLatency segmentedLatency = measurePushBack(segmented, size);
+  std::cout << "push_back x " << size << " (timed one by one)" << std::endl;
+  printLatency("std::vector:     ", vecLatency);
+  printLatency("SegmentedVector: ", segmentedLatency);
+
+  // Scans: operator[] has to find the chunk per element, forEachChunk()
+  // hands out contiguous spans the compiler vectorizes.
+  long long vecSum = 0, indexSum = 0, chunkSum = 0;
+  double tVec = measureMilliseconds(
+      [&] { vecSum = std::accumulate(vec.begin(), vec.end(), 0LL); });
+  double tIndex = measureMilliseconds([&] {
+    for (size_t i = 0; i < segmented.size(); ++i) indexSum += segmented[i];
+  });
+  double tChunk = measureMilliseconds([&] {
+    segmented.forEachChunk([&](const int* values, size_t count) {
+      chunkSum = std::accumulate(values, values + count, chunkSum);
+    });
+  });
+  std::cout << "Sum: std::vector " << tVec << " ms, operator[] " << tIndex
+            << " ms, forEachChunk() " << tChunk << " ms, same: "
+            << std::boolalpha << (vecSum == indexSum && vecSum == chunkSum)
+            << std::endl;
+
+  // Concurrent producers
+  size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+  size_t producers = std::max<size_t>(numThreads, 4);
+  SegmentedVector<int> shared;
+  double tConcurrent = measureMilliseconds([&] {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < producers; ++t) {
+      threads.emplace_back([&, t] {
+        for (size_t i = t; i < size; i += producers)
+          shared.concurrent_push_back(static_cast<int>(i));
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+  });
+  long long sharedSum = 0;
+  shared.forEachChunk([&](const int* values, size_t count) {
+    sharedSum = std::accumulate(values, values + count, sharedSum);
+  });
+  std::cout << producers << " producers (" << numThreads
+            << " hardware threads): " << tConcurrent << " ms, all "
+            << shared.size() << " elements present: "
+            << (sharedSum == vecSum) << std::endl;
+}
+
+int main() {
+  // Capacity management
+  std::cout << "*** SegmentedVector ***" << std::endl;
+  capacityManagement();
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,534 @@
+/* This file implements vectorized versions of the std::equal(),
+ * std::lexicographical_compare(), std::mismatch(), std::all_of(),
+ * std::any_of() and std::none_of() calls of comparingAndCheckingAlgorithms()
+ * in container_vector.cpp, for contiguous arrays of integers. The main use
+ * is diffing large snapshots, where the answer is usually "equal" and every
+ * byte has to be read.
+ *
+ * 1. mismatchBytes(): the kernel behind all comparisons. Integers have no
+ *    padding and equal integers have equal bytes, so the first differing
+ *    element is the one holding the first differing byte. Four registers
+ *    are compared per iteration and checked with a single test; only when
+ *    that test fails is the exact lane found with movemask (AVX2) or a
+ *    compare mask (AVX-512) and a trailing zero count.
+ * 2. Typed wrappers: mismatchSimd(), equalSimd() and
+ *    lexicographicalCompareSimd(), which decides on the first mismatch.
+ * 3. Predicate scans: anyOfSimd(), allOfSimd() and noneOfSimd() test blocks
+ *    of 64 ints with the SIMD-friendly predicates of stream_compaction.cpp
+ *    and exit after the first block that decides the answer. Plain lambdas
+ *    fall back to the std algorithms.
+ * 4. Examples mirroring comparingAndCheckingAlgorithms()
+ * 5. Benchmark: identical snapshots, 256 MiB and in cache, against
+ *    std::equal(), memcmp(), std::mismatch() and friends
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native simd_compare.cpp
+ */
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// 1. mismatchBytes()
+// Returns the index of the first byte where a and b differ, or size.
+inline size_t mismatchBytes(const void* a, const void* b, size_t size) {
+  const auto* p = static_cast<const unsigned char*>(a);
+  const auto* q = static_cast<const unsigned char*>(b);
+  size_t i = 0;
+#if defined(__AVX512BW__)
+  for (; i + 256 <= size; i += 256) {
+    __mmask64 m0 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i),
+                                           _mm512_loadu_si512(q + i));
+    __mmask64 m1 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i + 64),
+                                           _mm512_loadu_si512(q + i + 64));
+    __mmask64 m2 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i + 128),
+                                           _mm512_loadu_si512(q + i + 128));
+    __mmask64 m3 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i + 192),
+                                           _mm512_loadu_si512(q + i + 192));
+    if ((m0 | m1 | m2 | m3) != 0) {
+      if (m0) return i + std::countr_zero(m0);
+      if (m1) return i + 64 + std::countr_zero(m1);
+      if (m2) return i + 128 + std::countr_zero(m2);
+      return i + 192 + std::countr_zero(m3);
+    }
+  }
+  for (; i + 64 <= size; i += 64) {
+    __mmask64 m = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(p + i),
+                                          _mm512_loadu_si512(q + i));
+    if (m) return i + std::countr_zero(m);
+  }
+#elif defined(__AVX2__)
+  auto equalBytes = [&](size_t offset) {
+    return _mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + offset)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + offset)));
+  };
+  // Bit j of the result is set if byte j differs.
+  auto differing = [](__m256i equal) {
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+  };
+  for (; i + 128 <= size; i += 128) {
+    __m256i e0 = equalBytes(i), e1 = equalBytes(i + 32);
+    __m256i e2 = equalBytes(i + 64), e3 = equalBytes(i + 96);
+    __m256i all = _mm256_and_si256(_mm256_and_si256(e0, e1),
+                                   _mm256_and_si256(e2, e3));
+    if (differing(all) != 0) {
+      if (uint32_t m = differing(e0)) return i + std::countr_zero(m);
+      if (uint32_t m = differing(e1)) return i + 32 + std::countr_zero(m);
+      if (uint32_t m = differing(e2)) return i + 64 + std::countr_zero(m);
+      return i + 96 + std::countr_zero(differing(e3));
+    }
+  }
+  for (; i + 32 <= size; i += 32) {
+    if (uint32_t m = differing(equalBytes(i))) return i + std::countr_zero(m);
+  }
+#elif defined(__SSE2__)
+  for (; i + 16 <= size; i += 16) {
+    __m128i equal = _mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i)));
+    uint32_t m = ~static_cast<uint32_t>(_mm_movemask_epi8(equal)) & 0xFFFF;
+    if (m) return i + std::countr_zero(m);
+  }
+#endif
+  // Tail, and the whole range without SIMD: eight bytes at a time.
+  for (; i + 8 <= size; i += 8) {
+    uint64_t x, y;
+    std::memcpy(&x, p + i, 8);
+    std::memcpy(&y, q + i, 8);
+    if (x != y) break;
+  }
+  for (; i < size; ++i) {
+    if (p[i] != q[i]) return i;
+  }
+  return size;
+}
+
+// 2. Typed wrappers
+// Integers, enums and pointers: equal values always have equal bytes.
+template <typename T>
+concept BytewiseComparable =
+    std::has_unique_object_representations_v<T> && std::is_scalar_v<T>;
+
+template <BytewiseComparable T>
+std::pair<const T*, const T*> mismatchSimd(const T* first1, const T* last1,
+                                           const T* first2) {
+  const size_t size = static_cast<size_t>(last1 - first1);
+  size_t index = mismatchBytes(first1, first2, size * sizeof(T)) / sizeof(T);
+  return {first1 + index, first2 + index};
+}
+
+// Stops at the end of the shorter range, like the four-iterator
+// std::mismatch().
+template <BytewiseComparable T>
+std::pair<const T*, const T*> mismatchSimd(const T* first1, const T* last1,
+                                           const T* first2, const T* last2) {
+  const size_t size = std::min(static_cast<size_t>(last1 - first1),
+                               static_cast<size_t>(last2 - first2));
+  return mismatchSimd(first1, first1 + size, first2);
+}
+
+template <BytewiseComparable T>
+bool equalSimd(const T* first1, const T* last1, const T* first2) {
+  const size_t bytes = static_cast<size_t>(last1 - first1) * sizeof(T);
+  return mismatchBytes(first1, first2, bytes) == bytes;
+}
+
+// Only the first differing elements are compared as values, so signed
+// integers order correctly even though the scan looks at bytes.
+template <BytewiseComparable T>
+bool lexicographicalCompareSimd(const T* first1, const T* last1,
+                                const T* first2, const T* last2) {
+  auto [p, q] = mismatchSimd(first1, last1, first2, last2);
+  if (p != last1 && q != last2) return *p < *q;
+  return p == last1 && q != last2;
+}
+
+template <BytewiseComparable T>
+std::pair<size_t, size_t> mismatchSimd(const std::vector<T>& a,
+                                       const std::vector<T>& b) {
+  auto [p, q] = mismatchSimd(a.data(), a.data() + a.size(), b.data(),
+                             b.data() + b.size());
+  return {static_cast<size_t>(p - a.data()), static_cast<size_t>(q - b.data())};
+}
+
+template <BytewiseComparable T>
+bool equalSimd(const std::vector<T>& a, const std::vector<T>& b) {
+  return a.size() == b.size() &&
+         equalSimd(a.data(), a.data() + a.size(), b.data());
+}
+
+template <BytewiseComparable T>
+bool lexicographicalCompareSimd(const std::vector<T>& a,
+                                const std::vector<T>& b) {
+  return lexicographicalCompareSimd(a.data(), a.data() + a.size(), b.data(),
+                                    b.data() + b.size());
+}
+
+// 3. Predicate scans
+// The same interface as the predicates of stream_compaction.cpp: a scalar
+// operator() and a test() that checks eight or sixteen ints at once.
+struct IsMultipleOf2 {
+  bool operator()(int x) const { return x % 2 == 0; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpeq_epi32(_mm256_and_si256(x, _mm256_set1_epi32(1)),
+                              _mm256_setzero_si256());
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_testn_epi32_mask(x, _mm512_set1_epi32(1));
+  }
+#endif
+};
+
+struct GreaterThan {
+  int value;
+
+  bool operator()(int x) const { return x > value; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpgt_epi32(x, _mm256_set1_epi32(value));
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmpgt_epi32_mask(x, _mm512_set1_epi32(value));
+  }
+#endif
+};
+
+struct LessThan {
+  int value;
+
+  bool operator()(int x) const { return x < value; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(value), x);
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmplt_epi32_mask(x, _mm512_set1_epi32(value));
+  }
+#endif
+};
+
+// Returns true if pred(x) == Wanted for some element. anyOf, allOf and
+// noneOf are all this scan; a block of 64 ints is tested before each exit
+// check so the loop body stays branch-free.
+template <bool Wanted, typename Predicate>
+bool containsSimd(const int* data, size_t size, Predicate pred) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  if constexpr (requires(__m512i x) { pred.test(x); }) {
+    for (; i + 64 <= size; i += 64) {
+      __mmask16 m0 = pred.test(_mm512_loadu_si512(data + i));
+      __mmask16 m1 = pred.test(_mm512_loadu_si512(data + i + 16));
+      __mmask16 m2 = pred.test(_mm512_loadu_si512(data + i + 32));
+      __mmask16 m3 = pred.test(_mm512_loadu_si512(data + i + 48));
+      if constexpr (Wanted) {
+        if ((m0 | m1 | m2 | m3) != 0) return true;
+      } else {
+        if ((m0 & m1 & m2 & m3) != 0xFFFF) return true;
+      }
+    }
+  }
+#elif defined(__AVX2__)
+  if constexpr (requires(__m256i x) { pred.test(x); }) {
+    for (; i + 64 <= size; i += 64) {
+      __m256i combined = pred.test(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+      for (size_t j = 8; j < 64; j += 8) {
+        __m256i m = pred.test(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + j)));
+        combined = Wanted ? _mm256_or_si256(combined, m)
+                          : _mm256_and_si256(combined, m);
+      }
+      if constexpr (Wanted) {
+        if (!_mm256_testz_si256(combined, combined)) return true;
+      } else {
+        if (!_mm256_testc_si256(combined, _mm256_set1_epi32(-1))) return true;
+      }
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (pred(data[i]) == Wanted) return true;
+  }
+  return false;
+}
+
+template <typename Predicate>
+bool anyOfSimd(const int* data, size_t size, Predicate pred) {
+  return containsSimd<true>(data, size, pred);
+}
+
+template <typename Predicate>
+bool allOfSimd(const int* data, size_t size, Predicate pred) {
+  return !containsSimd<false>(data, size, pred);
+}
+
+template <typename Predicate>
+bool noneOfSimd(const int* data, size_t size, Predicate pred) {
+  return !containsSimd<true>(data, size, pred);
+}
+
+template <typename Predicate>
+bool anyOfSimd(const std::vector<int>& vec, Predicate pred) {
+  return anyOfSimd(vec.data(), vec.size(), pred);
+}
+
+template <typename Predicate>
+bool allOfSimd(const std::vector<int>& vec, Predicate pred) {
+  return allOfSimd(vec.data(), vec.size(), pred);
+}
+
+template <typename Predicate>
+bool noneOfSimd(const std::vector<int>& vec, Predicate pred) {
+  return noneOfSimd(vec.data(), vec.size(), pred);
+}
+
+// 4. Examples
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void comparingExamples() {
+  std::vector<int> vec1{1, 2, 3, 4, 5};
+  std::vector<int> vec2{1, 2, 3, 4};
+  std::vector<int> vec3{1, 2, -3, 4, 5};
+
+  // 4.1. equalSimd()
+  std::cout << "4.1. Using equalSimd() to check if two ranges are equal"
+            << std::endl;
+  printVector("First vector", vec1);
+  printVector("Second vector", vec2);
+  std::cout << "Result: " << std::boolalpha << equalSimd(vec1, vec2)
+            << std::endl;
+
+  // 4.2. lexicographicalCompareSimd()
+  std::cout << std::endl
+            << "4.2. Using lexicographicalCompareSimd() to check if one range "
+               "is lexicographically less than another"
+            << std::endl;
+  printVector("First vector", vec1);
+  printVector("Second vector", vec3);
+  std::cout << "Result: " << std::boolalpha
+            << lexicographicalCompareSimd(vec1, vec3) << std::endl;
+
+  // 4.3. mismatchSimd()
+  std::cout << std::endl
+            << "4.3. Using mismatchSimd() to find the first position where "
+               "two ranges differ"
+            << std::endl;
+  printVector("First vector", vec1);
+  printVector("Second vector", vec3);
+  auto [pos1, pos2] = mismatchSimd(vec1, vec3);
+  std::cout << "First vector differs at position: " << pos1 + 1
+            << " with value: " << vec1[pos1] << std::endl;
+  std::cout << "Second vector differs at position: " << pos2 + 1
+            << " with value: " << vec3[pos2] << std::endl;
+
+  // 4.4. allOfSimd(), anyOfSimd() and noneOfSimd()
+  std::cout << std::endl
+            << "4.4. Using allOfSimd(), anyOfSimd() and noneOfSimd() with the "
+               "x % 2 == 0 condition"
+            << std::endl;
+  printVector("Vector", vec1);
+  std::cout << "all_of: " << allOfSimd(vec1, IsMultipleOf2{})
+            << ", any_of: " << anyOfSimd(vec1, IsMultipleOf2{})
+            << ", none_of: " << noneOfSimd(vec1, IsMultipleOf2{})
+            << std::endl;
+}
+
+template <typename T>
+bool checkType(std::mt19937& gen) {
+  bool ok = true;
+  for (size_t size : {0u, 1u, 7u, 63u, 64u, 65u, 257u, 1000u, 4099u}) {
+    std::vector<T> a(size);
+    for (T& x : a) x = static_cast<T>(gen());
+    // One difference at every position, then none.
+    for (size_t diff = 0; diff <= size; ++diff) {
+      std::vector<T> b = a;
+      if (diff < size) b[diff] = static_cast<T>(b[diff] ^ 0x40);
+      auto [p, q] = mismatchSimd(a.data(), a.data() + size, b.data());
+      auto [sp, sq] = std::mismatch(a.data(), a.data() + size, b.data());
+      ok = ok && p == sp && q == sq;
+      ok = ok && equalSimd(a, b) == (a == b);
+      ok = ok && lexicographicalCompareSimd(a, b) == (a < b) &&
+           lexicographicalCompareSimd(b, a) == (b < a);
+    }
+    std::vector<T> shorter = a;
+    shorter.resize(size / 2);
+    ok = ok && lexicographicalCompareSimd(shorter, a) == (shorter < a) &&
+         lexicographicalCompareSimd(a, shorter) == (a < shorter);
+  }
+  return ok;
+}
+
+bool checkPredicates(std::mt19937& gen) {
+  bool ok = true;
+  for (size_t size : {0u, 1u, 63u, 64u, 65u, 200u, 1000u}) {
+    std::vector<int> vec(size);
+    for (int threshold : {-1, 0, 500, 998, 999, 1000}) {
+      for (int& x : vec) x = static_cast<int>(gen() % 1000);
+      // Place the deciding element near the end, after the SIMD blocks.
+      if (size > 0 && threshold == 998) vec[size - 1] = 999;
+      GreaterThan pred{threshold};
+      auto scalar = [&](int x) { return x > threshold; };
+      ok = ok &&
+           anyOfSimd(vec, pred) ==
+               std::any_of(vec.begin(), vec.end(), scalar) &&
+           allOfSimd(vec, pred) ==
+               std::all_of(vec.begin(), vec.end(), scalar) &&
+           noneOfSimd(vec, pred) ==
+               std::none_of(vec.begin(), vec.end(), scalar) &&
+           allOfSimd(vec, LessThan{threshold}) ==
+               std::all_of(vec.begin(), vec.end(),
+                           [&](int x) { return x < threshold; });
+    }
+  }
+  return ok;
+}
+
+bool checkAgainstStd() {
+  std::mt19937 gen(5);
+  return checkType<int8_t>(gen) && checkType<uint16_t>(gen) &&
+         checkType<int>(gen) && checkType<int64_t>(gen) &&
+         checkPredicates(gen);
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Best of a few runs, each repeating the call `repeats` times.
+template <typename Function>
+double bestOf(size_t repeats, Function function) {
+  double best = 0;
+  for (int run = 0; run < 3; ++run) {
+    double ms = measureMilliseconds([&] {
+      for (size_t r = 0; r < repeats; ++r) function();
+    });
+    best = run == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+void printLine(const std::string& name, double stdMs, double simdMs,
+               double bytes) {
+  std::cout << name << "std " << stdMs << " ms, SIMD " << simdMs << " ms ("
+            << bytes / simdMs / 1e6 << " GB/s, " << stdMs / simdMs << "x)"
+            << std::endl;
+}
+
+// Compares two identical snapshots of `size` ints, `repeats` times. Large
+// snapshots measure memory bandwidth, small ones the compare loops.
+void benchmarkSnapshots(size_t size, size_t repeats) {
+  const double bytes = 2.0 * static_cast<double>(size * repeats * sizeof(int));
+  std::mt19937 gen(42);
+  std::vector<int> snapshot(size);
+  for (int& x : snapshot) x = static_cast<int>(gen() % 1'000'000'000);
+  std::vector<int> replica = snapshot;
+  std::cout << "Two identical snapshots of " << size << " ints ("
+            << (size * sizeof(int) >> 10) << " KiB each), compared "
+            << repeats << " times" << std::endl;
+
+  // volatile keeps the compiler from dropping the unused results.
+  volatile bool sink = false;
+  volatile size_t position = 0;
+  double stdEqual = bestOf(repeats, [&] {
+    sink = std::equal(snapshot.begin(), snapshot.end(), replica.begin());
+  });
+  double memcmpEqual = bestOf(repeats, [&] {
+    sink = std::memcmp(snapshot.data(), replica.data(),
+                       size * sizeof(int)) == 0;
+  });
+  double simdEqual =
+      bestOf(repeats, [&] { sink = equalSimd(snapshot, replica); });
+  std::cout << "equal:                   std " << stdEqual << " ms, memcmp "
+            << memcmpEqual << " ms, SIMD " << simdEqual << " ms" << std::endl;
+
+  double stdMismatch = bestOf(repeats, [&] {
+    position = static_cast<size_t>(
+        std::mismatch(snapshot.begin(), snapshot.end(), replica.begin())
+            .first -
+        snapshot.begin());
+  });
+  double simdMismatch = bestOf(
+      repeats, [&] { position = mismatchSimd(snapshot, replica).first; });
+  printLine("mismatch:                ", stdMismatch, simdMismatch, bytes);
+
+  double stdLess = bestOf(repeats, [&] {
+    sink = std::lexicographical_compare(snapshot.begin(), snapshot.end(),
+                                        replica.begin(), replica.end());
+  });
+  double simdLess = bestOf(
+      repeats, [&] { sink = lexicographicalCompareSimd(snapshot, replica); });
+  printLine("lexicographical_compare: ", stdLess, simdLess, bytes);
+
+  // Every element is below 10^9, so all of them have to be tested.
+  auto below = [](int x) { return x < 1'000'000'000; };
+  double stdAll = bestOf(repeats, [&] {
+    sink = std::all_of(snapshot.begin(), snapshot.end(), below);
+  });
+  double simdAll = bestOf(
+      repeats, [&] { sink = allOfSimd(snapshot, LessThan{1'000'000'000}); });
+  printLine("all_of:                  ", stdAll, simdAll, bytes / 2);
+
+  auto above = [](int x) { return x > 1'000'000'000; };
+  double stdAny = bestOf(repeats, [&] {
+    sink = std::any_of(snapshot.begin(), snapshot.end(), above);
+  });
+  double simdAny = bestOf(repeats, [&] {
+    sink = anyOfSimd(snapshot, GreaterThan{1'000'000'000});
+  });
+  printLine("any_of:                  ", stdAny, simdAny, bytes / 2);
+}
+
+void benchmark() {
+  benchmarkSnapshots(size_t{1} << 26, 1);
+  std::cout << std::endl;
+  benchmarkSnapshots(size_t{1} << 13, 4096);
+}
+
+int main() {
+  // Comparing
+  std::cout << "*** SIMD comparing and checking algorithms ***" << std::endl;
+  comparingExamples();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match the std algorithms: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
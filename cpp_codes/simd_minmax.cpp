@@ -0,0 +1,496 @@
+/* This file implements vectorized and multi-threaded versions of the
+ * std::min_element(), std::max_element() and std::minmax_element() calls of
+ * minMaxAlgorithms() in container_vector.cpp, for arrays of ints.
+ *
+ * libstdc++ does not vectorize these algorithms: they return an iterator,
+ * so the loop carries the position of the best element along with its
+ * value. The kernels here split the two questions:
+ *
+ * 1. Block reduction: the input is cut into blocks of 16K ints (64 KiB,
+ *    L2-sized). Only the extreme values of a block are computed, with
+ *    vpminsd/vpmaxsd over four independent registers. The first block
+ *    holding a strictly better value is remembered.
+ * 2. Location: the position is searched for only inside that one block,
+ *    with a vector compare and a trailing (or leading) zero count.
+ * 3. Single-threaded minElementSimd(), maxElementSimd() and the fused
+ *    minmaxElementSimd(), which computes both extremes in one pass.
+ * 4. parallelMinElement(), parallelMaxElement() and
+ *    parallelMinmaxElement(): every thread reduces a contiguous range of
+ *    blocks; the results are combined in thread order.
+ *
+ * Ties are resolved as in the standard library: min_element() and
+ * max_element() return the first occurrence, minmax_element() the first
+ * smallest and the last largest element.
+ *
+ * 5. Examples mirroring minMaxAlgorithms()
+ * 6. Benchmark: one large array, and many small telemetry windows
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native -pthread simd_minmax.cpp
+ */
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Number of ints per block: 64 KiB, so the location pass over the winning
+// block usually hits L2.
+constexpr size_t blockSize = 1 << 14;
+
+constexpr size_t noBlock = SIZE_MAX;
+
+size_t defaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// 1. Block reduction
+#if defined(__AVX512F__)
+// The full-mask forms of vpminsd/vpmaxsd: GCC 12 warns about the undefined
+// pass-through operand inside _mm512_min_epi32() and _mm512_max_epi32().
+inline __m512i min512(__m512i a, __m512i b) {
+  return _mm512_mask_min_epi32(a, 0xFFFF, a, b);
+}
+
+inline __m512i max512(__m512i a, __m512i b) {
+  return _mm512_mask_max_epi32(a, 0xFFFF, a, b);
+}
+#endif
+
+// Stores the smallest and/or largest value of data[0, size), size > 0.
+template <bool WantMin, bool WantMax>
+void reduceBlock(const int* data, size_t size, int& minValue, int& maxValue) {
+  int mn = INT_MAX, mx = INT_MIN;
+  size_t i = 0;
+#if defined(__AVX512F__)
+  __m512i mn0 = _mm512_set1_epi32(INT_MAX), mn1 = mn0, mn2 = mn0, mn3 = mn0;
+  __m512i mx0 = _mm512_set1_epi32(INT_MIN), mx1 = mx0, mx2 = mx0, mx3 = mx0;
+  for (; i + 64 <= size; i += 64) {
+    __m512i x0 = _mm512_loadu_si512(data + i);
+    __m512i x1 = _mm512_loadu_si512(data + i + 16);
+    __m512i x2 = _mm512_loadu_si512(data + i + 32);
+    __m512i x3 = _mm512_loadu_si512(data + i + 48);
+    if constexpr (WantMin) {
+      mn0 = min512(mn0, x0);
+      mn1 = min512(mn1, x1);
+      mn2 = min512(mn2, x2);
+      mn3 = min512(mn3, x3);
+    }
+    if constexpr (WantMax) {
+      mx0 = max512(mx0, x0);
+      mx1 = max512(mx1, x1);
+      mx2 = max512(mx2, x2);
+      mx3 = max512(mx3, x3);
+    }
+  }
+  alignas(64) int lanes[16];
+  if constexpr (WantMin) {
+    mn0 = min512(min512(mn0, mn1),
+                 min512(mn2, mn3));
+    _mm512_store_si512(lanes, mn0);
+    mn = *std::min_element(lanes, lanes + 16);
+  }
+  if constexpr (WantMax) {
+    mx0 = max512(max512(mx0, mx1),
+                 max512(mx2, mx3));
+    _mm512_store_si512(lanes, mx0);
+    mx = *std::max_element(lanes, lanes + 16);
+  }
+#elif defined(__AVX2__)
+  __m256i mn0 = _mm256_set1_epi32(INT_MAX), mn1 = mn0, mn2 = mn0, mn3 = mn0;
+  __m256i mx0 = _mm256_set1_epi32(INT_MIN), mx1 = mx0, mx2 = mx0, mx3 = mx0;
+  auto load = [&](size_t offset) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+  };
+  for (; i + 32 <= size; i += 32) {
+    __m256i x0 = load(i), x1 = load(i + 8);
+    __m256i x2 = load(i + 16), x3 = load(i + 24);
+    if constexpr (WantMin) {
+      mn0 = _mm256_min_epi32(mn0, x0);
+      mn1 = _mm256_min_epi32(mn1, x1);
+      mn2 = _mm256_min_epi32(mn2, x2);
+      mn3 = _mm256_min_epi32(mn3, x3);
+    }
+    if constexpr (WantMax) {
+      mx0 = _mm256_max_epi32(mx0, x0);
+      mx1 = _mm256_max_epi32(mx1, x1);
+      mx2 = _mm256_max_epi32(mx2, x2);
+      mx3 = _mm256_max_epi32(mx3, x3);
+    }
+  }
+  alignas(32) int lanes[8];
+  if constexpr (WantMin) {
+    mn0 = _mm256_min_epi32(_mm256_min_epi32(mn0, mn1),
+                           _mm256_min_epi32(mn2, mn3));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), mn0);
+    mn = *std::min_element(lanes, lanes + 8);
+  }
+  if constexpr (WantMax) {
+    mx0 = _mm256_max_epi32(_mm256_max_epi32(mx0, mx1),
+                           _mm256_max_epi32(mx2, mx3));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), mx0);
+    mx = *std::max_element(lanes, lanes + 8);
+  }
+#endif
+  for (; i < size; ++i) {
+    if constexpr (WantMin) mn = std::min(mn, data[i]);
+    if constexpr (WantMax) mx = std::max(mx, data[i]);
+  }
+  minValue = mn;
+  maxValue = mx;
+}
+
+// The winning value of a range of blocks and the block it was first (or,
+// for a last-occurrence maximum, last) seen in.
+struct BlockExtremes {
+  int minValue = INT_MAX;
+  size_t minBlock = noBlock;
+  int maxValue = INT_MIN;
+  size_t maxBlock = noBlock;
+};
+
+// Folds `other`, which covers later blocks, into `result`.
+template <bool WantMin, bool WantMax, bool LastMax>
+void combine(BlockExtremes& result, const BlockExtremes& other) {
+  if constexpr (WantMin) {
+    if (other.minBlock != noBlock &&
+        (result.minBlock == noBlock || other.minValue < result.minValue)) {
+      result.minValue = other.minValue;
+      result.minBlock = other.minBlock;
+    }
+  }
+  if constexpr (WantMax) {
+    bool better = LastMax ? other.maxValue >= result.maxValue
+                          : other.maxValue > result.maxValue;
+    if (other.maxBlock != noBlock && (result.maxBlock == noBlock || better)) {
+      result.maxValue = other.maxValue;
+      result.maxBlock = other.maxBlock;
+    }
+  }
+}
+
+template <bool WantMin, bool WantMax, bool LastMax>
+BlockExtremes reduceBlocks(const int* data, size_t size, size_t firstBlock,
+                           size_t lastBlock) {
+  BlockExtremes result;
+  for (size_t b = firstBlock; b < lastBlock; ++b) {
+    size_t begin = b * blockSize;
+    size_t count = std::min(blockSize, size - begin);
+    BlockExtremes block;
+    reduceBlock<WantMin, WantMax>(data + begin, count, block.minValue,
+                                  block.maxValue);
+    block.minBlock = block.maxBlock = b;
+    combine<WantMin, WantMax, LastMax>(result, block);
+  }
+  return result;
+}
+
+// 2. Location
+// Index of the first (or last) element of data[0, size) equal to value;
+// the value is known to be there.
+inline size_t findFirstEqual(const int* data, size_t size, int value) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  const __m512i needle = _mm512_set1_epi32(value);
+  for (; i + 16 <= size; i += 16) {
+    __mmask16 m = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(data + i), needle);
+    if (m) return i + std::countr_zero(static_cast<unsigned>(m));
+  }
+#elif defined(__AVX2__)
+  const __m256i needle = _mm256_set1_epi32(value);
+  for (; i + 8 <= size; i += 8) {
+    __m256i equal = _mm256_cmpeq_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), needle);
+    unsigned m = static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+    if (m) return i + std::countr_zero(m);
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] == value) break;
+  }
+  return i;
+}
+
+inline size_t findLastEqual(const int* data, size_t size, int value) {
+  size_t i = size;
+#if defined(__AVX512F__)
+  const __m512i needle = _mm512_set1_epi32(value);
+  for (; i >= 16; i -= 16) {
+    __mmask16 m =
+        _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(data + i - 16), needle);
+    if (m) return i - 16 + std::bit_width(static_cast<unsigned>(m)) - 1;
+  }
+#elif defined(__AVX2__)
+  const __m256i needle = _mm256_set1_epi32(value);
+  for (; i >= 8; i -= 8) {
+    __m256i equal = _mm256_cmpeq_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i - 8)),
+        needle);
+    unsigned m = static_cast<unsigned>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(equal)));
+    if (m) return i - 8 + std::bit_width(m) - 1;
+  }
+#endif
+  while (data[i - 1] != value) --i;
+  return i - 1;
+}
+
+template <bool WantMin, bool WantMax, bool LastMax>
+std::pair<const int*, const int*> locate(const int* data, size_t size,
+                                         const BlockExtremes& extremes) {
+  auto blockStart = [&](size_t b) { return data + b * blockSize; };
+  auto blockCount = [&](size_t b) {
+    return std::min(blockSize, size - b * blockSize);
+  };
+  const int* minIt = data + size;
+  const int* maxIt = data + size;
+  if constexpr (WantMin) {
+    if (extremes.minBlock != noBlock) {
+      size_t b = extremes.minBlock;
+      minIt = blockStart(b) +
+              findFirstEqual(blockStart(b), blockCount(b), extremes.minValue);
+    }
+  }
+  if constexpr (WantMax) {
+    if (extremes.maxBlock != noBlock) {
+      size_t b = extremes.maxBlock;
+      maxIt = blockStart(b) +
+              (LastMax ? findLastEqual(blockStart(b), blockCount(b),
+                                       extremes.maxValue)
+                       : findFirstEqual(blockStart(b), blockCount(b),
+                                        extremes.maxValue));
+    }
+  }
+  return {minIt, maxIt};
+}
+
+// Reduces the blocks on numThreads threads, then locates the winners.
+template <bool WantMin, bool WantMax, bool LastMax>
+std::pair<const int*, const int*> extremeElements(size_t numThreads,
+                                                  const int* first,
+                                                  const int* last) {
+  const size_t size = static_cast<size_t>(last - first);
+  const size_t numBlocks = (size + blockSize - 1) / blockSize;
+  numThreads =
+      std::clamp<size_t>(numThreads, 1, std::max<size_t>(numBlocks, 1));
+
+  std::vector<BlockExtremes> partial(numThreads);
+  auto run = [&](size_t t) {
+    partial[t] = reduceBlocks<WantMin, WantMax, LastMax>(
+        first, size, numBlocks * t / numThreads,
+        numBlocks * (t + 1) / numThreads);
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < numThreads; ++t) threads.emplace_back(run, t);
+  run(0);
+  for (auto& thread : threads) thread.join();
+
+  BlockExtremes result;
+  for (const BlockExtremes& p : partial)
+    combine<WantMin, WantMax, LastMax>(result, p);
+  return locate<WantMin, WantMax, LastMax>(first, size, result);
+}
+
+// 3. Single-threaded interface; empty ranges return last, like the std
+// algorithms.
+inline const int* minElementSimd(const int* first, const int* last) {
+  return extremeElements<true, false, false>(1, first, last).first;
+}
+
+inline const int* maxElementSimd(const int* first, const int* last) {
+  return extremeElements<false, true, false>(1, first, last).second;
+}
+
+inline std::pair<const int*, const int*> minmaxElementSimd(const int* first,
+                                                           const int* last) {
+  return extremeElements<true, true, true>(1, first, last);
+}
+
+// 4. Multi-threaded interface
+inline const int* parallelMinElement(size_t numThreads, const int* first,
+                                     const int* last) {
+  return extremeElements<true, false, false>(numThreads, first, last).first;
+}
+
+inline const int* parallelMaxElement(size_t numThreads, const int* first,
+                                     const int* last) {
+  return extremeElements<false, true, false>(numThreads, first, last).second;
+}
+
+inline std::pair<const int*, const int*> parallelMinmaxElement(
+    size_t numThreads, const int* first, const int* last) {
+  return extremeElements<true, true, true>(numThreads, first, last);
+}
+
+// 5. Examples
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void minMaxExamples() {
+  std::vector<int> vec{4, 1, 7, 3, 9, 1, 9};
+  const int* first = vec.data();
+  const int* last = vec.data() + vec.size();
+
+  // 5.1. minElementSimd()
+  std::cout << "5.1. Using minElementSimd() to find the smallest element"
+            << std::endl;
+  printVector("Vector", vec);
+  const int* minIt = minElementSimd(first, last);
+  std::cout << "Minimum element: " << *minIt << " at index " << minIt - first
+            << std::endl;
+
+  // 5.2. maxElementSimd()
+  std::cout << std::endl
+            << "5.2. Using maxElementSimd() to find the largest element"
+            << std::endl;
+  printVector("Vector", vec);
+  const int* maxIt = maxElementSimd(first, last);
+  std::cout << "Maximum element: " << *maxIt << " at index " << maxIt - first
+            << std::endl;
+
+  // 5.3. minmaxElementSimd()
+  std::cout << std::endl
+            << "5.3. Using minmaxElementSimd() to find both in one pass; like "
+               "std::minmax_element() it returns the last largest element"
+            << std::endl;
+  printVector("Vector", vec);
+  auto [minIt2, maxIt2] = minmaxElementSimd(first, last);
+  std::cout << "Minimum element: " << *minIt2 << " at index "
+            << minIt2 - first << std::endl;
+  std::cout << "Maximum element: " << *maxIt2 << " at index "
+            << maxIt2 - first << std::endl;
+}
+
+bool checkAgainstStd() {
+  std::mt19937 gen(11);
+  bool ok = true;
+  for (size_t size : {size_t{0}, size_t{1}, size_t{15}, size_t{64},
+                      size_t{1000}, blockSize, blockSize + 1,
+                      5 * blockSize + 77}) {
+    // Few distinct values, so the extremes repeat in many blocks.
+    for (int range : {1, 3, 1000}) {
+      std::vector<int> vec(size);
+      for (int& x : vec) x = static_cast<int>(gen() % range) - range / 2;
+      if (range == 1) std::fill(vec.begin(), vec.end(), INT_MAX);
+      const int* first = vec.data();
+      const int* last = vec.data() + size;
+      auto stdMinMax = std::minmax_element(first, last);
+      for (size_t threads : {1, 3}) {
+        ok = ok &&
+             parallelMinElement(threads, first, last) ==
+                 std::min_element(first, last) &&
+             parallelMaxElement(threads, first, last) ==
+                 std::max_element(first, last) &&
+             parallelMinmaxElement(threads, first, last) ==
+                 std::make_pair(stdMinMax.first, stdMinMax.second);
+      }
+    }
+  }
+  return ok;
+}
+
+// 6. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Runs every algorithm over `windows` consecutive windows of `size` ints.
+void benchmarkWindows(const std::vector<int>& data, size_t size,
+                      size_t numThreads) {
+  const size_t windows = data.size() / size;
+  // volatile keeps the compiler from dropping the unused results.
+  volatile ptrdiff_t sink = 0;
+  auto forEachWindow = [&](auto function) {
+    return measureMilliseconds([&] {
+      for (size_t w = 0; w < windows; ++w) {
+        const int* first = data.data() + w * size;
+        function(first, first + size);
+      }
+    });
+  };
+
+  double stdMin = forEachWindow([&](const int* f, const int* l) {
+    sink = std::min_element(f, l) - f;
+  });
+  double simdMin = forEachWindow([&](const int* f, const int* l) {
+    sink = minElementSimd(f, l) - f;
+  });
+  double parallelMin = forEachWindow([&](const int* f, const int* l) {
+    sink = parallelMinElement(numThreads, f, l) - f;
+  });
+  double stdMax = forEachWindow([&](const int* f, const int* l) {
+    sink = std::max_element(f, l) - f;
+  });
+  double simdMax = forEachWindow([&](const int* f, const int* l) {
+    sink = maxElementSimd(f, l) - f;
+  });
+  double stdMinMax = forEachWindow([&](const int* f, const int* l) {
+    sink = std::minmax_element(f, l).second - f;
+  });
+  double simdMinMax = forEachWindow([&](const int* f, const int* l) {
+    sink = minmaxElementSimd(f, l).second - f;
+  });
+  double parallelMinMax = forEachWindow([&](const int* f, const int* l) {
+    sink = parallelMinmaxElement(numThreads, f, l).second - f;
+  });
+
+  std::cout << windows << " windows of " << size << " ints, " << numThreads
+            << " threads" << std::endl;
+  std::cout << "min_element:    std " << stdMin << " ms, SIMD " << simdMin
+            << " ms, parallel " << parallelMin << " ms ("
+            << stdMin / simdMin << "x)" << std::endl;
+  std::cout << "max_element:    std " << stdMax << " ms, SIMD " << simdMax
+            << " ms (" << stdMax / simdMax << "x)" << std::endl;
+  std::cout << "minmax_element: std " << stdMinMax << " ms, SIMD "
+            << simdMinMax << " ms, parallel " << parallelMinMax << " ms ("
+            << stdMinMax / simdMinMax << "x)" << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = size_t{1} << 26;
+  std::mt19937 gen(42);
+  std::vector<int> data(size);
+  for (int& x : data) x = static_cast<int>(gen());
+  benchmarkWindows(data, size, defaultThreadCount());
+  std::cout << std::endl;
+  benchmarkWindows(data, 4096, 1);
+}
+
+int main() {
+  // Minimum and maximum
+  std::cout << "*** SIMD min/max algorithms ***" << std::endl;
+  minMaxExamples();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match the std algorithms: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,612 @@
+/* This file implements SmallVector<T, N>, a vector-like container that keeps
+ * its first N elements inline (inside the object itself) and only spills to
+ * the heap once it grows past N. Most short vectors therefore never touch the
+ * allocator at all. The growth strategy used once the container lives on the
+ * heap is pluggable through a policy class:
+ *
+ * 1. Growth policies (1.5x, 2x, exact)
+ * 2. Allocation counters shared by SmallVector and a counting std::allocator
+ * 3. SmallVector<T, N, GrowthPolicy>
+ * 4. Examples mirroring container_vector.cpp
+ *    4.1. Inserting and removing
+ *    4.2. Capacity managment
+ *    4.3. Growth policies
+ * 5. Benchmark: allocations per operation against std::vector
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 1. Growth policies
+// Each policy answers: given the current capacity and the minimum capacity
+// that is required, how many elements should the new buffer hold?
+struct GrowthFactor2x {
+  static size_t grow(size_t capacity, size_t required) {
+    return std::max(capacity * 2, required);
+  }
+};
+
+struct GrowthFactor1_5x {
+  static size_t grow(size_t capacity, size_t required) {
+    return std::max(capacity + capacity / 2, required);
+  }
+};
+
+struct ExactGrowth {
+  static size_t grow(size_t /*capacity*/, size_t required) { return required; }
+};
+
+// 2. Allocation counters
+struct AllocationStats {
+  size_t allocations{0};
+  size_t deallocations{0};
+  size_t bytesAllocated{0};
+
+  void reset() { *this = AllocationStats{}; }
+};
+
+AllocationStats allocationStats;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    ++allocationStats.allocations;
+    allocationStats.bytesAllocated += count * sizeof(T);
+    return std::allocator<T>{}.allocate(count);
+  }
+
+  void deallocate(T* ptr, size_t count) {
+    ++allocationStats.deallocations;
+    std::allocator<T>{}.deallocate(ptr, count);
+  }
+
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const {
+    return true;
+  }
+};
+
+// 3. SmallVector
+template <typename T, size_t N, typename GrowthPolicy = GrowthFactor2x>
+class SmallVector {
+ public:
+  using value_type = T;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // Constructors
+  SmallVector() = default;
+
+  explicit SmallVector(size_t count) { resize(count); }
+
+  SmallVector(size_t count, const T& value) { resize(count, value); }
+
+  SmallVector(std::initializer_list<T> list) {
+    assign(list.begin(), list.end());
+  }
+
+  template <typename InputIt, typename = typename std::iterator_traits<
+                                 InputIt>::iterator_category>
+  SmallVector(InputIt first, InputIt last) {
+    assign(first, last);
+  }
+
+  // Copy constructor
+  SmallVector(const SmallVector& other) { assign(other.begin(), other.end()); }
+
+  // Move constructor
+  SmallVector(SmallVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    moveFrom(std::move(other));
+  }
+
+  // Copy assignment operator
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) assign(other.begin(), other.end());
+    return *this;
+  }
+
+  // Move assignment operator
+  SmallVector& operator=(SmallVector&& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      releaseHeap();
+      moveFrom(std::move(other));
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(std::initializer_list<T> list) {
+    assign(list.begin(), list.end());
+    return *this;
+  }
+
+  // Destructor
+  ~SmallVector() {
+    clear();
+    releaseHeap();
+  }
+
+  // Accessing
+  T& operator[](size_t index) { return mData[index]; }
+  const T& operator[](size_t index) const { return mData[index]; }
+
+  T& at(size_t index) {
+    if (index >= mSize) throw std::out_of_range("SmallVector::at");
+    return mData[index];
+  }
+  const T& at(size_t index) const {
+    if (index >= mSize) throw std::out_of_range("SmallVector::at");
+    return mData[index];
+  }
+
+  T& front() { return mData[0]; }
+  const T& front() const { return mData[0]; }
+  T& back() { return mData[mSize - 1]; }
+  const T& back() const { return mData[mSize - 1]; }
+  T* data() { return mData; }
+  const T* data() const { return mData; }
+
+  iterator begin() { return mData; }
+  iterator end() { return mData + mSize; }
+  const_iterator begin() const { return mData; }
+  const_iterator end() const { return mData + mSize; }
+  const_iterator cbegin() const { return mData; }
+  const_iterator cend() const { return mData + mSize; }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  template <typename InputIt>
+  void assign(InputIt first, InputIt last) {
+    clear();
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+      reserve(static_cast<size_t>(std::distance(first, last)));
+    }
+    for (; first != last; ++first) emplace_back(*first);
+  }
+
+  void assign(size_t count, const T& value) {
+    clear();
+    resize(count, value);
+  }
+
+  void assign(std::initializer_list<T> list) {
+    assign(list.begin(), list.end());
+  }
+
+  // Capacity
+  bool empty() const { return mSize == 0; }
+  size_t size() const { return mSize; }
+  size_t capacity() const { return mCapacity; }
+  size_t max_size() const {
+    return std::numeric_limits<difference_type>::max() / sizeof(T);
+  }
+  static constexpr size_t inline_capacity() { return N; }
+  bool isInline() const { return mData == inlineData(); }
+
+  void reserve(size_t newCapacity) {
+    if (newCapacity > mCapacity) reallocate(newCapacity);
+  }
+
+  // Returns to the inline buffer when the elements fit, otherwise trims the
+  // heap buffer down to exactly size() elements.
+  void shrink_to_fit() {
+    if (isInline() || mSize == mCapacity) return;
+    if (mSize <= N) {
+      T* heap = mData;
+      size_t heapCapacity = mCapacity;
+      relocate(heap, mSize, inlineData());
+      mData = inlineData();
+      mCapacity = N;
+      deallocate(heap, heapCapacity);
+    } else {
+      reallocate(mSize);
+    }
+  }
+
+  void resize(size_t count) { resizeImpl(count); }
+  void resize(size_t count, const T& value) { resizeImpl(count, value); }
+
+  // Inserting and removing
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    if (mSize == mCapacity) {
+      // The argument may alias an element, so build the new buffer first.
+      size_t newCapacity = GrowthPolicy::grow(mCapacity, mSize + 1);
+      T* buffer = allocate(newCapacity);
+      ::new (buffer + mSize) T(std::forward<Args>(args)...);
+      relocate(mData, mSize, buffer);
+      adoptBuffer(buffer, newCapacity);
+    } else {
+      ::new (mData + mSize) T(std::forward<Args>(args)...);
+    }
+    return mData[mSize++];
+  }
+
+  void pop_back() { mData[--mSize].~T(); }
+
+  iterator insert(const_iterator pos, const T& value) {
+    return emplace(pos, value);
+  }
+  iterator insert(const_iterator pos, T&& value) {
+    return emplace(pos, std::move(value));
+  }
+
+  iterator insert(const_iterator pos, size_t count, const T& value) {
+    size_t index = pos - begin();
+    if (count == 0) return begin() + index;
+    T copy(value);
+    openGap(index, count);
+    std::uninitialized_fill_n(mData + index, count, copy);
+    mSize += count;
+    return begin() + index;
+  }
+
+  iterator insert(const_iterator pos, std::initializer_list<T> list) {
+    size_t index = pos - begin();
+    openGap(index, list.size());
+    std::uninitialized_copy(list.begin(), list.end(), mData + index);
+    mSize += list.size();
+    return begin() + index;
+  }
+
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args) {
+    size_t index = pos - begin();
+    if (index == mSize) {
+      emplace_back(std::forward<Args>(args)...);
+      return begin() + index;
+    }
+    T value(std::forward<Args>(args)...);
+    openGap(index, 1);
+    ::new (mData + index) T(std::move(value));
+    ++mSize;
+    return begin() + index;
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    iterator from = begin() + (first - cbegin());
+    iterator to = begin() + (last - cbegin());
+    if (from == to) return from;
+    iterator newEnd = std::move(to, end(), from);
+    std::destroy(newEnd, end());
+    mSize -= static_cast<size_t>(to - from);
+    return from;
+  }
+
+  void clear() {
+    std::destroy(begin(), end());
+    mSize = 0;
+  }
+
+  void swap(SmallVector& other) {
+    SmallVector tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  friend bool operator==(const SmallVector& lhs, const SmallVector& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+
+ private:
+  T* inlineData() { return std::launder(reinterpret_cast<T*>(mInline)); }
+  const T* inlineData() const {
+    return std::launder(reinterpret_cast<const T*>(mInline));
+  }
+
+  static T* allocate(size_t count) {
+    return CountingAllocator<T>{}.allocate(count);
+  }
+  static void deallocate(T* ptr, size_t count) {
+    CountingAllocator<T>{}.deallocate(ptr, count);
+  }
+
+  // Moves count elements from src into uninitialized dst and destroys them in
+  // src. Trivially copyable types degrade to a plain memcpy.
+  static void relocate(T* src, size_t count, T* dst) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      if (count) std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+    } else {
+      std::uninitialized_move_n(src, count, dst);
+      std::destroy_n(src, count);
+    }
+  }
+
+  void releaseHeap() {
+    if (!isInline()) deallocate(mData, mCapacity);
+    mData = inlineData();
+    mCapacity = N;
+  }
+
+  void adoptBuffer(T* buffer, size_t newCapacity) {
+    if (!isInline()) deallocate(mData, mCapacity);
+    mData = buffer;
+    mCapacity = newCapacity;
+  }
+
+  void reallocate(size_t newCapacity) {
+    T* buffer = allocate(newCapacity);
+    relocate(mData, mSize, buffer);
+    adoptBuffer(buffer, newCapacity);
+  }
+
+  // Leaves [index, index + count) uninitialized, shifting the tail right.
+  void openGap(size_t index, size_t count) {
+    if (mSize + count > mCapacity) {
+      size_t newCapacity = GrowthPolicy::grow(mCapacity, mSize + count);
+      T* buffer = allocate(newCapacity);
+      relocate(mData, index, buffer);
+      relocate(mData + index, mSize - index, buffer + index + count);
+      adoptBuffer(buffer, newCapacity);
+      return;
+    }
+    T* first = mData + index;
+    T* last = mData + mSize;
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      std::memmove(static_cast<void*>(first + count), first,
+                   (last - first) * sizeof(T));
+    } else {
+      // Move the tail element by element, back to front, into raw memory and
+      // into moved-from slots alike, then destroy what is left in the gap.
+      for (T* it = last; it != first;) {
+        --it;
+        ::new (it + count) T(std::move(*it));
+        it->~T();
+      }
+    }
+  }
+
+  template <typename... Value>
+  void resizeImpl(size_t count, const Value&... value) {
+    if (count < mSize) {
+      std::destroy(begin() + count, end());
+      mSize = count;
+      return;
+    }
+    if (count > mCapacity) reallocate(GrowthPolicy::grow(mCapacity, count));
+    for (; mSize < count; ++mSize) ::new (mData + mSize) T(value...);
+  }
+
+  void moveFrom(SmallVector&& other) {
+    if (other.isInline()) {
+      relocate(other.mData, other.mSize, inlineData());
+      mData = inlineData();
+      mCapacity = N;
+    } else {
+      mData = other.mData;
+      mCapacity = other.mCapacity;
+      other.mData = other.inlineData();
+      other.mCapacity = N;
+    }
+    mSize = other.mSize;
+    other.mSize = 0;
+  }
+
+  alignas(T) unsigned char mInline[N * sizeof(T) > 0 ? N * sizeof(T) : 1];
+  T* mData{inlineData()};
+  size_t mSize{0};
+  size_t mCapacity{N};
+};
+
+template <typename Container>
+void printVector(const std::string& vectorName, const Container& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "] (size " << vec.size() << ", capacity " << vec.capacity()
+            << ")" << std::endl;
+}
+
+// 4.1. Inserting and removing
+void insertingAndRemoving() {
+  allocationStats.reset();
+  SmallVector<int, 16> vec{1, 2, 3, 4, 5};
+
+  std::cout << "4.1.1. Using push_back() to add 6" << std::endl;
+  vec.push_back(6);
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.2. Using emplace_back() to add 7" << std::endl;
+  vec.emplace_back(7);
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.3. Using insert() to insert 8 as the second element"
+            << std::endl;
+  vec.insert(vec.begin() + 1, 8);
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.4. Using emplace() to insert 9 as the third element"
+            << std::endl;
+  vec.emplace(vec.begin() + 2, 9);
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.5. Using erase() to remove the first element" << std::endl;
+  vec.erase(vec.begin());
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.6. Using pop_back() to remove the last element"
+            << std::endl;
+  vec.pop_back();
+  printVector("Modified vector", vec);
+
+  std::cout << "4.1.7. Using clear() to remove all elements" << std::endl;
+  vec.clear();
+  printVector("Modified vector", vec);
+
+  std::cout << "Heap allocations: " << allocationStats.allocations
+            << std::endl;
+}
+
+// 4.2. Capacity managment
+void capacityManagement() {
+  allocationStats.reset();
+  SmallVector<int, 4> vec{1, 2, 3, 4, 5};
+  printVector("Vector", vec);
+  std::cout << "Is inline: " << std::boolalpha << vec.isInline() << std::endl;
+
+  std::cout << std::endl << "4.2.1. Using reserve(10)" << std::endl;
+  vec.reserve(10);
+  printVector("Vector", vec);
+
+  std::cout << std::endl
+            << "4.2.2. Using resize(3) and shrink_to_fit() to move back inline"
+            << std::endl;
+  vec.resize(3);
+  vec.shrink_to_fit();
+  printVector("Vector", vec);
+  std::cout << "Is inline: " << std::boolalpha << vec.isInline() << std::endl;
+
+  std::cout << std::endl << "4.2.3. Using resize(6, 10)" << std::endl;
+  vec.resize(6, 10);
+  printVector("Vector", vec);
+
+  std::cout << "Allocations: " << allocationStats.allocations
+            << ", deallocations: " << allocationStats.deallocations
+            << std::endl;
+}
+
+// 4.3. Growth policies
+template <typename GrowthPolicy>
+void showGrowth(const std::string& policyName) {
+  allocationStats.reset();
+  SmallVector<int, 2, GrowthPolicy> vec;
+  std::cout << policyName << " capacities:";
+  size_t lastCapacity = vec.capacity();
+  for (int i = 0; i < 20; ++i) {
+    vec.push_back(i);
+    if (vec.capacity() != lastCapacity) {
+      lastCapacity = vec.capacity();
+      std::cout << " " << lastCapacity;
+    }
+  }
+  std::cout << " (" << allocationStats.allocations << " allocations)"
+            << std::endl;
+}
+
+void growthPolicies() {
+  showGrowth<GrowthFactor2x>("2x   ");
+  showGrowth<GrowthFactor1_5x>("1.5x ");
+  showGrowth<ExactGrowth>("Exact");
+}
+
+// 5. Benchmark
+// Replays the insertingAndRemoving() pattern on many short-lived vectors.
+template <typename T>
+T makeValue(int value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    return std::to_string(value);
+  } else {
+    return static_cast<T>(value);
+  }
+}
+
+template <typename Vector>
+void replayPattern(Vector& vec) {
+  using T = typename Vector::value_type;
+  vec.push_back(makeValue<T>(6));
+  vec.emplace_back(makeValue<T>(7));
+  vec.insert(vec.begin() + 1, makeValue<T>(8));
+  vec.emplace(vec.begin() + 2, makeValue<T>(9));
+  vec.erase(vec.begin());
+  vec.pop_back();
+}
+
+template <typename MakeVector>
+void benchmarkPattern(const std::string& name, MakeVector makeVector) {
+  constexpr size_t iterations = 1'000'000;
+  constexpr size_t operationsPerIteration = 7;  // construction + 6 edits
+  allocationStats.reset();
+  long long checksum = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    auto vec = makeVector();
+    replayPattern(vec);
+    checksum += static_cast<long long>(vec.size());
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  std::cout << name << ": " << elapsed << " ms, "
+            << static_cast<double>(allocationStats.allocations) /
+                   (iterations * operationsPerIteration)
+            << " allocations/op (checksum " << checksum << ")" << std::endl;
+}
+
+void benchmark() {
+  benchmarkPattern("std::vector<int>        ", [] {
+    return std::vector<int, CountingAllocator<int>>{1, 2, 3, 4, 5};
+  });
+  benchmarkPattern("SmallVector<int, 16>    ",
+                   [] { return SmallVector<int, 16>{1, 2, 3, 4, 5}; });
+  benchmarkPattern("SmallVector<int, 4>     ",
+                   [] { return SmallVector<int, 4>{1, 2, 3, 4, 5}; });
+  benchmarkPattern("SmallVector<string, 16> ", [] {
+    return SmallVector<std::string, 16>{"1", "2", "3", "4", "5"};
+  });
+}
+
+int main() {
+  // 4.1. Inserting and removing
+  std::cout << "*** 4.1. Inserting and removing ***" << std::endl;
+  insertingAndRemoving();
+
+  // 4.2. Capacity managment
+  std::cout << std::endl << "*** 4.2. Capacity managment ***" << std::endl;
+  capacityManagement();
+
+  // 4.3. Growth policies
+  std::cout << std::endl << "*** 4.3. Growth policies ***" << std::endl;
+  growthPolicies();
+
+  // 5. Benchmark
+  std::cout << std::endl
+            << "*** 5. Benchmark against std::vector ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,399 @@
+/* This file implements vectorized stream compaction for the std::remove(),
+ * std::remove_if(), std::unique() and std::erase_if() calls of
+ * removingAlgorithms() in container_vector.cpp.
+ *
+ * std::remove_if() decides per element with a branch. When the predicate is
+ * true for a random fraction of the elements the branch is mispredicted
+ * constantly, so its speed depends on the selectivity. The kernels here
+ * never branch on the data:
+ *
+ * 1. SIMD-friendly predicates: every predicate has a scalar operator() and
+ *    a method that tests eight (AVX2) or sixteen (AVX-512) ints at once.
+ * 2. Compaction kernels. All of them work in place, because the write
+ *    position never passes the read position.
+ *    2.1. removeIfBranchless(): scalar, always stores and advances the write
+ *         position by the result of the predicate.
+ *    2.2. removeIfAvx2(): the 8-bit keep mask indexes a 256-entry permute
+ *         table; vpermd packs the kept lanes to the front of the register.
+ *    2.3. removeIfAvx512(): vpcompressd packs the kept lanes directly.
+ * 3. uniqueSimd(): adjacent-duplicate removal. Every lane is compared with
+ *    its left neighbour, the last element of the previous block is carried
+ *    in a register.
+ * 4. erase_if-style wrappers on std::vector that also resize it.
+ * 5. Examples and benchmark: branchy versus branchless at several
+ *    selectivities.
+ *
+ * Build with: g++ -std=c++20 -O2 -march=native stream_compaction.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// 1. SIMD-friendly predicates
+struct EqualTo {
+  int value;
+
+  bool operator()(int x) const { return x == value; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpeq_epi32(x, _mm256_set1_epi32(value));
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmpeq_epi32_mask(x, _mm512_set1_epi32(value));
+  }
+#endif
+};
+
+struct GreaterThan {
+  int value;
+
+  bool operator()(int x) const { return x > value; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpgt_epi32(x, _mm256_set1_epi32(value));
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmpgt_epi32_mask(x, _mm512_set1_epi32(value));
+  }
+#endif
+};
+
+struct LessThan {
+  int value;
+
+  bool operator()(int x) const { return x < value; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(value), x);
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmplt_epi32_mask(x, _mm512_set1_epi32(value));
+  }
+#endif
+};
+
+// Matches low <= x <= high.
+struct InRange {
+  int low;
+  int high;
+
+  bool operator()(int x) const { return low <= x && x <= high; }
+#if defined(__AVX2__)
+  __m256i test(__m256i x) const {
+    __m256i belowLow = _mm256_cmpgt_epi32(_mm256_set1_epi32(low), x);
+    __m256i aboveHigh = _mm256_cmpgt_epi32(x, _mm256_set1_epi32(high));
+    return _mm256_xor_si256(_mm256_or_si256(belowLow, aboveHigh),
+                            _mm256_set1_epi32(-1));
+  }
+#endif
+#if defined(__AVX512F__)
+  __mmask16 test(__m512i x) const {
+    return _mm512_cmpge_epi32_mask(x, _mm512_set1_epi32(low)) &
+           _mm512_cmple_epi32_mask(x, _mm512_set1_epi32(high));
+  }
+#endif
+};
+
+// 2.1. removeIfBranchless()
+// Works with any predicate, including plain lambdas. Returns the new size.
+template <typename Predicate>
+size_t removeIfBranchless(int* data, size_t size, Predicate pred) {
+  size_t k = 0;
+  for (size_t i = 0; i < size; ++i) {
+    int x = data[i];
+    data[k] = x;
+    k += !pred(x);
+  }
+  return k;
+}
+
+// 2.2. removeIfAvx2()
+#if defined(__AVX2__)
+// Entry m lists, in order, the lanes whose bit is set in m, then padding.
+constexpr std::array<std::array<int32_t, 8>, 256> makePermuteTable() {
+  std::array<std::array<int32_t, 8>, 256> table{};
+  for (int mask = 0; mask < 256; ++mask) {
+    int slot = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+      if (mask & (1 << lane)) table[mask][slot++] = lane;
+    }
+    for (; slot < 8; ++slot) table[mask][slot] = 0;
+  }
+  return table;
+}
+
+alignas(32) constexpr auto permuteTable = makePermuteTable();
+
+inline __m256i compactLanes(__m256i x, int keepMask) {
+  __m256i indices = _mm256_load_si256(
+      reinterpret_cast<const __m256i*>(permuteTable[keepMask].data()));
+  return _mm256_permutevar8x32_epi32(x, indices);
+}
+
+// Each store writes a full register at the write position. That is safe in
+// place: the write position never passes the read position, so the store
+// only overlaps the block that has already been loaded.
+template <typename Predicate>
+size_t removeIfAvx2(int* data, size_t size, Predicate pred) {
+  size_t k = 0, i = 0;
+  for (; i + 8 <= size; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    int removeMask = _mm256_movemask_ps(_mm256_castsi256_ps(pred.test(x)));
+    int keepMask = ~removeMask & 0xFF;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + k),
+                        compactLanes(x, keepMask));
+    k += __builtin_popcount(keepMask);
+  }
+  for (; i < size; ++i) {
+    int x = data[i];
+    data[k] = x;
+    k += !pred(x);
+  }
+  return k;
+}
+#endif
+
+// 2.3. removeIfAvx512()
+#if defined(__AVX512F__)
+template <typename Predicate>
+size_t removeIfAvx512(int* data, size_t size, Predicate pred) {
+  size_t k = 0, i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m512i x = _mm512_loadu_si512(data + i);
+    __mmask16 keepMask = static_cast<__mmask16>(~pred.test(x));
+    // compress + full store is faster than a masked compressing store on
+    // several microarchitectures; the extra lanes are overwritten later.
+    _mm512_storeu_si512(data + k, _mm512_maskz_compress_epi32(keepMask, x));
+    k += __builtin_popcount(keepMask);
+  }
+  // The tail uses a masked load so no scalar loop is needed.
+  if (i < size) {
+    __mmask16 valid = static_cast<__mmask16>((1u << (size - i)) - 1);
+    __m512i x = _mm512_maskz_loadu_epi32(valid, data + i);
+    __mmask16 keepMask = static_cast<__mmask16>(~pred.test(x) & valid);
+    _mm512_mask_compressstoreu_epi32(data + k, keepMask, x);
+    k += __builtin_popcount(keepMask);
+  }
+  return k;
+}
+#endif
+
+// Picks the widest kernel the build supports.
+template <typename Predicate>
+size_t removeIfSimd(int* data, size_t size, Predicate pred) {
+#if defined(__AVX512F__)
+  return removeIfAvx512(data, size, pred);
+#elif defined(__AVX2__)
+  return removeIfAvx2(data, size, pred);
+#else
+  return removeIfBranchless(data, size, pred);
+#endif
+}
+
+// 3. uniqueSimd()
+// Continues from read position i and write position k >= 1.
+size_t uniqueScalar(int* data, size_t size, size_t k, size_t i) {
+  int last = data[k - 1];
+  for (; i < size; ++i) {
+    int x = data[i];
+    data[k] = x;
+    k += x != last;
+    last = x;
+  }
+  return k;
+}
+
+size_t uniqueSimd(int* data, size_t size) {
+  if (size < 2) return size;
+  size_t k = 1, i = 1;
+#if defined(__AVX2__)
+  // Lane j is compared with lane j - 1; lane 0 with the carried element.
+  const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+  int previous = data[0];
+  for (; i + 8 <= size; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i shifted = _mm256_permutevar8x32_epi32(x, rotate);
+    shifted = _mm256_blend_epi32(shifted, _mm256_set1_epi32(previous), 1);
+    int duplicateMask =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, shifted)));
+    int keepMask = ~duplicateMask & 0xFF;
+    previous = data[i + 7];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + k),
+                        compactLanes(x, keepMask));
+    k += __builtin_popcount(keepMask);
+  }
+  // data[k - 1] is the last kept element and equals previous.
+#endif
+  return uniqueScalar(data, size, k, i);
+}
+
+// 4. erase_if-style wrappers
+template <typename Predicate>
+size_t eraseIfSimd(std::vector<int>& vec, Predicate pred) {
+  size_t newSize = removeIfSimd(vec.data(), vec.size(), pred);
+  size_t removed = vec.size() - newSize;
+  vec.resize(newSize);
+  return removed;
+}
+
+size_t eraseSimd(std::vector<int>& vec, int value) {
+  return eraseIfSimd(vec, EqualTo{value});
+}
+
+size_t eraseDuplicatesSimd(std::vector<int>& vec) {
+  size_t newSize = uniqueSimd(vec.data(), vec.size());
+  size_t removed = vec.size() - newSize;
+  vec.resize(newSize);
+  return removed;
+}
+
+// 5. Examples and benchmark
+void printVector(const std::string& vectorName, const std::vector<int>& vec) {
+  std::cout << vectorName << ": [";
+  for (size_t i = 0; i < vec.size(); ++i) {
+    std::cout << vec[i];
+    if (i + 1 < vec.size()) std::cout << ", ";
+  }
+  std::cout << "]" << std::endl;
+}
+
+void removingAlgorithms() {
+  std::vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 3, 12, 13, 3, 15, 16, 17};
+
+  std::cout << "5.1. Using eraseSimd() to remove all 3s" << std::endl;
+  printVector("Initial vector", vec);
+  eraseSimd(vec, 3);
+  printVector("Modified vector", vec);
+
+  std::cout << std::endl
+            << "5.2. Using eraseIfSimd() to remove elements greater than 9"
+            << std::endl;
+  printVector("Initial vector", vec);
+  eraseIfSimd(vec, GreaterThan{9});
+  printVector("Modified vector", vec);
+
+  std::cout << std::endl
+            << "5.3. Using eraseDuplicatesSimd() on a sorted vector"
+            << std::endl;
+  std::vector<int> vec2{1, 1, 2, 3, 3, 3, 4, 5, 5, 6, 7, 7, 7, 7, 8, 9, 9};
+  printVector("Initial vector", vec2);
+  eraseDuplicatesSimd(vec2);
+  printVector("Modified vector", vec2);
+}
+
+bool checkAgainstStd() {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> dist(0, 9);
+  bool ok = true;
+  for (size_t size = 0; size < 200; ++size) {
+    std::vector<int> input(size);
+    for (int& x : input) x = dist(gen);
+
+    std::vector<int> expected = input, actual = input;
+    std::erase_if(expected, InRange{3, 6});
+    eraseIfSimd(actual, InRange{3, 6});
+    ok = ok && expected == actual;
+
+    actual = input;
+    actual.resize(removeIfBranchless(actual.data(), actual.size(),
+                                     [](int x) { return x % 3 == 0; }));
+    expected = input;
+    std::erase_if(expected, [](int x) { return x % 3 == 0; });
+    ok = ok && expected == actual;
+
+    expected = input;
+    actual = input;
+    expected.erase(std::unique(expected.begin(), expected.end()),
+                   expected.end());
+    eraseDuplicatesSimd(actual);
+    ok = ok && expected == actual;
+  }
+  return ok;
+}
+
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 24;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 999);
+  std::vector<int> input(size);
+  for (int& x : input) x = dist(gen);
+  std::vector<int> work;
+  std::cout << "Elements: " << size << std::endl;
+
+  // Each kernel runs on a fresh copy; only the compaction is timed.
+  auto run = [&](auto kernel) {
+    work = input;
+    return measureMilliseconds([&] { kernel(work); });
+  };
+
+  for (int percent : {1, 10, 50, 90, 99}) {
+    LessThan pred{percent * 10};
+    double branchy = run([&](std::vector<int>& v) {
+      v.erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+    });
+    size_t kept = work.size();
+    double branchless = run([&](std::vector<int>& v) {
+      v.resize(removeIfBranchless(v.data(), v.size(), pred));
+    });
+    double simd = run([&](std::vector<int>& v) { eraseIfSimd(v, pred); });
+    std::cout << "Removing " << percent << "%: std::remove_if " << branchy
+              << " ms, branchless " << branchless << " ms, simd " << simd
+              << " ms (kept " << kept << ")" << std::endl;
+  }
+
+  std::vector<int> sorted(size);
+  for (int& x : sorted) x = dist(gen) * 1000;
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t i = 0; i < size; i += 2) sorted[i] += static_cast<int>(i % 7);
+  std::sort(sorted.begin(), sorted.end());
+  work = sorted;
+  double stdUnique = measureMilliseconds(
+      [&] { work.erase(std::unique(work.begin(), work.end()), work.end()); });
+  work = sorted;
+  double simdUnique = measureMilliseconds([&] { eraseDuplicatesSimd(work); });
+  std::cout << "Adjacent duplicates: std::unique " << stdUnique
+            << " ms, simd " << simdUnique << " ms (kept " << work.size()
+            << ")" << std::endl;
+}
+
+int main() {
+  // Removing algorithms
+  std::cout << "*** Removing algorithms ***" << std::endl;
+  removingAlgorithms();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match the std algorithms: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
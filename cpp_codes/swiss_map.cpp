@@ -0,0 +1,360 @@
+/* This file shows SwissMap from swiss_map.h, an open addressing hash map
+ * probed 16 control bytes at a time, running the point lookups of
+ * container_map.cpp, and measures it against std::map.
+ *
+ * 1. Accessing and modifying
+ * 2. Inserting and removing, including erase_if()
+ * 3. Searching, including std::string_view lookups in a map of
+ *    std::string
+ * 4. reserve(): one rehash up front instead of one per doubling
+ * 5. Benchmark: inserts and random lookups with int and string keys
+ *
+ * Elements are printed in table order, which depends on the hashes.
+ *
+ * Build with: g++ -std=c++20 -O2 swiss_map.cpp
+ */
+
+#include "fast_output.h"
+#include "swiss_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+template <typename Map>
+void printMap(const std::string& mapName, const Map& mp) {
+  FastOutput& out = fastOut();
+  out << mapName << ": ";
+  if (!mp.empty()) out.writeMap(mp);
+  out << '\n';
+  out.flush();
+}
+
+// 1. Accessing and modifying
+void accessingAndModifying() {
+  SwissMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  // 1.1. Using operator []
+  std::cout << "1.1. Using operator [] to modify the value of key 1 to I"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp[1] = "I";
+  printMap("Modified map", mp);
+
+  // 1.2. Using at(), which throws std::out_of_range for a missing key
+  std::cout << std::endl
+            << "1.2. Using at() to modify the value of key 2 to II, and on "
+               "the missing key 4"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.at(2) = "II";
+  printMap("Modified map", mp);
+  try {
+    mp.at(4);
+  } catch (const std::out_of_range& e) {
+    std::cout << "mp.at(4) throws: " << e.what() << std::endl;
+  }
+
+  // 1.3. Using find()
+  std::cout << std::endl
+            << "1.3. Using find() to modify the value of key 3 to III"
+            << std::endl;
+  printMap("Initial map", mp);
+  auto it = mp.find(3);
+  if (it != mp.end()) it->second = "III";
+  printMap("Modified map", mp);
+
+  // 1.4. Using a range-based for loop; the elements are
+  // std::pair<const int, std::string> as in std::map
+  std::cout << std::endl
+            << "1.4. Using a range-based for loop to append ! to every value"
+            << std::endl;
+  printMap("Initial map", mp);
+  for (auto& [key, value] : mp) value += "!";
+  printMap("Modified map", mp);
+
+  // 1.5. Using swap()
+  std::cout << std::endl
+            << "1.5. Using swap() with the map {{4, four}, {5, five}}"
+            << std::endl;
+  SwissMap<int, std::string> other{{4, "four"}, {5, "five"}};
+  mp.swap(other);
+  printMap("Map", mp);
+  printMap("Other map", other);
+}
+
+// 2. Inserting and removing
+void insertingAndRemoving() {
+  SwissMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+
+  // 2.1. Using insert(); an existing key is left alone
+  std::cout << "2.1. Using insert() to insert {1, I} and {4, four}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert({{1, "I"}, {4, "four"}});
+  printMap("Modified map", mp);
+
+  // 2.2. Using insert_or_assign()
+  std::cout << std::endl
+            << "2.2. Using insert_or_assign() to insert {1, I} and {5, five}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.insert_or_assign(1, "I");
+  mp.insert_or_assign(5, "five");
+  printMap("Modified map", mp);
+
+  // 2.3. Using emplace() and try_emplace()
+  std::cout << std::endl
+            << "2.3. Using emplace() for {6, six} and try_emplace() for "
+               "{7, seven} and {2, II}"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.emplace(6, "six");
+  mp.try_emplace(7, "seven");
+  mp.try_emplace(2, "II");
+  printMap("Modified map", mp);
+
+  // 2.4. Using erase() by key and by iterator
+  std::cout << std::endl
+            << "2.4. Using erase() to remove key 7, and key 6 through an "
+               "iterator"
+            << std::endl;
+  printMap("Initial map", mp);
+  mp.erase(7);
+  mp.erase(mp.find(6));
+  printMap("Modified map", mp);
+
+  // 2.5. Using erase_if()
+  std::cout << std::endl
+            << "2.5. Using erase_if() to remove the odd keys" << std::endl;
+  printMap("Initial map", mp);
+  erase_if(mp, [](const auto& element) { return element.first % 2 != 0; });
+  printMap("Modified map", mp);
+
+  // 2.6. Using clear(); the table is kept for reuse
+  std::cout << std::endl << "2.6. Using clear()" << std::endl;
+  printMap("Initial map", mp);
+  mp.clear();
+  printMap("Modified map", mp);
+  std::cout << "Capacity after clear(): " << mp.capacity() << std::endl;
+}
+
+// 3. Searching
+void searchingAlgorithms() {
+  SwissMap<int, std::string> mp{{1, "one"}, {2, "two"}, {3, "three"}};
+  printMap("Map", mp);
+
+  // 3.1. find(), count() and contains()
+  std::cout << std::endl
+            << "3.1. find(), count() and contains() with key 2" << std::endl;
+  auto it = mp.find(2);
+  if (it != mp.end()) std::cout << "Found value: " << it->second << std::endl;
+  std::cout << "count(2): " << mp.count(2) << ", contains(4): "
+            << std::boolalpha << mp.contains(4) << std::endl;
+
+  // 3.2. Heterogeneous lookup: StringHash and std::equal_to<> accept a
+  // std::string_view, so no std::string is built for the search
+  std::cout << std::endl
+            << "3.2. Searching a map of std::string with a std::string_view"
+            << std::endl;
+  SwissMap<std::string, int, StringHash, std::equal_to<>> byName{
+      {"one", 1}, {"two", 2}, {"three", 3}};
+  std::string_view line = "two three four";
+  for (std::string_view word : {line.substr(0, 3), line.substr(4, 5),
+                                line.substr(10, 4)}) {
+    auto found = byName.find(word);
+    std::cout << word << ": "
+              << (found == byName.end() ? "missing"
+                                        : std::to_string(found->second))
+              << std::endl;
+  }
+}
+
+// 4. reserve()
+void reserving() {
+  std::cout << "4.1. Inserting 1000 keys without and with reserve(1000)"
+            << std::endl;
+  SwissMap<int, int> grown;
+  size_t rehashes = 0;
+  for (int key = 0; key < 1000; ++key) {
+    size_t before = grown.capacity();
+    grown[key] = key;
+    rehashes += grown.capacity() != before;
+  }
+  std::cout << "Without reserve(): " << rehashes << " rehashes, capacity "
+            << grown.capacity() << std::endl;
+
+  SwissMap<int, int> reserved;
+  reserved.reserve(1000);
+  size_t capacity = reserved.capacity();
+  for (int key = 0; key < 1000; ++key) reserved[key] = key;
+  std::cout << "With reserve(): capacity " << capacity << " before and "
+            << reserved.capacity() << " after the inserts" << std::endl;
+}
+
+// Applies random operations to a SwissMap and a std::map and compares them.
+bool checkAgainstStd() {
+  std::mt19937 gen(3);
+  bool ok = true;
+  for (int keyRange : {20, 5000}) {
+    SwissMap<int, int> swiss;
+    std::map<int, int> reference;
+    for (int step = 0; step < 50000; ++step) {
+      int key = static_cast<int>(gen() % keyRange);
+      int value = static_cast<int>(gen() % 1000);
+      switch (gen() % 8) {
+        case 0:
+          ok = ok && swiss.insert({key, value}).second ==
+                         reference.insert({key, value}).second;
+          break;
+        case 1:
+          swiss.insert_or_assign(key, value);
+          reference.insert_or_assign(key, value);
+          break;
+        case 2:
+        case 3:
+          ok = ok && swiss.erase(key) == reference.erase(key);
+          break;
+        case 4:
+          swiss[key] += value;
+          reference[key] += value;
+          break;
+        case 5:
+          if (step % 1000 == 0) {
+            int divisor = 2 + value % 5;
+            auto pred = [&](const auto& e) { return e.first % divisor == 0; };
+            ok = ok && erase_if(swiss, pred) == std::erase_if(reference, pred);
+          }
+          break;
+        default: {
+          auto it = swiss.find(key);
+          auto r = reference.find(key);
+          ok = ok && (it == swiss.end()) == (r == reference.end()) &&
+               (it == swiss.end() || it->second == r->second);
+          break;
+        }
+      }
+    }
+    std::map<int, int> contents(swiss.begin(), swiss.end());
+    SwissMap<int, int> copy = swiss;
+    ok = ok && swiss.size() == reference.size() && contents == reference &&
+         copy == swiss;
+  }
+  return ok;
+}
+
+// 5. Benchmark
+template <typename Function>
+double measureMilliseconds(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Builds both maps from keys, then looks up queries in each.
+template <typename Key, typename SwissType, typename Query>
+void benchmarkMaps(const std::string& title, const std::vector<Key>& keys,
+                   const std::vector<Query>& queries) {
+  // volatile keeps the compiler from dropping the unused results.
+  volatile size_t sink = 0;
+  std::map<Key, int, std::less<>> tree;
+  SwissType swiss;
+  double treeInsert = measureMilliseconds([&] {
+    for (size_t i = 0; i < keys.size(); ++i) tree.emplace(keys[i], int(i));
+  });
+  double swissInsert = measureMilliseconds([&] {
+    swiss.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) swiss.emplace(keys[i], int(i));
+  });
+  double treeFind = measureMilliseconds([&] {
+    size_t hits = 0;
+    for (const Query& query : queries) hits += tree.find(query) != tree.end();
+    sink = hits;
+  });
+  double swissFind = measureMilliseconds([&] {
+    size_t hits = 0;
+    for (const Query& query : queries)
+      hits += swiss.find(query) != swiss.end();
+    sink = hits;
+  });
+
+  std::cout << title << ": " << keys.size() << " keys, " << queries.size()
+            << " lookups (half of them misses)" << std::endl;
+  std::cout << "Insert: std::map " << treeInsert << " ms, SwissMap "
+            << swissInsert << " ms (" << treeInsert / swissInsert << "x)"
+            << std::endl;
+  std::cout << "Find:   std::map " << treeFind << " ms, SwissMap " << swissFind
+            << " ms (" << treeFind / swissFind << "x)" << std::endl;
+}
+
+void benchmark() {
+  constexpr size_t size = 1 << 20;
+  constexpr size_t lookups = 1 << 22;
+  std::mt19937 gen(42);
+
+  std::vector<int> intKeys(size);
+  for (int& key : intKeys) key = static_cast<int>(gen() >> 1);
+  std::vector<int> intQueries(lookups);
+  for (int& query : intQueries)
+    query = gen() % 2 ? intKeys[gen() % size] : -static_cast<int>(gen() >> 1);
+  benchmarkMaps<int, SwissMap<int, int>>("int keys", intKeys, intQueries);
+
+  // The queries are std::string_view slices of one buffer, as when
+  // parsing; SwissMap takes them as they are.
+  std::vector<std::string> stringKeys(size / 4);
+  for (std::string& key : stringKeys)
+    key = "user-" + std::to_string(gen()) + "-session";
+  std::string buffer;
+  std::vector<std::pair<size_t, size_t>> spans;
+  for (size_t i = 0; i < lookups / 4; ++i) {
+    std::string word = gen() % 2 ? stringKeys[gen() % stringKeys.size()]
+                                 : "user-" + std::to_string(gen()) + "-miss";
+    spans.emplace_back(buffer.size(), word.size());
+    buffer += word;
+  }
+  std::vector<std::string_view> stringQueries;
+  for (auto [offset, length] : spans)
+    stringQueries.emplace_back(buffer.data() + offset, length);
+  std::cout << std::endl;
+  benchmarkMaps<std::string,
+                SwissMap<std::string, int, StringHash, std::equal_to<>>>(
+      "std::string keys, std::string_view lookups", stringKeys,
+      stringQueries);
+}
+
+int main() {
+  // Accessing and modifying
+  std::cout << "*** Accessing and modifying ***" << std::endl;
+  accessingAndModifying();
+
+  // Inserting and removing
+  std::cout << std::endl << "*** Inserting and removing ***" << std::endl;
+  insertingAndRemoving();
+
+  // Searching
+  std::cout << std::endl << "*** Searching ***" << std::endl;
+  searchingAlgorithms();
+
+  // Reserving
+  std::cout << std::endl << "*** Reserving ***" << std::endl;
+  reserving();
+
+  // Correctness
+  std::cout << std::endl
+            << "*** Results match std::map: " << std::boolalpha
+            << checkAgainstStd() << " ***" << std::endl;
+
+  // Benchmark
+  std::cout << std::endl << "*** Benchmark ***" << std::endl;
+  benchmark();
+
+  return 0;
+}
@@ -0,0 +1,662 @@
+/* This header implements SwissMap<Key, T, Hash, KeyEqual>, an open
+ * addressing hash map for the point lookups of container_map.cpp (find(),
+ * count(), at(), operator[]), where std::map pays a cache miss per tree
+ * level.
+ *
+ * 1. Layout: the elements live in one array of slots. Next to it is an
+ *    array of control bytes, one per slot, which holds either "empty" or
+ *    the low 7 bits of the hash of the slot's key (H2). The other hash
+ *    bits (H1) pick the home slot.
+ * 2. Lookup: starting at the home slot, 16 control bytes are compared
+ *    against H2 with one SSE2 instruction; only slots whose byte matches
+ *    have their key compared, which is rarely more than one. The search
+ *    stops at the first window that contains an empty byte.
+ * 3. Deletion without tombstones: probing is linear, slot by slot, so an
+ *    erased slot is refilled by shifting the following elements of its run
+ *    back ("backward shift deletion"). Erases never leave markers behind,
+ *    so lookups do not slow down with churn and the table never has to be
+ *    rebuilt to clean them up.
+ * 4. Growth: the table doubles when it is 7/8 full. reserve(n) sizes it
+ *    once for n elements; inserting up to n elements then never rehashes,
+ *    and erasing never shrinks it.
+ * 5. Heterogeneous lookup: with a transparent Hash and KeyEqual, e.g.
+ *    StringHash and std::equal_to<>, a std::string_view finds a
+ *    std::string key without building a temporary string.
+ *
+ * Unlike std::unordered_map, insert and erase invalidate iterators and
+ * references, and erase(iterator) returns nothing: backward shifting can
+ * move an element that was already visited. Use erase_if() to remove
+ * elements while walking the table.
+ */
+
+#ifndef SWISS_MAP_H
+#define SWISS_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Hashes std::string, std::string_view and string literals alike, so that
+// SwissMap<std::string, T, StringHash, std::equal_to<>> can be searched
+// with any of them.
+struct StringHash {
+  using is_transparent = void;
+
+  size_t operator()(std::string_view text) const noexcept {
+    return std::hash<std::string_view>{}(text);
+  }
+};
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class SwissMap {
+  using Traits = std::allocator_traits<Allocator>;
+  using CtrlAllocator = typename Traits::template rebind_alloc<int8_t>;
+
+  template <bool Const>
+  class Iterator;
+
+  // Enables the lookup overloads taking any K that Hash and KeyEqual accept.
+  template <typename K>
+  static constexpr bool isTransparent = requires {
+    typename Hash::is_transparent;
+    typename KeyEqual::is_transparent;
+  };
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // Construction
+  SwissMap() = default;
+
+  explicit SwissMap(const Allocator& alloc) : mAlloc(alloc) {}
+
+  template <typename InputIt>
+  SwissMap(InputIt first, InputIt last, const Allocator& alloc = Allocator())
+      : mAlloc(alloc) {
+    insert(first, last);
+  }
+
+  SwissMap(std::initializer_list<value_type> init,
+           const Allocator& alloc = Allocator())
+      : SwissMap(init.begin(), init.end(), alloc) {}
+
+  SwissMap(const SwissMap& other)
+      : mHash(other.mHash),
+        mEqual(other.mEqual),
+        mAlloc(Traits::select_on_container_copy_construction(other.mAlloc)) {
+    if (other.mCapacity == 0) return;
+    // Same capacity and hash: every element keeps its slot index.
+    allocate(other.mCapacity);
+    try {
+      for (size_t i = 0; i < mCapacity; ++i) {
+        if (other.mCtrl[i] == emptyCtrl) continue;
+        Traits::construct(mAlloc, mSlots + i, other.mSlots[i]);
+        setCtrl(i, other.mCtrl[i]);
+        ++mSize;
+      }
+    } catch (...) {
+      destroyAndRelease();
+      throw;
+    }
+  }
+
+  SwissMap(SwissMap&& other) noexcept
+      : mHash(std::move(other.mHash)),
+        mEqual(std::move(other.mEqual)),
+        mAlloc(std::move(other.mAlloc)) {
+    steal(other);
+  }
+
+  SwissMap& operator=(const SwissMap& other) {
+    if (this == &other) return *this;
+    clear();
+    mHash = other.mHash;
+    mEqual = other.mEqual;
+    reserve(other.size());
+    for (const value_type& element : other)
+      try_emplace(element.first, element.second);
+    return *this;
+  }
+
+  SwissMap& operator=(SwissMap&& other) noexcept(
+      Traits::propagate_on_container_move_assignment::value ||
+      Traits::is_always_equal::value) {
+    if (this == &other) return *this;
+    mHash = std::move(other.mHash);
+    mEqual = std::move(other.mEqual);
+    if constexpr (Traits::propagate_on_container_move_assignment::value) {
+      destroyAndRelease();
+      mAlloc = std::move(other.mAlloc);
+      steal(other);
+    } else {
+      if (mAlloc == other.mAlloc) {
+        destroyAndRelease();
+        steal(other);
+      } else {
+        // The memory belongs to another allocator: move element by element.
+        clear();
+        reserve(other.size());
+        for (value_type& element : other)
+          try_emplace(element.first, std::move(element.second));
+        other.clear();
+      }
+    }
+    return *this;
+  }
+
+  ~SwissMap() { destroyAndRelease(); }
+
+  // Iterators, in table order
+  iterator begin() noexcept { return iteratorAt(0); }
+  const_iterator begin() const noexcept { return iteratorAt(0); }
+  iterator end() noexcept { return iteratorAt(mCapacity); }
+  const_iterator end() const noexcept { return iteratorAt(mCapacity); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  // Capacity
+  bool empty() const noexcept { return mSize == 0; }
+  size_t size() const noexcept { return mSize; }
+  size_t capacity() const noexcept { return mCapacity; }
+  float load_factor() const noexcept {
+    return mCapacity == 0 ? 0.0f : static_cast<float>(mSize) / mCapacity;
+  }
+  static constexpr float max_load_factor() noexcept { return 7.0f / 8.0f; }
+
+  // Makes room for count elements with at most one rehash.
+  void reserve(size_t count) {
+    if (count <= maxLoad(mCapacity)) return;
+    size_t newCapacity = std::bit_ceil(std::max(groupSize, count));
+    while (maxLoad(newCapacity) < count) newCapacity *= 2;
+    rehash(newCapacity);
+  }
+
+  hasher hash_function() const { return mHash; }
+  key_equal key_eq() const { return mEqual; }
+  allocator_type get_allocator() const { return mAlloc; }
+
+  // Lookup
+  T& at(const Key& key) {
+    size_t index = findIndex(key);
+    if (index == npos) throw std::out_of_range("SwissMap::at");
+    return mSlots[index].second;
+  }
+
+  const T& at(const Key& key) const {
+    size_t index = findIndex(key);
+    if (index == npos) throw std::out_of_range("SwissMap::at");
+    return mSlots[index].second;
+  }
+
+  T& operator[](const Key& key) { return try_emplace(key).first->second; }
+  T& operator[](Key&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  iterator find(const Key& key) { return iteratorFor(findIndex(key)); }
+  const_iterator find(const Key& key) const {
+    return iteratorFor(findIndex(key));
+  }
+  size_t count(const Key& key) const { return findIndex(key) != npos; }
+  bool contains(const Key& key) const { return findIndex(key) != npos; }
+
+  template <typename K>
+    requires isTransparent<K>
+  iterator find(const K& key) {
+    return iteratorFor(findIndex(key));
+  }
+  template <typename K>
+    requires isTransparent<K>
+  const_iterator find(const K& key) const {
+    return iteratorFor(findIndex(key));
+  }
+  template <typename K>
+    requires isTransparent<K>
+  size_t count(const K& key) const {
+    return findIndex(key) != npos;
+  }
+  template <typename K>
+    requires isTransparent<K>
+  bool contains(const K& key) const {
+    return findIndex(key) != npos;
+  }
+
+  // Modifiers
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+    return emplaceKey(key, std::forward<Args>(args)...);
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+    return emplaceKey(std::move(key), std::forward<Args>(args)...);
+  }
+  // The key is only converted to Key if it is inserted.
+  template <typename K, typename... Args>
+    requires isTransparent<K> && std::is_constructible_v<Key, K&&>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+    return emplaceKey(std::forward<K>(key), std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    std::pair<Key, T> element(std::forward<Args>(args)...);
+    return emplaceKey(std::move(element.first), std::move(element.second));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& element) {
+    return emplaceKey(element.first, element.second);
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>)
+      reserve(mSize + static_cast<size_t>(std::distance(first, last)));
+    for (; first != last; ++first) emplace(*first);
+  }
+
+  void insert(std::initializer_list<value_type> init) {
+    insert(init.begin(), init.end());
+  }
+
+  template <typename K, typename M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& value) {
+    auto result = try_emplace(std::forward<K>(key), std::forward<M>(value));
+    if (!result.second) result.first->second = std::forward<M>(value);
+    return result;
+  }
+
+  size_t erase(const Key& key) {
+    size_t index = findIndex(key);
+    if (index == npos) return 0;
+    eraseAt(index);
+    return 1;
+  }
+
+  // Returns nothing: the slot may now hold an element shifted back from
+  // further along its run (see the notes at the top).
+  void erase(const_iterator pos) {
+    eraseAt(static_cast<size_t>(pos.mSlot - mSlots));
+  }
+  void erase(iterator pos) { erase(const_iterator(pos)); }
+
+  // Removes every element for which pred(value_type&) holds. The walk
+  // starts after an empty slot, so no run wraps around its start, and an
+  // erased slot is checked again for the element shifted into it.
+  template <typename Predicate>
+  friend size_t erase_if(SwissMap& map, Predicate pred) {
+    if (map.mSize == 0) return 0;
+    size_t mask = map.mCapacity - 1;
+    size_t start = 0;
+    while (map.mCtrl[start] != emptyCtrl) ++start;
+    size_t removed = 0;
+    for (size_t step = 1; step <= map.mCapacity; ++step) {
+      size_t index = (start + step) & mask;
+      while (map.mCtrl[index] != emptyCtrl && pred(map.mSlots[index])) {
+        map.eraseAt(index);
+        ++removed;
+      }
+    }
+    return removed;
+  }
+
+  // Destroys the elements but keeps the table for reuse.
+  void clear() noexcept {
+    if (mSize == 0) return;
+    for (size_t i = 0; i < mCapacity; ++i)
+      if (mCtrl[i] != emptyCtrl) Traits::destroy(mAlloc, mSlots + i);
+    std::memset(mCtrl, emptyCtrl, mCapacity + groupSize - 1);
+    mSize = 0;
+  }
+
+  void swap(SwissMap& other) noexcept {
+    using std::swap;
+    swap(mCtrl, other.mCtrl);
+    swap(mSlots, other.mSlots);
+    swap(mCapacity, other.mCapacity);
+    swap(mSize, other.mSize);
+    swap(mHash, other.mHash);
+    swap(mEqual, other.mEqual);
+    if constexpr (Traits::propagate_on_container_swap::value)
+      swap(mAlloc, other.mAlloc);
+  }
+
+  friend bool operator==(const SwissMap& a, const SwissMap& b) {
+    if (a.size() != b.size()) return false;
+    for (const value_type& element : a) {
+      auto it = b.find(element.first);
+      if (it == b.end() || !(it->second == element.second)) return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr size_t groupSize = 16;
+  static constexpr int8_t emptyCtrl = INT8_MIN;
+  static constexpr size_t npos = SIZE_MAX;
+
+  // 16 control bytes, compared at once.
+  class Group {
+   public:
+    explicit Group(const int8_t* ctrl) {
+#if defined(__SSE2__)
+      mCtrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+      std::memcpy(mCtrl, ctrl, groupSize);
+#endif
+    }
+
+    // Bit i is set if byte i equals h2.
+    uint32_t match(int8_t h2) const {
+#if defined(__SSE2__)
+      return static_cast<uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(mCtrl, _mm_set1_epi8(h2))));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < groupSize; ++i)
+        mask |= static_cast<uint32_t>(mCtrl[i] == h2) << i;
+      return mask;
+#endif
+    }
+
+    // Empty is the only control byte with the sign bit set.
+    uint32_t matchEmpty() const {
+#if defined(__SSE2__)
+      return static_cast<uint32_t>(_mm_movemask_epi8(mCtrl));
+#else
+      return match(emptyCtrl);
+#endif
+    }
+
+   private:
+#if defined(__SSE2__)
+    __m128i mCtrl;
+#else
+    int8_t mCtrl[groupSize];
+#endif
+  };
+
+  template <bool Const>
+  class Iterator {
+    using Slot = std::conditional_t<Const, const typename SwissMap::value_type,
+                                    typename SwissMap::value_type>;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SwissMap::value_type;
+    using difference_type = ptrdiff_t;
+    using pointer = Slot*;
+    using reference = Slot&;
+
+    Iterator() = default;
+    template <bool OtherConst>
+      requires(Const && !OtherConst)
+    Iterator(const Iterator<OtherConst>& other)
+        : mCtrl(other.mCtrl), mSlot(other.mSlot), mCtrlEnd(other.mCtrlEnd) {}
+
+    reference operator*() const { return *mSlot; }
+    pointer operator->() const { return mSlot; }
+
+    Iterator& operator++() {
+      ++mCtrl;
+      ++mSlot;
+      skipEmpty();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) {
+      return a.mSlot == b.mSlot;
+    }
+
+   private:
+    friend class SwissMap;
+    friend class Iterator<!Const>;
+
+    Iterator(const int8_t* ctrl, Slot* slot, const int8_t* ctrlEnd)
+        : mCtrl(ctrl), mSlot(slot), mCtrlEnd(ctrlEnd) {}
+
+    // Moves to the next full slot, 16 control bytes at a time.
+    void skipEmpty() {
+      while (mCtrl < mCtrlEnd) {
+        uint32_t full = ~Group(mCtrl).matchEmpty() & 0xFFFF;
+        size_t step = full ? static_cast<size_t>(std::countr_zero(full))
+                           : groupSize;
+        size_t left = static_cast<size_t>(mCtrlEnd - mCtrl);
+        // Bytes past the end are copies of the first ones.
+        if (step >= left) step = left;
+        mCtrl += step;
+        mSlot += step;
+        if (full) return;
+      }
+    }
+
+    const int8_t* mCtrl = nullptr;
+    Slot* mSlot = nullptr;
+    const int8_t* mCtrlEnd = nullptr;
+  };
+
+  static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+  // std::hash is the identity for integers in libstdc++; the bits are mixed
+  // so that both H1 and H2 depend on the whole key.
+  template <typename K>
+  size_t hashOf(const K& key) const {
+    uint64_t h = static_cast<uint64_t>(mHash(key));
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+
+  static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+  size_t home(size_t hash) const { return (hash >> 7) & (mCapacity - 1); }
+
+  // The bytes after the last slot repeat the first groupSize - 1 ones, so
+  // a group can be loaded at any slot without wrapping around.
+  void setCtrl(size_t index, int8_t value) {
+    mCtrl[index] = value;
+    if (index < groupSize - 1) mCtrl[mCapacity + index] = value;
+  }
+
+  // Returns the slot holding key and true, or the slot where key would be
+  // inserted and false.
+  template <typename K>
+  std::pair<size_t, bool> probe(const K& key, size_t hash) const {
+    size_t mask = mCapacity - 1;
+    for (size_t pos = home(hash);; pos = (pos + groupSize) & mask) {
+      Group group(mCtrl + pos);
+      for (uint32_t bits = group.match(h2(hash)); bits; bits &= bits - 1) {
+        size_t index = (pos + std::countr_zero(bits)) & mask;
+        if (mEqual(mSlots[index].first, key)) return {index, true};
+      }
+      if (uint32_t empty = group.matchEmpty())
+        return {(pos + std::countr_zero(empty)) & mask, false};
+    }
+  }
+
+  template <typename K>
+  size_t findIndex(const K& key) const {
+    if (mSize == 0) return npos;
+    auto [index, found] = probe(key, hashOf(key));
+    return found ? index : npos;
+  }
+
+  size_t findEmpty(size_t hash) const {
+    size_t mask = mCapacity - 1;
+    for (size_t pos = home(hash);; pos = (pos + groupSize) & mask) {
+      if (uint32_t empty = Group(mCtrl + pos).matchEmpty())
+        return (pos + std::countr_zero(empty)) & mask;
+    }
+  }
+
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplaceKey(K&& key, Args&&... args) {
+    size_t hash = hashOf(key);
+    size_t index = 0;
+    if (mCapacity != 0) {
+      auto [slot, found] = probe(key, hash);
+      if (found) return {iteratorFor(slot), false};
+      index = slot;
+    }
+    if (mSize + 1 > maxLoad(mCapacity)) {
+      rehash(mCapacity == 0 ? groupSize : mCapacity * 2);
+      index = findEmpty(hash);
+    }
+    Traits::construct(mAlloc, mSlots + index, std::piecewise_construct,
+                      std::forward_as_tuple(std::forward<K>(key)),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+    setCtrl(index, h2(hash));
+    ++mSize;
+    return {iteratorFor(index), true};
+  }
+
+  // Moves the element in slot from into the empty slot to. The key of a
+  // value_type is const; it is moved from anyway, since the old element is
+  // destroyed right after (std::map's node handles do the same).
+  void relocate(size_t from, size_t to) {
+    value_type& element = mSlots[from];
+    Traits::construct(mAlloc, mSlots + to,
+                      std::move(const_cast<Key&>(element.first)),
+                      std::move(element.second));
+    Traits::destroy(mAlloc, mSlots + from);
+  }
+
+  // Backward shift deletion: every later element of the run that may live
+  // in the hole (its home is not between the hole and itself) moves into
+  // it, and leaves a new hole behind.
+  void eraseAt(size_t hole) {
+    size_t mask = mCapacity - 1;
+    Traits::destroy(mAlloc, mSlots + hole);
+    for (size_t next = (hole + 1) & mask; mCtrl[next] != emptyCtrl;
+         next = (next + 1) & mask) {
+      size_t nextHome = home(hashOf(mSlots[next].first));
+      if (((next - nextHome) & mask) < ((next - hole) & mask)) continue;
+      relocate(next, hole);
+      setCtrl(hole, mCtrl[next]);
+      hole = next;
+    }
+    setCtrl(hole, emptyCtrl);
+    --mSize;
+  }
+
+  void allocate(size_t capacity) {
+    CtrlAllocator ctrlAlloc(mAlloc);
+    mCtrl = ctrlAlloc.allocate(capacity + groupSize - 1);
+    try {
+      mSlots = Traits::allocate(mAlloc, capacity);
+    } catch (...) {
+      ctrlAlloc.deallocate(mCtrl, capacity + groupSize - 1);
+      mCtrl = nullptr;
+      throw;
+    }
+    mCapacity = capacity;
+    std::memset(mCtrl, emptyCtrl, capacity + groupSize - 1);
+  }
+
+  void release() noexcept {
+    if (mCapacity == 0) return;
+    CtrlAllocator(mAlloc).deallocate(mCtrl, mCapacity + groupSize - 1);
+    Traits::deallocate(mAlloc, mSlots, mCapacity);
+    mCtrl = nullptr;
+    mSlots = nullptr;
+    mCapacity = 0;
+  }
+
+  void destroyAndRelease() noexcept {
+    clear();
+    release();
+  }
+
+  void steal(SwissMap& other) noexcept {
+    mCtrl = std::exchange(other.mCtrl, nullptr);
+    mSlots = std::exchange(other.mSlots, nullptr);
+    mCapacity = std::exchange(other.mCapacity, 0);
+    mSize = std::exchange(other.mSize, 0);
+  }
+
+  // Moves every element into a new table of the given capacity.
+  void rehash(size_t capacity) {
+    int8_t* oldCtrl = mCtrl;
+    value_type* oldSlots = mSlots;
+    size_t oldCapacity = mCapacity;
+    allocate(capacity);
+    for (size_t i = 0; i < oldCapacity; ++i) {
+      if (oldCtrl[i] == emptyCtrl) continue;
+      value_type& element = oldSlots[i];
+      size_t hash = hashOf(element.first);
+      size_t index = findEmpty(hash);
+      Traits::construct(mAlloc, mSlots + index,
+                        std::move(const_cast<Key&>(element.first)),
+                        std::move(element.second));
+      Traits::destroy(mAlloc, oldSlots + i);
+      setCtrl(index, h2(hash));
+    }
+    if (oldCapacity != 0) {
+      CtrlAllocator(mAlloc).deallocate(oldCtrl, oldCapacity + groupSize - 1);
+      Traits::deallocate(mAlloc, oldSlots, oldCapacity);
+    }
+  }
+
+  iterator iteratorAt(size_t index) {
+    iterator it(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    it.skipEmpty();
+    return it;
+  }
+  const_iterator iteratorAt(size_t index) const {
+    const_iterator it(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    it.skipEmpty();
+    return it;
+  }
+
+  // index is a full slot or npos.
+  iterator iteratorFor(size_t index) {
+    return index == npos ? end() : iteratorAt(index);
+  }
+  const_iterator iteratorFor(size_t index) const {
+    return index == npos ? end() : iteratorAt(index);
+  }
+
+  int8_t* mCtrl = nullptr;
+  value_type* mSlots = nullptr;
+  size_t mCapacity = 0;
+  size_t mSize = 0;
+  [[no_unique_address]] Hash mHash;
+  [[no_unique_address]] KeyEqual mEqual;
+  [[no_unique_address]] Allocator mAlloc;
+};
+
+#endif  // SWISS_MAP_H